@@ -4,6 +4,7 @@
 
 #include "../gl/psy-gl-context.h"
 #include "../gl/psy-gl-program.h"
+#include "../gl/psy-gl-state.h"
 #include "../gl/psy-gl-utilities.h"
 #include "psy-artist.h"
 #include "psy-circle.h"
@@ -11,6 +12,8 @@
 #include "psy-drawing-context.h"
 #include "psy-duration.h"
 #include "psy-gtk-window.h"
+#include "psy-presentation-log.h"
+#include "psy-visual-stimulus-private.h"
 #include "psy-window.h"
 
 /* forward declarations */
@@ -39,8 +42,36 @@ struct _PsyGtkWindow {
     gint frames_lapsed; // number of frames lapsed since the last frame
 
     PsyTimePoint *frame_time;
+
+    PsyPresentationLog *presentation_log;
+    GArray *pending_frames; // gint64 frame counters awaiting their feedback
+    GArray *pending_onsets; // PendingOnset's awaiting their feedback
+    gint64  current_frame;  // the frame counter of the frame being drawn
+    gint64  current_predicted;      // its predicted presentation time in µs
+    gint64  last_presentation_time; // in µs, 0 when unknown
+
+    guint64 num_onsets;
+    gdouble sum_onset_error; // in µs
+    gdouble max_onset_error; // in µs
 };
 
+/*
+ * A stimulus that has been drawn for the first time, whose actual onset is
+ * known once the frame clock reports when that frame has been presented.
+ */
+typedef struct PendingOnset {
+    PsyVisualStimulus *stimulus;
+    gint64             frame_counter;
+    gint64             predicted;
+} PendingOnset;
+
+static void
+pending_onset_clear(gpointer data)
+{
+    PendingOnset *onset = data;
+    g_clear_object(&onset->stimulus);
+}
+
 G_DEFINE_TYPE_WITH_CODE(PsyGtkWindow, psy_gtk_window, PSY_TYPE_WINDOW, {
     // Initialize GTK when creating the first Gtk window
     gtk_init();
@@ -54,6 +85,7 @@ typedef enum GtkWindowProperty {
 
 typedef enum GtkWindowSignals {
     SIG_DEBUG_MESSAGE,
+    SIG_STIMULUS_PRESENTED,
     NUM_SIGNALS
 } GtkWindowSingals;
 
@@ -98,12 +130,106 @@ psy_gtk_window_get_property(GObject    *object,
     }
 }
 
+/*
+ * Reports the actual onset of the stimuli that started at the frame
+ * described by @record.
+ */
+static void
+resolve_onsets(PsyGtkWindow *self, const PsyPresentationRecord *record)
+{
+    guint i = 0;
+    while (i < self->pending_onsets->len) {
+        PendingOnset *onset
+            = &g_array_index(self->pending_onsets, PendingOnset, i);
+
+        if (onset->frame_counter != record->frame_counter) {
+            i++;
+            continue;
+        }
+
+        if (record->presentation_time != 0) {
+            PsyTimePoint *predicted
+                = psy_time_point_new_monotonic(onset->predicted);
+            PsyTimePoint *actual
+                = psy_time_point_new_monotonic(record->presentation_time);
+            gdouble error
+                = (gdouble) (record->presentation_time - onset->predicted);
+
+            self->num_onsets++;
+            self->sum_onset_error += error;
+            if (self->num_onsets == 1 || ABS(error) > self->max_onset_error)
+                self->max_onset_error = ABS(error);
+
+            psy_visual_stimulus_set_onset_time(onset->stimulus, actual);
+            g_signal_emit(self,
+                          gtk_window_signals[SIG_STIMULUS_PRESENTED],
+                          0,
+                          onset->stimulus,
+                          predicted,
+                          actual);
+
+            psy_time_point_free(predicted);
+            psy_time_point_free(actual);
+        }
+
+        g_array_remove_index(self->pending_onsets, i);
+    }
+}
+
+/*
+ * The frame clock reports when a frame has actually been presented a few
+ * frames after it has been drawn. This logs the frames whose timings have
+ * become complete meanwhile.
+ */
+static void
+collect_presentation_feedback(PsyGtkWindow *self, GdkFrameClock *clock)
+{
+    guint i = 0;
+    while (i < self->pending_frames->len) {
+        gint64 counter = g_array_index(self->pending_frames, gint64, i);
+        GdkFrameTimings *timings = gdk_frame_clock_get_timings(clock, counter);
+
+        // Frames that dropped out of the history of the clock are logged
+        // without a presentation time.
+        if (timings && !gdk_frame_timings_get_complete(timings)) {
+            i++;
+            continue;
+        }
+
+        PsyPresentationRecord record = {.frame_counter = counter};
+        if (timings) {
+            record.predicted_time
+                = gdk_frame_timings_get_predicted_presentation_time(timings);
+            record.presentation_time
+                = gdk_frame_timings_get_presentation_time(timings);
+            record.refresh_interval
+                = gdk_frame_timings_get_refresh_interval(timings);
+        }
+
+        if (record.presentation_time != 0 && self->last_presentation_time != 0
+            && record.refresh_interval > 0) {
+            gint64 lapsed
+                = record.presentation_time - self->last_presentation_time;
+            gint64 num_intervals = (lapsed + record.refresh_interval / 2)
+                                   / record.refresh_interval;
+            record.num_dropped = (gint) MAX(num_intervals - 1, 0);
+        }
+        self->last_presentation_time = record.presentation_time;
+
+        psy_presentation_log_push(self->presentation_log, &record);
+        resolve_onsets(self, &record);
+
+        g_array_remove_index(self->pending_frames, i);
+    }
+}
+
 static gboolean
 tick_callback(GtkWidget *d_area, GdkFrameClock *clock, gpointer data)
 {
     PsyGtkWindow *window = PSY_GTK_WINDOW(data);
     GtkGLArea    *canvas = GTK_GL_AREA(d_area);
     gtk_gl_area_make_current(canvas);
+    psy_gl_state_invalidate();
 
     // Check if there is anything to draw to
     if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER)
@@ -127,7 +253,12 @@ tick_callback(GtkWidget *d_area, GdkFrameClock *clock, gpointer data)
 
     PsyTimePoint *tp = psy_time_point_new_monotonic(predicted);
 
+    collect_presentation_feedback(window, clock);
+
+    window->current_frame     = frame_count;
+    window->current_predicted = predicted;
     canvas_class->draw(PSY_CANVAS(window), frame_count, tp);
+    g_array_append_val(window->pending_frames, frame_count);
 
     psy_gtk_window_compute_frame_stats(window, tp);
     psy_gtk_window_set_last_frame_time(window, tp);
@@ -143,6 +274,7 @@ on_canvas_resize(GtkDrawingArea *darea, gint width, gint height, gpointer data)
 {
     PsyGtkWindow *self = data;
     gtk_gl_area_make_current(GTK_GL_AREA(darea));
+    psy_gl_state_invalidate();
 
     g_signal_emit_by_name(
         self, "resize", width, height); // allow clients to update
@@ -171,6 +303,7 @@ on_canvas_realize(GtkGLArea *canvas, PsyGtkWindow *window)
 {
     GError *error = NULL;
     gtk_gl_area_make_current(canvas);
+    psy_gl_state_invalidate();
 
     if (gtk_gl_area_get_error(canvas) != NULL)
         return;
@@ -183,6 +316,10 @@ on_canvas_realize(GtkGLArea *canvas, PsyGtkWindow *window)
             GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
     }
 
+    // The smooth edges of shapes are blended with the background.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
     init_shaders(window, &error);
 
     if (error) {
@@ -199,6 +336,7 @@ static void
 on_canvas_unrealize(GtkGLArea *area, PsyGtkWindow *self)
 {
     gtk_gl_area_make_current(area);
+    psy_gl_state_invalidate();
     PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(self));
     psy_drawing_context_free_resources(context);
 }
@@ -358,6 +496,11 @@ psy_gtk_window_init(PsyGtkWindow *self)
 
     gtk_window_set_decorated(GTK_WINDOW(self->window), FALSE);
 
+    self->presentation_log = psy_presentation_log_new(1024);
+    self->pending_frames   = g_array_new(FALSE, FALSE, sizeof(gint64));
+    self->pending_onsets   = g_array_new(FALSE, FALSE, sizeof(PendingOnset));
+    g_array_set_clear_func(self->pending_onsets, pending_onset_clear);
+
     create_drawing_context(self);
 
     gtk_widget_set_visible(GTK_WIDGET(self->window), TRUE);
@@ -369,6 +512,8 @@ psy_gtk_window_dispose(GObject *gobject)
     PsyGtkWindow *self = PSY_GTK_WINDOW(gobject);
 
     g_clear_object(&self->window);
+    if (self->pending_onsets)
+        g_array_set_size(self->pending_onsets, 0);
 
     G_OBJECT_CLASS(psy_gtk_window_parent_class)->dispose(gobject);
 }
@@ -379,6 +524,9 @@ psy_gtk_window_finalize(GObject *gobject)
     PsyGtkWindow *self = PSY_GTK_WINDOW(gobject);
 
     g_clear_pointer(&self->frame_time, psy_time_point_free);
+    g_clear_object(&self->presentation_log);
+    g_clear_pointer(&self->pending_frames, g_array_unref);
+    g_clear_pointer(&self->pending_onsets, g_array_unref);
 
     G_OBJECT_CLASS(psy_gtk_window_parent_class)->finalize(gobject);
 }
@@ -424,6 +572,9 @@ clear(PsyCanvas *self)
     gfloat    r, b, g, a;
     PsyColor *color = psy_canvas_get_background_color(self);
 
+    // GTK may have changed the state since the previous frame.
+    psy_gl_state_invalidate();
+
     // clang-format off
     g_object_get(color,
                  "r", &r,
@@ -444,6 +595,25 @@ draw_stimuli(PsyCanvas *self, guint64 nth_frame, PsyTimePoint *tp)
         ->draw_stimuli(self, nth_frame, tp);
 }
 
+static void
+draw_stimulus(PsyCanvas *self, PsyVisualStimulus *stimulus)
+{
+    PsyGtkWindow *window = PSY_GTK_WINDOW(self);
+
+    PSY_CANVAS_CLASS(psy_gtk_window_parent_class)
+        ->draw_stimulus(self, stimulus);
+
+    // The update before drawing the first frame increments nth-frame to 1.
+    if (psy_visual_stimulus_get_nth_frame(stimulus) == 1) {
+        PendingOnset onset = {
+            .stimulus      = g_object_ref(stimulus),
+            .frame_counter = window->current_frame,
+            .predicted     = window->current_predicted,
+        };
+        g_array_append_val(window->pending_onsets, onset);
+    }
+}
+
 static void
 update_frame_stats(PsyCanvas *canvas, PsyFrameCount *stats)
 {
@@ -463,6 +633,12 @@ upload_projection_matrices(PsyCanvas *self)
     psy_gl_canvas_upload_projection_matrices(self);
 }
 
+static void
+set_translucent(PsyCanvas *self, gboolean translucent)
+{
+    psy_gl_canvas_set_translucent(self, translucent);
+}
+
 static void
 psy_gtk_window_class_init(PsyGtkWindowClass *klass)
 {
@@ -480,8 +656,10 @@ psy_gtk_window_class_init(PsyGtkWindowClass *klass)
     PsyCanvasClass *psy_canvas_class             = PSY_CANVAS_CLASS(klass);
     psy_canvas_class->clear                      = clear;
     psy_canvas_class->draw_stimuli               = draw_stimuli;
+    psy_canvas_class->draw_stimulus              = draw_stimulus;
     psy_canvas_class->update_frame_stats         = update_frame_stats;
     psy_canvas_class->upload_projection_matrices = upload_projection_matrices;
+    psy_canvas_class->set_translucent            = set_translucent;
 
     /**
      * PsyGtkWindow:enable-debug:
@@ -540,6 +718,35 @@ psy_gtk_window_class_init(PsyGtkWindowClass *klass)
                        G_TYPE_STRING,
                        G_TYPE_STRING,
                        G_TYPE_STRING);
+
+    /**
+     * PsyGtkWindow::stimulus-presented:
+     * @self: An instance of `PsyGtkWindow`
+     * @stimulus: the [class@VisualStimulus] that has been presented
+     * @predicted: the time at which its first frame was predicted to be
+     *             presented
+     * @actual: the time at which its first frame has actually been presented
+     *
+     * This signal is emitted when the frame clock reports the time at which
+     * the first frame of @stimulus has been presented. This happens a few
+     * frames after the stimulus has been drawn, so an experiment can log the
+     * real onset of a stimulus rather than the predicted one. When the
+     * compositor doesn't report presentation times, this signal isn't
+     * emitted.
+     */
+    gtk_window_signals[SIG_STIMULUS_PRESENTED]
+        = g_signal_new("stimulus-presented",
+                       G_TYPE_FROM_CLASS(klass),
+                       G_SIGNAL_RUN_FIRST,
+                       0,
+                       NULL,
+                       NULL,
+                       NULL,
+                       G_TYPE_NONE,
+                       3,
+                       PSY_TYPE_VISUAL_STIMULUS,
+                       PSY_TYPE_TIME_POINT,
+                       PSY_TYPE_TIME_POINT);
 }
 
 /**
@@ -621,6 +828,55 @@ psy_gtk_window_compute_frame_stats(PsyGtkWindow *self, PsyTimePoint *tp_new)
     }
 }
 
+/**
+ * psy_gtk_window_get_presentation_log:
+ * @self: An instance of [class@GtkWindow]
+ *
+ * Obtains the log with the predicted and actual presentation time, the
+ * refresh interval and the number of dropped frames of every frame. The
+ * actual presentation time of a frame is logged a few frames after it has
+ * been drawn. The log may be read from another thread.
+ *
+ * Returns:(transfer none): the presentation log of @self
+ */
+PsyPresentationLog *
+psy_gtk_window_get_presentation_log(PsyGtkWindow *self)
+{
+    g_return_val_if_fail(PSY_IS_GTK_WINDOW(self), NULL);
+    return self->presentation_log;
+}
+
+/**
+ * psy_gtk_window_get_onset_stats:
+ * @self: An instance of [class@GtkWindow]
+ * @num_onsets:(out)(optional): the number of stimulus onsets whose actual
+ *             presentation time has been reported
+ * @mean_error_ms:(out)(optional): the mean of the actual minus the predicted
+ *                onset in ms
+ * @max_error_ms:(out)(optional): the largest absolute difference between the
+ *               actual and the predicted onset in ms
+ *
+ * Obtains how accurately the onsets of the stimuli presented so far matched
+ * their predicted onsets.
+ */
+void
+psy_gtk_window_get_onset_stats(PsyGtkWindow *self,
+                               guint64      *num_onsets,
+                               gdouble      *mean_error_ms,
+                               gdouble      *max_error_ms)
+{
+    g_return_if_fail(PSY_IS_GTK_WINDOW(self));
+
+    if (num_onsets)
+        *num_onsets = self->num_onsets;
+    if (mean_error_ms)
+        *mean_error_ms = self->num_onsets
+                             ? self->sum_onset_error / self->num_onsets / 1000
+                             : 0.0;
+    if (max_error_ms)
+        *max_error_ms = self->max_onset_error / 1000;
+}
+
 /**
  * psy_gtk_window_free:(skip)
  *
@@ -2,6 +2,7 @@
 #ifndef PSY_GTK_WINDOW_H
 #define PSY_GTK_WINDOW_H
 
+#include <psy-presentation-log.h>
 #include <psy-window.h>
 
 G_BEGIN_DECLS
@@ -20,6 +21,15 @@ psy_gtk_window_new_for_monitor(gint monitor);
 G_MODULE_EXPORT void
 psy_gtk_window_free(PsyGtkWindow *self);
 
+G_MODULE_EXPORT PsyPresentationLog *
+psy_gtk_window_get_presentation_log(PsyGtkWindow *self);
+
+G_MODULE_EXPORT void
+psy_gtk_window_get_onset_stats(PsyGtkWindow *self,
+                               guint64      *num_onsets,
+                               gdouble      *mean_error_ms,
+                               gdouble      *max_error_ms);
+
 G_END_DECLS
 
 #endif
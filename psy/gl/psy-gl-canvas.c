@@ -1,10 +1,13 @@
 
 #include <epoxy/egl.h>
 #include <epoxy/gl.h>
+#include <string.h>
 
 #include "psy-gl-canvas.h"
 #include "psy-gl-error.h"
+#include "psy-gl-state.h"
 #include "psy-gl-utilities.h"
+#include "psy-matrix4.h"
 
 static void GLAPIENTRY
 on_gl_canvas_error(GLenum        source,
@@ -15,11 +18,29 @@ on_gl_canvas_error(GLenum        source,
                    const GLchar *message,
                    const void   *object);
 
+/*
+ * The number of frames that may be read back asynchronously at once. The
+ * image of frame N - 2 is handed out as soon as frame N has been drawn.
+ */
+#define NUM_READBACKS 3
+
+/*
+ * A pixel pack buffer that receives the pixels of a frame in the
+ * background, the fence signals that the transfer has completed.
+ */
+typedef struct Readback {
+    GLuint  pbo;
+    GLsync  fence; // NULL when the readback isn't pending
+    gint    width, height;
+    guint64 frame_num;
+} Readback;
+
 struct _PsyGlCanvas {
     PsyImageCanvas parent;
 
     /* stuff related to egl */
     EGLDisplay display; // used display
+    gboolean   display_initialized;
     EGLConfig  config;
     EGLContext egl_context;
     EGLSurface surface;
@@ -32,6 +53,12 @@ struct _PsyGlCanvas {
     gboolean debug;              /* whether or not to create a debug context. */
     gboolean use_es; /* whether or not to create OpenGL es context. If false
                         regular opengl will be used */
+
+    /* asynchronous readback */
+    gboolean   async_readback;
+    Readback   readbacks[NUM_READBACKS];
+    guint      next_readback; // the slot used by the next frame
+    GPtrArray *image_pool;    // PsyImage's that may be reused
 };
 
 G_DEFINE_TYPE(PsyGlCanvas, psy_gl_canvas, PSY_TYPE_IMAGE_CANVAS)
@@ -42,14 +69,27 @@ typedef enum GlCanvasProperty {
     PROP_USE_ES,
     PROP_MAJOR,
     PROP_MINOR,
+    PROP_ASYNC_READBACK,
     NUM_PROPS, // number of properties, keep this one last.
 } GlCanvasProperty;
 
-typedef enum GlCanvasSignals { SIG_DEBUG_MESSAGE, NUM_SIGNALS } GlCanvasSignals;
+typedef enum GlCanvasSignals {
+    SIG_DEBUG_MESSAGE,
+    SIG_IMAGE_READY,
+    NUM_SIGNALS
+} GlCanvasSignals;
 
 static GParamSpec *properties[NUM_PROPS] = {0};
 static guint       signals[NUM_SIGNALS]  = {0};
 
+/*
+ * Canvases on the same device share an EGLDisplay, possibly in different
+ * threads. eglTerminate would destroy the contexts of all of them, so the
+ * display is only terminated when the last canvas that uses it is gone.
+ */
+static GMutex      display_lock;
+static GHashTable *display_refs; // EGLDisplay -> number of canvases
+
 static void
 psy_gl_canvas_set_property(GObject      *object,
                            guint         property_id,
@@ -71,6 +111,9 @@ psy_gl_canvas_set_property(GObject      *object,
     case PROP_MINOR:
         self->gl_minor = g_value_get_int(value);
         break;
+    case PROP_ASYNC_READBACK:
+        psy_gl_canvas_set_async_readback(self, g_value_get_boolean(value));
+        break;
     default:
         /* We don't have any other property... */
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -99,6 +142,9 @@ psy_gl_canvas_get_property(GObject    *object,
     case PROP_MINOR:
         g_value_set_int(value, self->gl_minor);
         break;
+    case PROP_ASYNC_READBACK:
+        g_value_set_boolean(value, self->async_readback);
+        break;
     default:
         /* We don't have any other property... */
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -109,7 +155,45 @@ psy_gl_canvas_get_property(GObject    *object,
 static void
 psy_gl_canvas_init(PsyGlCanvas *self)
 {
-    (void) self;
+    self->image_pool = g_ptr_array_new_with_free_func(g_object_unref);
+}
+
+static gboolean
+gl_canvas_initialize_display(EGLDisplay display, EGLint *major, EGLint *minor)
+{
+    gboolean ret;
+
+    g_mutex_lock(&display_lock);
+
+    ret = eglInitialize(display, major, minor) == EGL_TRUE;
+    if (ret) {
+        if (!display_refs)
+            display_refs = g_hash_table_new(NULL, NULL);
+        guint count = GPOINTER_TO_UINT(g_hash_table_lookup(display_refs,
+                                                            display));
+        g_hash_table_insert(display_refs, display, GUINT_TO_POINTER(count + 1));
+    }
+
+    g_mutex_unlock(&display_lock);
+    return ret;
+}
+
+static void
+gl_canvas_terminate_display(EGLDisplay display)
+{
+    g_mutex_lock(&display_lock);
+
+    guint count
+        = GPOINTER_TO_UINT(g_hash_table_lookup(display_refs, display)) - 1;
+    if (count == 0) {
+        g_hash_table_remove(display_refs, display);
+        eglTerminate(display);
+    }
+    else {
+        g_hash_table_insert(display_refs, display, GUINT_TO_POINTER(count));
+    }
+
+    g_mutex_unlock(&display_lock);
 }
 
 // Taken from:
@@ -189,8 +273,8 @@ psy_gl_canvas_constructed(GObject *obj)
             continue;
         }
 
-        if (eglInitialize(canvas->display, &egl_major, &egl_minor)
-            != EGL_TRUE) {
+        if (!gl_canvas_initialize_display(
+                canvas->display, &egl_major, &egl_minor)) {
             egl_ret = eglGetError();
             g_info("Unable to initialize egl for device %d: %s",
                    i,
@@ -198,6 +282,7 @@ psy_gl_canvas_constructed(GObject *obj)
         }
         else {
             // Use the first device for which we can initialize egl.
+            canvas->display_initialized = TRUE;
             g_debug("Initialized display for egl %d.%d", egl_major, egl_minor);
             g_debug("device %d", i);
             init_egl = TRUE;
@@ -247,6 +332,8 @@ psy_gl_canvas_constructed(GObject *obj)
         g_critical("Unable to make the context current: %s",
                    psy_egl_strerr(egl_ret));
     }
+    // The cache may hold the state of another context of this thread.
+    psy_gl_state_invalidate();
 
     if (canvas->debug) {
         glEnable(GL_DEBUG_OUTPUT);
@@ -287,6 +374,17 @@ psy_gl_canvas_constructed(GObject *obj)
         g_clear_error(&error);
     }
 
+    // The smooth edges of shapes are blended with the background. The
+    // translucent stimuli are drawn after the opaque ones, without writing
+    // depth, see psy_gl_canvas_set_translucent.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    psy_gl_check_error(&error);
+    if (error) {
+        g_critical("Unable to enable blending: %s", error->message);
+        g_clear_error(&error);
+    }
+
     PsyCanvasClass *cls;
     cls = PSY_CANVAS_GET_CLASS(canvas);
     cls->init_default_shaders(PSY_CANVAS(canvas), &error);
@@ -297,31 +395,190 @@ psy_gl_canvas_constructed(GObject *obj)
     }
 }
 
+static gboolean
+gl_canvas_make_current(PsyGlCanvas *self)
+{
+    if (eglMakeCurrent(
+            self->display, self->surface, self->surface, self->egl_context)
+        != EGL_TRUE) {
+        EGLint error = eglGetError();
+        g_critical("Unable to make GlCanvas current: %s",
+                   psy_egl_strerr(error));
+        return FALSE;
+    }
+    // The cache may hold the state of another context of this thread.
+    psy_gl_state_invalidate();
+    return TRUE;
+}
+
+static void
+gl_canvas_clear_readbacks(PsyGlCanvas *self)
+{
+    for (guint i = 0; i < NUM_READBACKS; i++) {
+        Readback *readback = &self->readbacks[i];
+        if (readback->fence) {
+            glDeleteSync(readback->fence);
+            readback->fence = NULL;
+        }
+        if (readback->pbo) {
+            glDeleteBuffers(1, &readback->pbo);
+            readback->pbo = 0;
+        }
+    }
+}
+
 static void
 psy_gl_canvas_finalize(GObject *object)
 {
     PsyGlCanvas *self = PSY_GL_CANVAS(object);
 
-    eglDestroySurface(self->display, self->surface);
-    eglDestroyContext(self->display, self->egl_context);
-    eglTerminate(self->display);
+    if (self->egl_context && gl_canvas_make_current(self))
+        gl_canvas_clear_readbacks(self);
+    g_ptr_array_unref(self->image_pool);
+
+    g_free(self->devices);
+
+    if (self->display_initialized) {
+        // Unbind the context, so it's destroyed right away.
+        if (eglGetCurrentContext() == self->egl_context) {
+            eglMakeCurrent(
+                self->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            psy_gl_state_invalidate();
+        }
+        eglDestroySurface(self->display, self->surface);
+        eglDestroyContext(self->display, self->egl_context);
+        gl_canvas_terminate_display(self->display);
+    }
 
     G_OBJECT_CLASS(psy_gl_canvas_parent_class)->finalize(object);
 }
 
+/*
+ * Obtains an image of the size of the canvas, preferably one from the pool
+ */
+static PsyImage *
+gl_canvas_take_image(PsyGlCanvas *self, gint width, gint height)
+{
+    for (guint i = 0; i < self->image_pool->len; i++) {
+        PsyImage *image = g_ptr_array_index(self->image_pool, i);
+        if (psy_image_get_width(image) == (guint) width
+            && psy_image_get_height(image) == (guint) height) {
+            return g_ptr_array_steal_index_fast(self->image_pool, i);
+        }
+    }
+    return psy_image_new(width, height, PSY_IMAGE_FORMAT_RGBA);
+}
+
+/*
+ * Copies the pixels of a pending readback into an image and hands it out
+ * with the image-ready signal. This blocks until the transfer is complete,
+ * which it normally is, as it was started two frames ago.
+ */
+static void
+gl_canvas_resolve_readback(PsyGlCanvas *self, Readback *readback)
+{
+    GError *error = NULL;
+
+    if (!readback->fence)
+        return;
+
+    glClientWaitSync(
+        readback->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(readback->fence);
+    readback->fence = NULL;
+
+    PsyImage *image
+        = gl_canvas_take_image(self, readback->width, readback->height);
+    gsize num_bytes = psy_image_get_num_bytes(image);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+    const void *pixels
+        = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, num_bytes, GL_MAP_READ_BIT);
+    if (pixels) {
+        memcpy(psy_image_get_ptr(image), pixels, num_bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (psy_gl_check_error(&error) || !pixels) {
+        g_critical("Unable to read back frame %" G_GUINT64_FORMAT ": %s",
+                   readback->frame_num,
+                   error ? error->message : "unable to map the buffer");
+        g_clear_error(&error);
+        g_ptr_array_add(self->image_pool, image);
+        return;
+    }
+
+    g_signal_emit(
+        self, signals[SIG_IMAGE_READY], 0, image, readback->frame_num);
+
+    // When no handler kept the image, it can be reused.
+    if (G_OBJECT(image)->ref_count == 1)
+        g_ptr_array_add(self->image_pool, image);
+    else
+        g_object_unref(image);
+}
+
+/*
+ * Starts copying the pixels of the frame that has just been drawn into a
+ * pixel pack buffer, without waiting for the GPU.
+ */
+static void
+gl_canvas_start_readback(PsyGlCanvas *self, guint64 frame_num)
+{
+    PsyCanvas *canvas   = PSY_CANVAS(self);
+    Readback  *readback = &self->readbacks[self->next_readback];
+    gint       width    = psy_canvas_get_width(canvas);
+    gint       height   = psy_canvas_get_height(canvas);
+    GError    *error    = NULL;
+
+    // Normally empty, as the frame of this slot was handed out before.
+    gl_canvas_resolve_readback(self, readback);
+
+    if (!readback->pbo)
+        glGenBuffers(1, &readback->pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+    if (readback->width != width || readback->height != height) {
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+                     (GLsizeiptr) width * height * 4,
+                     NULL,
+                     GL_STREAM_READ);
+        readback->width  = width;
+        readback->height = height;
+    }
+
+    // With a pack buffer bound, the last argument is an offset into it.
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback->fence     = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback->frame_num = frame_num;
+
+    if (psy_gl_check_error(&error)) {
+        g_critical("Unable to start reading back frame %" G_GUINT64_FORMAT
+                   ": %s",
+                   frame_num,
+                   error->message);
+        g_clear_error(&error);
+    }
+
+    self->next_readback = (self->next_readback + 1) % NUM_READBACKS;
+
+    // The next slot holds frame N - 2, hand it out now rather than when
+    // the slot is reused, which would delay it by another frame.
+    gl_canvas_resolve_readback(self, &self->readbacks[self->next_readback]);
+}
+
 static void
 gl_canvas_draw(PsyCanvas *canvas, guint64 frame_num, PsyTimePoint *tp)
 {
     PsyGlCanvas *self = PSY_GL_CANVAS(canvas);
-    if (eglMakeCurrent(
-            self->display, self->surface, self->surface, self->egl_context)
-        != EGL_TRUE) {
-        EGLint error = eglGetError();
-        g_critical("Unable to make GlCanvas current: %s",
-                   psy_egl_strerr(error));
-    }
+    gl_canvas_make_current(self);
 
     PSY_CANVAS_CLASS(psy_gl_canvas_parent_class)->draw(canvas, frame_num, tp);
+
+    if (self->async_readback)
+        gl_canvas_start_readback(self, frame_num);
 }
 
 static void
@@ -329,6 +586,9 @@ gl_canvas_clear(PsyCanvas *self)
 {
     // don't chain up, its not implemented in parent
 
+    // The state may have been changed since the previous frame.
+    psy_gl_state_invalidate();
+
     gfloat    r, b, g, a;
     GError   *error = NULL;
     PsyColor *color = psy_canvas_get_background_color(self);
@@ -356,6 +616,12 @@ gl_canvas_upload_projection_matrices(PsyCanvas *self)
     psy_gl_canvas_upload_projection_matrices(self);
 }
 
+static void
+gl_canvas_set_translucent(PsyCanvas *self, gboolean translucent)
+{
+    psy_gl_canvas_set_translucent(self, translucent);
+}
+
 static void
 gl_canvas_init_default_shaders(PsyCanvas *self, GError **error)
 {
@@ -374,12 +640,7 @@ gl_canvas_get_image(PsyCanvas *canvas)
     g_assert(psy_image_get_height(ret)
              == (guint) psy_canvas_get_height(canvas));
 
-    if (eglMakeCurrent(
-            self->display, self->surface, self->surface, self->egl_context)
-        != EGL_TRUE) {
-        EGLint error = eglGetError();
-        g_critical("Unable to make context current: %s", psy_egl_strerr(error));
-    }
+    gl_canvas_make_current(self);
 
     glReadPixels(0,
                  0,
@@ -395,14 +656,39 @@ gl_canvas_get_image(PsyCanvas *canvas)
         g_clear_error(&error);
     }
 
-    glFinish();
-
-    // In OpenGL the origin is at the left bottom not left top.
-    psy_image_flip_upside_down(ret);
-
+    // The projection renders upside down, so the rows are in the order of
+    // a PsyImage already, see gl_canvas_create_projection_matrix.
     return ret;
 }
 
+/*
+ * In OpenGL the origin of the framebuffer is at the left bottom, whereas
+ * the first row of a PsyImage is the top row. As the canvas is only seen
+ * as image, its content is rendered upside down, so the pixels that are
+ * read back need not be flipped on the CPU.
+ */
+static PsyMatrix4 *
+gl_canvas_create_projection_matrix(PsyCanvas *canvas)
+{
+    PsyMatrix4 *projection
+        = PSY_CANVAS_CLASS(psy_gl_canvas_parent_class)
+              ->create_projection_matrix(canvas);
+    if (!projection)
+        return NULL;
+
+    gfloat      flip_values[] = {1.0f, -1.0f, 1.0f};
+    PsyVector3 *flip_vector   = psy_vector3_new_data(3, flip_values);
+    PsyMatrix4 *flip          = psy_matrix4_new_identity();
+    psy_matrix4_scale(flip, flip_vector);
+
+    PsyMatrix4 *flipped = psy_matrix4_mul(flip, projection);
+
+    g_object_unref(flip_vector);
+    g_object_unref(flip);
+    g_object_unref(projection);
+    return flipped;
+}
+
 static void GLAPIENTRY
 on_gl_canvas_error(GLenum        source,
                    GLenum        type,
@@ -524,6 +810,9 @@ psy_gl_canvas_class_init(PsyGlCanvasClass *klass)
         = gl_canvas_upload_projection_matrices;
     psy_canvas_class->init_default_shaders = gl_canvas_init_default_shaders;
     psy_canvas_class->get_image            = gl_canvas_get_image;
+    psy_canvas_class->set_translucent      = gl_canvas_set_translucent;
+    psy_canvas_class->create_projection_matrix
+        = gl_canvas_create_projection_matrix;
 
     /**
      * PsyGlCanvas:enable-debug:
@@ -575,6 +864,23 @@ psy_gl_canvas_class_init(PsyGlCanvasClass *klass)
                            3,
                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
 
+    /**
+     * PsyGlCanvas:async-readback:
+     *
+     * When TRUE, the pixels of every frame are copied into a pixel buffer
+     * in the background while the next frames are drawn. The image of a
+     * frame is handed out with the [signal@GlCanvas::image-ready] signal as
+     * soon as two more frames have been drawn, so capturing every frame
+     * doesn't make the CPU wait for the GPU. Call [method@GlCanvas.flush_readback] in order to obtain the
+     * images of the last frames.
+     */
+    properties[PROP_ASYNC_READBACK] = g_param_spec_boolean(
+        "async-readback",
+        "AsyncReadback",
+        "Whether to read back every frame in the background",
+        FALSE,
+        G_PARAM_READWRITE);
+
     g_object_class_install_properties(object_class, NUM_PROPS, properties);
 
     /**
@@ -613,6 +919,30 @@ psy_gl_canvas_class_init(PsyGlCanvasClass *klass)
                        G_TYPE_STRING,
                        G_TYPE_STRING,
                        G_TYPE_STRING);
+
+    /**
+     * PsyGlCanvas::image-ready:
+     * @self: An instance of `PsyGlCanvas`
+     * @image: the [class@Image] with the content of the frame
+     * @frame_num: the number of the frame
+     *
+     * This signal is emitted with the image of a frame when
+     * [property@GlCanvas:async-readback] is enabled. When a handler doesn't
+     * keep a reference to @image, its memory is reused for a later frame,
+     * so a handler that keeps it should take a reference, e.g. with
+     * g_object_ref.
+     */
+    signals[SIG_IMAGE_READY] = g_signal_new("image-ready",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_FIRST,
+                                            0,
+                                            NULL,
+                                            NULL,
+                                            NULL,
+                                            G_TYPE_NONE,
+                                            2,
+                                            PSY_TYPE_IMAGE,
+                                            G_TYPE_UINT64);
 }
 
 /**
@@ -689,3 +1019,63 @@ psy_gl_canvas_free(PsyGlCanvas *self)
     g_return_if_fail(PSY_IS_GL_CANVAS(self));
     g_object_unref(self);
 }
+
+/**
+ * psy_gl_canvas_set_async_readback:
+ * @self: an instance of [class@GlCanvas]
+ * @async_readback: whether to read back every frame in the background
+ *
+ * See [property@GlCanvas:async-readback]. Disabling it hands out the
+ * images of the frames that are still being read back.
+ */
+void
+psy_gl_canvas_set_async_readback(PsyGlCanvas *self, gboolean async_readback)
+{
+    g_return_if_fail(PSY_IS_GL_CANVAS(self));
+
+    async_readback = async_readback != FALSE;
+    if (self->async_readback == async_readback)
+        return;
+
+    if (!async_readback)
+        psy_gl_canvas_flush_readback(self);
+
+    self->async_readback = async_readback;
+    g_object_notify_by_pspec(G_OBJECT(self), properties[PROP_ASYNC_READBACK]);
+}
+
+/**
+ * psy_gl_canvas_get_async_readback:
+ * @self: an instance of [class@GlCanvas]
+ *
+ * Returns: whether the frames are read back in the background.
+ */
+gboolean
+psy_gl_canvas_get_async_readback(PsyGlCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_GL_CANVAS(self), FALSE);
+    return self->async_readback;
+}
+
+/**
+ * psy_gl_canvas_flush_readback:
+ * @self: an instance of [class@GlCanvas]
+ *
+ * Waits for the frames that are being read back, and emits
+ * [signal@GlCanvas::image-ready] for each of them in the order in which
+ * they were drawn. Call this after the last frame has been drawn.
+ */
+void
+psy_gl_canvas_flush_readback(PsyGlCanvas *self)
+{
+    g_return_if_fail(PSY_IS_GL_CANVAS(self));
+
+    if (!gl_canvas_make_current(self))
+        return;
+
+    // The slot of the next frame holds the oldest pending frame.
+    for (guint i = 0; i < NUM_READBACKS; i++) {
+        guint slot = (self->next_readback + i) % NUM_READBACKS;
+        gl_canvas_resolve_readback(self, &self->readbacks[slot]);
+    }
+}
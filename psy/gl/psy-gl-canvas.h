@@ -24,4 +24,13 @@ psy_gl_canvas_new_full(gint     width,
 G_MODULE_EXPORT void
 psy_gl_canvas_free(PsyGlCanvas *self);
 
+G_MODULE_EXPORT void
+psy_gl_canvas_set_async_readback(PsyGlCanvas *self, gboolean async_readback);
+
+G_MODULE_EXPORT gboolean
+psy_gl_canvas_get_async_readback(PsyGlCanvas *self);
+
+G_MODULE_EXPORT void
+psy_gl_canvas_flush_readback(PsyGlCanvas *self);
+
 G_END_DECLS
@@ -2,6 +2,7 @@
 
 #include "psy-gl-context.h"
 #include "psy-gl-fragment-shader.h"
+#include "psy-gl-gpu-timer.h"
 #include "psy-gl-program.h"
 #include "psy-gl-texture.h"
 #include "psy-gl-vbuffer.h"
@@ -71,6 +72,15 @@ psy_gl_create_texture(PsyDrawingContext *self)
     return PSY_TEXTURE(psy_gl_texture_new());
 }
 
+static PsyGpuTimer *
+psy_gl_create_gpu_timer(PsyDrawingContext *self)
+{
+    g_assert(PSY_IS_GL_CONTEXT(self));
+    if (!psy_gl_gpu_timer_is_supported())
+        return NULL;
+    return PSY_GPU_TIMER(psy_gl_gpu_timer_new());
+}
+
 static void
 psy_gl_context_class_init(PsyGlContextClass *class)
 {
@@ -86,6 +96,7 @@ psy_gl_context_class_init(PsyGlContextClass *class)
         = psy_gl_create_fragment_shader;
     drawing_context_class->create_vbuffer = psy_gl_create_vbuffer;
     drawing_context_class->create_texture = psy_gl_create_texture;
+    drawing_context_class->create_gpu_timer = psy_gl_create_gpu_timer;
 }
 
 /* ************ public functions ******************** */
@@ -0,0 +1,173 @@
+
+#include <epoxy/gl.h>
+
+#include "psy-gl-gpu-timer.h"
+
+/**
+ * PsyGlGpuTimer:
+ *
+ * The OpenGL implementation of [class@GpuTimer]. It records timestamps with
+ * `GL_TIMESTAMP` queries. Other than `GL_TIME_ELAPSED` queries, timestamps
+ * may be nested, so the time of a whole frame and the time of the parts of
+ * it can be measured at once. Every frame uses its own set of query objects,
+ * and a set is only read back when it is reused.
+ *
+ * Timer queries require OpenGL 3.3 or the GL_ARB_timer_query extension,
+ * when they are unavailable, no timestamps are recorded.
+ */
+
+typedef struct _PsyGlGpuTimer {
+    PsyGpuTimer parent;
+    GArray     *queries[PSY_GPU_TIMER_NUM_FRAMES]; // GLuint query objects
+    guint       num_issued[PSY_GPU_TIMER_NUM_FRAMES];
+    guint       frame;   // the set of the current frame
+    gboolean    started; // whether begin_frame has been called
+    GArray     *results; // guint64 timestamps read back
+    gboolean    supported;
+} PsyGlGpuTimer;
+
+G_DEFINE_FINAL_TYPE(PsyGlGpuTimer, psy_gl_gpu_timer, PSY_TYPE_GPU_TIMER)
+
+static void
+psy_gl_gpu_timer_init(PsyGlGpuTimer *self)
+{
+    for (guint i = 0; i < PSY_GPU_TIMER_NUM_FRAMES; i++)
+        self->queries[i] = g_array_new(FALSE, TRUE, sizeof(GLuint));
+    self->results   = g_array_new(FALSE, TRUE, sizeof(guint64));
+    self->supported = psy_gl_gpu_timer_is_supported();
+}
+
+static void
+psy_gl_gpu_timer_finalize(GObject *object)
+{
+    PsyGlGpuTimer *self = PSY_GL_GPU_TIMER(object);
+
+    for (guint i = 0; i < PSY_GPU_TIMER_NUM_FRAMES; i++) {
+        GArray *queries = self->queries[i];
+        if (queries->len > 0)
+            glDeleteQueries(queries->len, (GLuint *) queries->data);
+        g_array_unref(queries);
+    }
+    g_array_unref(self->results);
+
+    G_OBJECT_CLASS(psy_gl_gpu_timer_parent_class)->finalize(object);
+}
+
+/*
+ * Reads back the timestamps of the set of queries, unless the GPU hasn't
+ * executed them all yet.
+ */
+static void
+gl_gpu_timer_read_back(PsyGlGpuTimer *self, guint frame)
+{
+    GArray *queries    = self->queries[frame];
+    guint   num_issued = self->num_issued[frame];
+    GLint   available  = 0;
+
+    g_array_set_size(self->results, 0);
+
+    if (num_issued == 0)
+        return;
+
+    // Queries complete in order, so the last one tells about all of them.
+    GLuint last = g_array_index(queries, GLuint, num_issued - 1);
+    glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+
+    g_array_set_size(self->results, num_issued);
+    for (guint i = 0; i < num_issued; i++) {
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(
+            g_array_index(queries, GLuint, i), GL_QUERY_RESULT, &timestamp);
+        g_array_index(self->results, guint64, i) = timestamp;
+    }
+}
+
+static void
+gl_gpu_timer_begin_frame(PsyGpuTimer *timer)
+{
+    PsyGlGpuTimer *self = PSY_GL_GPU_TIMER(timer);
+
+    if (!self->supported)
+        return;
+
+    if (self->started)
+        self->frame = (self->frame + 1) % PSY_GPU_TIMER_NUM_FRAMES;
+    self->started = TRUE;
+
+    gl_gpu_timer_read_back(self, self->frame);
+    self->num_issued[self->frame] = 0;
+}
+
+static guint
+gl_gpu_timer_query_timestamp(PsyGpuTimer *timer)
+{
+    PsyGlGpuTimer *self = PSY_GL_GPU_TIMER(timer);
+
+    if (!self->supported || !self->started)
+        return PSY_GPU_TIMER_INVALID;
+
+    GArray *queries = self->queries[self->frame];
+    guint   index   = self->num_issued[self->frame]++;
+
+    if (index == queries->len) {
+        GLuint query;
+        glGenQueries(1, &query);
+        g_array_append_val(queries, query);
+    }
+
+    glQueryCounter(g_array_index(queries, GLuint, index), GL_TIMESTAMP);
+    return index;
+}
+
+static const guint64 *
+gl_gpu_timer_get_results(PsyGpuTimer *timer, guint *num_results)
+{
+    PsyGlGpuTimer *self = PSY_GL_GPU_TIMER(timer);
+
+    *num_results = self->results->len;
+    return self->results->len ? (const guint64 *) self->results->data : NULL;
+}
+
+static void
+psy_gl_gpu_timer_class_init(PsyGlGpuTimerClass *klass)
+{
+    GObjectClass     *object_class = G_OBJECT_CLASS(klass);
+    PsyGpuTimerClass *timer_class  = PSY_GPU_TIMER_CLASS(klass);
+
+    object_class->finalize = psy_gl_gpu_timer_finalize;
+
+    timer_class->begin_frame     = gl_gpu_timer_begin_frame;
+    timer_class->query_timestamp = gl_gpu_timer_query_timestamp;
+    timer_class->get_results     = gl_gpu_timer_get_results;
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_gl_gpu_timer_new:(constructor)
+ *
+ * Creates a timer for the OpenGL context that is current.
+ *
+ * Returns: a new [class@GlGpuTimer]
+ */
+PsyGlGpuTimer *
+psy_gl_gpu_timer_new(void)
+{
+    return g_object_new(PSY_TYPE_GL_GPU_TIMER, NULL);
+}
+
+/**
+ * psy_gl_gpu_timer_is_supported:
+ *
+ * Returns: TRUE when the current OpenGL context supports timer queries.
+ */
+gboolean
+psy_gl_gpu_timer_is_supported(void)
+{
+    if (epoxy_is_desktop_gl())
+        return epoxy_gl_version() >= 33
+               || epoxy_has_gl_extension("GL_ARB_timer_query");
+    return FALSE;
+}
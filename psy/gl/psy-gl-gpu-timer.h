@@ -0,0 +1,20 @@
+
+#pragma once
+
+#include "psy-gpu-timer.h"
+
+G_BEGIN_DECLS
+
+#define PSY_TYPE_GL_GPU_TIMER psy_gl_gpu_timer_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyGlGpuTimer, psy_gl_gpu_timer, PSY, GL_GPU_TIMER, PsyGpuTimer)
+
+G_MODULE_EXPORT PsyGlGpuTimer *
+psy_gl_gpu_timer_new(void);
+
+G_MODULE_EXPORT gboolean
+psy_gl_gpu_timer_is_supported(void);
+
+G_END_DECLS
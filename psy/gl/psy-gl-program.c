@@ -4,6 +4,7 @@
 #include "psy-gl-error.h"
 #include "psy-gl-fragment-shader.h"
 #include "psy-gl-shader.h"
+#include "psy-gl-state.h"
 #include "psy-gl-vertex-shader.h"
 #include "psy-shader.h"
 
@@ -14,6 +15,7 @@ typedef struct _PsyGlProgram {
     PsyShaderProgram parent;
     GLuint           object_id;
     guint            is_linked : 1;
+    GHashTable      *uniforms; // name -> location of the active uniforms
 } PsyGlProgram;
 
 G_DEFINE_TYPE(PsyGlProgram, psy_gl_program, PSY_TYPE_SHADER_PROGRAM)
@@ -52,6 +54,8 @@ psy_gl_program_init(PsyGlProgram *self)
 {
     self->object_id = 0;
     self->is_linked = 0;
+    self->uniforms
+        = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 }
 
 static void
@@ -61,11 +65,14 @@ psy_gl_program_finalize(GObject *object)
     // PsyGlProgramPrivate* priv = psy_gl_program_get_instance_private(self);
 
     if (self->object_id) {
+        psy_gl_state_forget_program(self->object_id);
         glDeleteProgram(self->object_id);
         self->object_id = 0;
         self->is_linked = 0;
     }
 
+    g_hash_table_destroy(self->uniforms);
+
     G_OBJECT_CLASS(psy_gl_program_parent_class)->finalize(object);
 }
 
@@ -167,6 +174,48 @@ psy_gl_program_set_fragment_shader_from_path(PsyShaderProgram *program,
     klass->set_fragment_shader(program, PSY_SHADER(shader), error);
 }
 
+/*
+ * Stores the locations of all active uniforms, so setting a uniform by name
+ * doesn't need to query the driver. Arrays are reported as "name[0]", they
+ * are stored under "name" as well.
+ */
+static void
+psy_gl_program_introspect_uniforms(PsyGlProgram *self)
+{
+    GLint num_uniforms = 0, max_length = 0;
+
+    g_hash_table_remove_all(self->uniforms);
+
+    glGetProgramiv(self->object_id, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    glGetProgramiv(self->object_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    gchar *name = g_malloc(max_length + 1);
+
+    for (GLint i = 0; i < num_uniforms; i++) {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+
+        glGetActiveUniform(
+            self->object_id, i, max_length + 1, &length, &size, &type, name);
+
+        GLint location = glGetUniformLocation(self->object_id, name);
+        if (location < 0)
+            continue; // e.g. a member of a uniform block
+
+        g_hash_table_insert(
+            self->uniforms, g_strdup(name), GINT_TO_POINTER(location));
+
+        if (g_str_has_suffix(name, "[0]")) {
+            g_hash_table_insert(self->uniforms,
+                                g_strndup(name, length - 3),
+                                GINT_TO_POINTER(location));
+        }
+    }
+
+    g_free(name);
+}
+
 static void
 psy_gl_program_link(PsyShaderProgram *program, GError **error)
 {
@@ -218,6 +267,8 @@ psy_gl_program_link(PsyShaderProgram *program, GError **error)
         return;
     }
     self->is_linked = true;
+
+    psy_gl_program_introspect_uniforms(self);
 }
 
 static gboolean
@@ -236,56 +287,97 @@ psy_gl_program_use_program(PsyShaderProgram *self, GError **error)
             return;
     }
     PsyGlProgram *gl_program = PSY_GL_PROGRAM(self);
-    glUseProgram(gl_program->object_id);
+    psy_gl_state_use_program(gl_program->object_id);
     psy_gl_check_error(error);
 }
 
-static void
-psy_gl_program_set_uniform_matrix_4(PsyShaderProgram *self,
-                                    const gchar      *name,
-                                    PsyMatrix4       *matrix,
-                                    GError          **error)
+static gint
+psy_gl_program_get_uniform_handle(PsyShaderProgram *self,
+                                  const gchar      *name,
+                                  GError          **error)
 {
-    PsyGlProgram *program = PSY_GL_PROGRAM(self);
-    GLfloat       elements[16];
-    psy_matrix4_get_elements(matrix, elements);
+    PsyGlProgram *program  = PSY_GL_PROGRAM(self);
+    gpointer      location = NULL;
 
-    GLint location = glGetUniformLocation(program->object_id, name);
-    if (psy_gl_check_error(error))
-        return;
-    if (location == -1) {
+    if (!g_hash_table_lookup_extended(
+            program->uniforms, name, NULL, &location)) {
         g_set_error(error,
                     PSY_GL_ERROR,
                     PSY_GL_ERROR_INVALID_VALUE,
-                    "no matrix uniform with name '%s",
+                    "no active uniform with name '%s'",
                     name);
-        return;
+        return -1;
     }
 
-    glUniformMatrix4fv(location, 1, GL_FALSE, elements);
+    return GPOINTER_TO_INT(location);
 }
 
 static void
-psy_gl_program_set_uniform_4f(PsyShaderProgram *self,
-                              const gchar      *name,
-                              gfloat           *values,
-                              GError          **error)
+psy_gl_program_set_uniform_matrix_4_by_handle(PsyShaderProgram *self,
+                                              gint              handle,
+                                              PsyMatrix4       *matrix,
+                                              GError          **error)
 {
-    PsyGlProgram *program = PSY_GL_PROGRAM(self);
+    (void) self;
+    GLfloat elements[16];
 
-    GLint location = glGetUniformLocation(program->object_id, name);
-    if (psy_gl_check_error(error))
+    if (handle < 0) {
+        g_set_error(error,
+                    PSY_GL_ERROR,
+                    PSY_GL_ERROR_INVALID_VALUE,
+                    "invalid uniform handle %d",
+                    handle);
         return;
-    if (location == -1) {
+    }
+
+    psy_matrix4_get_elements(matrix, elements);
+    glUniformMatrix4fv(handle, 1, GL_FALSE, elements);
+}
+
+static void
+psy_gl_program_set_uniform_4f_by_handle(PsyShaderProgram *self,
+                                        gint              handle,
+                                        gfloat           *values,
+                                        GError          **error)
+{
+    (void) self;
+
+    if (handle < 0) {
         g_set_error(error,
                     PSY_GL_ERROR,
                     PSY_GL_ERROR_INVALID_VALUE,
-                    "no uniform_4f with name '%s",
-                    name);
+                    "invalid uniform handle %d",
+                    handle);
         return;
     }
 
-    glUniform4f(location, values[0], values[1], values[2], values[3]);
+    glUniform4f(handle, values[0], values[1], values[2], values[3]);
+}
+
+static void
+psy_gl_program_set_uniform_matrix_4(PsyShaderProgram *self,
+                                    const gchar      *name,
+                                    PsyMatrix4       *matrix,
+                                    GError          **error)
+{
+    gint handle = psy_gl_program_get_uniform_handle(self, name, error);
+    if (handle < 0)
+        return;
+
+    psy_gl_program_set_uniform_matrix_4_by_handle(self, handle, matrix, error);
+}
+
+static void
+psy_gl_program_set_uniform_4f(PsyShaderProgram *self,
+                              const gchar      *name,
+                              gfloat           *values,
+                              GError          **error)
+{
+    gint handle = psy_gl_program_get_uniform_handle(self, name, error);
+    if (handle < 0)
+        return;
+
+    psy_gl_program_set_uniform_4f_by_handle(self, handle, values, error);
 }
 
 static void
@@ -318,6 +410,12 @@ psy_gl_program_class_init(PsyGlProgramClass *class)
     program_class->set_uniform_matrix4 = psy_gl_program_set_uniform_matrix_4;
     program_class->set_uniform_4f      = psy_gl_program_set_uniform_4f;
 
+    program_class->get_uniform_handle = psy_gl_program_get_uniform_handle;
+    program_class->set_uniform_matrix4_by_handle
+        = psy_gl_program_set_uniform_matrix_4_by_handle;
+    program_class->set_uniform_4f_by_handle
+        = psy_gl_program_set_uniform_4f_by_handle;
+
     gl_program_properties[PROP_OBJECT_ID]
         = g_param_spec_uint("object-id",
                             "Object ID",
@@ -0,0 +1,419 @@
+
+#include <epoxy/egl.h>
+
+#include "psy-gl-render-pool.h"
+
+/**
+ * PsyGlRenderPool:
+ *
+ * A PsyGlRenderPool renders images offscreen on several threads at once. It
+ * runs a number of workers, each in its own thread with its own
+ * [class@GlCanvas] and hence its own OpenGL context. Jobs are queued with
+ * [method@GlRenderPool.push]: a worker resets its canvas, lets the
+ * [callback@GlRenderFunc] of the job build the scene, draws the requested
+ * number of frames and returns the last frame as [class@Image], which is
+ * obtained with [method@GlRenderPool.pop].
+ *
+ * As every worker has an independent context, generating a large set of
+ * stimuli scales with the number of cores, also with a software rasterizer
+ * such as Mesa's llvmpipe. llvmpipe uses several threads per context
+ * itself, so when all cores are busy with workers, setting the environment
+ * variable LP_NUM_THREADS to 1 avoids oversubscribing them.
+ *
+ * The workers don't share OpenGL objects, a texture is uploaded by every
+ * worker that draws it. Data such as a decoded [class@Image] may be shared
+ * by jobs, as long as no job modifies it.
+ */
+
+/*
+ * A job with a NULL func tells a worker to stop.
+ */
+typedef struct RenderJob {
+    guint64         id;
+    PsyGlRenderFunc func;
+    gpointer        data;
+    GDestroyNotify  destroy;
+    guint           num_frames;
+} RenderJob;
+
+typedef struct RenderResult {
+    guint64   id;
+    PsyImage *image;
+} RenderResult;
+
+static void
+render_job_free(RenderJob *job)
+{
+    if (job->destroy)
+        job->destroy(job->data);
+    g_free(job);
+}
+
+static void
+render_result_free(RenderResult *result)
+{
+    g_clear_object(&result->image);
+    g_free(result);
+}
+
+typedef struct _PsyGlRenderPool {
+    GObject parent;
+
+    gint  width, height;
+    guint num_workers;
+
+    GPtrArray   *threads;
+    GAsyncQueue *jobs;
+    GAsyncQueue *results;
+    guint64      next_id;
+    gint         num_pending; // atomic, jobs pushed but not popped
+} PsyGlRenderPool;
+
+G_DEFINE_FINAL_TYPE(PsyGlRenderPool, psy_gl_render_pool, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_WIDTH,
+    PROP_HEIGHT,
+    PROP_NUM_WORKERS,
+    NUM_PROPERTIES
+} PsyGlRenderPoolProperty;
+
+static GParamSpec *render_pool_properties[NUM_PROPERTIES];
+
+static void
+psy_gl_render_pool_set_property(GObject      *object,
+                                guint         prop_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+    PsyGlRenderPool *self = PSY_GL_RENDER_POOL(object);
+
+    switch ((PsyGlRenderPoolProperty) prop_id) {
+    case PROP_WIDTH:
+        self->width = g_value_get_int(value);
+        break;
+    case PROP_HEIGHT:
+        self->height = g_value_get_int(value);
+        break;
+    case PROP_NUM_WORKERS:
+        self->num_workers = g_value_get_uint(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_gl_render_pool_get_property(GObject    *object,
+                                guint       prop_id,
+                                GValue     *value,
+                                GParamSpec *pspec)
+{
+    PsyGlRenderPool *self = PSY_GL_RENDER_POOL(object);
+
+    switch ((PsyGlRenderPoolProperty) prop_id) {
+    case PROP_WIDTH:
+        g_value_set_int(value, self->width);
+        break;
+    case PROP_HEIGHT:
+        g_value_set_int(value, self->height);
+        break;
+    case PROP_NUM_WORKERS:
+        g_value_set_uint(value, self->num_workers);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static gpointer
+render_pool_worker(gpointer data)
+{
+    PsyGlRenderPool *self = data; // outlives its workers, see dispose
+
+    // The context of the canvas is bound to this thread.
+    PsyGlCanvas    *glcanvas = psy_gl_canvas_new(self->width, self->height);
+    PsyImageCanvas *canvas   = PSY_IMAGE_CANVAS(glcanvas);
+
+    while (TRUE) {
+        RenderJob *job = g_async_queue_pop(self->jobs);
+        if (!job->func) {
+            render_job_free(job);
+            break;
+        }
+
+        psy_canvas_reset(PSY_CANVAS(canvas));
+        job->func(canvas, job->data);
+        for (guint i = 0; i < job->num_frames; i++)
+            psy_image_canvas_iterate(canvas);
+
+        RenderResult *result = g_new(RenderResult, 1);
+        result->id           = job->id;
+        result->image        = psy_canvas_get_image(PSY_CANVAS(canvas));
+
+        // Release the data of the job before the result is handed out.
+        render_job_free(job);
+        g_async_queue_push(self->results, result);
+    }
+
+    g_object_unref(glcanvas);
+    eglReleaseThread();
+    return NULL;
+}
+
+static void
+psy_gl_render_pool_init(PsyGlRenderPool *self)
+{
+    self->threads = g_ptr_array_new();
+    self->jobs    = g_async_queue_new_full((GDestroyNotify) render_job_free);
+    self->results
+        = g_async_queue_new_full((GDestroyNotify) render_result_free);
+}
+
+static void
+psy_gl_render_pool_constructed(GObject *object)
+{
+    PsyGlRenderPool *self = PSY_GL_RENDER_POOL(object);
+
+    G_OBJECT_CLASS(psy_gl_render_pool_parent_class)->constructed(object);
+
+    if (self->num_workers == 0)
+        self->num_workers = g_get_num_processors();
+
+    for (guint i = 0; i < self->num_workers; i++) {
+        gchar   *name   = g_strdup_printf("psy-render-%u", i);
+        GThread *thread = g_thread_new(name, render_pool_worker, self);
+        g_ptr_array_add(self->threads, thread);
+        g_free(name);
+    }
+}
+
+static void
+psy_gl_render_pool_dispose(GObject *object)
+{
+    PsyGlRenderPool *self = PSY_GL_RENDER_POOL(object);
+
+    // Discard the jobs that haven't started and stop the workers.
+    RenderJob *job;
+    while ((job = g_async_queue_try_pop(self->jobs)) != NULL)
+        render_job_free(job);
+
+    for (guint i = 0; i < self->threads->len; i++)
+        g_async_queue_push(self->jobs, g_new0(RenderJob, 1));
+
+    for (guint i = 0; i < self->threads->len; i++)
+        g_thread_join(g_ptr_array_index(self->threads, i));
+    g_ptr_array_set_size(self->threads, 0);
+
+    G_OBJECT_CLASS(psy_gl_render_pool_parent_class)->dispose(object);
+}
+
+static void
+psy_gl_render_pool_finalize(GObject *object)
+{
+    PsyGlRenderPool *self = PSY_GL_RENDER_POOL(object);
+
+    g_ptr_array_unref(self->threads);
+    g_async_queue_unref(self->jobs);
+    g_async_queue_unref(self->results);
+
+    G_OBJECT_CLASS(psy_gl_render_pool_parent_class)->finalize(object);
+}
+
+static void
+psy_gl_render_pool_class_init(PsyGlRenderPoolClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = psy_gl_render_pool_set_property;
+    object_class->get_property = psy_gl_render_pool_get_property;
+    object_class->constructed  = psy_gl_render_pool_constructed;
+    object_class->dispose      = psy_gl_render_pool_dispose;
+    object_class->finalize     = psy_gl_render_pool_finalize;
+
+    /**
+     * PsyGlRenderPool:width:
+     *
+     * The width of the canvases of the workers and of the rendered images.
+     */
+    render_pool_properties[PROP_WIDTH]
+        = g_param_spec_int("width",
+                           "Width",
+                           "The width of the rendered images",
+                           1,
+                           G_MAXINT,
+                           640,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyGlRenderPool:height:
+     *
+     * The height of the canvases of the workers and of the rendered images.
+     */
+    render_pool_properties[PROP_HEIGHT]
+        = g_param_spec_int("height",
+                           "Height",
+                           "The height of the rendered images",
+                           1,
+                           G_MAXINT,
+                           480,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyGlRenderPool:num-workers:
+     *
+     * The number of workers that render in parallel. When 0 is specified,
+     * there is a worker for every processor.
+     */
+    render_pool_properties[PROP_NUM_WORKERS]
+        = g_param_spec_uint("num-workers",
+                            "NumWorkers",
+                            "The number of threads that render",
+                            0,
+                            G_MAXUINT,
+                            0,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    g_object_class_install_properties(
+        object_class, NUM_PROPERTIES, render_pool_properties);
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_gl_render_pool_new:(constructor)
+ * @width: the width of the rendered images
+ * @height: the height of the rendered images
+ * @num_workers: the number of threads that render, or 0 for one thread per
+ *               processor
+ *
+ * Creates a pool and starts its workers.
+ *
+ * Returns: a new [class@GlRenderPool]
+ */
+PsyGlRenderPool *
+psy_gl_render_pool_new(gint width, gint height, guint num_workers)
+{
+    // clang-format off
+    return g_object_new(PSY_TYPE_GL_RENDER_POOL,
+                        "width", width,
+                        "height", height,
+                        "num-workers", num_workers,
+                        NULL);
+    // clang-format on
+}
+
+/**
+ * psy_gl_render_pool_free:(skip)
+ * @self: an instance of [class@GlRenderPool]
+ *
+ * Frees instances of [class@GlRenderPool]. Jobs that haven't started are
+ * discarded, this waits for the jobs that are being rendered.
+ */
+void
+psy_gl_render_pool_free(PsyGlRenderPool *self)
+{
+    g_return_if_fail(PSY_IS_GL_RENDER_POOL(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_gl_render_pool_get_num_workers:
+ * @self: an instance of [class@GlRenderPool]
+ *
+ * Returns: the number of threads that render
+ */
+guint
+psy_gl_render_pool_get_num_workers(PsyGlRenderPool *self)
+{
+    g_return_val_if_fail(PSY_IS_GL_RENDER_POOL(self), 0);
+    return self->num_workers;
+}
+
+/**
+ * psy_gl_render_pool_push:
+ * @self: an instance of [class@GlRenderPool]
+ * @func:(scope notified)(closure job_data): builds the scene of the job
+ * @job_data: the data passed to @func
+ * @destroy:(nullable): frees @job_data when the job is done or discarded
+ * @num_frames: the number of frames to draw, the image of the last frame
+ *              is the result of the job
+ *
+ * Queues a job that is rendered by the first worker that is available.
+ * The job is rendered on a freshly reset canvas, so @func should play its
+ * stimuli at the time of the canvas. Jobs are pushed and popped from the
+ * same thread.
+ *
+ * Returns: the id of the job, [method@GlRenderPool.pop] returns it along
+ *          with the image.
+ */
+guint64
+psy_gl_render_pool_push(PsyGlRenderPool *self,
+                        PsyGlRenderFunc  func,
+                        gpointer         job_data,
+                        GDestroyNotify   destroy,
+                        guint            num_frames)
+{
+    g_return_val_if_fail(PSY_IS_GL_RENDER_POOL(self), 0);
+    g_return_val_if_fail(func != NULL, 0);
+    g_return_val_if_fail(num_frames > 0, 0);
+
+    guint64    id   = self->next_id++;
+    RenderJob *job  = g_new(RenderJob, 1);
+    job->id         = id;
+    job->func       = func;
+    job->data       = job_data;
+    job->destroy    = destroy;
+    job->num_frames = num_frames;
+
+    // A worker may render and free the job as soon as it is pushed.
+    g_atomic_int_inc(&self->num_pending);
+    g_async_queue_push(self->jobs, job);
+
+    return id;
+}
+
+/**
+ * psy_gl_render_pool_pop:
+ * @self: an instance of [class@GlRenderPool]
+ * @job_id:(out)(optional): the id of the job of the image
+ *
+ * Waits for a job to complete. The jobs are rendered in parallel, so they
+ * don't necessarily complete in the order in which they were pushed.
+ *
+ * Returns:(transfer full)(nullable): the image of a completed job, or NULL
+ *          when no jobs are pending.
+ */
+PsyImage *
+psy_gl_render_pool_pop(PsyGlRenderPool *self, guint64 *job_id)
+{
+    g_return_val_if_fail(PSY_IS_GL_RENDER_POOL(self), NULL);
+
+    if (g_atomic_int_get(&self->num_pending) == 0)
+        return NULL;
+
+    RenderResult *result = g_async_queue_pop(self->results);
+    g_atomic_int_dec_and_test(&self->num_pending);
+
+    PsyImage *image = g_steal_pointer(&result->image);
+    if (job_id)
+        *job_id = result->id;
+    render_result_free(result);
+
+    return image;
+}
+
+/**
+ * psy_gl_render_pool_get_num_pending:
+ * @self: an instance of [class@GlRenderPool]
+ *
+ * Returns: the number of jobs that have been pushed, but whose images
+ *          haven't been popped yet
+ */
+guint
+psy_gl_render_pool_get_num_pending(PsyGlRenderPool *self)
+{
+    g_return_val_if_fail(PSY_IS_GL_RENDER_POOL(self), 0);
+    return (guint) g_atomic_int_get(&self->num_pending);
+}
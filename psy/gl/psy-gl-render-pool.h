@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include "psy-gl-canvas.h"
+
+G_BEGIN_DECLS
+
+/**
+ * PsyGlRenderFunc:
+ * @canvas: the canvas of the worker that renders the job
+ * @job_data: the data that was passed along with the job
+ *
+ * A function that builds the scene of a job on @canvas, e.g. it creates
+ * stimuli for @canvas and plays them at the time of @canvas. It's called
+ * in the thread of a worker.
+ */
+typedef void (*PsyGlRenderFunc)(PsyImageCanvas *canvas, gpointer job_data);
+
+#define PSY_TYPE_GL_RENDER_POOL psy_gl_render_pool_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyGlRenderPool, psy_gl_render_pool, PSY, GL_RENDER_POOL, GObject)
+
+G_MODULE_EXPORT PsyGlRenderPool *
+psy_gl_render_pool_new(gint width, gint height, guint num_workers);
+
+G_MODULE_EXPORT void
+psy_gl_render_pool_free(PsyGlRenderPool *self);
+
+G_MODULE_EXPORT guint
+psy_gl_render_pool_get_num_workers(PsyGlRenderPool *self);
+
+G_MODULE_EXPORT guint64
+psy_gl_render_pool_push(PsyGlRenderPool *self,
+                        PsyGlRenderFunc  func,
+                        gpointer         job_data,
+                        GDestroyNotify   destroy,
+                        guint            num_frames);
+
+G_MODULE_EXPORT PsyImage *
+psy_gl_render_pool_pop(PsyGlRenderPool *self, guint64 *job_id);
+
+G_MODULE_EXPORT guint
+psy_gl_render_pool_get_num_pending(PsyGlRenderPool *self);
+
+G_END_DECLS
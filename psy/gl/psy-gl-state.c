@@ -0,0 +1,186 @@
+
+#include "psy-gl-state.h"
+
+/*
+ * A small cache of the OpenGL state that psylib changes most while drawing:
+ * the program in use, the active texture unit, the 2D texture bound to it
+ * and the vertex array. Calls that would bind what is bound already are
+ * skipped, this matters when consecutive stimuli share their program,
+ * texture or mesh.
+ *
+ * A context is current in one thread, so the cache is kept per thread. The
+ * cached names belong to the context that is current, hence every site that
+ * makes a context current must invalidate the cache. Other code, e.g. GTK,
+ * may change the state between frames, so the canvases invalidate the cache
+ * at the start of every frame as well. When an object is deleted, its name
+ * may be reused by OpenGL, so it must be forgotten.
+ */
+
+typedef struct GlState {
+    gboolean valid;
+    GLuint   program;
+    GLenum   active_texture;
+    GLuint   texture_2d; // bound to active_texture
+    GLuint   vertex_array;
+} GlState;
+
+static GPrivate gl_state_key = G_PRIVATE_INIT(g_free);
+
+static GlState *
+gl_state_get(void)
+{
+    GlState *state = g_private_get(&gl_state_key);
+    if (!state) {
+        state = g_new0(GlState, 1);
+        g_private_set(&gl_state_key, state);
+    }
+    return state;
+}
+
+/**
+ * psy_gl_state_invalidate:(skip)
+ *
+ * Forgets the cached state, the next calls will set the state again.
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_invalidate(void)
+{
+    gl_state_get()->valid = FALSE;
+}
+
+static GlState *
+gl_state_get_valid(void)
+{
+    GlState *state = gl_state_get();
+    if (!state->valid) {
+        // Make sure the next calls do reach OpenGL
+        state->program        = G_MAXUINT;
+        state->active_texture = 0;
+        state->texture_2d     = G_MAXUINT;
+        state->vertex_array   = G_MAXUINT;
+        state->valid          = TRUE;
+    }
+    return state;
+}
+
+/**
+ * psy_gl_state_use_program:(skip)
+ * @program: the name of the OpenGL program
+ *
+ * Calls glUseProgram, unless @program is in use already.
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_use_program(GLuint program)
+{
+    GlState *state = gl_state_get_valid();
+    if (state->program == program)
+        return;
+
+    glUseProgram(program);
+    state->program = program;
+}
+
+/**
+ * psy_gl_state_active_texture:(skip)
+ * @unit: the texture unit, e.g. GL_TEXTURE0
+ *
+ * Calls glActiveTexture, unless @unit is active already.
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_active_texture(GLenum unit)
+{
+    GlState *state = gl_state_get_valid();
+    if (state->active_texture == unit)
+        return;
+
+    glActiveTexture(unit);
+    state->active_texture = unit;
+    state->texture_2d     = G_MAXUINT; // unknown for this unit
+}
+
+/**
+ * psy_gl_state_bind_texture_2d:(skip)
+ * @texture: the name of the OpenGL texture
+ *
+ * Binds @texture to the GL_TEXTURE_2D target of the active texture unit,
+ * unless it is bound already.
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_bind_texture_2d(GLuint texture)
+{
+    GlState *state = gl_state_get_valid();
+    if (state->texture_2d == texture)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    state->texture_2d = texture;
+}
+
+/**
+ * psy_gl_state_bind_vertex_array:(skip)
+ * @vertex_array: the name of the OpenGL vertex array object
+ *
+ * Calls glBindVertexArray, unless @vertex_array is bound already.
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_bind_vertex_array(GLuint vertex_array)
+{
+    GlState *state = gl_state_get_valid();
+    if (state->vertex_array == vertex_array)
+        return;
+
+    glBindVertexArray(vertex_array);
+    state->vertex_array = vertex_array;
+}
+
+/**
+ * psy_gl_state_forget_program:(skip)
+ * @program: the name of a program that is deleted
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_forget_program(GLuint program)
+{
+    GlState *state = gl_state_get();
+    if (state->program == program)
+        state->valid = FALSE;
+}
+
+/**
+ * psy_gl_state_forget_texture:(skip)
+ * @texture: the name of a texture that is deleted
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_forget_texture(GLuint texture)
+{
+    GlState *state = gl_state_get();
+    if (state->texture_2d == texture)
+        state->valid = FALSE;
+}
+
+/**
+ * psy_gl_state_forget_vertex_array:(skip)
+ * @vertex_array: the name of a vertex array that is deleted
+ *
+ * Stability: private
+ */
+void
+psy_gl_state_forget_vertex_array(GLuint vertex_array)
+{
+    GlState *state = gl_state_get();
+    if (state->vertex_array == vertex_array)
+        state->valid = FALSE;
+}
@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <epoxy/gl.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void
+psy_gl_state_invalidate(void);
+
+void
+psy_gl_state_use_program(GLuint program);
+
+void
+psy_gl_state_active_texture(GLenum unit);
+
+void
+psy_gl_state_bind_texture_2d(GLuint texture);
+
+void
+psy_gl_state_bind_vertex_array(GLuint vertex_array);
+
+void
+psy_gl_state_forget_program(GLuint program);
+
+void
+psy_gl_state_forget_texture(GLuint texture);
+
+void
+psy_gl_state_forget_vertex_array(GLuint vertex_array);
+
+G_END_DECLS
@@ -1,14 +1,19 @@
 
 #include <epoxy/gl.h>
+#include <string.h>
 
 #include "../psy-enums.h"
 #include "psy-gl-error.h"
+#include "psy-gl-state.h"
 #include "psy-gl-texture.h"
 
 typedef struct _PsyGlTexture {
     PsyTexture parent;
     guint      object_id;
+    GLuint     pbo_id; // the staging buffer of a pending upload
+    GLsync     fence;  // signals the end of a pending upload
     guint      is_uploaded : 1;
+    guint      mipmaps_dirty : 1; // regenerated when bound the next time
 } PsyGlTexture;
 
 G_DEFINE_TYPE(PsyGlTexture, psy_gl_texture, PSY_TYPE_TEXTURE)
@@ -64,12 +69,30 @@ psy_gl_texture_dispose(GObject *object)
     G_OBJECT_CLASS(psy_gl_texture_parent_class)->dispose(object);
 }
 
+/*
+ * Releases the staging buffer and fence of a pending upload.
+ */
+static void
+gl_texture_clear_pending(PsyGlTexture *self)
+{
+    if (self->fence) {
+        glDeleteSync(self->fence);
+        self->fence = NULL;
+    }
+    if (self->pbo_id) {
+        glDeleteBuffers(1, &self->pbo_id);
+        self->pbo_id = 0;
+    }
+}
+
 static void
 psy_gl_texture_finalize(GObject *object)
 {
     PsyGlTexture *self = PSY_GL_TEXTURE(object);
 
+    gl_texture_clear_pending(self);
     if (self->object_id) {
+        psy_gl_state_forget_texture(self->object_id);
         glDeleteTextures(1, &self->object_id);
         self->object_id = 0;
     }
@@ -77,57 +100,78 @@ psy_gl_texture_finalize(GObject *object)
     G_OBJECT_CLASS(psy_gl_texture_parent_class)->finalize(object);
 }
 
-static void
-psy_gl_texture_upload(PsyTexture *self, GError **error)
+/*
+ * Checks whether the decoded image of the texture can be uploaded and
+ * returns its pixel format.
+ */
+static GLenum
+gl_texture_get_upload_format(PsyTexture *self, GError **error)
 {
-    PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
-
-    const guint8 *source       = psy_texture_get_data(PSY_TEXTURE(self));
-    gint          width        = (int) psy_texture_get_width(self);
-    gint          height       = (int) psy_texture_get_height(self);
-    guint         num_channels = psy_texture_get_num_channels(self);
+    guint width        = psy_texture_get_width(self);
+    guint height       = psy_texture_get_height(self);
+    guint num_channels = psy_texture_get_num_channels(self);
 
-    if (!source) {
+    if (!psy_texture_get_data(self)) {
         g_set_error(error,
                     PSY_TEXTURE_ERROR,
                     PSY_TEXTURE_ERROR_FAILED,
                     "The texture has not any data to upload");
-        return;
+        return 0;
     }
-    if (!width) {
+    if (!width || !height) {
         g_set_error(error,
                     PSY_TEXTURE_ERROR,
                     PSY_TEXTURE_ERROR_FAILED,
-                    "The width of the texture is %u",
-                    width);
-    }
-    if (!height) {
-        g_set_error(error,
-                    PSY_TEXTURE_ERROR,
-                    PSY_TEXTURE_ERROR_FAILED,
-                    "The height of the texture is %u",
+                    "The size of the texture is %u * %u",
+                    width,
                     height);
+        return 0;
     }
-    if (!num_channels) {
+
+    switch (num_channels) {
+    case 1:
+        return GL_LUMINANCE; // May break glTexImage2d below...
+    case 2:
+        return GL_LUMINANCE_ALPHA; // May break glTexImage2d below...
+    case 3:
+        return GL_RGB;
+    case 4:
+        return GL_RGBA;
+    default:
         g_set_error(error,
                     PSY_TEXTURE_ERROR,
                     PSY_TEXTURE_ERROR_FAILED,
                     "The the texture num channels is %u",
                     num_channels);
+        return 0;
     }
+}
 
-    if (gl_self->object_id)
-        glDeleteTextures(1, &gl_self->object_id);
+/*
+ * (Re)creates the texture object and specifies its image. When a pixel
+ * unpack buffer is bound, source is an offset in that buffer and the transfer
+ * is executed by the GL implementation in the background.
+ */
+static void
+gl_texture_specify_image(PsyGlTexture *self,
+                         GLenum        pix_format,
+                         const void   *source,
+                         GError      **error)
+{
+    gint width  = (gint) psy_texture_get_width(PSY_TEXTURE(self));
+    gint height = (gint) psy_texture_get_height(PSY_TEXTURE(self));
 
-    glGenTextures(1, &gl_self->object_id);
-    if (psy_gl_check_error(error))
-        return;
+    if (self->object_id) {
+        psy_gl_state_forget_texture(self->object_id);
+        glDeleteTextures(1, &self->object_id);
+    }
 
-    glActiveTexture(GL_TEXTURE0);
+    glGenTextures(1, &self->object_id);
     if (psy_gl_check_error(error))
         return;
 
-    glBindTexture(GL_TEXTURE_2D, gl_self->object_id);
+    psy_gl_state_active_texture(GL_TEXTURE0);
+    psy_gl_state_bind_texture_2d(self->object_id);
     if (psy_gl_check_error(error))
         return;
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -145,49 +189,165 @@ psy_gl_texture_upload(PsyTexture *self, GError **error)
     if (psy_gl_check_error(error))
         return;
 
-    int pix_format = 0;
-    switch (num_channels) {
-    case 1:
-        pix_format = GL_LUMINANCE;
-        break; // May break glTexImage2d below...
-    case 2:
-        pix_format = GL_LUMINANCE_ALPHA;
-        break; // May break glTexImage2d below...
-    case 3:
-        pix_format = GL_RGB;
-        break;
-    case 4:
-        pix_format = GL_RGBA;
-        break;
-    default:
-        g_assert_not_reached();
-    }
-    if (pix_format == 0) {
-        g_assert(pix_format != 0);
-        g_critical("The texture has a unsupported number of channels");
-    }
-
+    // The rows of a decoded image are tightly packed.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D,
                  0,
-                 pix_format,
+                 (GLint) pix_format,
                  width,
                  height,
                  0,
                  pix_format,
                  GL_UNSIGNED_BYTE,
                  source);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     if (psy_gl_check_error(
             error)) // If an error happens here check case 1 and 2 above.
         return;
 
     glGenerateMipmap(GL_TEXTURE_2D);
-    if (psy_gl_check_error(
-            error)) // If an error happens here check case 1 and 2 above.
+    psy_gl_check_error(error);
+}
+
+/*
+ * Waits at most timeout_ns for the fence of a pending upload, a timeout of
+ * 0 just polls the fence.
+ */
+static gboolean
+gl_texture_wait_fence(PsyGlTexture *self, GLuint64 timeout_ns)
+{
+    if (!self->fence)
+        return self->is_uploaded;
+
+    GLenum status
+        = glClientWaitSync(self->fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+
+    switch (status) {
+    case GL_ALREADY_SIGNALED:
+    case GL_CONDITION_SATISFIED:
+        break;
+    case GL_WAIT_FAILED:
+        // The commands are still ordered, so drawing with the texture waits
+        // for the transfer anyway.
+        g_warning("Unable to wait for the upload of texture %s",
+                  psy_texture_get_filename(PSY_TEXTURE(self)));
+        break;
+    case GL_TIMEOUT_EXPIRED:
+    default:
+        return FALSE;
+    }
+
+    gl_texture_clear_pending(self);
+    self->is_uploaded = TRUE;
+    return TRUE;
+}
+
+static void
+psy_gl_texture_upload(PsyTexture *self, GError **error)
+{
+    PsyGlTexture *gl_self     = PSY_GL_TEXTURE(self);
+    GError       *local_error = NULL;
+
+    GLenum pix_format = gl_texture_get_upload_format(self, &local_error);
+    if (local_error) {
+        g_propagate_error(error, local_error);
+        return;
+    }
+
+    gl_texture_clear_pending(gl_self);
+    gl_self->is_uploaded = FALSE;
+
+    gl_texture_specify_image(
+        gl_self, pix_format, psy_texture_get_data(self), &local_error);
+    if (local_error) {
+        g_propagate_error(error, local_error);
         return;
+    }
 
     gl_self->is_uploaded = TRUE;
 }
 
+/*
+ * Copies the decoded image into a pixel buffer object and lets the GL
+ * implementation transfer it to the texture in the background. A fence marks
+ * the end of the transfer and mipmap generation.
+ */
+static void
+psy_gl_texture_upload_async(PsyTexture *self, GError **error)
+{
+    PsyGlTexture *gl_self     = PSY_GL_TEXTURE(self);
+    GError       *local_error = NULL;
+
+    GLenum pix_format = gl_texture_get_upload_format(self, &local_error);
+    if (local_error) {
+        g_propagate_error(error, local_error);
+        return;
+    }
+
+    gl_texture_clear_pending(gl_self);
+    gl_self->is_uploaded = FALSE;
+
+    GLsizeiptr num_bytes = (GLsizeiptr) psy_texture_get_width(self)
+                           * psy_texture_get_height(self)
+                           * psy_texture_get_num_channels(self);
+
+    glGenBuffers(1, &gl_self->pbo_id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_self->pbo_id);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, num_bytes, NULL, GL_STREAM_DRAW);
+    if (psy_gl_check_error(&local_error))
+        goto unbind;
+
+    void *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                     0,
+                                     num_bytes,
+                                     GL_MAP_WRITE_BIT
+                                         | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!staging) {
+        psy_gl_check_error(&local_error);
+        if (!local_error)
+            g_set_error(&local_error,
+                        PSY_TEXTURE_ERROR,
+                        PSY_TEXTURE_ERROR_FAILED,
+                        "Unable to map a pixel buffer for the upload");
+        goto unbind;
+    }
+    memcpy(staging, psy_texture_get_data(self), (gsize) num_bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With a bound unpack buffer, the source is an offset into the buffer.
+    gl_texture_specify_image(gl_self, pix_format, NULL, &local_error);
+    if (local_error)
+        goto unbind;
+
+    gl_self->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Make sure the transfer starts now, rather than at the next swap.
+    glFlush();
+
+unbind:
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (local_error) {
+        gl_texture_clear_pending(gl_self);
+        g_propagate_error(error, local_error);
+    }
+}
+
+static gboolean
+psy_gl_texture_is_upload_pending(PsyTexture *self)
+{
+    PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
+    return gl_self->fence != NULL && !gl_texture_wait_fence(gl_self, 0);
+}
+
+static gboolean
+psy_gl_texture_wait_uploaded(PsyTexture *self, gint64 timeout_us)
+{
+    PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
+    GLuint64      timeout_ns
+        = timeout_us < 0 ? G_MAXUINT64 : (GLuint64) timeout_us * 1000;
+
+    return gl_texture_wait_fence(gl_self, timeout_ns);
+}
+
 static void
 psy_gl_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
 {
@@ -224,7 +384,9 @@ psy_gl_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
                     num_channels);
     }
 
+    gl_texture_clear_pending(gl_self);
     if (gl_self->object_id) {
+        psy_gl_state_forget_texture(gl_self->object_id);
         glDeleteTextures(1, &gl_self->object_id);
         gl_self->object_id = 0;
     }
@@ -233,11 +395,8 @@ psy_gl_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
     if (psy_gl_check_error(error))
         return;
 
-    glActiveTexture(GL_TEXTURE0);
-    if (psy_gl_check_error(error))
-        return;
-
-    glBindTexture(GL_TEXTURE_2D, gl_self->object_id);
+    psy_gl_state_active_texture(GL_TEXTURE0);
+    psy_gl_state_bind_texture_2d(gl_self->object_id);
     if (psy_gl_check_error(error))
         return;
 
@@ -258,7 +417,7 @@ psy_gl_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
 
     PsyImageFormat format = psy_image_get_format(image);
 
-    if (PSY_IMAGE_FORMAT_LUM)
+    if (format == PSY_IMAGE_FORMAT_LUM)
         glTexImage2D(GL_TEXTURE_2D,
                      0,
                      GL_LUMINANCE,
@@ -299,14 +458,102 @@ psy_gl_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
     if (psy_gl_check_error(error))
         return;
 
-    gl_self->is_uploaded = TRUE;
+    gl_self->is_uploaded   = TRUE;
+    gl_self->mipmaps_dirty = FALSE;
+}
+
+static void
+psy_gl_texture_upload_sub_image(PsyTexture *self,
+                                PsyImage   *image,
+                                guint       x,
+                                guint       y,
+                                guint       width,
+                                guint       height,
+                                GError    **error)
+{
+    PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
+    GLenum        pix_format;
+
+    // The GL orders the commands, so a pending upload is fine.
+    if (!gl_self->is_uploaded && !gl_self->fence) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_FAILED,
+                    "A sub image can only be uploaded to an uploaded texture");
+        return;
+    }
+
+    switch (psy_image_get_format(image)) {
+    case PSY_IMAGE_FORMAT_LUM:
+        pix_format = GL_LUMINANCE;
+        break;
+    case PSY_IMAGE_FORMAT_RGB:
+        pix_format = GL_RGB;
+        break;
+    case PSY_IMAGE_FORMAT_RGBA:
+        pix_format = GL_RGBA;
+        break;
+    case PSY_IMAGE_FORMAT_INVALID:
+    default:
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_FAILED,
+                    "Unable to upload a sub image with an invalid format");
+        return;
+    }
+
+    psy_gl_state_active_texture(GL_TEXTURE0);
+    psy_gl_state_bind_texture_2d(gl_self->object_id);
+    if (psy_gl_check_error(error))
+        return;
+
+    // The rows of a PsyImage are tightly packed, the GL reads the region
+    // straight from the image.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) psy_image_get_width(image));
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, (GLint) x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, (GLint) y);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    (GLint) x,
+                    (GLint) y,
+                    (GLsizei) width,
+                    (GLsizei) height,
+                    pix_format,
+                    GL_UNSIGNED_BYTE,
+                    psy_image_get_ptr(image));
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (psy_gl_check_error(error))
+        return;
+
+    // Regenerating the mipmaps of a large atlas per region is expensive, so
+    // they are regenerated once before the texture is used again.
+    gl_self->mipmaps_dirty = TRUE;
+}
+
+static void
+psy_gl_texture_unload(PsyTexture *self)
+{
+    PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
+
+    gl_texture_clear_pending(gl_self);
+    if (gl_self->object_id) {
+        psy_gl_state_forget_texture(gl_self->object_id);
+        glDeleteTextures(1, &gl_self->object_id);
+        gl_self->object_id = 0;
+    }
+    gl_self->is_uploaded   = FALSE;
+    gl_self->mipmaps_dirty = FALSE;
 }
 
 static gboolean
 psy_gl_texture_is_uploaded(PsyTexture *self)
 {
     PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
-    return gl_self->is_uploaded;
+    return gl_texture_wait_fence(gl_self, 0);
 }
 
 static void
@@ -314,13 +561,16 @@ psy_gl_texture_bind(PsyTexture *self, GError **error)
 {
     PsyGlTexture *gl_self = PSY_GL_TEXTURE(self);
 
-    glActiveTexture(GL_TEXTURE0);
+    psy_gl_state_active_texture(GL_TEXTURE0);
+    psy_gl_state_bind_texture_2d(gl_self->object_id);
     if (psy_gl_check_error(error))
         return;
 
-    glBindTexture(GL_TEXTURE_2D, gl_self->object_id);
-    if (psy_gl_check_error(error))
-        return;
+    if (gl_self->mipmaps_dirty) {
+        gl_self->mipmaps_dirty = FALSE;
+        glGenerateMipmap(GL_TEXTURE_2D);
+        psy_gl_check_error(error);
+    }
 }
 
 static void
@@ -334,10 +584,15 @@ psy_gl_texture_class_init(PsyGlTextureClass *class)
     gobject_class->finalize     = psy_gl_texture_finalize;
     gobject_class->dispose      = psy_gl_texture_dispose;
 
-    texture_class->upload       = psy_gl_texture_upload;
-    texture_class->is_uploaded  = psy_gl_texture_is_uploaded;
-    texture_class->bind         = psy_gl_texture_bind;
-    texture_class->upload_image = psy_gl_texture_upload_image;
+    texture_class->upload            = psy_gl_texture_upload;
+    texture_class->is_uploaded       = psy_gl_texture_is_uploaded;
+    texture_class->bind              = psy_gl_texture_bind;
+    texture_class->upload_image      = psy_gl_texture_upload_image;
+    texture_class->upload_sub_image  = psy_gl_texture_upload_sub_image;
+    texture_class->upload_async      = psy_gl_texture_upload_async;
+    texture_class->is_upload_pending = psy_gl_texture_is_upload_pending;
+    texture_class->wait_uploaded     = psy_gl_texture_wait_uploaded;
+    texture_class->unload            = psy_gl_texture_unload;
 
     gl_texture_properties[PROP_OBJECT_ID]
         = g_param_spec_string("object-id",
@@ -1,31 +1,49 @@
 
 #include <epoxy/egl.h>
+#include <epoxy/gl.h>
 
 #include "psy-gl-program.h"
 #include "psy-gl-utilities.h"
 
-/**
- * psy_gl_canvas_init_default_shaders:
- *
- * Takes care that the default shaders are uploaded.
- *
- * Stability: private
+G_DEFINE_QUARK("psy-gl-projection-handle", projection_handle)
+
+/*
+ * Looks up the handle of the projection uniform once per program. It is
+ * stored + 1 on the program itself, so it dies with the program and can't
+ * be mistaken for the handle of a program that takes its place.
  */
-void
-psy_gl_canvas_init_default_shaders(PsyCanvas *self, GError **error)
+static gint
+program_get_projection_handle(PsyShaderProgram *program, GError **error)
 {
-    // Uniform color program
-    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(self));
+    gpointer data
+        = g_object_get_qdata(G_OBJECT(program), projection_handle_quark());
+    if (data)
+        return GPOINTER_TO_INT(data) - 1;
 
+    gint handle
+        = psy_shader_program_get_uniform_handle(program, "projection", error);
+    if (handle >= 0)
+        g_object_set_qdata(G_OBJECT(program),
+                           projection_handle_quark(),
+                           GINT_TO_POINTER(handle + 1));
+    return handle;
+}
+
+static void
+init_program(PsyDrawingContext *context,
+             const gchar       *name,
+             const gchar       *vertex_path,
+             const gchar       *fragment_path,
+             GError           **error)
+{
     PsyShaderProgram *program = psy_drawing_context_create_program(context);
 
-    psy_shader_program_set_vertex_shader_from_path(
-        program, "./psy/uniform-color.vert", error);
+    psy_shader_program_set_vertex_shader_from_path(program, vertex_path, error);
     if (*error)
         goto fail;
 
     psy_shader_program_set_fragment_shader_from_path(
-        program, "./psy/uniform-color.frag", error);
+        program, fragment_path, error);
     if (*error)
         goto fail;
 
@@ -33,35 +51,79 @@ psy_gl_canvas_init_default_shaders(PsyCanvas *self, GError **error)
     if (*error)
         goto fail;
 
-    psy_drawing_context_register_program(
-        context, PSY_UNIFORM_COLOR_PROGRAM_NAME, program, error);
+    psy_drawing_context_register_program(context, name, program, error);
     if (*error)
-        return;
+        goto fail;
 
-    // Picture program
-    program = psy_drawing_context_create_program(context);
+    return;
 
-    psy_shader_program_set_vertex_shader_from_path(
-        program, "./psy/picture.vert", error);
+fail:
+    g_object_unref(program);
+}
+
+/**
+ * psy_gl_canvas_init_default_shaders:
+ *
+ * Takes care that the default shaders are uploaded.
+ *
+ * Stability: private
+ */
+void
+psy_gl_canvas_init_default_shaders(PsyCanvas *self, GError **error)
+{
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(self));
+
+    // Uniform color program
+    init_program(context,
+                 PSY_UNIFORM_COLOR_PROGRAM_NAME,
+                 "./psy/uniform-color.vert",
+                 "./psy/uniform-color.frag",
+                 error);
     if (*error)
-        goto fail;
+        return;
 
-    psy_shader_program_set_fragment_shader_from_path(
-        program, "./psy/picture.frag", error);
+    // Picture program
+    init_program(context,
+                 PSY_PICTURE_PROGRAM_NAME,
+                 "./psy/picture.vert",
+                 "./psy/picture.frag",
+                 error);
     if (*error)
-        goto fail;
+        return;
 
-    psy_shader_program_link(program, error);
+    // Program for batches of uniformly colored shapes
+    init_program(context,
+                 PSY_INSTANCED_COLOR_PROGRAM_NAME,
+                 "./psy/instanced-color.vert",
+                 "./psy/instanced-color.frag",
+                 error);
     if (*error)
-        goto fail;
+        return;
 
-    psy_drawing_context_register_program(
-        context, PSY_PICTURE_PROGRAM_NAME, program, error);
+    // Program for smooth shapes
+    init_program(context,
+                 PSY_SDF_PROGRAM_NAME,
+                 "./psy/sdf.vert",
+                 "./psy/sdf.frag",
+                 error);
+    if (*error)
+        return;
 
-    return;
+    // Program for batches of pictures in a texture atlas
+    init_program(context,
+                 PSY_INSTANCED_PICTURE_PROGRAM_NAME,
+                 "./psy/instanced-picture.vert",
+                 "./psy/instanced-picture.frag",
+                 error);
+    if (*error)
+        return;
 
-fail:
-    g_object_unref(program);
+    // Program for text, drawn as glyphs from a texture atlas
+    init_program(context,
+                 PSY_INSTANCED_GLYPH_PROGRAM_NAME,
+                 "./psy/instanced-glyph.vert",
+                 "./psy/instanced-glyph.frag",
+                 error);
 }
 
 /**
@@ -77,47 +139,62 @@ psy_gl_canvas_upload_projection_matrices(PsyCanvas *self)
     GError     *error      = NULL;
 
     PsyDrawingContext *context = psy_canvas_get_context(self);
-    PsyShaderProgram  *program = psy_drawing_context_get_program(
-        context, PSY_UNIFORM_COLOR_PROGRAM_NAME);
 
-    if (program) {
-        psy_shader_program_use(program, &error);
-        if (error) {
-            g_critical("Unable to set picture projection matrix: %s",
-                       error->message);
-            g_error_free(error);
-            error = NULL;
-        }
-        psy_shader_program_set_uniform_matrix4(
-            program, "projection", projection, &error);
-        if (error) {
-            g_critical("Unable to set picture projection matrix: %s",
-                       error->message);
-            g_error_free(error);
-            error = NULL;
-        }
-    }
-    program
-        = psy_drawing_context_get_program(context, PSY_PICTURE_PROGRAM_NAME);
-    if (program) {
+    const gchar *program_names[] = {
+        PSY_UNIFORM_COLOR_PROGRAM_NAME,
+        PSY_PICTURE_PROGRAM_NAME,
+        PSY_INSTANCED_COLOR_PROGRAM_NAME,
+        PSY_SDF_PROGRAM_NAME,
+        PSY_INSTANCED_PICTURE_PROGRAM_NAME,
+        PSY_INSTANCED_GLYPH_PROGRAM_NAME,
+    };
+
+    for (gsize i = 0; i < G_N_ELEMENTS(program_names); i++) {
+        PsyShaderProgram *program
+            = psy_drawing_context_get_program(context, program_names[i]);
+        if (!program)
+            continue;
+
         psy_shader_program_use(program, &error);
         if (error) {
-            g_critical("Unable to set picture projection matrix: %s",
-                       error->message);
-            g_error_free(error);
-            error = NULL;
+            g_critical(
+                "Unable to use %s: %s", program_names[i], error->message);
+            g_clear_error(&error);
+            continue;
         }
-        psy_shader_program_set_uniform_matrix4(
-            program, "projection", projection, &error);
+        gint handle = program_get_projection_handle(program, &error);
+        if (!error)
+            psy_shader_program_set_uniform_matrix4_by_handle(
+                program, handle, projection, &error);
         if (error) {
-            g_critical("Unable to set picture projection matrix: %s",
+            g_critical("Unable to set the projection matrix of %s: %s",
+                       program_names[i],
                        error->message);
-            g_error_free(error);
-            error = NULL;
+            g_clear_error(&error);
         }
     }
 }
 
+/**
+ * psy_gl_canvas_set_translucent:
+ * @canvas: the canvas that is drawing
+ * @translucent: whether the stimuli that follow are translucent
+ *
+ * Translucent stimuli are drawn from back to front after the opaque ones.
+ * They are still hidden by opaque stimuli in front of them, but they don't
+ * write depth, so they never hide the stimuli that are blended over them.
+ * A translucent stimulus is drawn over an opaque one at the same depth.
+ *
+ * Stability: private
+ */
+void
+psy_gl_canvas_set_translucent(PsyCanvas *canvas, gboolean translucent)
+{
+    (void) canvas;
+    glDepthMask(translucent ? GL_FALSE : GL_TRUE);
+    glDepthFunc(translucent ? GL_LEQUAL : GL_LESS);
+}
+
 /**
  * psy_egl_strerr:
  * @error: an error code returned by `eglGetError()`
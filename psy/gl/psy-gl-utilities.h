@@ -11,6 +11,9 @@ psy_gl_canvas_init_default_shaders(PsyCanvas *self, GError **error);
 void
 psy_gl_canvas_upload_projection_matrices(PsyCanvas *canvas);
 
+void
+psy_gl_canvas_set_translucent(PsyCanvas *canvas, gboolean translucent);
+
 const gchar *
 psy_egl_strerr(gint error);
 
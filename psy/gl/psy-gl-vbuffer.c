@@ -2,6 +2,7 @@
 
 #include "psy-gl-vbuffer.h"
 #include "psy-gl-error.h"
+#include "psy-gl-state.h"
 
 #include <epoxy/gl.h>
 
@@ -9,7 +10,10 @@ typedef struct _PsyGlVBuffer {
     PsyVBuffer parent;
     GLuint     vertex_buffer_id;
     GLuint     vertex_array_id;
-    guint      is_uploaded : 1;
+    GLuint     instance_buffer_id; // per instance model, color and tex_rect
+    GLsizeiptr buffer_size;        // the size of the vertex buffer storage
+    guint      is_uploaded        : 1;
+    guint      instances_attached : 1; // instance_buffer_id is in the vao
 } PsyGlVBuffer;
 
 G_DEFINE_TYPE(PsyGlVBuffer, psy_gl_vbuffer, PSY_TYPE_VBUFFER)
@@ -53,48 +57,40 @@ psy_gl_vbuffer_finalize(GObject *object)
     }
 
     if (self->vertex_array_id) {
+        psy_gl_state_forget_vertex_array(self->vertex_array_id);
         glDeleteVertexArrays(1, &self->vertex_array_id);
         self->vertex_array_id = 0;
     }
 
+    if (self->instance_buffer_id) {
+        glDeleteBuffers(1, &self->instance_buffer_id);
+        self->instance_buffer_id = 0;
+    }
+
     G_OBJECT_CLASS(psy_gl_vbuffer_parent_class)->finalize(object);
 }
 
+/*
+ * Creates the vertex buffer and a vertex array object that describes the
+ * layout of PsyVertex in it. The vertex array refers to the buffer object,
+ * not to its storage, so it stays valid when the storage is respecified.
+ */
 static void
-psy_gl_vbuffer_upload(PsyVBuffer *vbuffer, GError **error)
+psy_gl_vbuffer_create_objects(PsyGlVBuffer *self, GError **error)
 {
-    PsyGlVBuffer *self = PSY_GL_VBUFFER(vbuffer);
-    if (self->vertex_buffer_id) {
-        glDeleteBuffers(1, &self->vertex_buffer_id);
-        self->vertex_buffer_id = 0;
-    }
-
-    if (self->vertex_array_id) {
-        glDeleteVertexArrays(1, &self->vertex_array_id);
-        self->vertex_array_id = 0;
-    }
-
     glGenBuffers(1, &self->vertex_buffer_id);
-    psy_gl_check_error(error);
-    if (*error)
+    if (psy_gl_check_error(error))
         return;
     glBindBuffer(GL_ARRAY_BUFFER, self->vertex_buffer_id);
-    psy_gl_check_error(error);
-    if (*error)
-        return;
-    glBufferData(GL_ARRAY_BUFFER,
-                 (GLsizeiptr) psy_vbuffer_get_size(vbuffer),
-                 psy_vbuffer_get_buffer(vbuffer),
-                 GL_STATIC_DRAW);
-    psy_gl_check_error(error);
-    if (*error)
+    if (psy_gl_check_error(error))
         return;
 
     glGenVertexArrays(1, &self->vertex_array_id);
     if (psy_gl_check_error(error))
         return;
+    self->instances_attached = 0;
 
-    glBindVertexArray(self->vertex_array_id);
+    psy_gl_state_bind_vertex_array(self->vertex_array_id);
     if (psy_gl_check_error(error))
         return;
 
@@ -137,6 +133,41 @@ psy_gl_vbuffer_upload(PsyVBuffer *vbuffer, GError **error)
         return;
 
     glEnableVertexAttribArray(2);
+    psy_gl_check_error(error);
+}
+
+static void
+psy_gl_vbuffer_upload(PsyVBuffer *vbuffer, GError **error)
+{
+    PsyGlVBuffer *self        = PSY_GL_VBUFFER(vbuffer);
+    GLsizeiptr    size        = (GLsizeiptr) psy_vbuffer_get_size(vbuffer);
+    GError       *local_error = NULL;
+
+    if (!self->vertex_buffer_id || !self->vertex_array_id) {
+        psy_gl_vbuffer_create_objects(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, self->vertex_buffer_id);
+    }
+
+    if (self->is_uploaded && size <= self->buffer_size) {
+        // The vertices fit in the existing storage, just copy them.
+        glBufferSubData(
+            GL_ARRAY_BUFFER, 0, size, psy_vbuffer_get_buffer(vbuffer));
+    }
+    else {
+        // The first upload is assumed to be static, the geometry of a buffer
+        // that is uploaded again is likely to change more often.
+        glBufferData(GL_ARRAY_BUFFER,
+                     size,
+                     psy_vbuffer_get_buffer(vbuffer),
+                     self->is_uploaded ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        self->buffer_size = size;
+    }
     if (psy_gl_check_error(error))
         return;
 
@@ -153,16 +184,20 @@ psy_gl_vbuffer_is_uploaded(PsyVBuffer *self)
 static void
 psy_gl_vbuffer_draw_triangles(PsyVBuffer *self, GError **error)
 {
-    PsyGlVBuffer *gl_vbuffer = PSY_GL_VBUFFER(self);
-    if (!psy_gl_vbuffer_is_uploaded(self))
-        psy_gl_vbuffer_upload(self, error);
-    if (*error)
-        return;
+    PsyGlVBuffer *gl_vbuffer  = PSY_GL_VBUFFER(self);
+    GError       *local_error = NULL;
+
+    if (!psy_gl_vbuffer_is_uploaded(self)) {
+        psy_gl_vbuffer_upload(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
 
-    glBindVertexArray(gl_vbuffer->vertex_array_id);
+    psy_gl_state_bind_vertex_array(gl_vbuffer->vertex_array_id);
 #ifndef NDEBUG
-    psy_gl_check_error(error);
-    if (*error) {
+    if (psy_gl_check_error(error)) {
         g_assert_not_reached();
         return;
     }
@@ -174,13 +209,18 @@ psy_gl_vbuffer_draw_triangles(PsyVBuffer *self, GError **error)
 static void
 psy_gl_vbuffer_draw_triangle_strip(PsyVBuffer *self, GError **error)
 {
-    PsyGlVBuffer *gl_vbuffer = PSY_GL_VBUFFER(self);
-    if (!psy_gl_vbuffer_is_uploaded(self))
-        psy_gl_vbuffer_upload(self, error);
-    if (*error)
-        return;
+    PsyGlVBuffer *gl_vbuffer  = PSY_GL_VBUFFER(self);
+    GError       *local_error = NULL;
+
+    if (!psy_gl_vbuffer_is_uploaded(self)) {
+        psy_gl_vbuffer_upload(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
 
-    glBindVertexArray(gl_vbuffer->vertex_array_id);
+    psy_gl_state_bind_vertex_array(gl_vbuffer->vertex_array_id);
 #ifndef NDEBUG
     if (psy_gl_check_error(error))
         g_assert_not_reached();
@@ -192,13 +232,18 @@ psy_gl_vbuffer_draw_triangle_strip(PsyVBuffer *self, GError **error)
 static void
 psy_gl_vbuffer_draw_triangle_fan(PsyVBuffer *self, GError **error)
 {
-    PsyGlVBuffer *gl_vbuffer = PSY_GL_VBUFFER(self);
-    if (!psy_gl_vbuffer_is_uploaded(self))
-        psy_gl_vbuffer_upload(self, error);
-    if (*error)
-        return;
+    PsyGlVBuffer *gl_vbuffer  = PSY_GL_VBUFFER(self);
+    GError       *local_error = NULL;
+
+    if (!psy_gl_vbuffer_is_uploaded(self)) {
+        psy_gl_vbuffer_upload(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
 
-    glBindVertexArray(gl_vbuffer->vertex_array_id);
+    psy_gl_state_bind_vertex_array(gl_vbuffer->vertex_array_id);
 #ifndef NDEBUG
     if (psy_gl_check_error(error))
         g_assert_not_reached();
@@ -207,6 +252,114 @@ psy_gl_vbuffer_draw_triangle_fan(PsyVBuffer *self, GError **error)
     psy_gl_check_error(error);
 }
 
+/*
+ * The instance attributes start after the per vertex attributes. The model
+ * matrix occupies 4 locations, one for each column.
+ */
+#define INSTANCE_MODEL_LOCATION    3
+#define INSTANCE_COLOR_LOCATION    7
+#define INSTANCE_TEX_RECT_LOCATION 8
+
+static void
+psy_gl_vbuffer_attach_instances(PsyGlVBuffer *self, GError **error)
+{
+    if (!self->instance_buffer_id) {
+        glGenBuffers(1, &self->instance_buffer_id);
+        if (psy_gl_check_error(error))
+            return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, self->instance_buffer_id);
+    if (psy_gl_check_error(error))
+        return;
+
+    for (GLuint col = 0; col < 4; col++) {
+        GLuint location = INSTANCE_MODEL_LOCATION + col;
+        glVertexAttribPointer(
+            location,
+            4,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(PsyVBufferInstance),
+            (void *) (G_STRUCT_OFFSET(PsyVBufferInstance, model)
+                      + col * 4 * sizeof(gfloat)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(PsyVBufferInstance),
+                          (void *) G_STRUCT_OFFSET(PsyVBufferInstance, color));
+    glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+    glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+
+    glVertexAttribPointer(
+        INSTANCE_TEX_RECT_LOCATION,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(PsyVBufferInstance),
+        (void *) G_STRUCT_OFFSET(PsyVBufferInstance, tex_rect));
+    glEnableVertexAttribArray(INSTANCE_TEX_RECT_LOCATION);
+    glVertexAttribDivisor(INSTANCE_TEX_RECT_LOCATION, 1);
+    if (psy_gl_check_error(error))
+        return;
+
+    self->instances_attached = 1;
+}
+
+static void
+psy_gl_vbuffer_draw_triangle_fan_instanced(PsyVBuffer               *self,
+                                           const PsyVBufferInstance *instances,
+                                           guint   num_instances,
+                                           GError **error)
+{
+    PsyGlVBuffer *gl_vbuffer  = PSY_GL_VBUFFER(self);
+    GError       *local_error = NULL;
+
+    if (!psy_gl_vbuffer_is_uploaded(self)) {
+        psy_gl_vbuffer_upload(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
+
+    if (num_instances == 0)
+        return;
+
+    psy_gl_state_bind_vertex_array(gl_vbuffer->vertex_array_id);
+
+    if (!gl_vbuffer->instances_attached) {
+        psy_gl_vbuffer_attach_instances(gl_vbuffer, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return;
+        }
+    }
+
+    // Orphan the previous contents, the driver doesn't have to wait until
+    // the previous draw call has finished with it.
+    glBindBuffer(GL_ARRAY_BUFFER, gl_vbuffer->instance_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER,
+                 (GLsizeiptr) (num_instances * sizeof(PsyVBufferInstance)),
+                 instances,
+                 GL_STREAM_DRAW);
+#ifndef NDEBUG
+    if (psy_gl_check_error(error))
+        return;
+#endif
+
+    glDrawArraysInstanced(GL_TRIANGLE_FAN,
+                          0,
+                          (GLint) psy_vbuffer_get_nvertices(self),
+                          (GLsizei) num_instances);
+    psy_gl_check_error(error);
+}
+
 static void
 psy_gl_vbuffer_class_init(PsyGlVBufferClass *class)
 {
@@ -221,6 +374,8 @@ psy_gl_vbuffer_class_init(PsyGlVBufferClass *class)
     vbuffer_class->draw_triangles      = psy_gl_vbuffer_draw_triangles;
     vbuffer_class->draw_triangle_strip = psy_gl_vbuffer_draw_triangle_strip;
     vbuffer_class->draw_triangle_fan   = psy_gl_vbuffer_draw_triangle_fan;
+    vbuffer_class->draw_triangle_fan_instanced
+        = psy_gl_vbuffer_draw_triangle_fan_instanced;
 
     gl_vbuffer_properties[PROP_OBJECT_ID]
         = g_param_spec_uint("object-id",
@@ -0,0 +1,243 @@
+
+#include "psy-fake-parallel-port.h"
+
+/**
+ * PsyFakeParallelPort:
+ *
+ * PsyFakeParallelPort is a parallel port that doesn't talk to hardware.
+ * What is written to the port can be inspected with
+ * [method@FakeParallelPort.get_output] and the lines that are read from the
+ * port are set with [method@FakeParallelPort.set_input]. Setting the input
+ * wakes up threads that wait for input via
+ * [method@ParallelPort.wait_for_input], as an interrupt of a real port
+ * would. This makes it possible to test code that uses parallel ports,
+ * e.g. a [class@ResponseBox], without the hardware.
+ */
+
+typedef struct _PsyFakeParallelPort {
+    PsyParallelPort parent;
+
+    GMutex lock;
+    GCond  cond;
+    guint8 input;
+    guint8 output;
+    guint  num_changes; // incremented when the input changes
+} PsyFakeParallelPort;
+
+G_DEFINE_FINAL_TYPE(PsyFakeParallelPort,
+                    psy_fake_parallel_port,
+                    PSY_TYPE_PARALLEL_PORT)
+
+static void
+psy_fake_parallel_port_init(PsyFakeParallelPort *self)
+{
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+}
+
+static void
+psy_fake_parallel_port_finalize(GObject *object)
+{
+    PsyFakeParallelPort *self = PSY_FAKE_PARALLEL_PORT(object);
+
+    G_OBJECT_CLASS(psy_fake_parallel_port_parent_class)->finalize(object);
+
+    g_mutex_clear(&self->lock);
+    g_cond_clear(&self->cond);
+}
+
+static void
+fake_port_open(PsyParallelPort *self, gint port_num, GError **error)
+{
+    gchar buffer[64];
+
+    psy_parallel_port_close(self);
+
+    PSY_PARALLEL_PORT_CLASS(psy_fake_parallel_port_parent_class)
+        ->open(self, port_num, error);
+
+    g_snprintf(buffer, sizeof(buffer), "fake%d", port_num);
+    PSY_PARALLEL_PORT_GET_CLASS(self)->set_port_name(self, buffer);
+}
+
+static gboolean
+fake_port_check(PsyParallelPort *self, PsyIoDirection dir, GError **error)
+{
+    if (!psy_parallel_port_is_open(self)) {
+        g_set_error(error,
+                    PSY_PARALLEL_PORT_ERROR,
+                    PSY_PARALLEL_PORT_ERROR_DEV_CLOSED,
+                    "The device is closed");
+        return FALSE;
+    }
+
+    if (psy_parallel_port_get_direction(self) != dir) {
+        g_set_error(error,
+                    PSY_PARALLEL_PORT_ERROR,
+                    PSY_PARALLEL_PORT_ERROR_DIRECTION,
+                    "The port is not configured as %s",
+                    dir == PSY_IO_DIRECTION_IN ? "input" : "output");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+fake_port_write(PsyParallelPort *self, guint8 pins, GError **error)
+{
+    PsyFakeParallelPort *fake = PSY_FAKE_PARALLEL_PORT(self);
+
+    if (!fake_port_check(self, PSY_IO_DIRECTION_OUT, error))
+        return;
+
+    g_mutex_lock(&fake->lock);
+    fake->output = pins;
+    g_mutex_unlock(&fake->lock);
+
+    psy_parallel_port_set_pins(self, pins);
+}
+
+static void
+fake_port_write_pin(PsyParallelPort *self,
+                    gint             pin,
+                    PsyIoLevel       level,
+                    GError         **error)
+{
+    guint8 pins = psy_parallel_port_get_pins(self);
+
+    if (level == PSY_IO_LEVEL_HIGH)
+        pins |= 1u << pin;
+    else
+        pins &= ~(1u << pin);
+
+    psy_parallel_port_write(self, pins, error);
+}
+
+static guint8
+fake_port_read(PsyParallelPort *self, GError **error)
+{
+    PsyFakeParallelPort *fake = PSY_FAKE_PARALLEL_PORT(self);
+    guint8               pins;
+
+    if (!fake_port_check(self, PSY_IO_DIRECTION_IN, error))
+        return 0;
+
+    g_mutex_lock(&fake->lock);
+    pins = fake->input;
+    g_mutex_unlock(&fake->lock);
+
+    psy_parallel_port_set_pins(self, pins);
+    return pins;
+}
+
+static PsyIoLevel
+fake_port_read_pin(PsyParallelPort *self, gint pin, GError **error)
+{
+    GError *local_error = NULL;
+    guint8  pins        = psy_parallel_port_read(self, &local_error);
+
+    if (local_error) {
+        g_propagate_error(error, local_error);
+        return PSY_IO_LEVEL_LOW;
+    }
+
+    return pins & (1u << pin) ? PSY_IO_LEVEL_HIGH : PSY_IO_LEVEL_LOW;
+}
+
+static gboolean
+fake_port_wait_for_input(PsyParallelPort *self,
+                         gint64           timeout_us,
+                         GError         **error)
+{
+    PsyFakeParallelPort *fake = PSY_FAKE_PARALLEL_PORT(self);
+    gboolean             changed;
+
+    if (!fake_port_check(self, PSY_IO_DIRECTION_IN, error))
+        return FALSE;
+
+    gint64 end_time = g_get_monotonic_time() + timeout_us;
+
+    g_mutex_lock(&fake->lock);
+
+    guint num_changes = fake->num_changes;
+    while (fake->num_changes == num_changes) {
+        if (!g_cond_wait_until(&fake->cond, &fake->lock, end_time))
+            break;
+    }
+    changed = fake->num_changes != num_changes;
+
+    g_mutex_unlock(&fake->lock);
+
+    return changed;
+}
+
+static void
+psy_fake_parallel_port_class_init(PsyFakeParallelPortClass *cls)
+{
+    GObjectClass *obj_cls = G_OBJECT_CLASS(cls);
+
+    obj_cls->finalize = psy_fake_parallel_port_finalize;
+
+    PsyParallelPortClass *parallel_cls = PSY_PARALLEL_PORT_CLASS(cls);
+
+    parallel_cls->open           = fake_port_open;
+    parallel_cls->write          = fake_port_write;
+    parallel_cls->write_pin      = fake_port_write_pin;
+    parallel_cls->read           = fake_port_read;
+    parallel_cls->read_pin       = fake_port_read_pin;
+    parallel_cls->wait_for_input = fake_port_wait_for_input;
+}
+
+/**
+ * psy_fake_parallel_port_new:(constructor)
+ *
+ * Returns: a new [class@FakeParallelPort]
+ */
+PsyParallelPort *
+psy_fake_parallel_port_new(void)
+{
+    return g_object_new(PSY_TYPE_FAKE_PARALLEL_PORT, NULL);
+}
+
+/**
+ * psy_fake_parallel_port_set_input:
+ * @self: an instance of [class@FakeParallelPort]
+ * @pins: the state of the lines that is read from the port
+ *
+ * Sets the lines that are returned when the port is read. When @pins
+ * differs from the current input, threads that wait in
+ * [method@ParallelPort.wait_for_input] are woken up. This function may be
+ * called from any thread.
+ */
+void
+psy_fake_parallel_port_set_input(PsyFakeParallelPort *self, guint8 pins)
+{
+    g_return_if_fail(PSY_IS_FAKE_PARALLEL_PORT(self));
+
+    g_mutex_lock(&self->lock);
+    if (self->input != pins) {
+        self->input = pins;
+        self->num_changes++;
+        g_cond_broadcast(&self->cond);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+/**
+ * psy_fake_parallel_port_get_output:
+ * @self: an instance of [class@FakeParallelPort]
+ *
+ * Returns: the lines that have been written to the port last.
+ */
+guint8
+psy_fake_parallel_port_get_output(PsyFakeParallelPort *self)
+{
+    g_return_val_if_fail(PSY_IS_FAKE_PARALLEL_PORT(self), 0);
+
+    g_mutex_lock(&self->lock);
+    guint8 output = self->output;
+    g_mutex_unlock(&self->lock);
+
+    return output;
+}
@@ -0,0 +1,26 @@
+
+#pragma once
+
+#include "psy-parallel-port.h"
+
+G_BEGIN_DECLS
+
+#define PSY_TYPE_FAKE_PARALLEL_PORT psy_fake_parallel_port_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(PsyFakeParallelPort,
+                     psy_fake_parallel_port,
+                     PSY,
+                     FAKE_PARALLEL_PORT,
+                     PsyParallelPort)
+
+G_MODULE_EXPORT PsyParallelPort *
+psy_fake_parallel_port_new(void);
+
+G_MODULE_EXPORT void
+psy_fake_parallel_port_set_input(PsyFakeParallelPort *self, guint8 pins);
+
+G_MODULE_EXPORT guint8
+psy_fake_parallel_port_get_output(PsyFakeParallelPort *self);
+
+G_END_DECLS
@@ -2,6 +2,8 @@
 #include "psy-parallel-port.h"
 #include "enum-types.h"
 #include "psy-config.h"
+#include "psy-trigger-device-private.h"
+#include "psy-trigger-device.h"
 #if defined(HAVE_LINUX_PARPORT_H)
     #include "psy-parport.h"
 #endif
@@ -21,21 +23,31 @@ G_DEFINE_QUARK(psy-parallel-port-error-quark, psy_parallel_port_error)
  * This class does provide the full API of communicating with a parallel port
  * ParallelPorts in psylib are identified by there number, the id 0 might be
  * mapped to "/dev/parport0/" on linux but "LPT1" on windows.
+ * PsyParallelPort implements [iface@TriggerDevice], so it may be used by
+ * [class@ParallelTrigger] as any other trigger device.
  *
  * TODO Most of these function work synchronous, hence, a class
  * needs to be designed that can read, write, open, close in an async fashion.
  */
 
 typedef struct {
-    gchar          port_name[64];
-    gint           port_num; // -1 closed or 0 - max_port for a open one.
-    PsyIoDirection direction;
-    guint8         pins; // the lines as written to or read from the device.
+    gchar           port_name[64];
+    gint            port_num; // -1 closed or 0 - max_port for a open one.
+    PsyIoDirection  direction;
+    guint8          pins; // the lines as written to or read from the device.
+    PsyWriteLatency latency;
 } PsyParallelPortPrivate;
 
-G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyParallelPort,
-                                    psy_parallel_port,
-                                    G_TYPE_OBJECT)
+static void
+psy_parallel_port_trigger_device_init(PsyTriggerDeviceInterface *iface);
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE(
+    PsyParallelPort,
+    psy_parallel_port,
+    G_TYPE_OBJECT,
+    G_ADD_PRIVATE(PsyParallelPort)
+        G_IMPLEMENT_INTERFACE(PSY_TYPE_TRIGGER_DEVICE,
+                              psy_parallel_port_trigger_device_init))
 
 typedef enum PsyParallelPortProperty {
     PROP_NULL,
@@ -137,6 +149,7 @@ psy_parallel_port_init(PsyParallelPort *self)
 
     priv->port_num  = -1;
     priv->direction = PSY_IO_DIRECTION_OUT;
+    psy_write_latency_reset(&priv->latency);
 }
 
 static void
@@ -174,6 +187,57 @@ parallel_port_set_port_name(PsyParallelPort *self, const gchar *name)
     g_snprintf(priv->port_name, sizeof(priv->port_name), "%s", name);
 }
 
+static gboolean
+parallel_port_wait_for_input(PsyParallelPort *self,
+                             gint64           timeout_us,
+                             GError         **error)
+{
+    (void) self;
+    (void) error;
+
+    if (timeout_us > 0)
+        g_usleep((gulong) timeout_us);
+
+    return FALSE;
+}
+
+static gboolean
+parallel_port_trigger_is_open(PsyTriggerDevice *self)
+{
+    return psy_parallel_port_is_open(PSY_PARALLEL_PORT(self));
+}
+
+static const gchar *
+parallel_port_trigger_get_name(PsyTriggerDevice *self)
+{
+    return psy_parallel_port_get_port_name(PSY_PARALLEL_PORT(self));
+}
+
+static void
+parallel_port_trigger_write(PsyTriggerDevice *self,
+                            guint8            mask,
+                            GError          **error)
+{
+    psy_parallel_port_write(PSY_PARALLEL_PORT(self), mask, error);
+}
+
+static PsyWriteLatency *
+parallel_port_trigger_get_write_latency(PsyTriggerDevice *self)
+{
+    PsyParallelPortPrivate *priv
+        = psy_parallel_port_get_instance_private(PSY_PARALLEL_PORT(self));
+    return &priv->latency;
+}
+
+static void
+psy_parallel_port_trigger_device_init(PsyTriggerDeviceInterface *iface)
+{
+    iface->is_open           = parallel_port_trigger_is_open;
+    iface->get_name          = parallel_port_trigger_get_name;
+    iface->write             = parallel_port_trigger_write;
+    iface->get_write_latency = parallel_port_trigger_get_write_latency;
+}
+
 static void
 psy_parallel_port_class_init(PsyParallelPortClass *cls)
 {
@@ -183,9 +247,10 @@ psy_parallel_port_class_init(PsyParallelPortClass *cls)
     obj_cls->get_property = psy_parallel_port_get_property;
     obj_cls->finalize     = parallel_port_finalize;
 
-    cls->open          = parallel_port_open;
-    cls->close         = parallel_port_close;
-    cls->set_port_name = parallel_port_set_port_name;
+    cls->open           = parallel_port_open;
+    cls->close          = parallel_port_close;
+    cls->set_port_name  = parallel_port_set_port_name;
+    cls->wait_for_input = parallel_port_wait_for_input;
 
     /**
      * PsyParallelPort:port-num:
@@ -598,6 +663,38 @@ psy_parallel_port_read_pin(PsyParallelPort *self, gint pin, GError **error)
     return cls->read_pin(self, pin, error);
 }
 
+/**
+ * psy_parallel_port_wait_for_input:
+ * @self: an instance of `PsyParallelPort`
+ * @timeout_us: the maximum number of microseconds to wait
+ * @error: Errors are returned here.
+ *
+ * Waits until the input lines of the port might have changed. Some backends
+ * are able to tell that the input has changed, e.g. because an interrupt
+ * was raised, other backends just wait for @timeout_us. In both cases
+ * you should read the port afterwards with [method@ParallelPort.read] in
+ * order to see whether the lines have actually changed.
+ * This function is used by [class@ResponseBox] to sample the port.
+ *
+ * Returns: TRUE if the backend detected a change of the input, FALSE when
+ *          the timeout expired or when the backend is unable to detect
+ *          changes.
+ */
+gboolean
+psy_parallel_port_wait_for_input(PsyParallelPort *self,
+                                 gint64           timeout_us,
+                                 GError         **error)
+{
+    PsyParallelPortClass *cls;
+    g_return_val_if_fail(PSY_IS_PARALLEL_PORT(self), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    cls = PSY_PARALLEL_PORT_GET_CLASS(self);
+    g_return_val_if_fail(cls->wait_for_input, FALSE);
+
+    return cls->wait_for_input(self, timeout_us, error);
+}
+
 /**
  * psy_parallel_port_get_pins:
  *
@@ -37,6 +37,11 @@ psy_parallel_port_error_quark(void);
  *        sure that you can obtain the mask of the pins on the ParallelPort.
  * @read_pin: This should be implemented in the deriving class. This
  *            function reads whether the signal is high or low.
+ * @wait_for_input: Blocks until the input lines might have changed or until
+ *                  the timeout expires. Backends that are able to detect
+ *                  changes, e.g. via an interrupt, should return TRUE when a
+ *                  change is detected. The default implementation sleeps for
+ *                  the timeout and returns FALSE.
  */
 typedef struct _PsyParallelPortClass {
     GObjectClass parent_class;
@@ -55,7 +60,11 @@ typedef struct _PsyParallelPortClass {
     guint8 (*read)(PsyParallelPort *self, GError **error);
     PsyIoLevel (*read_pin)(PsyParallelPort *self, gint pin, GError **error);
 
-    gpointer padding[8];
+    gboolean (*wait_for_input)(PsyParallelPort *self,
+                               gint64           timeout_us,
+                               GError         **error);
+
+    gpointer padding[7];
 
 } PsyParallelPortClass;
 
@@ -107,6 +116,11 @@ psy_parallel_port_read(PsyParallelPort *self, GError **error);
 G_MODULE_EXPORT PsyIoLevel
 psy_parallel_port_read_pin(PsyParallelPort *self, gint pin, GError **error);
 
+G_MODULE_EXPORT gboolean
+psy_parallel_port_wait_for_input(PsyParallelPort *self,
+                                 gint64           timeout_us,
+                                 GError         **error);
+
 G_MODULE_EXPORT guint8
 psy_parallel_port_get_pins(PsyParallelPort *self);
 
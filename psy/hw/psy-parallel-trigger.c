@@ -6,75 +6,656 @@
 #include "psy-duration.h"
 #include "psy-parallel-port.h"
 #include "psy-time-point.h"
-
+#include "psy-trigger-device.h"
+
+#if defined _WIN32
+    #include <windows.h>
+#elif defined HAVE_PTHREAD_H
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+/*
+ * Sleeps until less than 1 ms before tp and spins for the remainder. The
+ * time is compared as integers, so the loops don't allocate.
+ */
 static void
 wait_until(PsyTimePoint *tp, GCancellable *cancellable)
 {
-    PsyDuration *one_ms  = psy_duration_new_ms(1);
-    PsyDuration *null_ms = psy_duration_new_ms(0);
-    PsyClock    *clock   = psy_clock_new();
+    gint64 until = psy_clock_get_zero_time() + tp->ticks_since_start;
+
+    // Sleep loop until less than 1ms from tp
+    while (!g_cancellable_is_cancelled(cancellable)
+           && until - psy_clock_get_monotonic_time() >= 1000)
+        g_usleep(1000);
+
+    // Busy loop until now > tp, allow other threads to run.
+    while (!g_cancellable_is_cancelled(cancellable)
+           && psy_clock_get_monotonic_time() <= until)
+        g_thread_yield();
+}
+
+// clang-format off
+G_DEFINE_QUARK(psy-parallel-trigger-error-quark, psy_parallel_trigger_error)
+
+// clang-format on
+
+/* ************ PsyParallelTriggerEvent ***************** */
+
+#define EVENT_NOT_WRITTEN G_MININT64
+
+/**
+ * PsyParallelTriggerEvent:
+ *
+ * A PsyParallelTriggerEvent describes one trigger in a sequence of triggers
+ * that may be handed to [method@ParallelTrigger.schedule_events]. It contains
+ * the mask that should be written, when it should be written and for how long.
+ * Once the trigger has been written, the event also tells when the mask
+ * has actually been written to and cleared from the port.
+ */
+struct _PsyParallelTriggerEvent {
+    gint64 start; // us since the zero time of PsyClock
+    gint64 stop;
+    gint64 written_start;
+    gint64 written_stop;
+    guint8 mask;
+};
+
+G_DEFINE_BOXED_TYPE(PsyParallelTriggerEvent,
+                    psy_parallel_trigger_event,
+                    psy_parallel_trigger_event_copy,
+                    psy_parallel_trigger_event_free)
+
+/**
+ * psy_parallel_trigger_event_new:(constructor)
+ * @mask: the mask to write to the port
+ * @tstart: the time at which the mask should be written
+ * @dur: the duration after which the mask should be cleared again
+ *
+ * Returns: a new [struct@ParallelTriggerEvent] free it with
+ *          [method@ParallelTriggerEvent.free].
+ */
+PsyParallelTriggerEvent *
+psy_parallel_trigger_event_new(guint8        mask,
+                               PsyTimePoint *tstart,
+                               PsyDuration  *dur)
+{
+    g_return_val_if_fail(tstart != NULL, NULL);
+    g_return_val_if_fail(dur != NULL, NULL);
+
+    PsyParallelTriggerEvent *event = g_new(PsyParallelTriggerEvent, 1);
+
+    event->mask          = mask;
+    event->start         = tstart->ticks_since_start;
+    event->stop          = event->start + psy_duration_get_us(dur);
+    event->written_start = EVENT_NOT_WRITTEN;
+    event->written_stop  = EVENT_NOT_WRITTEN;
+
+    return event;
+}
+
+/**
+ * psy_parallel_trigger_event_copy:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns:(transfer full): a copy of @self
+ */
+PsyParallelTriggerEvent *
+psy_parallel_trigger_event_copy(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    PsyParallelTriggerEvent *copy = g_new(PsyParallelTriggerEvent, 1);
+    *copy                         = *self;
+    return copy;
+}
+
+/**
+ * psy_parallel_trigger_event_free:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Frees instances created with [ctor@ParallelTriggerEvent.new] or
+ * [method@ParallelTriggerEvent.copy].
+ */
+void
+psy_parallel_trigger_event_free(PsyParallelTriggerEvent *self)
+{
+    g_free(self);
+}
+
+/**
+ * psy_parallel_trigger_event_get_mask:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns: the mask that is written to the port by this event.
+ */
+guint8
+psy_parallel_trigger_event_get_mask(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return self->mask;
+}
+
+/**
+ * psy_parallel_trigger_event_get_start:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns:(transfer full): the requested start time of the trigger
+ */
+PsyTimePoint *
+psy_parallel_trigger_event_get_start(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    PsyTimePoint *tp      = psy_time_point_new();
+    tp->ticks_since_start = self->start;
+    return tp;
+}
+
+/**
+ * psy_parallel_trigger_event_get_duration:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns:(transfer full): the requested duration of the trigger
+ */
+PsyDuration *
+psy_parallel_trigger_event_get_duration(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    return psy_duration_new_us(self->stop - self->start);
+}
+
+/**
+ * psy_parallel_trigger_event_is_written:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Events that are canceled before they are finished are reported with
+ * the ones that are written. This function tells them apart.
+ *
+ * Returns: TRUE if the mask has been written to and cleared from the port.
+ */
+gboolean
+psy_parallel_trigger_event_is_written(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, FALSE);
+
+    return self->written_start != EVENT_NOT_WRITTEN
+           && self->written_stop != EVENT_NOT_WRITTEN;
+}
+
+/**
+ * psy_parallel_trigger_event_get_written_start:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns:(transfer full)(nullable): the time at which the mask was written
+ *         to the port, or NULL when it has not been written.
+ */
+PsyTimePoint *
+psy_parallel_trigger_event_get_written_start(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
 
-    gint loop = 1;
+    if (self->written_start == EVENT_NOT_WRITTEN)
+        return NULL;
+
+    PsyTimePoint *tp      = psy_time_point_new();
+    tp->ticks_since_start = self->written_start;
+    return tp;
+}
+
+/**
+ * psy_parallel_trigger_event_get_written_stop:
+ * @self: an instance of [struct@ParallelTriggerEvent]
+ *
+ * Returns:(transfer full)(nullable): the time at which the mask was
+ *         cleared from the port, or NULL when that has not happened.
+ */
+PsyTimePoint *
+psy_parallel_trigger_event_get_written_stop(PsyParallelTriggerEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    if (self->written_stop == EVENT_NOT_WRITTEN)
+        return NULL;
+
+    PsyTimePoint *tp      = psy_time_point_new();
+    tp->ticks_since_start = self->written_stop;
+    return tp;
+}
 
-    PsyDuration  *dur_test = NULL;
-    PsyTimePoint *now      = NULL;
+/* ************ the sequence worker ***************** */
+
+/*
+ * The sequence worker is one persistent thread per PsyParallelTrigger that
+ * executes all scheduled events. It sleeps on its message queue until it is
+ * within SPIN_WINDOW_US of the next edge and spins for the remainder. While
+ * waiting for an edge and writing the port no memory is allocated and no
+ * PsyClock/PsyTimePoint objects are created; all times are plain gint64
+ * microseconds since the zero time of PsyClock.
+ * Finished events are handed back to the main context in batches, just
+ * before the worker goes to sleep again.
+ *
+ * While spinning, the worker moves events between its arrays. Those arrays
+ * are kept large enough for all events that are known, so that moving an
+ * event never reallocates. The weak reference to the trigger is created on
+ * the thread that owns the trigger and is shared by all batches, the worker
+ * never touches the trigger itself.
+ */
+
+#define SPIN_WINDOW_US 2000
+
+typedef enum {
+    SEQ_MSG_STOP,
+    SEQ_MSG_EVENTS,
+    SEQ_MSG_CANCEL,
+} SequenceMessageType;
+
+typedef struct SequenceMessage {
+    SequenceMessageType type;
+    GPtrArray          *events; // owned, only for SEQ_MSG_EVENTS
+} SequenceMessage;
+
+typedef struct SequenceWorker {
+    GThread            *thread;
+    GAsyncQueue        *queue;
+    GMainContext       *context;
+    PsyTriggerDevice   *device;  // owned
+    GWeakRef           *trigger; // atomic rc box, shared with the batches
+    gint64              zero_time;
+
+    // state of the worker thread
+    GPtrArray *pending;  // sorted on start, the first event is the last
+    GPtrArray *active;   // events whose mask is currently on the device
+    GPtrArray *done;     // finished events, not yet reported
+    guint      capacity; // allocated size of active and done
+    guint8     device_value;
+} SequenceWorker;
+
+typedef struct SequenceBatch {
+    GWeakRef  *trigger; // atomic rc box
+    GPtrArray *events;
+} SequenceBatch;
+
+typedef enum {
+    SIG_FINISHED,
+    SIG_EVENTS_WRITTEN,
+    NUM_SIGNALS,
+} PsyParallelTriggerSignal;
+
+static guint trigger_signals[NUM_SIGNALS];
+
+static SequenceMessage *
+sequence_message_new(SequenceMessageType type, GPtrArray *events)
+{
+    SequenceMessage *msg = g_new(SequenceMessage, 1);
+    msg->type            = type;
+    msg->events          = events;
+    return msg;
+}
+
+static void
+sequence_message_free(SequenceMessage *msg)
+{
+    if (msg->events)
+        g_ptr_array_unref(msg->events);
+    g_free(msg);
+}
+
+static void
+sequence_batch_free(gpointer data)
+{
+    SequenceBatch *batch = data;
+    g_atomic_rc_box_release_full(batch->trigger,
+                                 (GDestroyNotify) g_weak_ref_clear);
+    g_ptr_array_unref(batch->events);
+    g_free(batch);
+}
+
+static gboolean
+sequence_batch_emit(gpointer data)
+{
+    SequenceBatch      *batch   = data;
+    PsyParallelTrigger *trigger = g_weak_ref_get(batch->trigger);
+
+    if (trigger) {
+        g_signal_emit(
+            trigger, trigger_signals[SIG_EVENTS_WRITTEN], 0, batch->events);
+        g_object_unref(trigger);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static inline gint64
+sequence_worker_now(SequenceWorker *self)
+{
+    return psy_clock_get_monotonic_time() - self->zero_time;
+}
+
+static gint
+compare_event_start_reversed(gconstpointer e1, gconstpointer e2)
+{
+    const PsyParallelTriggerEvent *ev1 = *(PsyParallelTriggerEvent **) e1;
+    const PsyParallelTriggerEvent *ev2 = *(PsyParallelTriggerEvent **) e2;
+
+    return (ev1->start < ev2->start) - (ev1->start > ev2->start);
+}
+
+static GPtrArray *
+event_array_new(guint capacity)
+{
+    return g_ptr_array_new_full(
+        capacity, (GDestroyNotify) psy_parallel_trigger_event_free);
+}
+
+/*
+ * Moves the events of *array to a new array that holds capacity events.
+ */
+static void
+event_array_grow(GPtrArray **array, guint capacity)
+{
+    GPtrArray *grown = event_array_new(capacity);
+
+    for (guint i = 0; i < (*array)->len; i++)
+        g_ptr_array_add(grown, g_ptr_array_index(*array, i));
+    g_ptr_array_set_free_func(*array, NULL);
+    g_ptr_array_unref(*array);
+
+    *array = grown;
+}
+
+/*
+ * Makes sure that the active and done arrays can hold all events that are
+ * known, so moving events between them while spinning never reallocates.
+ * This is called when events arrive, not while spinning.
+ */
+static void
+sequence_worker_reserve(SequenceWorker *self)
+{
+    guint needed = self->pending->len + self->active->len + self->done->len;
+    if (needed <= self->capacity)
+        return;
+
+    self->capacity = MAX(needed, self->capacity * 2);
+    event_array_grow(&self->active, self->capacity);
+    event_array_grow(&self->done, self->capacity);
+}
+
+/*
+ * The done array is replaced by a new one of the same capacity, so adding
+ * to it while spinning never reallocates.
+ */
+static void
+sequence_worker_flush(SequenceWorker *self)
+{
+    if (self->done->len == 0)
+        return;
+
+    SequenceBatch *batch = g_new(SequenceBatch, 1);
+    batch->trigger       = g_atomic_rc_box_acquire(self->trigger);
+    batch->events        = self->done;
+
+    self->done = event_array_new(self->capacity);
+
+    g_main_context_invoke_full(self->context,
+                               G_PRIORITY_DEFAULT,
+                               sequence_batch_emit,
+                               batch,
+                               sequence_batch_free);
+}
+
+static void
+sequence_worker_write(SequenceWorker *self, guint8 value)
+{
+    GError *error = NULL;
+
+    psy_trigger_device_write(self->device, value, &error);
+    if (error) {
+        g_critical("ParallelTrigger write failed: %s", error->message);
+        g_error_free(error);
+    }
+    self->device_value = value;
+}
+
+static guint8
+sequence_worker_active_mask(SequenceWorker *self)
+{
+    guint8 mask = 0;
+    for (guint i = 0; i < self->active->len; i++) {
+        PsyParallelTriggerEvent *ev = g_ptr_array_index(self->active, i);
+        mask |= ev->mask;
+    }
+    return mask;
+}
+
+/*
+ * Returns the time of the first event that should start or stop or
+ * G_MAXINT64 when there is nothing to do.
+ */
+static gint64
+sequence_worker_next_edge(SequenceWorker *self)
+{
+    gint64 next = G_MAXINT64;
+
+    if (self->pending->len > 0) {
+        PsyParallelTriggerEvent *ev
+            = g_ptr_array_index(self->pending, self->pending->len - 1);
+        next = ev->start;
+    }
+
+    for (guint i = 0; i < self->active->len; i++) {
+        PsyParallelTriggerEvent *ev = g_ptr_array_index(self->active, i);
+        next                        = MIN(next, ev->stop);
+    }
 
-    // Sleep loop untill less than 1ms from tp
-    while (loop) {
-        if (g_cancellable_is_cancelled(cancellable)) {
+    return next;
+}
+
+/*
+ * Starts the events that are due, and subsequently stops the events that
+ * are due, the port is written at most twice.
+ */
+static void
+sequence_worker_process_edges(SequenceWorker *self)
+{
+    gint64   now     = sequence_worker_now(self);
+    gboolean started = FALSE;
+    guint    ndone   = self->done->len;
+
+    while (self->pending->len > 0) {
+        PsyParallelTriggerEvent *ev
+            = g_ptr_array_index(self->pending, self->pending->len - 1);
+        if (ev->start > now)
             break;
+        g_ptr_array_steal_index(self->pending, self->pending->len - 1);
+        g_ptr_array_add(self->active, ev);
+        started = TRUE;
+    }
+
+    if (started) {
+        sequence_worker_write(self, sequence_worker_active_mask(self));
+        gint64 written = sequence_worker_now(self);
+        for (guint i = 0; i < self->active->len; i++) {
+            PsyParallelTriggerEvent *ev = g_ptr_array_index(self->active, i);
+            if (ev->written_start == EVENT_NOT_WRITTEN)
+                ev->written_start = written;
         }
-        now      = psy_clock_now(clock);
-        dur_test = psy_time_point_subtract(tp, now);
+        now = written;
+    }
 
-        if (psy_duration_less(dur_test, one_ms)) {
-            loop = 0;
+    for (guint i = self->active->len; i > 0; i--) {
+        PsyParallelTriggerEvent *ev = g_ptr_array_index(self->active, i - 1);
+        if (ev->stop <= now) {
+            g_ptr_array_steal_index(self->active, i - 1);
+            g_ptr_array_add(self->done, ev);
         }
-        else {
-            g_usleep(1000);
+    }
+
+    if (self->done->len > ndone) {
+        sequence_worker_write(self, sequence_worker_active_mask(self));
+        gint64 written = sequence_worker_now(self);
+        for (guint i = ndone; i < self->done->len; i++) {
+            PsyParallelTriggerEvent *ev = g_ptr_array_index(self->done, i);
+            ev->written_stop            = written;
         }
+    }
+}
+
+/*
+ * Drops all events that aren't finished yet, they are reported as
+ * not written.
+ */
+static void
+sequence_worker_cancel(SequenceWorker *self)
+{
+    while (self->active->len > 0)
+        g_ptr_array_add(self->done, g_ptr_array_steal_index(self->active, 0));
+
+    while (self->pending->len > 0)
+        g_ptr_array_add(
+            self->done,
+            g_ptr_array_steal_index(self->pending, self->pending->len - 1));
+
+    if (self->device_value)
+        sequence_worker_write(self, 0);
+
+    sequence_worker_flush(self);
+}
 
-        g_clear_pointer(&dur_test, psy_duration_free);
-        g_clear_pointer(&now, psy_time_point_free);
+static gboolean
+sequence_worker_handle_message(SequenceWorker *self, SequenceMessage *msg)
+{
+    gboolean running = TRUE;
+
+    switch (msg->type) {
+    case SEQ_MSG_EVENTS:
+        for (guint i = 0; i < msg->events->len; i++)
+            g_ptr_array_add(self->pending, g_ptr_array_index(msg->events, i));
+        // the events are owned by the pending array now
+        g_ptr_array_set_free_func(msg->events, NULL);
+        g_ptr_array_sort(self->pending, compare_event_start_reversed);
+        sequence_worker_reserve(self);
+        break;
+    case SEQ_MSG_CANCEL:
+        sequence_worker_cancel(self);
+        break;
+    case SEQ_MSG_STOP:
+        sequence_worker_cancel(self);
+        running = FALSE;
+        break;
+    default:
+        g_assert_not_reached();
     }
 
-    g_assert(!dur_test);
-    g_assert(!now);
+    sequence_message_free(msg);
+    return running;
+}
 
-    loop = 1;
+static void
+sequence_worker_raise_priority(void)
+{
+#if defined _WIN32
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        g_info("Unable to raise the priority of the trigger thread");
+#elif defined HAVE_PTHREAD_H
+    struct sched_param param
+        = {.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1};
+
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0)
+        g_info("Unable to use realtime scheduling for the trigger thread: %s",
+               g_strerror(ret));
+#endif
+}
 
-    // Busy loop until now >= tp
-    while (loop) {
-        if (g_cancellable_is_cancelled(cancellable)) {
-            break;
-        }
-        now      = psy_clock_now(clock);
-        dur_test = psy_time_point_subtract(tp, now);
+static gpointer
+sequence_worker_thread(gpointer data)
+{
+    SequenceWorker *self    = data;
+    gboolean        running = TRUE;
+
+    sequence_worker_raise_priority();
 
-        if (psy_duration_less(dur_test, null_ms)) {
-            loop = 0;
+    while (running) {
+        SequenceMessage *msg  = NULL;
+        gint64           next = sequence_worker_next_edge(self);
+        gint64           now  = sequence_worker_now(self);
+
+        if (next == G_MAXINT64) {
+            sequence_worker_flush(self);
+            msg = g_async_queue_pop(self->queue);
+        }
+        else if (next - now > SPIN_WINDOW_US) {
+            sequence_worker_flush(self);
+            msg = g_async_queue_timeout_pop(
+                self->queue, (guint64) (next - now - SPIN_WINDOW_US));
         }
         else {
-            // allow other threads to run.
-            g_thread_yield();
+            msg = g_async_queue_try_pop(self->queue);
         }
 
-        g_clear_pointer(&dur_test, psy_duration_free);
-        g_clear_pointer(&now, psy_time_point_free);
+        if (msg) {
+            running = sequence_worker_handle_message(self, msg);
+            continue;
+        }
+
+        if (next - sequence_worker_now(self) > SPIN_WINDOW_US)
+            continue; // we woke up early
+
+        while (sequence_worker_now(self) < next)
+            ; // spin
+
+        sequence_worker_process_edges(self);
     }
 
-    g_assert(!dur_test);
-    g_assert(!now);
+    return NULL;
+}
 
-    g_object_unref(clock);
-    psy_duration_free(one_ms);
-    psy_duration_free(null_ms);
+static SequenceWorker *
+sequence_worker_new(PsyParallelTrigger *trigger, PsyTriggerDevice *device)
+{
+    SequenceWorker *self = g_new0(SequenceWorker, 1);
+
+    self->queue     = g_async_queue_new();
+    self->context   = g_main_context_ref_thread_default();
+    self->device    = g_object_ref(device);
+    self->zero_time = psy_clock_get_zero_time();
+
+    // This runs on the thread that owns trigger, so it is alive here.
+    self->trigger = g_atomic_rc_box_new0(GWeakRef);
+    g_weak_ref_init(self->trigger, trigger);
+
+    self->capacity = 64;
+    self->pending  = event_array_new(self->capacity);
+    self->active   = event_array_new(self->capacity);
+    self->done     = event_array_new(self->capacity);
+
+    self->thread
+        = g_thread_new("ParallelTriggerThread", sequence_worker_thread, self);
+
+    return self;
 }
 
-// clang-format off
-G_DEFINE_QUARK(psy-parallel-trigger-error-quark, psy_parallel_trigger_error)
+static void
+sequence_worker_free(SequenceWorker *self)
+{
+    g_async_queue_push(self->queue, sequence_message_new(SEQ_MSG_STOP, NULL));
+    g_thread_join(self->thread);
 
-// clang-format on
+    g_async_queue_unref(self->queue);
+    g_main_context_unref(self->context);
+    g_object_unref(self->device);
+    g_atomic_rc_box_release_full(self->trigger,
+                                 (GDestroyNotify) g_weak_ref_clear);
+
+    g_ptr_array_unref(self->pending);
+    g_ptr_array_unref(self->active);
+    g_ptr_array_unref(self->done);
+
+    g_free(self);
+}
 
 typedef struct TriggerData {
     PsyTimePoint *trigger_start;
@@ -101,11 +682,17 @@ trigger_data_free(gpointer data)
  * it is not possible to trigger again.
  * Signals will be delivered when the stimulus is triggered or optionally when
  * the trigger stops.
+ *
+ * By default the trigger uses a [class@ParallelPort], but it can send its
+ * triggers via any [iface@TriggerDevice], e.g. a [class@SerialPort], see
+ * [ctor@ParallelTrigger.new_for_device].
  */
 
 typedef struct {
-    PsyParallelPort *port;
-    GTask           *trigger_task;
+    PsyParallelPort  *port;   // NULL when the device isn't a parallel port
+    PsyTriggerDevice *device; // the device the triggers are written to
+    GTask            *trigger_task;
+    SequenceWorker   *sequence_worker;
 } PsyParallelTriggerPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(PsyParallelTrigger,
@@ -117,33 +704,30 @@ typedef enum PsyParallelTriggerProperty {
     PORT_NUM,
     PORT_NAME,
     PORT_IS_OPEN,
+    DEVICE,
     NUM_PROPS,
 } PsyParallelTriggerProperty;
 
-typedef enum {
-    SIG_FINISHED,
-    NUM_SIGNALS,
-} PsyParallelTriggerSignal;
-
 static GParamSpec *trigger_props[NUM_PROPS];
-static guint       trigger_signals[NUM_SIGNALS];
-
-// There are currently no settable properties
-// static void
-// psy_parallel_trigger_set_property(GObject      *object,
-//                                   guint         property_id,
-//                                   const GValue *value,
-//                                   GParamSpec   *spec)
-// {
-//     PsyParallelTrigger *self = PSY_PARALLEL_TRI?GGER(object);
-//     // PsyParallelTriggerPrivate *priv
-//     //     = psy_parallel_trigger_get_instance_private(self);
-//
-//     switch ((PsyParallelTriggerProperty) property_id) {
-//     default:
-//         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
-//     }
-// }
+
+static void
+psy_parallel_trigger_set_property(GObject      *object,
+                                  guint         property_id,
+                                  const GValue *value,
+                                  GParamSpec   *spec)
+{
+    PsyParallelTrigger        *self = PSY_PARALLEL_TRIGGER(object);
+    PsyParallelTriggerPrivate *priv
+        = psy_parallel_trigger_get_instance_private(self);
+
+    switch ((PsyParallelTriggerProperty) property_id) {
+    case DEVICE:
+        priv->device = g_value_dup_object(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
 
 static void
 psy_parallel_trigger_get_property(GObject    *object,
@@ -157,14 +741,19 @@ psy_parallel_trigger_get_property(GObject    *object,
 
     switch ((PsyParallelTriggerProperty) property_id) {
     case PORT_NUM:
-        g_value_set_int(value, psy_parallel_port_get_port_num(priv->port));
+        g_value_set_int(value,
+                        priv->port ? psy_parallel_port_get_port_num(priv->port)
+                                   : -1);
         break;
     case PORT_NAME:
-        g_value_set_string(value, psy_parallel_port_get_port_name(priv->port));
+        g_value_set_string(value, psy_parallel_trigger_get_port_name(self));
         break;
     case PORT_IS_OPEN:
         g_value_set_boolean(value, psy_parallel_trigger_is_open(self));
         break;
+    case DEVICE:
+        g_value_set_object(value, priv->device);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
     }
@@ -173,10 +762,25 @@ psy_parallel_trigger_get_property(GObject    *object,
 static void
 psy_parallel_trigger_init(PsyParallelTrigger *self)
 {
-    PsyParallelTriggerPrivate *priv
-        = psy_parallel_trigger_get_instance_private(self);
+    (void) self;
+}
+
+static void
+psy_parallel_trigger_constructed(GObject *object)
+{
+    PsyParallelTriggerPrivate *priv = psy_parallel_trigger_get_instance_private(
+        PSY_PARALLEL_TRIGGER(object));
+
+    if (!priv->device) {
+        priv->port = psy_parallel_port_new();
+        if (priv->port)
+            priv->device = g_object_ref(PSY_TRIGGER_DEVICE(priv->port));
+    }
+    else if (PSY_IS_PARALLEL_PORT(priv->device)) {
+        priv->port = g_object_ref(PSY_PARALLEL_PORT(priv->device));
+    }
 
-    priv->port = psy_parallel_port_new();
+    G_OBJECT_CLASS(psy_parallel_trigger_parent_class)->constructed(object);
 }
 
 static void
@@ -185,7 +789,9 @@ psy_parallel_trigger_dispose(GObject *self)
     PsyParallelTriggerPrivate *priv
         = psy_parallel_trigger_get_instance_private(PSY_PARALLEL_TRIGGER(self));
 
+    g_clear_pointer(&priv->sequence_worker, sequence_worker_free);
     g_clear_object(&priv->port);
+    g_clear_object(&priv->device);
 
     G_OBJECT_CLASS(psy_parallel_trigger_parent_class)->dispose(self);
 }
@@ -195,9 +801,9 @@ psy_parallel_trigger_class_init(PsyParallelTriggerClass *cls)
 {
     GObjectClass *obj_cls = G_OBJECT_CLASS(cls);
 
-    // Currently there are no settable properties
-    // obj_cls->set_property = psy_parallel_trigger_set_property;
+    obj_cls->set_property = psy_parallel_trigger_set_property;
     obj_cls->get_property = psy_parallel_trigger_get_property;
+    obj_cls->constructed  = psy_parallel_trigger_constructed;
     obj_cls->dispose      = psy_parallel_trigger_dispose;
 
     /**
@@ -242,6 +848,20 @@ psy_parallel_trigger_class_init(PsyParallelTriggerClass *cls)
                                FALSE,
                                G_PARAM_READABLE);
 
+    /**
+     * PsyParallelTrigger:device:
+     *
+     * The [iface@TriggerDevice] that is used to write the triggers. When
+     * it isn't specified at construction time, a [class@ParallelPort] is
+     * used.
+     */
+    trigger_props[DEVICE]
+        = g_param_spec_object("device",
+                              "Device",
+                              "The device to write the triggers to",
+                              PSY_TYPE_TRIGGER_DEVICE,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
     g_object_class_install_properties(obj_cls, NUM_PROPS, trigger_props);
 
     /**
@@ -265,6 +885,31 @@ psy_parallel_trigger_class_init(PsyParallelTriggerClass *cls)
                                                  G_TYPE_UINT,
                                                  PSY_TYPE_TIME_POINT,
                                                  PSY_TYPE_TIME_POINT);
+
+    /**
+     * PsyParallelTrigger::events-written:
+     * @self: an instance of `PsyParallelTrigger`
+     * @events:(element-type PsyParallelTriggerEvent): the events that have
+     *         been handled by the trigger thread.
+     *
+     * This signal is emitted in the main context from which the events were
+     * scheduled with [method@ParallelTrigger.schedule_events]. Finished
+     * events are reported in batches, each event contains the times at which
+     * the mask was actually written to and cleared from the port. Events
+     * that were canceled are reported too, see
+     * [method@ParallelTriggerEvent.is_written].
+     */
+    trigger_signals[SIG_EVENTS_WRITTEN]
+        = g_signal_new("events-written",
+                       G_TYPE_FROM_CLASS(obj_cls),
+                       G_SIGNAL_RUN_LAST,
+                       0,
+                       NULL,
+                       NULL,
+                       NULL,
+                       G_TYPE_NONE,
+                       1,
+                       G_TYPE_PTR_ARRAY);
 }
 
 /**
@@ -284,6 +929,42 @@ psy_parallel_trigger_new(void)
     return trigger;
 }
 
+/**
+ * psy_parallel_trigger_new_for_device:(constructor)
+ * @device: the [iface@TriggerDevice] to write the triggers to
+ *
+ * Creates a new PsyParallelTrigger that writes its triggers to @device. When
+ * @device isn't a [class@ParallelPort] it should be opened and closed via its
+ * own API, [method@ParallelTrigger.open] only works for parallel ports.
+ *
+ * Returns: an instance of `PsyParallelTrigger`
+ */
+PsyParallelTrigger *
+psy_parallel_trigger_new_for_device(PsyTriggerDevice *device)
+{
+    g_return_val_if_fail(PSY_IS_TRIGGER_DEVICE(device), NULL);
+
+    return g_object_new(PSY_TYPE_PARALLEL_TRIGGER, "device", device, NULL);
+}
+
+/**
+ * psy_parallel_trigger_get_device:
+ * @self: an instance of `PsyParallelTrigger`
+ *
+ * Returns:(transfer none)(nullable): The device to which the triggers are
+ *         written.
+ */
+PsyTriggerDevice *
+psy_parallel_trigger_get_device(PsyParallelTrigger *self)
+{
+    g_return_val_if_fail(PSY_IS_PARALLEL_TRIGGER(self), NULL);
+
+    PsyParallelTriggerPrivate *priv
+        = psy_parallel_trigger_get_instance_private(self);
+
+    return priv->device;
+}
+
 /**
  * psy_parallel_trigger_open:
  * @self: an instance of PsyParallelTrigger
@@ -304,6 +985,15 @@ psy_parallel_trigger_open(PsyParallelTrigger *self,
     g_return_if_fail(PSY_IS_PARALLEL_TRIGGER(self));
     g_return_if_fail(error == NULL || *error == NULL);
 
+    if (!priv->port) {
+        g_set_error(error,
+                    PSY_PARALLEL_TRIGGER_ERROR,
+                    PSY_PARALLEL_TRIGGER_ERROR_FAILED,
+                    "The device of this trigger isn't a parallel port, "
+                    "open the device itself");
+        return;
+    }
+
     psy_parallel_port_open(priv->port, dev_num, error);
 }
 
@@ -313,7 +1003,8 @@ psy_parallel_trigger_open(PsyParallelTrigger *self,
  *
  * Closes the device when it's opened. This releases some of the resources
  * related to opening the parallel port. When the device is destroyed, it will
- * also be closed.
+ * also be closed. Other trigger devices aren't closed, but pending triggers
+ * are dropped.
  */
 void
 psy_parallel_trigger_close(PsyParallelTrigger *self)
@@ -323,7 +1014,9 @@ psy_parallel_trigger_close(PsyParallelTrigger *self)
 
     g_return_if_fail(PSY_IS_PARALLEL_TRIGGER(self));
 
-    psy_parallel_port_close(priv->port);
+    g_clear_pointer(&priv->sequence_worker, sequence_worker_free);
+    if (priv->port)
+        psy_parallel_port_close(priv->port);
 }
 
 /**
@@ -342,7 +1035,7 @@ psy_parallel_trigger_is_open(PsyParallelTrigger *self)
     PsyParallelTriggerPrivate *priv
         = psy_parallel_trigger_get_instance_private(self);
 
-    return psy_parallel_port_is_open(priv->port);
+    return priv->device && psy_trigger_device_is_open(priv->device);
 }
 
 /**
@@ -365,7 +1058,10 @@ psy_parallel_trigger_get_port_name(PsyParallelTrigger *self)
 
     g_return_val_if_fail(PSY_IS_PARALLEL_TRIGGER(self), NULL);
 
-    return psy_parallel_port_get_port_name(priv->port);
+    if (!priv->device)
+        return "";
+
+    return psy_trigger_device_get_name(priv->device);
 }
 
 void
@@ -432,7 +1128,7 @@ write_thread(GTask        *task,
         goto end;
     }
 
-    psy_parallel_port_write(PSY_PARALLEL_PORT(priv->port), data->mask, &error);
+    psy_trigger_device_write(priv->device, data->mask, &error);
     if (error) {
         g_critical("ParallelTrigger write failed: %s\n", error->message);
     }
@@ -444,7 +1140,7 @@ write_thread(GTask        *task,
         goto end;
     }
 
-    psy_parallel_port_write(PSY_PARALLEL_PORT(priv->port), 0, &error);
+    psy_trigger_device_write(priv->device, 0, &error);
     if (error) {
         g_printerr("Oops write failed: %s\n", error->message);
     }
@@ -558,7 +1254,7 @@ psy_parallel_trigger_write(PsyParallelTrigger *self,
     g_return_if_fail(PSY_IS_PARALLEL_TRIGGER(self));
     g_return_if_fail(error == NULL || *error == NULL);
 
-    if (!psy_parallel_port_is_open(priv->port)) {
+    if (!psy_parallel_trigger_is_open(self)) {
         g_set_error(error,
                     PSY_TYPE_PARALLEL_PORT_ERROR,
                     PSY_PARALLEL_PORT_ERROR_DEV_CLOSED,
@@ -615,8 +1311,9 @@ psy_parallel_trigger_write(PsyParallelTrigger *self,
  * @self: An instance of psy_parallel_trigger
  *
  * If there is an ongoing call to send a trigger or a trigger is busy, this
- * call will try to cancel that trigger. If nothing is going on, this does
- * nothing.
+ * call will try to cancel that trigger. Events scheduled with
+ * [method@ParallelTrigger.schedule_events] that haven't finished are dropped
+ * as well. If nothing is going on, this does nothing.
  * Note that this may be inconvenient, when the parallel port has just
  * triggered, but
  *
@@ -637,4 +1334,99 @@ psy_parallel_trigger_cancel(PsyParallelTrigger *self)
             g_critical("Unable to cancel trigger task");
         }
     }
+
+    if (priv->sequence_worker) {
+        g_async_queue_push(priv->sequence_worker->queue,
+                           sequence_message_new(SEQ_MSG_CANCEL, NULL));
+    }
+}
+
+/**
+ * psy_parallel_trigger_schedule:
+ * @self: an instance of `PsyParallelTrigger`
+ * @mask: the mask to write to the port
+ * @tstart: the timepoint at which the mask should be written
+ * @dur: the duration after which the port is cleared again
+ * @error: Errors are returned here.
+ *
+ * Schedules one trigger, see [method@ParallelTrigger.schedule_events].
+ */
+void
+psy_parallel_trigger_schedule(PsyParallelTrigger *self,
+                              guint8              mask,
+                              PsyTimePoint       *tstart,
+                              PsyDuration        *dur,
+                              GError            **error)
+{
+    g_return_if_fail(PSY_IS_PARALLEL_TRIGGER(self));
+    g_return_if_fail(tstart != NULL && dur != NULL);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    GPtrArray *events = g_ptr_array_new_full(
+        1, (GDestroyNotify) psy_parallel_trigger_event_free);
+    g_ptr_array_add(events, psy_parallel_trigger_event_new(mask, tstart, dur));
+
+    psy_parallel_trigger_schedule_events(self, events, error);
+
+    g_ptr_array_unref(events);
+}
+
+/**
+ * psy_parallel_trigger_schedule_events:
+ * @self: an instance of `PsyParallelTrigger`
+ * @events:(element-type PsyParallelTriggerEvent)(transfer none): the events
+ *         that should be written to the port.
+ * @error: Errors are returned here.
+ *
+ * Hands a list of events to the trigger thread of this trigger. Unlike
+ * [method@ParallelTrigger.write] this function may be called again while
+ * other events are still pending, so a trigger can be scheduled for each
+ * stimulus in advance. The events don't have to be sorted, and events that
+ * overlap in time are written as the bitwise or of their masks.
+ * One persistent thread, started the first time this function is called,
+ * waits for the deadlines and writes the port. The events are reported back
+ * with the actual write times via the
+ * [signal@ParallelTrigger::events-written] signal in the main context that
+ * was the thread default when this function was first called.
+ * It's not advisable to mix this function with
+ * [method@ParallelTrigger.write] as both will write to the same port.
+ */
+void
+psy_parallel_trigger_schedule_events(PsyParallelTrigger *self,
+                                     GPtrArray          *events,
+                                     GError            **error)
+{
+    g_return_if_fail(PSY_IS_PARALLEL_TRIGGER(self));
+    g_return_if_fail(events != NULL);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyParallelTriggerPrivate *priv
+        = psy_parallel_trigger_get_instance_private(self);
+
+    if (!psy_parallel_trigger_is_open(self)) {
+        g_set_error(error,
+                    PSY_PARALLEL_PORT_ERROR,
+                    PSY_PARALLEL_PORT_ERROR_DEV_CLOSED,
+                    "Parallel Port is closed.");
+        return;
+    }
+
+    if (events->len == 0)
+        return;
+
+    if (!priv->sequence_worker)
+        priv->sequence_worker = sequence_worker_new(self, priv->device);
+
+    GPtrArray *copy = g_ptr_array_new_full(
+        events->len, (GDestroyNotify) psy_parallel_trigger_event_free);
+    for (guint i = 0; i < events->len; i++) {
+        PsyParallelTriggerEvent *ev = g_ptr_array_index(events, i);
+        PsyParallelTriggerEvent *c  = psy_parallel_trigger_event_copy(ev);
+        c->written_start            = EVENT_NOT_WRITTEN;
+        c->written_stop             = EVENT_NOT_WRITTEN;
+        g_ptr_array_add(copy, c);
+    }
+
+    g_async_queue_push(priv->sequence_worker->queue,
+                       sequence_message_new(SEQ_MSG_EVENTS, copy));
 }
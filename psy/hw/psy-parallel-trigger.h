@@ -5,6 +5,7 @@
 #include "../psy-enums.h"
 #include "../psy-time-point.h"
 #include "psy-parallel-port.h"
+#include "psy-trigger-device.h"
 
 G_BEGIN_DECLS
 
@@ -13,6 +14,42 @@ G_BEGIN_DECLS
 G_MODULE_EXPORT GQuark
 psy_parallel_trigger_error_quark(void);
 
+typedef struct _PsyParallelTriggerEvent PsyParallelTriggerEvent;
+
+#define PSY_TYPE_PARALLEL_TRIGGER_EVENT psy_parallel_trigger_event_get_type()
+
+G_MODULE_EXPORT GType
+psy_parallel_trigger_event_get_type(void);
+
+G_MODULE_EXPORT PsyParallelTriggerEvent *
+psy_parallel_trigger_event_new(guint8        mask,
+                               PsyTimePoint *tstart,
+                               PsyDuration  *dur);
+
+G_MODULE_EXPORT PsyParallelTriggerEvent *
+psy_parallel_trigger_event_copy(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT void
+psy_parallel_trigger_event_free(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT guint8
+psy_parallel_trigger_event_get_mask(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT PsyTimePoint *
+psy_parallel_trigger_event_get_start(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT PsyDuration *
+psy_parallel_trigger_event_get_duration(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT gboolean
+psy_parallel_trigger_event_is_written(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT PsyTimePoint *
+psy_parallel_trigger_event_get_written_start(PsyParallelTriggerEvent *self);
+
+G_MODULE_EXPORT PsyTimePoint *
+psy_parallel_trigger_event_get_written_stop(PsyParallelTriggerEvent *self);
+
 #define PSY_TYPE_PARALLEL_TRIGGER psy_parallel_trigger_get_type()
 
 G_MODULE_EXPORT
@@ -32,6 +69,12 @@ typedef struct _PsyParallelTriggerClass {
 G_MODULE_EXPORT PsyParallelTrigger *
 psy_parallel_trigger_new(void);
 
+G_MODULE_EXPORT PsyParallelTrigger *
+psy_parallel_trigger_new_for_device(PsyTriggerDevice *device);
+
+G_MODULE_EXPORT PsyTriggerDevice *
+psy_parallel_trigger_get_device(PsyParallelTrigger *self);
+
 G_MODULE_EXPORT void
 psy_parallel_trigger_open(PsyParallelTrigger *self,
                           gint                dev_num,
@@ -61,6 +104,18 @@ psy_parallel_trigger_write_pin(PsyParallelTrigger *self,
                                PsyDuration        *duration,
                                GError            **error);
 
+G_MODULE_EXPORT void
+psy_parallel_trigger_schedule(PsyParallelTrigger *self,
+                              guint8              mask,
+                              PsyTimePoint       *tstart,
+                              PsyDuration        *dur,
+                              GError            **error);
+
+G_MODULE_EXPORT void
+psy_parallel_trigger_schedule_events(PsyParallelTrigger *self,
+                                     GPtrArray          *events,
+                                     GError            **error);
+
 G_MODULE_EXPORT void
 psy_parallel_trigger_cancel(PsyParallelTrigger *self);
 
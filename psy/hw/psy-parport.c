@@ -1,10 +1,13 @@
 
+#define _GNU_SOURCE // for ppoll
+
 #include "psy-parport.h"
 
 #include <error.h>
 #include <fcntl.h>
 #include <linux/parport.h>
 #include <linux/ppdev.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -193,7 +196,7 @@ parport_read(PsyParallelPort *self, GError **error)
             "Unable to read from a port that is not configured as input.");
     }
 
-    if (ioctl(pp->fd, PPWDATA, &lines) == -1) {
+    if (ioctl(pp->fd, PPRDATA, &lines) == -1) {
         g_set_error(error,
                     PSY_PARALLEL_PORT_ERROR,
                     PSY_PARALLEL_PORT_ERROR_FAILED,
@@ -217,6 +220,52 @@ parport_read_pin(PsyParallelPort *self, gint pin, GError **error)
     return pins & (1ul << pin) ? PSY_IO_LEVEL_HIGH : PSY_IO_LEVEL_LOW;
 }
 
+/*
+ * ppdev reports the interrupts of the port as readable on the file
+ * descriptor, the interrupt is raised when the nAck line goes low. When the
+ * port has no interrupt configured, this just waits for the timeout.
+ */
+static gboolean
+parport_wait_for_input(PsyParallelPort *self,
+                       gint64           timeout_us,
+                       GError         **error)
+{
+    PsyParport *pp = PSY_PARPORT(self);
+
+    if (!psy_parallel_port_is_open(self)) {
+        g_set_error(error,
+                    PSY_PARALLEL_PORT_ERROR,
+                    PSY_PARALLEL_PORT_ERROR_DEV_CLOSED,
+                    "Can't wait for input of a closed device");
+        return FALSE;
+    }
+
+    struct pollfd   pfd = {.fd = pp->fd, .events = POLLIN};
+    struct timespec timeout
+        = {.tv_sec  = timeout_us / G_USEC_PER_SEC,
+           .tv_nsec = (timeout_us % G_USEC_PER_SEC) * 1000};
+
+    int ret = ppoll(&pfd, 1, &timeout, NULL);
+    if (ret < 0) {
+        if (errno == EINTR)
+            return FALSE;
+        g_set_error(error,
+                    PSY_PARALLEL_PORT_ERROR,
+                    PSY_PARALLEL_PORT_ERROR_FAILED,
+                    "Unable to wait for input: %s",
+                    g_strerror(errno));
+        return FALSE;
+    }
+
+    if (ret > 0 && (pfd.revents & POLLIN)) {
+        int num_irqs = 0;
+        ioctl(pp->fd, PPCLRIRQ, &num_irqs);
+        return num_irqs > 0;
+    }
+
+    return FALSE;
+}
+
 static void
 psy_parport_class_init(PsyParportClass *cls)
 {
@@ -225,10 +274,11 @@ psy_parport_class_init(PsyParportClass *cls)
 
     PsyParallelPortClass *parallel_cls = PSY_PARALLEL_PORT_CLASS(cls);
 
-    parallel_cls->open      = parport_open;
-    parallel_cls->close     = parport_close;
-    parallel_cls->write     = parport_write;
-    parallel_cls->write_pin = parport_write_pin;
-    parallel_cls->read      = parport_read;
-    parallel_cls->read_pin  = parport_read_pin;
+    parallel_cls->open           = parport_open;
+    parallel_cls->close          = parport_close;
+    parallel_cls->write          = parport_write;
+    parallel_cls->write_pin      = parport_write_pin;
+    parallel_cls->read           = parport_read;
+    parallel_cls->read_pin       = parport_read_pin;
+    parallel_cls->wait_for_input = parport_wait_for_input;
 }
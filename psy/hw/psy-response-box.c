@@ -0,0 +1,740 @@
+
+#include "psy-response-box.h"
+#include "psy-clock.h"
+#include "psy-queue.h"
+
+// clang-format off
+G_DEFINE_QUARK(psy-response-box-error-quark, psy_response_box_error)
+
+// clang-format on
+
+/* ************ PsyResponseEvent ***************** */
+
+/**
+ * PsyResponseEvent:
+ *
+ * A PsyResponseEvent describes a transition of the input lines of a
+ * [class@ResponseBox]. It tells which lines have changed, what the state of
+ * the lines was after the transition and when the transition was detected.
+ */
+struct _PsyResponseEvent {
+    gint64 time; // us since the zero time of PsyClock
+    guint8 pins;
+    guint8 changed;
+};
+
+G_DEFINE_BOXED_TYPE(PsyResponseEvent,
+                    psy_response_event,
+                    psy_response_event_copy,
+                    psy_response_event_free)
+
+/**
+ * psy_response_event_copy:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns:(transfer full): a copy of @self
+ */
+PsyResponseEvent *
+psy_response_event_copy(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    PsyResponseEvent *copy = g_new(PsyResponseEvent, 1);
+    *copy                  = *self;
+    return copy;
+}
+
+/**
+ * psy_response_event_free:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Frees instances obtained with [method@ResponseEvent.copy].
+ */
+void
+psy_response_event_free(PsyResponseEvent *self)
+{
+    g_free(self);
+}
+
+/**
+ * psy_response_event_get_time:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns:(transfer full): the time at which the transition was detected.
+ */
+PsyTimePoint *
+psy_response_event_get_time(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, NULL);
+
+    PsyTimePoint *tp      = psy_time_point_new();
+    tp->ticks_since_start = self->time;
+    return tp;
+}
+
+/**
+ * psy_response_event_get_pins:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns: the state of all input lines after the transition.
+ */
+guint8
+psy_response_event_get_pins(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return self->pins;
+}
+
+/**
+ * psy_response_event_get_changed:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns: a mask of the lines that have changed in this transition.
+ */
+guint8
+psy_response_event_get_changed(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return self->changed;
+}
+
+/**
+ * psy_response_event_get_pressed:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns: a mask of the lines that went high in this transition.
+ */
+guint8
+psy_response_event_get_pressed(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return self->changed & self->pins;
+}
+
+/**
+ * psy_response_event_get_released:
+ * @self: an instance of [struct@ResponseEvent]
+ *
+ * Returns: a mask of the lines that went low in this transition.
+ */
+guint8
+psy_response_event_get_released(PsyResponseEvent *self)
+{
+    g_return_val_if_fail(self != NULL, 0);
+
+    return self->changed & ~self->pins;
+}
+
+/* ************ the sampler ***************** */
+
+/*
+ * The sampler is a thread that reads the port in a loop. In between reads
+ * it waits with psy_parallel_port_wait_for_input, which returns early when
+ * the backend detects a change of the input. Transitions are time stamped
+ * directly after the read and pushed on a lock free queue. The first sample
+ * that is pushed on an empty queue schedules a drain on the main context,
+ * the drain emits PsyResponseBox::response for every sample in the queue.
+ * The sampler never allocates memory while sampling the port, except for
+ * the source that is used to schedule the drain.
+ */
+
+#define DEFAULT_CAPACITY 1024
+#define DEFAULT_POLL_INTERVAL_US 100
+
+typedef struct Sampler {
+    GThread         *thread;
+    GMainContext    *context;
+    PsyParallelPort *port; // owned
+    PsyInputQueue   *queue;
+    GWeakRef         box; // initialized on the thread that owns the box
+    gint64           zero_time;
+
+    gint stop;            // atomic
+    gint poll_interval;   // atomic
+    gint drain_scheduled; // atomic
+    gint num_dropped;     // atomic
+} Sampler;
+
+typedef enum {
+    SIG_RESPONSE,
+    NUM_SIGNALS,
+} PsyResponseBoxSignal;
+
+static guint response_box_signals[NUM_SIGNALS];
+
+static void
+sampler_clear(gpointer data)
+{
+    Sampler *self = data;
+
+    g_main_context_unref(self->context);
+    g_object_unref(self->port);
+    psy_input_queue_free(self->queue);
+    g_weak_ref_clear(&self->box);
+}
+
+static void
+sampler_unref(Sampler *self)
+{
+    g_atomic_rc_box_release_full(self, sampler_clear);
+}
+
+static void
+response_box_add_dropped(PsyResponseBox *self, guint num_dropped);
+
+static gboolean
+sampler_drain(gpointer data)
+{
+    Sampler        *sampler = data;
+    PsyResponseBox *box     = g_weak_ref_get(&sampler->box);
+    PsyInputSample  sample;
+
+    // Samples pushed from now on will schedule a new drain.
+    g_atomic_int_set(&sampler->drain_scheduled, FALSE);
+
+    guint num_dropped = (guint) g_atomic_int_and(&sampler->num_dropped, 0);
+
+    while (psy_input_queue_pop(sampler->queue, &sample)) {
+        if (!box)
+            continue;
+
+        PsyResponseEvent event = {
+            .time    = sample.time,
+            .pins    = sample.pins,
+            .changed = sample.changed,
+        };
+        g_signal_emit(box, response_box_signals[SIG_RESPONSE], 0, &event);
+    }
+
+    if (box) {
+        if (num_dropped > 0)
+            response_box_add_dropped(box, num_dropped);
+        g_object_unref(box);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * The drain holds a reference to the sampler, it reaches the box via the weak
+ * reference of the sampler, so the sampler thread never touches the box.
+ */
+static void
+sampler_schedule_drain(Sampler *self)
+{
+    if (!g_atomic_int_compare_and_exchange(&self->drain_scheduled, FALSE, TRUE))
+        return;
+
+    g_main_context_invoke_full(self->context,
+                               G_PRIORITY_HIGH,
+                               sampler_drain,
+                               g_atomic_rc_box_acquire(self),
+                               (GDestroyNotify) sampler_unref);
+}
+
+typedef struct SamplerThreadData {
+    Sampler *sampler;
+    guint8   pins;
+} SamplerThreadData;
+
+static gpointer
+sampler_thread(gpointer data)
+{
+    SamplerThreadData *tdata   = data;
+    Sampler           *self    = tdata->sampler;
+    GError            *error   = NULL;
+    guint8             current = tdata->pins;
+
+    g_free(tdata);
+
+    while (!error && !g_atomic_int_get(&self->stop)) {
+        gint64 interval = g_atomic_int_get(&self->poll_interval);
+
+        psy_parallel_port_wait_for_input(self->port, interval, &error);
+        if (error)
+            break;
+
+        guint8 pins = psy_parallel_port_read(self->port, &error);
+        gint64 now  = psy_clock_get_monotonic_time() - self->zero_time;
+        if (error)
+            break;
+
+        if (pins == current)
+            continue;
+
+        PsyInputSample sample = {
+            .time    = now,
+            .pins    = pins,
+            .changed = pins ^ current,
+        };
+        current = pins;
+
+        if (!psy_input_queue_push(self->queue, &sample))
+            g_atomic_int_inc(&self->num_dropped);
+
+        sampler_schedule_drain(self);
+    }
+
+    if (error) {
+        g_warning("PsyResponseBox stopped sampling %s: %s",
+                  psy_parallel_port_get_port_name(self->port),
+                  error->message);
+        g_error_free(error);
+    }
+
+    return NULL;
+}
+
+static Sampler *
+sampler_new(PsyResponseBox  *box,
+            PsyParallelPort *port,
+            guint8           pins,
+            guint            capacity,
+            guint            poll_interval)
+{
+    PsyInputQueue *queue = psy_input_queue_new(capacity);
+    if (!queue)
+        return NULL;
+
+    Sampler *self = g_atomic_rc_box_new0(Sampler);
+
+    self->context       = g_main_context_ref_thread_default();
+    self->port          = g_object_ref(port);
+    self->queue         = queue;
+    self->zero_time     = psy_clock_get_zero_time();
+    self->poll_interval = (gint) poll_interval;
+
+    // This runs on the thread that owns box, before the thread may use it.
+    g_weak_ref_init(&self->box, box);
+
+    SamplerThreadData *tdata = g_new(SamplerThreadData, 1);
+    tdata->sampler           = self;
+    tdata->pins              = pins;
+
+    self->thread = g_thread_new("ResponseBoxThread", sampler_thread, tdata);
+
+    return self;
+}
+
+static void
+sampler_stop(Sampler *self)
+{
+    g_atomic_int_set(&self->stop, TRUE);
+    g_thread_join(self->thread);
+    self->thread = NULL;
+
+    sampler_unref(self);
+}
+
+/* ************ PsyResponseBox ***************** */
+
+/**
+ * PsyResponseBox:
+ *
+ * A PsyResponseBox collects the responses of a participant from the input
+ * lines of a [class@ParallelPort]. Once started with
+ * [method@ResponseBox.start], a dedicated thread samples the port and
+ * timestamps every transition of the lines with the time of [class@Clock].
+ * The transitions are delivered as [struct@ResponseEvent]s via the
+ * [signal@ResponseBox::response] signal in the main context from which the
+ * response box was started. Hence, the precision of the reaction times
+ * doesn't depend on how busy the main loop is.
+ *
+ * The thread waits in [method@ParallelPort.wait_for_input] between reads.
+ * When the backend is able to use interrupts, the thread wakes up as soon
+ * as the input changes, otherwise the port is polled every
+ * [property@ResponseBox:poll-interval] microseconds. Use a poll interval of
+ * 0 to poll the port continuously, at the cost of one CPU core.
+ *
+ * For testing purposes a [class@FakeParallelPort] may be used.
+ */
+typedef struct _PsyResponseBox {
+    GObject parent;
+
+    PsyParallelPort *port;
+    Sampler         *sampler;
+    guint            capacity;
+    guint            poll_interval;
+    guint            num_dropped;
+} PsyResponseBox;
+
+G_DEFINE_FINAL_TYPE(PsyResponseBox, psy_response_box, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PORT,
+    CAPACITY,
+    POLL_INTERVAL,
+    IS_RUNNING,
+    NUM_DROPPED,
+    NUM_PROPS,
+} PsyResponseBoxProperty;
+
+static GParamSpec *response_box_props[NUM_PROPS];
+
+static void
+response_box_add_dropped(PsyResponseBox *self, guint num_dropped)
+{
+    self->num_dropped += num_dropped;
+    g_warning("PsyResponseBox dropped %u responses, the queue is full",
+              num_dropped);
+    g_object_notify_by_pspec(G_OBJECT(self), response_box_props[NUM_DROPPED]);
+}
+
+static void
+psy_response_box_set_property(GObject      *object,
+                              guint         property_id,
+                              const GValue *value,
+                              GParamSpec   *spec)
+{
+    PsyResponseBox *self = PSY_RESPONSE_BOX(object);
+
+    switch ((PsyResponseBoxProperty) property_id) {
+    case PORT:
+        self->port = g_value_dup_object(value);
+        break;
+    case CAPACITY:
+        self->capacity = g_value_get_uint(value);
+        break;
+    case POLL_INTERVAL:
+        psy_response_box_set_poll_interval(self, g_value_get_uint(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_response_box_get_property(GObject    *object,
+                              guint       property_id,
+                              GValue     *value,
+                              GParamSpec *spec)
+{
+    PsyResponseBox *self = PSY_RESPONSE_BOX(object);
+
+    switch ((PsyResponseBoxProperty) property_id) {
+    case PORT:
+        g_value_set_object(value, self->port);
+        break;
+    case CAPACITY:
+        g_value_set_uint(value, self->capacity);
+        break;
+    case POLL_INTERVAL:
+        g_value_set_uint(value, self->poll_interval);
+        break;
+    case IS_RUNNING:
+        g_value_set_boolean(value, psy_response_box_is_running(self));
+        break;
+    case NUM_DROPPED:
+        g_value_set_uint(value, self->num_dropped);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_response_box_init(PsyResponseBox *self)
+{
+    self->capacity      = DEFAULT_CAPACITY;
+    self->poll_interval = DEFAULT_POLL_INTERVAL_US;
+}
+
+static void
+psy_response_box_dispose(GObject *object)
+{
+    PsyResponseBox *self = PSY_RESPONSE_BOX(object);
+
+    g_clear_pointer(&self->sampler, sampler_stop);
+    g_clear_object(&self->port);
+
+    G_OBJECT_CLASS(psy_response_box_parent_class)->dispose(object);
+}
+
+static void
+psy_response_box_class_init(PsyResponseBoxClass *klass)
+{
+    GObjectClass *obj_cls = G_OBJECT_CLASS(klass);
+
+    obj_cls->set_property = psy_response_box_set_property;
+    obj_cls->get_property = psy_response_box_get_property;
+    obj_cls->dispose      = psy_response_box_dispose;
+
+    /**
+     * PsyResponseBox:port:
+     *
+     * The [class@ParallelPort] that is sampled. The port should be opened
+     * and configured as input before the response box is started.
+     */
+    response_box_props[PORT]
+        = g_param_spec_object("port",
+                              "Port",
+                              "The parallel port to sample",
+                              PSY_TYPE_PARALLEL_PORT,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyResponseBox:capacity:
+     *
+     * The number of responses that can be buffered before they are
+     * delivered in the main context. Responses that don't fit are dropped,
+     * see [property@ResponseBox:num-dropped].
+     */
+    response_box_props[CAPACITY]
+        = g_param_spec_uint("capacity",
+                            "Capacity",
+                            "The number of responses that can be buffered",
+                            1,
+                            G_MAXINT,
+                            DEFAULT_CAPACITY,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyResponseBox:poll-interval:
+     *
+     * The maximum number of microseconds the sampling thread waits between
+     * two reads of the port. This may be changed while the response box is
+     * running.
+     */
+    response_box_props[POLL_INTERVAL] = g_param_spec_uint(
+        "poll-interval",
+        "PollInterval",
+        "The maximum time in us between two samples of the port",
+        0,
+        G_MAXINT,
+        DEFAULT_POLL_INTERVAL_US,
+        G_PARAM_READWRITE);
+
+    /**
+     * PsyResponseBox:is-running:
+     *
+     * TRUE when the port is being sampled.
+     */
+    response_box_props[IS_RUNNING]
+        = g_param_spec_boolean("is-running",
+                               "IsRunning",
+                               "Whether the port is being sampled",
+                               FALSE,
+                               G_PARAM_READABLE);
+
+    /**
+     * PsyResponseBox:num-dropped:
+     *
+     * The number of responses that have been dropped, because the main
+     * context didn't handle them in time.
+     */
+    response_box_props[NUM_DROPPED]
+        = g_param_spec_uint("num-dropped",
+                            "NumDropped",
+                            "The number of responses that have been dropped",
+                            0,
+                            G_MAXUINT,
+                            0,
+                            G_PARAM_READABLE);
+
+    g_object_class_install_properties(obj_cls, NUM_PROPS, response_box_props);
+
+    /**
+     * PsyResponseBox::response:
+     * @self: an instance of `PsyResponseBox`
+     * @event: a [struct@ResponseEvent] describing the transition of the
+     *         input lines.
+     *
+     * This signal is emitted in the main context from which the response
+     * box was started, once for every transition of the input lines.
+     */
+    response_box_signals[SIG_RESPONSE]
+        = g_signal_new("response",
+                       G_TYPE_FROM_CLASS(obj_cls),
+                       G_SIGNAL_RUN_LAST,
+                       0,
+                       NULL,
+                       NULL,
+                       NULL,
+                       G_TYPE_NONE,
+                       1,
+                       PSY_TYPE_RESPONSE_EVENT);
+}
+
+/**
+ * psy_response_box_new:(constructor)
+ * @port: the [class@ParallelPort] to sample
+ *
+ * Returns: a new [class@ResponseBox] that samples @port
+ */
+PsyResponseBox *
+psy_response_box_new(PsyParallelPort *port)
+{
+    g_return_val_if_fail(PSY_IS_PARALLEL_PORT(port), NULL);
+
+    return g_object_new(PSY_TYPE_RESPONSE_BOX, "port", port, NULL);
+}
+
+/**
+ * psy_response_box_free:(skip)
+ *
+ * Frees instances created with [ctor@ResponseBox.new]
+ */
+void
+psy_response_box_free(PsyResponseBox *self)
+{
+    g_return_if_fail(PSY_IS_RESPONSE_BOX(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_response_box_get_port:
+ * @self: an instance of [class@ResponseBox]
+ *
+ * Returns:(transfer none): the port that is sampled by @self
+ */
+PsyParallelPort *
+psy_response_box_get_port(PsyResponseBox *self)
+{
+    g_return_val_if_fail(PSY_IS_RESPONSE_BOX(self), NULL);
+
+    return self->port;
+}
+
+/**
+ * psy_response_box_set_poll_interval:
+ * @self: an instance of [class@ResponseBox]
+ * @interval_us: the maximum time between two reads of the port
+ *
+ * See [property@ResponseBox:poll-interval]
+ */
+void
+psy_response_box_set_poll_interval(PsyResponseBox *self, guint interval_us)
+{
+    g_return_if_fail(PSY_IS_RESPONSE_BOX(self));
+    g_return_if_fail(interval_us <= G_MAXINT);
+
+    self->poll_interval = interval_us;
+    if (self->sampler)
+        g_atomic_int_set(&self->sampler->poll_interval, (gint) interval_us);
+}
+
+/**
+ * psy_response_box_get_poll_interval:
+ * @self: an instance of [class@ResponseBox]
+ *
+ * Returns: the maximum time in microseconds between two reads of the port.
+ */
+guint
+psy_response_box_get_poll_interval(PsyResponseBox *self)
+{
+    g_return_val_if_fail(PSY_IS_RESPONSE_BOX(self), 0);
+
+    return self->poll_interval;
+}
+
+/**
+ * psy_response_box_start:
+ * @self: an instance of [class@ResponseBox]
+ * @error: Errors are returned here.
+ *
+ * Starts sampling the port in a separate thread. The port should be open
+ * and configured as input. The responses are delivered in the thread
+ * default main context of the calling thread.
+ */
+void
+psy_response_box_start(PsyResponseBox *self, GError **error)
+{
+    g_return_if_fail(PSY_IS_RESPONSE_BOX(self));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    if (self->sampler) {
+        g_set_error(error,
+                    PSY_RESPONSE_BOX_ERROR,
+                    PSY_RESPONSE_BOX_ERROR_RUNNING,
+                    "The response box is already running");
+        return;
+    }
+
+    if (!self->port || !psy_parallel_port_is_input(self->port)) {
+        g_set_error(error,
+                    PSY_RESPONSE_BOX_ERROR,
+                    PSY_RESPONSE_BOX_ERROR_PORT,
+                    "The port should be open and configured as input");
+        return;
+    }
+
+    // The initial state is read here, so responses given directly after
+    // this function returns are not missed.
+    GError *read_error = NULL;
+    guint8  pins       = psy_parallel_port_read(self->port, &read_error);
+    if (read_error) {
+        g_set_error(error,
+                    PSY_RESPONSE_BOX_ERROR,
+                    PSY_RESPONSE_BOX_ERROR_PORT,
+                    "Unable to read the port: %s",
+                    read_error->message);
+        g_error_free(read_error);
+        return;
+    }
+
+    self->sampler = sampler_new(
+        self, self->port, pins, self->capacity, self->poll_interval);
+    if (!self->sampler) {
+        g_set_error(error,
+                    PSY_RESPONSE_BOX_ERROR,
+                    PSY_RESPONSE_BOX_ERROR_FAILED,
+                    "Unable to allocate a queue for %u responses",
+                    self->capacity);
+        return;
+    }
+
+    g_object_notify_by_pspec(G_OBJECT(self), response_box_props[IS_RUNNING]);
+}
+
+/**
+ * psy_response_box_stop:
+ * @self: an instance of [class@ResponseBox]
+ *
+ * Stops sampling the port. Responses that have been sampled before,
+ * but that aren't delivered yet, are still delivered.
+ */
+void
+psy_response_box_stop(PsyResponseBox *self)
+{
+    g_return_if_fail(PSY_IS_RESPONSE_BOX(self));
+
+    if (!self->sampler)
+        return;
+
+    g_clear_pointer(&self->sampler, sampler_stop);
+
+    g_object_notify_by_pspec(G_OBJECT(self), response_box_props[IS_RUNNING]);
+}
+
+/**
+ * psy_response_box_is_running:
+ * @self: an instance of [class@ResponseBox]
+ *
+ * Returns: TRUE when the port is being sampled.
+ */
+gboolean
+psy_response_box_is_running(PsyResponseBox *self)
+{
+    g_return_val_if_fail(PSY_IS_RESPONSE_BOX(self), FALSE);
+
+    return self->sampler != NULL;
+}
+
+/**
+ * psy_response_box_get_num_dropped:
+ * @self: an instance of [class@ResponseBox]
+ *
+ * Returns: the number of responses that have been dropped since @self was
+ *          created.
+ */
+guint
+psy_response_box_get_num_dropped(PsyResponseBox *self)
+{
+    g_return_val_if_fail(PSY_IS_RESPONSE_BOX(self), 0);
+
+    return self->num_dropped;
+}
@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include "../psy-enums.h"
+#include "../psy-time-point.h"
+#include "psy-parallel-port.h"
+
+G_BEGIN_DECLS
+
+#define PSY_RESPONSE_BOX_ERROR psy_response_box_error_quark()
+
+G_MODULE_EXPORT GQuark
+psy_response_box_error_quark(void);
+
+typedef struct _PsyResponseEvent PsyResponseEvent;
+
+#define PSY_TYPE_RESPONSE_EVENT psy_response_event_get_type()
+
+G_MODULE_EXPORT GType
+psy_response_event_get_type(void);
+
+G_MODULE_EXPORT PsyResponseEvent *
+psy_response_event_copy(PsyResponseEvent *self);
+
+G_MODULE_EXPORT void
+psy_response_event_free(PsyResponseEvent *self);
+
+G_MODULE_EXPORT PsyTimePoint *
+psy_response_event_get_time(PsyResponseEvent *self);
+
+G_MODULE_EXPORT guint8
+psy_response_event_get_pins(PsyResponseEvent *self);
+
+G_MODULE_EXPORT guint8
+psy_response_event_get_changed(PsyResponseEvent *self);
+
+G_MODULE_EXPORT guint8
+psy_response_event_get_pressed(PsyResponseEvent *self);
+
+G_MODULE_EXPORT guint8
+psy_response_event_get_released(PsyResponseEvent *self);
+
+#define PSY_TYPE_RESPONSE_BOX psy_response_box_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyResponseBox, psy_response_box, PSY, RESPONSE_BOX, GObject)
+
+G_MODULE_EXPORT PsyResponseBox *
+psy_response_box_new(PsyParallelPort *port);
+
+G_MODULE_EXPORT void
+psy_response_box_free(PsyResponseBox *self);
+
+G_MODULE_EXPORT PsyParallelPort *
+psy_response_box_get_port(PsyResponseBox *self);
+
+G_MODULE_EXPORT void
+psy_response_box_set_poll_interval(PsyResponseBox *self, guint interval_us);
+
+G_MODULE_EXPORT guint
+psy_response_box_get_poll_interval(PsyResponseBox *self);
+
+G_MODULE_EXPORT void
+psy_response_box_start(PsyResponseBox *self, GError **error);
+
+G_MODULE_EXPORT void
+psy_response_box_stop(PsyResponseBox *self);
+
+G_MODULE_EXPORT gboolean
+psy_response_box_is_running(PsyResponseBox *self);
+
+G_MODULE_EXPORT guint
+psy_response_box_get_num_dropped(PsyResponseBox *self);
+
+G_END_DECLS
@@ -0,0 +1,673 @@
+
+#include "psy-serial-port.h"
+#include "psy-config.h"
+#include "psy-trigger-device-private.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#if defined(HAVE_LINUX_SERIAL_H)
+    #include <linux/serial.h>
+#endif
+
+// clang-format off
+G_DEFINE_QUARK(psy-serial-port-error-quark, psy_serial_port_error)
+
+// clang-format on
+
+/**
+ * PsySerialPort:
+ *
+ * PsySerialPort sends triggers over a serial (tty) device, as many
+ * (USB-)serial trigger interfaces of acquisition systems expect. Each mask
+ * is sent as one byte. The port is configured in raw mode (no line
+ * discipline processing of the bytes) with a configurable baud rate.
+ *
+ * By default each write waits with tcdrain() until the byte has been
+ * transmitted, so the time at which the write returns is close to the time
+ * the trigger arrives at the other end. On Linux the driver is additionally
+ * asked to use its low latency mode, which is ignored silently by devices
+ * that don't support it, such as pseudo terminals.
+ *
+ * PsySerialPort implements [iface@TriggerDevice], so it may be used with
+ * [ctor@ParallelTrigger.new_for_device].
+ */
+
+#define DEFAULT_BAUD_RATE 115200
+
+typedef struct _PsySerialPort {
+    GObject  parent;
+    gint     fd;
+    gchar   *port_name;
+    guint    baud_rate;
+    gboolean low_latency;
+    gboolean drain;
+
+    PsyWriteLatency latency;
+} PsySerialPort;
+
+static void
+psy_serial_port_trigger_device_init(PsyTriggerDeviceInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(
+    PsySerialPort,
+    psy_serial_port,
+    G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(PSY_TYPE_TRIGGER_DEVICE,
+                          psy_serial_port_trigger_device_init))
+
+typedef enum {
+    PROP_NULL,
+    PROP_PORT_NAME,
+    PROP_IS_OPEN,
+    PROP_BAUD_RATE,
+    PROP_LOW_LATENCY,
+    PROP_DRAIN,
+    NUM_PROPS,
+} PsySerialPortProperty;
+
+static GParamSpec *serial_port_properties[NUM_PROPS];
+
+static void
+psy_serial_port_set_property(GObject      *object,
+                             guint         property_id,
+                             const GValue *value,
+                             GParamSpec   *spec)
+{
+    PsySerialPort *self = PSY_SERIAL_PORT(object);
+
+    switch ((PsySerialPortProperty) property_id) {
+    case PROP_BAUD_RATE:
+        psy_serial_port_set_baud_rate(self, g_value_get_uint(value));
+        break;
+    case PROP_LOW_LATENCY:
+        psy_serial_port_set_low_latency(self, g_value_get_boolean(value));
+        break;
+    case PROP_DRAIN:
+        psy_serial_port_set_drain(self, g_value_get_boolean(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_serial_port_get_property(GObject    *object,
+                             guint       property_id,
+                             GValue     *value,
+                             GParamSpec *spec)
+{
+    PsySerialPort *self = PSY_SERIAL_PORT(object);
+
+    switch ((PsySerialPortProperty) property_id) {
+    case PROP_PORT_NAME:
+        g_value_set_string(value, psy_serial_port_get_port_name(self));
+        break;
+    case PROP_IS_OPEN:
+        g_value_set_boolean(value, psy_serial_port_is_open(self));
+        break;
+    case PROP_BAUD_RATE:
+        g_value_set_uint(value, self->baud_rate);
+        break;
+    case PROP_LOW_LATENCY:
+        g_value_set_boolean(value, self->low_latency);
+        break;
+    case PROP_DRAIN:
+        g_value_set_boolean(value, self->drain);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_serial_port_init(PsySerialPort *self)
+{
+    self->fd          = -1;
+    self->port_name   = NULL;
+    self->baud_rate   = DEFAULT_BAUD_RATE;
+    self->low_latency = TRUE;
+    self->drain       = TRUE;
+    psy_write_latency_reset(&self->latency);
+}
+
+static void
+psy_serial_port_finalize(GObject *object)
+{
+    PsySerialPort *self = PSY_SERIAL_PORT(object);
+
+    psy_serial_port_close(self);
+
+    G_OBJECT_CLASS(psy_serial_port_parent_class)->finalize(object);
+}
+
+static gboolean
+baud_rate_to_speed(guint baud_rate, speed_t *speed)
+{
+    switch (baud_rate) {
+    case 9600:
+        *speed = B9600;
+        return TRUE;
+    case 19200:
+        *speed = B19200;
+        return TRUE;
+    case 38400:
+        *speed = B38400;
+        return TRUE;
+    case 57600:
+        *speed = B57600;
+        return TRUE;
+    case 115200:
+        *speed = B115200;
+        return TRUE;
+    case 230400:
+        *speed = B230400;
+        return TRUE;
+#if defined(B460800)
+    case 460800:
+        *speed = B460800;
+        return TRUE;
+#endif
+#if defined(B921600)
+    case 921600:
+        *speed = B921600;
+        return TRUE;
+#endif
+#if defined(B1000000)
+    case 1000000:
+        *speed = B1000000;
+        return TRUE;
+#endif
+#if defined(B2000000)
+    case 2000000:
+        *speed = B2000000;
+        return TRUE;
+#endif
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * Asks the driver to push received/transmitted bytes without delay. This is
+ * e.g. important for FTDI based USB adapters that otherwise buffer for up to
+ * 16 ms. Devices that don't know about it (like ptys) are fine without it.
+ */
+static void
+serial_port_apply_low_latency(PsySerialPort *self)
+{
+#if defined(HAVE_LINUX_SERIAL_H) && defined(TIOCGSERIAL)
+    struct serial_struct serial;
+
+    if (ioctl(self->fd, TIOCGSERIAL, &serial) != 0) {
+        g_debug("%s doesn't support TIOCGSERIAL: %s",
+                self->port_name,
+                g_strerror(errno));
+        return;
+    }
+
+    if (self->low_latency)
+        serial.flags |= ASYNC_LOW_LATENCY;
+    else
+        serial.flags &= ~ASYNC_LOW_LATENCY;
+
+    if (ioctl(self->fd, TIOCSSERIAL, &serial) != 0)
+        g_debug("Unable to set low latency mode on %s: %s",
+                self->port_name,
+                g_strerror(errno));
+#else
+    (void) self;
+#endif
+}
+
+static gboolean
+serial_port_configure(PsySerialPort *self, GError **error)
+{
+    struct termios tio;
+    speed_t        speed;
+
+    if (!baud_rate_to_speed(self->baud_rate, &speed)) {
+        g_set_error(error,
+                    PSY_SERIAL_PORT_ERROR,
+                    PSY_SERIAL_PORT_ERROR_BAUD_RATE,
+                    "A baud rate of %u is not supported",
+                    self->baud_rate);
+        return FALSE;
+    }
+
+    if (tcgetattr(self->fd, &tio) != 0)
+        goto error;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~CSTOPB;
+    tio.c_cc[VMIN]  = 0;
+    tio.c_cc[VTIME] = 0;
+
+    if (cfsetispeed(&tio, speed) != 0 || cfsetospeed(&tio, speed) != 0)
+        goto error;
+
+    if (tcsetattr(self->fd, TCSANOW, &tio) != 0)
+        goto error;
+
+    serial_port_apply_low_latency(self);
+
+    return TRUE;
+
+error:
+
+    g_set_error(error,
+                PSY_SERIAL_PORT_ERROR,
+                PSY_SERIAL_PORT_ERROR_OPEN,
+                "Unable to configure device %s: %s",
+                self->port_name,
+                g_strerror(errno));
+    return FALSE;
+}
+
+static gboolean
+serial_port_trigger_is_open(PsyTriggerDevice *self)
+{
+    return psy_serial_port_is_open(PSY_SERIAL_PORT(self));
+}
+
+static const gchar *
+serial_port_trigger_get_name(PsyTriggerDevice *self)
+{
+    return psy_serial_port_get_port_name(PSY_SERIAL_PORT(self));
+}
+
+static void
+serial_port_trigger_write(PsyTriggerDevice *self, guint8 mask, GError **error)
+{
+    psy_serial_port_write(PSY_SERIAL_PORT(self), mask, error);
+}
+
+static void
+serial_port_trigger_write_batch(PsyTriggerDevice *self,
+                                const guint8     *masks,
+                                gsize             n_masks,
+                                GError          **error)
+{
+    psy_serial_port_write_bytes(PSY_SERIAL_PORT(self), masks, n_masks, error);
+}
+
+static PsyWriteLatency *
+serial_port_trigger_get_write_latency(PsyTriggerDevice *self)
+{
+    return &PSY_SERIAL_PORT(self)->latency;
+}
+
+static void
+psy_serial_port_trigger_device_init(PsyTriggerDeviceInterface *iface)
+{
+    iface->is_open           = serial_port_trigger_is_open;
+    iface->get_name          = serial_port_trigger_get_name;
+    iface->write             = serial_port_trigger_write;
+    iface->write_batch       = serial_port_trigger_write_batch;
+    iface->get_write_latency = serial_port_trigger_get_write_latency;
+}
+
+static void
+psy_serial_port_class_init(PsySerialPortClass *klass)
+{
+    GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+    obj_class->set_property = psy_serial_port_set_property;
+    obj_class->get_property = psy_serial_port_get_property;
+    obj_class->finalize     = psy_serial_port_finalize;
+
+    /**
+     * PsySerialPort:port-name:
+     *
+     * The name of the device that has been opened, e.g. "/dev/ttyUSB0" or
+     * an empty string when the device is closed.
+     */
+    serial_port_properties[PROP_PORT_NAME]
+        = g_param_spec_string("port-name",
+                              "PortName",
+                              "The (file/device) name of the serial port",
+                              "",
+                              G_PARAM_READABLE);
+
+    /**
+     * PsySerialPort:is-open:
+     *
+     * Returns true when the device is open.
+     */
+    serial_port_properties[PROP_IS_OPEN]
+        = g_param_spec_boolean("is-open",
+                               "IsOpen",
+                               "Whether or not the port is open",
+                               FALSE,
+                               G_PARAM_READABLE);
+
+    /**
+     * PsySerialPort:baud-rate:
+     *
+     * The speed of the serial line in bits per second. When the port is
+     * open, the device is reconfigured.
+     */
+    serial_port_properties[PROP_BAUD_RATE]
+        = g_param_spec_uint("baud-rate",
+                            "BaudRate",
+                            "The speed of the serial line",
+                            9600,
+                            G_MAXUINT,
+                            DEFAULT_BAUD_RATE,
+                            G_PARAM_READWRITE);
+
+    /**
+     * PsySerialPort:low-latency:
+     *
+     * Whether the driver should be asked to use its low latency mode. This
+     * is only supported on Linux and only by some drivers.
+     */
+    serial_port_properties[PROP_LOW_LATENCY]
+        = g_param_spec_boolean("low-latency",
+                               "LowLatency",
+                               "Ask the driver to use its low latency mode",
+                               TRUE,
+                               G_PARAM_READWRITE);
+
+    /**
+     * PsySerialPort:drain:
+     *
+     * When TRUE, a write only returns once the bytes have been transmitted
+     * (see tcdrain()). Otherwise, the write returns as soon as the bytes are
+     * handed to the OS.
+     */
+    serial_port_properties[PROP_DRAIN]
+        = g_param_spec_boolean("drain",
+                               "Drain",
+                               "Wait until written bytes are transmitted",
+                               TRUE,
+                               G_PARAM_READWRITE);
+
+    g_object_class_install_properties(
+        obj_class, NUM_PROPS, serial_port_properties);
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_serial_port_new:(constructor)
+ *
+ * Returns: a new and closed [class@SerialPort]
+ */
+PsySerialPort *
+psy_serial_port_new(void)
+{
+    return g_object_new(PSY_TYPE_SERIAL_PORT, NULL);
+}
+
+/**
+ * psy_serial_port_free:(skip)
+ *
+ * Frees a serial port created with [ctor@SerialPort.new].
+ */
+void
+psy_serial_port_free(PsySerialPort *self)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_serial_port_open:
+ * @self: an instance of [class@SerialPort]
+ * @port_name: the name of the device e.g. "/dev/ttyUSB0"
+ * @error: Errors are returned here.
+ *
+ * Opens and configures the serial port. When the port was already open,
+ * it is closed first.
+ */
+void
+psy_serial_port_open(PsySerialPort *self,
+                     const gchar   *port_name,
+                     GError       **error)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+    g_return_if_fail(port_name != NULL);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    psy_serial_port_close(self);
+
+    errno    = 0;
+    self->fd = open(port_name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (self->fd < 0) {
+        g_set_error(error,
+                    PSY_SERIAL_PORT_ERROR,
+                    PSY_SERIAL_PORT_ERROR_OPEN,
+                    "Unable to open %s: %s",
+                    port_name,
+                    g_strerror(errno));
+        return;
+    }
+    self->port_name = g_strdup(port_name);
+
+    if (!serial_port_configure(self, error)) {
+        psy_serial_port_close(self);
+        return;
+    }
+
+    tcflush(self->fd, TCIOFLUSH);
+}
+
+/**
+ * psy_serial_port_close:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Closes the port if it is open.
+ */
+void
+psy_serial_port_close(PsySerialPort *self)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+
+    if (self->fd >= 0) {
+        close(self->fd);
+        self->fd = -1;
+    }
+    g_clear_pointer(&self->port_name, g_free);
+}
+
+/**
+ * psy_serial_port_is_open:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Returns: TRUE when the port is open
+ */
+gboolean
+psy_serial_port_is_open(PsySerialPort *self)
+{
+    g_return_val_if_fail(PSY_IS_SERIAL_PORT(self), FALSE);
+
+    return self->fd >= 0;
+}
+
+/**
+ * psy_serial_port_get_port_name:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Returns: the name of the opened device or an empty string when closed
+ */
+const gchar *
+psy_serial_port_get_port_name(PsySerialPort *self)
+{
+    g_return_val_if_fail(PSY_IS_SERIAL_PORT(self), NULL);
+
+    return self->port_name ? self->port_name : "";
+}
+
+/**
+ * psy_serial_port_set_baud_rate:
+ * @self: an instance of [class@SerialPort]
+ * @baud_rate: the speed of the line e.g. 115200
+ *
+ * Set the baud rate of the port. When the port is open, it is reconfigured.
+ */
+void
+psy_serial_port_set_baud_rate(PsySerialPort *self, guint baud_rate)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+
+    self->baud_rate = baud_rate;
+
+    if (psy_serial_port_is_open(self)) {
+        GError *error = NULL;
+        if (!serial_port_configure(self, &error)) {
+            g_warning("Unable to set the baud rate: %s", error->message);
+            g_error_free(error);
+        }
+    }
+}
+
+/**
+ * psy_serial_port_get_baud_rate:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Returns: the baud rate of the port
+ */
+guint
+psy_serial_port_get_baud_rate(PsySerialPort *self)
+{
+    g_return_val_if_fail(PSY_IS_SERIAL_PORT(self), 0);
+
+    return self->baud_rate;
+}
+
+/**
+ * psy_serial_port_set_low_latency:
+ * @self: an instance of [class@SerialPort]
+ * @low_latency: whether or not to use the low latency mode of the driver
+ */
+void
+psy_serial_port_set_low_latency(PsySerialPort *self, gboolean low_latency)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+
+    self->low_latency = low_latency;
+
+    if (psy_serial_port_is_open(self))
+        serial_port_apply_low_latency(self);
+}
+
+/**
+ * psy_serial_port_get_low_latency:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Returns: whether the low latency mode is requested
+ */
+gboolean
+psy_serial_port_get_low_latency(PsySerialPort *self)
+{
+    g_return_val_if_fail(PSY_IS_SERIAL_PORT(self), FALSE);
+
+    return self->low_latency;
+}
+
+/**
+ * psy_serial_port_set_drain:
+ * @self: an instance of [class@SerialPort]
+ * @drain: whether writes should wait until the bytes are transmitted
+ */
+void
+psy_serial_port_set_drain(PsySerialPort *self, gboolean drain)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+
+    self->drain = drain;
+}
+
+/**
+ * psy_serial_port_get_drain:
+ * @self: an instance of [class@SerialPort]
+ *
+ * Returns: whether writes wait until the bytes are transmitted
+ */
+gboolean
+psy_serial_port_get_drain(PsySerialPort *self)
+{
+    g_return_val_if_fail(PSY_IS_SERIAL_PORT(self), FALSE);
+
+    return self->drain;
+}
+
+/**
+ * psy_serial_port_write:
+ * @self: an instance of [class@SerialPort]
+ * @mask: the byte to send
+ * @error: Errors are returned here.
+ *
+ * Sends one byte over the serial line.
+ */
+void
+psy_serial_port_write(PsySerialPort *self, guint8 mask, GError **error)
+{
+    psy_serial_port_write_bytes(self, &mask, 1, error);
+}
+
+/**
+ * psy_serial_port_write_bytes:
+ * @self: an instance of [class@SerialPort]
+ * @bytes:(array length=n_bytes): the bytes to send
+ * @n_bytes: the number of bytes to send
+ * @error: Errors are returned here.
+ *
+ * Sends a number of bytes with as few system calls as possible. When
+ * [property@SerialPort:drain] is set, this returns after the last byte has
+ * been transmitted.
+ */
+void
+psy_serial_port_write_bytes(PsySerialPort *self,
+                            const guint8  *bytes,
+                            gsize          n_bytes,
+                            GError       **error)
+{
+    g_return_if_fail(PSY_IS_SERIAL_PORT(self));
+    g_return_if_fail(bytes != NULL || n_bytes == 0);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    if (!psy_serial_port_is_open(self)) {
+        g_set_error(error,
+                    PSY_SERIAL_PORT_ERROR,
+                    PSY_SERIAL_PORT_ERROR_DEV_CLOSED,
+                    "Can't write to closed device");
+        return;
+    }
+
+    gsize written = 0;
+    while (written < n_bytes) {
+        ssize_t ret = write(self->fd, bytes + written, n_bytes - written);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            g_set_error(error,
+                        PSY_SERIAL_PORT_ERROR,
+                        PSY_SERIAL_PORT_ERROR_FAILED,
+                        "Unable to write to %s: %s",
+                        self->port_name,
+                        g_strerror(errno));
+            return;
+        }
+        written += (gsize) ret;
+    }
+
+    if (self->drain) {
+        while (tcdrain(self->fd) != 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error(error,
+                        PSY_SERIAL_PORT_ERROR,
+                        PSY_SERIAL_PORT_ERROR_FAILED,
+                        "Unable to drain %s: %s",
+                        self->port_name,
+                        g_strerror(errno));
+            return;
+        }
+    }
+}
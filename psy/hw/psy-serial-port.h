@@ -0,0 +1,69 @@
+
+#pragma once
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include "../psy-enums.h"
+#include "psy-trigger-device.h"
+
+G_BEGIN_DECLS
+
+#define PSY_SERIAL_PORT_ERROR psy_serial_port_error_quark()
+
+G_MODULE_EXPORT GQuark
+psy_serial_port_error_quark(void);
+
+#define PSY_TYPE_SERIAL_PORT psy_serial_port_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(PsySerialPort, psy_serial_port, PSY, SERIAL_PORT, GObject)
+
+G_MODULE_EXPORT PsySerialPort *
+psy_serial_port_new(void);
+
+G_MODULE_EXPORT void
+psy_serial_port_free(PsySerialPort *self);
+
+G_MODULE_EXPORT void
+psy_serial_port_open(PsySerialPort *self,
+                     const gchar   *port_name,
+                     GError       **error);
+
+G_MODULE_EXPORT void
+psy_serial_port_close(PsySerialPort *self);
+
+G_MODULE_EXPORT gboolean
+psy_serial_port_is_open(PsySerialPort *self);
+
+G_MODULE_EXPORT const gchar *
+psy_serial_port_get_port_name(PsySerialPort *self);
+
+G_MODULE_EXPORT void
+psy_serial_port_set_baud_rate(PsySerialPort *self, guint baud_rate);
+
+G_MODULE_EXPORT guint
+psy_serial_port_get_baud_rate(PsySerialPort *self);
+
+G_MODULE_EXPORT void
+psy_serial_port_set_low_latency(PsySerialPort *self, gboolean low_latency);
+
+G_MODULE_EXPORT gboolean
+psy_serial_port_get_low_latency(PsySerialPort *self);
+
+G_MODULE_EXPORT void
+psy_serial_port_set_drain(PsySerialPort *self, gboolean drain);
+
+G_MODULE_EXPORT gboolean
+psy_serial_port_get_drain(PsySerialPort *self);
+
+G_MODULE_EXPORT void
+psy_serial_port_write(PsySerialPort *self, guint8 mask, GError **error);
+
+G_MODULE_EXPORT void
+psy_serial_port_write_bytes(PsySerialPort *self,
+                            const guint8  *bytes,
+                            gsize          n_bytes,
+                            GError       **error);
+
+G_END_DECLS
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "psy-trigger-device.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The write latency statistics of a trigger device. Implementations of
+ * PsyTriggerDevice embed one in their instance and return it from the
+ * get_write_latency vfunc. The fields are updated with atomics, so a
+ * realtime thread that writes triggers never takes a lock.
+ */
+struct _PsyWriteLatency {
+    guint64 num_writes;
+    gint64  sum;
+    gint64  min;
+    gint64  max;
+};
+
+void
+psy_write_latency_reset(PsyWriteLatency *self);
+
+G_END_DECLS
@@ -0,0 +1,297 @@
+
+#include "psy-trigger-device.h"
+#include "psy-clock.h"
+#include "psy-trigger-device-private.h"
+
+/**
+ * PsyTriggerDevice:
+ *
+ * PsyTriggerDevice is an interface for devices that are able to send a
+ * trigger to e.g. an EEG system. A trigger is a mask of 8 bits, for a
+ * [class@ParallelPort] the bits are put on the data lines, whereas a
+ * [class@SerialPort] sends the mask as one byte over the line.
+ *
+ * All writes via [method@TriggerDevice.write] and
+ * [method@TriggerDevice.write_batch] are timed. The time it takes to
+ * return from a write is collected per device, so the latency of different
+ * backends can be compared with [method@TriggerDevice.get_write_latency] or
+ * actively with [method@TriggerDevice.measure_write_latency].
+ */
+
+G_DEFINE_INTERFACE(PsyTriggerDevice, psy_trigger_device, G_TYPE_OBJECT)
+
+/**
+ * psy_write_latency_reset:(skip)
+ *
+ * Clears the statistics, implementations of [iface@TriggerDevice] call this
+ * when they initialize the instance.
+ *
+ * Stability: private
+ */
+void
+psy_write_latency_reset(PsyWriteLatency *self)
+{
+    __atomic_store_n(&self->num_writes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sum, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->min, G_MAXINT64, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->max, 0, __ATOMIC_RELAXED);
+}
+
+static PsyWriteLatency *
+get_write_latency(PsyTriggerDevice *self)
+{
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_val_if_fail(iface->get_write_latency, NULL);
+
+    return iface->get_write_latency(self);
+}
+
+/*
+ * Adds a write without locking, the trigger threads call this for every
+ * write.
+ */
+static void
+add_write_latency(PsyTriggerDevice *self, gint64 latency_us)
+{
+    PsyWriteLatency *latency = get_write_latency(self);
+    if (!latency)
+        return;
+
+    gint64 min = __atomic_load_n(&latency->min, __ATOMIC_RELAXED);
+    while (latency_us < min
+           && !__atomic_compare_exchange_n(&latency->min,
+                                           &min,
+                                           latency_us,
+                                           TRUE,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+        ;
+
+    gint64 max = __atomic_load_n(&latency->max, __ATOMIC_RELAXED);
+    while (latency_us > max
+           && !__atomic_compare_exchange_n(&latency->max,
+                                           &max,
+                                           latency_us,
+                                           TRUE,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+        ;
+
+    __atomic_fetch_add(&latency->sum, latency_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&latency->num_writes, 1, __ATOMIC_RELEASE);
+}
+
+static void
+trigger_device_write_batch(PsyTriggerDevice *self,
+                           const guint8     *masks,
+                           gsize             n_masks,
+                           GError          **error)
+{
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+
+    for (gsize i = 0; i < n_masks; i++) {
+        iface->write(self, masks[i], error);
+        if (error && *error)
+            return;
+    }
+}
+
+static void
+psy_trigger_device_default_init(PsyTriggerDeviceInterface *iface)
+{
+    iface->write_batch = trigger_device_write_batch;
+}
+
+/**
+ * psy_trigger_device_is_open:
+ * @self: an instance of [iface@TriggerDevice]
+ *
+ * Returns: TRUE if the device may be written to.
+ */
+gboolean
+psy_trigger_device_is_open(PsyTriggerDevice *self)
+{
+    g_return_val_if_fail(PSY_IS_TRIGGER_DEVICE(self), FALSE);
+
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_val_if_fail(iface->is_open, FALSE);
+
+    return iface->is_open(self);
+}
+
+/**
+ * psy_trigger_device_get_name:
+ * @self: an instance of [iface@TriggerDevice]
+ *
+ * Returns: the name of the device at the OS level, or an empty string
+ *          when the device isn't open.
+ */
+const gchar *
+psy_trigger_device_get_name(PsyTriggerDevice *self)
+{
+    g_return_val_if_fail(PSY_IS_TRIGGER_DEVICE(self), NULL);
+
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_val_if_fail(iface->get_name, NULL);
+
+    return iface->get_name(self);
+}
+
+/**
+ * psy_trigger_device_write:
+ * @self: an instance of [iface@TriggerDevice]
+ * @mask: the mask to write to the device
+ * @error: Errors are returned here.
+ *
+ * Writes the mask to the device, the time it takes until this call returns
+ * is added to the write latency statistics of this device.
+ */
+void
+psy_trigger_device_write(PsyTriggerDevice *self, guint8 mask, GError **error)
+{
+    g_return_if_fail(PSY_IS_TRIGGER_DEVICE(self));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_if_fail(iface->write);
+
+    gint64 start = psy_clock_get_monotonic_time();
+    iface->write(self, mask, error);
+    add_write_latency(self, psy_clock_get_monotonic_time() - start);
+}
+
+/**
+ * psy_trigger_device_write_batch:
+ * @self: an instance of [iface@TriggerDevice]
+ * @masks:(array length=n_masks): the masks to write to the device
+ * @n_masks: the number of masks
+ * @error: Errors are returned here.
+ *
+ * Writes a number of masks directly after each other. Backends such as
+ * [class@SerialPort] send them all in one system call. The time it takes
+ * to write the batch is added to the write latency statistics as one write.
+ */
+void
+psy_trigger_device_write_batch(PsyTriggerDevice *self,
+                               const guint8     *masks,
+                               gsize             n_masks,
+                               GError          **error)
+{
+    g_return_if_fail(PSY_IS_TRIGGER_DEVICE(self));
+    g_return_if_fail(masks != NULL || n_masks == 0);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    if (n_masks == 0)
+        return;
+
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_if_fail(iface->write_batch);
+
+    gint64 start = psy_clock_get_monotonic_time();
+    iface->write_batch(self, masks, n_masks, error);
+    add_write_latency(self, psy_clock_get_monotonic_time() - start);
+}
+
+/**
+ * psy_trigger_device_get_write_latency:
+ * @self: an instance of [iface@TriggerDevice]
+ * @mean:(out)(optional)(transfer full): the mean time a write took
+ * @min:(out)(optional)(transfer full): the fastest write
+ * @max:(out)(optional)(transfer full): the slowest write
+ * @num_writes:(out)(optional): the number of writes the statistics are
+ *             based on.
+ *
+ * Obtain statistics of the time it took for writes to return. When there
+ * haven't been any writes, the durations are 0. The statistics are updated
+ * without a lock, so a write that happens concurrently may be counted
+ * partially.
+ */
+void
+psy_trigger_device_get_write_latency(PsyTriggerDevice *self,
+                                     PsyDuration     **mean,
+                                     PsyDuration     **min,
+                                     PsyDuration     **max,
+                                     guint64          *num_writes)
+{
+    g_return_if_fail(PSY_IS_TRIGGER_DEVICE(self));
+
+    PsyWriteLatency *latency = get_write_latency(self);
+    g_return_if_fail(latency);
+
+    guint64 n  = __atomic_load_n(&latency->num_writes, __ATOMIC_ACQUIRE);
+    gint64  s  = __atomic_load_n(&latency->sum, __ATOMIC_RELAXED);
+    gint64  lo = __atomic_load_n(&latency->min, __ATOMIC_RELAXED);
+    gint64  hi = __atomic_load_n(&latency->max, __ATOMIC_RELAXED);
+
+    if (mean)
+        *mean = psy_duration_new_us(n ? s / (gint64) n : 0);
+    if (min)
+        *min = psy_duration_new_us(n ? lo : 0);
+    if (max)
+        *max = psy_duration_new_us(n ? hi : 0);
+    if (num_writes)
+        *num_writes = n;
+}
+
+/**
+ * psy_trigger_device_reset_write_latency:
+ * @self: an instance of [iface@TriggerDevice]
+ *
+ * Clears the write latency statistics of this device.
+ */
+void
+psy_trigger_device_reset_write_latency(PsyTriggerDevice *self)
+{
+    g_return_if_fail(PSY_IS_TRIGGER_DEVICE(self));
+
+    PsyWriteLatency *latency = get_write_latency(self);
+    g_return_if_fail(latency);
+
+    psy_write_latency_reset(latency);
+}
+
+/**
+ * psy_trigger_device_measure_write_latency:
+ * @self: an instance of [iface@TriggerDevice]
+ * @num_writes: the number of writes to perform
+ * @error: Errors are returned here.
+ *
+ * Writes a 0 mask @num_writes times to the device and returns the mean
+ * duration of a write. This allows to pick the fastest of the available
+ * devices, before the experiment starts. The writes are also added to the
+ * statistics of [method@TriggerDevice.get_write_latency].
+ *
+ * Returns:(transfer full)(nullable): the mean time it took for a write to
+ *         return, or NULL when an error occurred.
+ */
+PsyDuration *
+psy_trigger_device_measure_write_latency(PsyTriggerDevice *self,
+                                         guint             num_writes,
+                                         GError          **error)
+{
+    g_return_val_if_fail(PSY_IS_TRIGGER_DEVICE(self), NULL);
+    g_return_val_if_fail(num_writes > 0, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    PsyTriggerDeviceInterface *iface = PSY_TRIGGER_DEVICE_GET_IFACE(self);
+    g_return_val_if_fail(iface->write, NULL);
+
+    gint64 total = 0;
+
+    for (guint i = 0; i < num_writes; i++) {
+        GError *local_error = NULL;
+        gint64  start       = psy_clock_get_monotonic_time();
+
+        iface->write(self, 0, &local_error);
+
+        gint64 dur = psy_clock_get_monotonic_time() - start;
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return NULL;
+        }
+        add_write_latency(self, dur);
+        total += dur;
+    }
+
+    return psy_duration_new_us(total / num_writes);
+}
@@ -0,0 +1,76 @@
+
+#pragma once
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include "../psy-duration.h"
+
+G_BEGIN_DECLS
+
+#define PSY_TYPE_TRIGGER_DEVICE psy_trigger_device_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_INTERFACE(
+    PsyTriggerDevice, psy_trigger_device, PSY, TRIGGER_DEVICE, GObject)
+
+typedef struct _PsyWriteLatency PsyWriteLatency;
+
+/**
+ * PsyTriggerDeviceInterface:
+ * @is_open: Returns whether the device is ready to be written to.
+ * @get_name: Returns the (OS) name of the device, e.g. "/dev/parport0" or
+ *            "/dev/ttyUSB0".
+ * @write: Puts the mask on the device. Implementations should return as soon
+ *         as the mask has actually been handed to the hardware.
+ * @write_batch: Writes a number of masks in one go. This is optional, when
+ *               it isn't implemented, @write is called for each mask.
+ * @get_write_latency: Returns the storage for the write latency statistics,
+ *                     which the implementation embeds in its instance.
+ */
+struct _PsyTriggerDeviceInterface {
+    GTypeInterface parent_iface;
+
+    gboolean (*is_open)(PsyTriggerDevice *self);
+    const gchar *(*get_name)(PsyTriggerDevice *self);
+
+    void (*write)(PsyTriggerDevice *self, guint8 mask, GError **error);
+    void (*write_batch)(PsyTriggerDevice *self,
+                        const guint8     *masks,
+                        gsize             n_masks,
+                        GError          **error);
+
+    PsyWriteLatency *(*get_write_latency)(PsyTriggerDevice *self);
+};
+
+G_MODULE_EXPORT gboolean
+psy_trigger_device_is_open(PsyTriggerDevice *self);
+
+G_MODULE_EXPORT const gchar *
+psy_trigger_device_get_name(PsyTriggerDevice *self);
+
+G_MODULE_EXPORT void
+psy_trigger_device_write(PsyTriggerDevice *self, guint8 mask, GError **error);
+
+G_MODULE_EXPORT void
+psy_trigger_device_write_batch(PsyTriggerDevice *self,
+                               const guint8     *masks,
+                               gsize             n_masks,
+                               GError          **error);
+
+G_MODULE_EXPORT void
+psy_trigger_device_get_write_latency(PsyTriggerDevice *self,
+                                     PsyDuration     **mean,
+                                     PsyDuration     **min,
+                                     PsyDuration     **max,
+                                     guint64          *num_writes);
+
+G_MODULE_EXPORT void
+psy_trigger_device_reset_write_latency(PsyTriggerDevice *self);
+
+G_MODULE_EXPORT PsyDuration *
+psy_trigger_device_measure_write_latency(PsyTriggerDevice *self,
+                                         guint             num_writes,
+                                         GError          **error);
+
+G_END_DECLS
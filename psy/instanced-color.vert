@@ -0,0 +1,15 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;   // the vertex position of the mesh
+layout (location = 3) in mat4 aModel; // per instance, occupies location 3-6
+layout (location = 7) in vec4 aColor; // per instance
+
+uniform mat4 projection;
+
+out vec4 instanceColor;
+
+void main()
+{
+    gl_Position   = projection * aModel * vec4(aPos, 1.0);
+    instanceColor = aColor;
+}
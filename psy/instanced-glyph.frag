@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 texture_Coordinate;
+in vec4 instanceColor;
+
+uniform sampler2D pic_texture;
+
+out vec4 FragColor;
+
+void main()
+{
+    // The glyphs are white, their coverage is stored in the alpha channel.
+    FragColor = instanceColor * texture(pic_texture, texture_Coordinate);
+}
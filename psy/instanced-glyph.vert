@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;     // the vertex position of the unit square
+layout (location = 3) in mat4 aModel;   // per instance, occupies location 3-6
+layout (location = 7) in vec4 aColor;   // per instance
+layout (location = 8) in vec4 aTexRect; // per instance, u0, v0, u1, v1
+
+uniform mat4 projection;
+
+out vec2 texture_Coordinate;
+out vec4 instanceColor;
+
+void main()
+{
+    gl_Position = projection * aModel * vec4(aPos, 1.0);
+    // The left top of the unit square maps to the left top of the glyph.
+    texture_Coordinate = mix(aTexRect.xy,
+                             aTexRect.zw,
+                             vec2(aPos.x + 0.5, 0.5 - aPos.y));
+    instanceColor = aColor;
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 texture_Coordinate;
+
+uniform sampler2D pic_texture;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = texture(pic_texture, texture_Coordinate);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "psy-artist.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The shapes of the sdf program, these values must match the ones in
+ * sdf.frag.
+ */
+typedef enum {
+    PSY_SDF_SHAPE_ELLIPSE           = 0,
+    PSY_SDF_SHAPE_ANNULUS           = 1,
+    PSY_SDF_SHAPE_ROUNDED_RECTANGLE = 2,
+} PsySdfShape;
+
+void
+psy_artist_fill_instance(PsyArtist          *self,
+                         gfloat              scale_x,
+                         gfloat              scale_y,
+                         PsyVBufferInstance *instance);
+
+PsyVBuffer *
+psy_artist_get_unit_square(PsyArtist *self);
+
+void
+psy_artist_set_color_uniform(PsyArtist *self, GError **error);
+
+void
+psy_artist_draw_sdf(PsyArtist  *self,
+                    PsySdfShape shape,
+                    gfloat      half_width,
+                    gfloat      half_height,
+                    gfloat      parameter);
+
+G_END_DECLS
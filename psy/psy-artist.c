@@ -20,20 +20,58 @@
  */
 
 #include <epoxy/gl.h>
+#include <string.h>
 
+#include "psy-artist-private.h"
 #include "psy-artist.h"
 #include "psy-canvas.h"
+#include "psy-color-private.h"
+#include "psy-matrix4-private.h"
 #include "psy-matrix4.h"
-#include "psy-vector3.h"
+#include "psy-visual-stimulus-private.h"
 #include "psy-visual-stimulus.h"
 
+/*
+ * The handles of the uniforms that the artist sets each time it draws. The
+ * program is a weak pointer, so another program that is created at the same
+ * address can't be mistaken for it.
+ */
+typedef struct UniformHandles {
+    PsyShaderProgram *program; // weak, for which the handles are valid
+    gint              model;
+    gint              color;
+    gint              sdf_params;
+} UniformHandles;
+
 typedef struct _PsyArtistPrivate {
     PsyCanvas         *canvas;
     PsyDrawingContext *context;
     PsyVisualStimulus *stimulus;
     PsyMatrix4        *model;
+    guint              model_serial; // transform serial of model
+    UniformHandles     handles;      // of the program of the artist
+    UniformHandles     sdf_handles;  // of the sdf program
+    PsyVBuffer        *unit_square;  // shared via the context, not owned
 } PsyArtistPrivate;
 
+static const gchar *UNIT_SQUARE_MESH_NAME = "psy-unit-rectangle";
+
+static void
+uniform_handles_update(UniformHandles *handles, PsyShaderProgram *program)
+{
+    if (handles->program == program)
+        return;
+
+    // Uniforms that a program lacks get a handle of -1, so setting them fails.
+    g_set_weak_pointer(&handles->program, program);
+    handles->model
+        = psy_shader_program_get_uniform_handle(program, "model", NULL);
+    handles->color
+        = psy_shader_program_get_uniform_handle(program, "ourColor", NULL);
+    handles->sdf_params
+        = psy_shader_program_get_uniform_handle(program, "sdfParams", NULL);
+}
+
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyArtist, psy_artist, G_TYPE_OBJECT)
 
 typedef enum {
@@ -55,6 +93,8 @@ artist_dispose(GObject *object)
     g_clear_object(&priv->stimulus);
     g_clear_object(&priv->model);
     g_clear_object(&priv->context);
+    g_clear_weak_pointer(&priv->handles.program);
+    g_clear_weak_pointer(&priv->sdf_handles.program);
 
     G_OBJECT_CLASS(psy_artist_parent_class)->dispose(object);
 }
@@ -128,6 +168,26 @@ psy_artist_init(PsyArtist *self)
     priv->model = psy_matrix4_new_identity();
 }
 
+static void
+artist_update_model(PsyArtist *self)
+{
+    PsyArtistPrivate *priv = psy_artist_get_instance_private(self);
+
+    guint serial = psy_visual_stimulus_get_transform_serial(priv->stimulus);
+    if (serial == priv->model_serial)
+        return;
+
+    psy_matrix4_set_model_transform(
+        priv->model,
+        psy_visual_stimulus_get_x(priv->stimulus),
+        psy_visual_stimulus_get_y(priv->stimulus),
+        -psy_visual_stimulus_get_z(priv->stimulus),
+        psy_visual_stimulus_get_rotation(priv->stimulus),
+        psy_visual_stimulus_get_scale_x(priv->stimulus),
+        psy_visual_stimulus_get_scale_y(priv->stimulus));
+    priv->model_serial = serial;
+}
+
 static void
 artist_draw(PsyArtist *self)
 {
@@ -136,37 +196,17 @@ artist_draw(PsyArtist *self)
     GError           *error      = NULL;
     const gchar      *model_name = "model";
 
-    gfloat x = psy_visual_stimulus_get_x(priv->stimulus);
-    gfloat y = psy_visual_stimulus_get_y(priv->stimulus);
-    gfloat z = -psy_visual_stimulus_get_z(priv->stimulus);
-
-    PsyVector3 *translation
-        = g_object_new(PSY_TYPE_VECTOR3, "x", x, "y", y, "z", z, NULL);
+    artist_update_model(self);
 
-    gfloat scale_x = psy_visual_stimulus_get_scale_x(priv->stimulus);
-    gfloat scale_y = psy_visual_stimulus_get_scale_y(priv->stimulus);
-
-    PsyVector3 *scale_vec
-        = g_object_new(PSY_TYPE_VECTOR3, "x", scale_x, "y", scale_y, NULL);
-
-    gfloat rotation_degrees = psy_visual_stimulus_get_rotation(priv->stimulus);
-    PsyVector3 *z_axis
-        = g_object_new(PSY_TYPE_VECTOR3, "x", 0.0, "y", 0.0, "z", 1.0, NULL);
-
-    psy_matrix4_set_identity(priv->model);
-
-    psy_matrix4_translate(priv->model, translation);
-    psy_matrix4_rotate(priv->model, rotation_degrees, z_axis);
-    psy_matrix4_scale(priv->model, scale_vec);
-
-    psy_shader_program_use(psy_artist_get_program(self), &error);
+    psy_shader_program_use(program, &error);
     if (error) {
         g_critical("Unable to use program: %s", error->message);
         g_clear_error(&error);
     }
     else {
-        psy_shader_program_set_uniform_matrix4(
-            program, model_name, priv->model, &error);
+        uniform_handles_update(&priv->handles, program);
+        psy_shader_program_set_uniform_matrix4_by_handle(
+            program, priv->handles.model, priv->model, &error);
         if (error) {
             static int once = 0;
             if (!once) {
@@ -178,15 +218,18 @@ artist_draw(PsyArtist *self)
                     "a 4*4 matrix that handles the model transformations",
                     model_name,
                     error->message);
-                g_error_free(error);
-                error = NULL;
             }
+            g_clear_error(&error);
         }
     }
+}
 
-    g_object_unref(translation);
-    g_object_unref(scale_vec);
-    g_object_unref(z_axis);
+static gboolean
+artist_is_translucent(PsyArtist *self)
+{
+    PsyArtistPrivate *priv  = psy_artist_get_instance_private(self);
+    PsyColor         *color = psy_visual_stimulus_get_color(priv->stimulus);
+    return psy_color_get_alpha(color) < 1.0f;
 }
 
 static void
@@ -199,8 +242,9 @@ psy_artist_class_init(PsyArtistClass *klass)
     object_class->dispose      = artist_dispose;
     object_class->constructed  = artist_constructed;
 
-    klass->draw        = artist_draw;
-    klass->get_program = artist_get_program;
+    klass->draw           = artist_draw;
+    klass->get_program    = artist_get_program;
+    klass->is_translucent = artist_is_translucent;
 
     /**
      * Artist:stimulus:
@@ -362,3 +406,270 @@ psy_artist_get_context(PsyArtist *self)
 
     return priv->context;
 }
+
+/**
+ * psy_artist_get_model:
+ * @self: an instance of [class@Artist]
+ *
+ * Obtain the model matrix that positions, scales and rotates the stimulus of
+ * @self. The matrix is brought up to date with the stimulus, before it is
+ * returned. This is mainly intended for deriving classes that implement
+ * [vfunc@Artist.get_instance].
+ *
+ * Returns:(transfer none): the model matrix of @self
+ */
+PsyMatrix4 *
+psy_artist_get_model(PsyArtist *self)
+{
+    g_return_val_if_fail(PSY_IS_ARTIST(self), NULL);
+    PsyArtistPrivate *priv = psy_artist_get_instance_private(self);
+
+    artist_update_model(self);
+
+    return priv->model;
+}
+
+/**
+ * psy_artist_get_instance:
+ * @self: an instance of [class@Artist]
+ * @instance:(out caller-allocates): the model matrix and color of the
+ *           stimulus are returned here.
+ * @texture:(out)(transfer none): the texture atlas to draw the instance with
+ *          is returned here, it is left alone by artists that draw a
+ *          uniformly colored shape.
+ *
+ * Artists that draw a simple uniformly colored shape may be drawn together
+ * with other artists, with one instanced draw call, instead of each artist
+ * drawing its own stimulus. Those artists return a mesh that is shared with
+ * all artists that draw the same shape, the model matrix of @instance maps
+ * the mesh to the stimulus. Artists that draw a picture that lives in a
+ * [class@TextureAtlas] also return the atlas texture and the part of the atlas
+ * to show in the tex_rect of @instance. Other artists return NULL and are
+ * drawn with [method@Artist.draw].
+ *
+ * Returns:(transfer none)(nullable): the mesh that is drawn for @instance
+ *          or NULL when @self should draw its stimulus itself.
+ */
+PsyVBuffer *
+psy_artist_get_instance(PsyArtist          *self,
+                        PsyVBufferInstance *instance,
+                        PsyTexture        **texture)
+{
+    g_return_val_if_fail(PSY_IS_ARTIST(self), NULL);
+    g_return_val_if_fail(instance != NULL, NULL);
+    g_return_val_if_fail(texture != NULL, NULL);
+
+    PsyArtistClass *klass = PSY_ARTIST_GET_CLASS(self);
+    if (!klass->get_instance)
+        return NULL;
+
+    return klass->get_instance(self, instance, texture);
+}
+
+/**
+ * psy_artist_is_translucent:
+ * @self: an instance of [class@Artist]
+ *
+ * Tells whether the stimulus of @self is blended with what is drawn behind
+ * it. A canvas draws the translucent stimuli after the opaque ones, without
+ * writing their depth, see [property@Canvas:sort-stimuli]. A stimulus is
+ * translucent when the alpha of its color is below 1.0, but artists that
+ * draw with their own alpha, e.g. text, pictures with an alpha channel or
+ * shapes with smooth edges, are translucent as well.
+ *
+ * Returns: TRUE when the stimulus of @self is blended
+ */
+gboolean
+psy_artist_is_translucent(PsyArtist *self)
+{
+    g_return_val_if_fail(PSY_IS_ARTIST(self), FALSE);
+
+    PsyArtistClass *klass = PSY_ARTIST_GET_CLASS(self);
+    g_return_val_if_fail(klass->is_translucent, FALSE);
+
+    return klass->is_translucent(self);
+}
+
+/**
+ * psy_artist_fill_instance:(skip)
+ * @self: an instance of [class@Artist]
+ * @scale_x: scales the mesh along the x-axis to the size of the stimulus
+ * @scale_y: scales the mesh along the y-axis to the size of the stimulus
+ * @instance:(out caller-allocates): the instance to fill
+ *
+ * Fills @instance with the model matrix of @self, scaled by @scale_x and
+ * @scale_y, and with the color of the stimulus, the tex_rect is cleared. This
+ * is a helper for the artists that implement [vfunc@Artist.get_instance] with
+ * a unit mesh.
+ *
+ * Stability: private
+ */
+void
+psy_artist_fill_instance(PsyArtist          *self,
+                         gfloat              scale_x,
+                         gfloat              scale_y,
+                         PsyVBufferInstance *instance)
+{
+    PsyArtistPrivate *priv = psy_artist_get_instance_private(self);
+
+    artist_update_model(self);
+    psy_matrix4_get_elements(priv->model, instance->model);
+
+    // model * scale(scale_x, scale_y, 1), the matrix is column major.
+    for (guint row = 0; row < 4; row++) {
+        instance->model[row] *= scale_x;
+        instance->model[4 + row] *= scale_y;
+    }
+
+    PsyColor *color = psy_visual_stimulus_get_color(priv->stimulus);
+    if (color) {
+        memcpy(instance->color,
+               psy_color_get_rgba_values(color),
+               sizeof(instance->color));
+    }
+    else {
+        const gfloat black[4] = {0.0, 0.0, 0.0, 1.0};
+        memcpy(instance->color, black, sizeof(instance->color));
+    }
+    memset(instance->tex_rect, 0, sizeof(instance->tex_rect));
+}
+
+/**
+ * psy_artist_get_unit_square:(skip)
+ * @self: an instance of [class@Artist]
+ *
+ * Obtains a square of 1 * 1 around the origin, that may be drawn as a
+ * triangle fan. The square is shared by all artists of the drawing context.
+ *
+ * Returns:(transfer none)(nullable): the unit square
+ *
+ * Stability: private
+ */
+PsyVBuffer *
+psy_artist_get_unit_square(PsyArtist *self)
+{
+    PsyArtistPrivate *priv = psy_artist_get_instance_private(self);
+
+    if (priv->unit_square)
+        return priv->unit_square;
+
+    PsyVBuffer *mesh
+        = psy_drawing_context_get_vbuffer(priv->context, UNIT_SQUARE_MESH_NAME);
+
+    if (!mesh) {
+        GError *error = NULL;
+
+        mesh = psy_drawing_context_create_vbuffer(priv->context);
+        psy_vbuffer_set_nvertices(mesh, 4);
+        psy_vbuffer_set_xyz(mesh, 0, -0.5, 0.5, 0);
+        psy_vbuffer_set_xyz(mesh, 1, 0.5, 0.5, 0);
+        psy_vbuffer_set_xyz(mesh, 2, 0.5, -0.5, 0);
+        psy_vbuffer_set_xyz(mesh, 3, -0.5, -0.5, 0);
+
+        psy_drawing_context_register_vbuffer(
+            priv->context, UNIT_SQUARE_MESH_NAME, mesh, &error);
+        if (error) {
+            g_critical("PsyArtist: unable to register mesh: %s",
+                       error->message);
+            g_error_free(error);
+            return NULL;
+        }
+    }
+
+    priv->unit_square = mesh;
+    return mesh;
+}
+
+/**
+ * psy_artist_set_color_uniform:(skip)
+ * @self: an instance of [class@Artist]
+ * @error: an error is returned here when the color can't be set
+ *
+ * Sets the "ourColor" uniform of the program of @self to the color of its
+ * stimulus. This is intended for the artists that draw a uniformly colored
+ * shape, after they have chained up to [vfunc@Artist.draw], which makes the
+ * program current.
+ *
+ * Stability: private
+ */
+void
+psy_artist_set_color_uniform(PsyArtist *self, GError **error)
+{
+    PsyArtistPrivate *priv    = psy_artist_get_instance_private(self);
+    PsyShaderProgram *program = psy_artist_get_program(self);
+    gfloat            rgba[4] = {0, 0, 0, 1};
+
+    PsyColor *color = psy_visual_stimulus_get_color(priv->stimulus);
+    if (color)
+        memcpy(rgba, psy_color_get_rgba_values(color), sizeof(rgba));
+
+    uniform_handles_update(&priv->handles, program);
+    psy_shader_program_set_uniform_4f_by_handle(
+        program, priv->handles.color, rgba, error);
+}
+
+/**
+ * psy_artist_draw_sdf:(skip)
+ * @self: an instance of [class@Artist]
+ * @shape: the shape to draw
+ * @half_width: half the width of the shape
+ * @half_height: half the height of the shape
+ * @parameter: the inner radius of an annulus or the corner radius of a
+ *             rounded rectangle, not used for an ellipse.
+ *
+ * Draws the stimulus of @self as a smooth shape, using its model matrix and
+ * color. The shape is computed per fragment from its signed distance to the
+ * edge, so it is drawn on a single quad and its size may change freely.
+ * Artists that use this draw their stimulus with it instead of chaining
+ * up to [vfunc@Artist.draw].
+ *
+ * Stability: private
+ */
+void
+psy_artist_draw_sdf(PsyArtist  *self,
+                    PsySdfShape shape,
+                    gfloat      half_width,
+                    gfloat      half_height,
+                    gfloat      parameter)
+{
+    PsyArtistPrivate *priv  = psy_artist_get_instance_private(self);
+    GError           *error = NULL;
+    gfloat            rgba[4]   = {0, 0, 0, 1};
+    const gfloat      params[4] = {half_width, half_height, parameter, shape};
+
+    PsyShaderProgram *program
+        = psy_drawing_context_get_program(priv->context, PSY_SDF_PROGRAM_NAME);
+    PsyVBuffer *quad = psy_artist_get_unit_square(self);
+    if (!program || !quad) {
+        g_critical("PsyArtist: unable to draw a smooth shape, the %s is "
+                   "missing",
+                   program ? "unit square" : "sdf program");
+        return;
+    }
+
+    artist_update_model(self);
+
+    PsyColor *color = psy_visual_stimulus_get_color(priv->stimulus);
+    if (color)
+        memcpy(rgba, psy_color_get_rgba_values(color), sizeof(rgba));
+
+    psy_shader_program_use(program, &error);
+    uniform_handles_update(&priv->sdf_handles, program);
+    if (!error)
+        psy_shader_program_set_uniform_matrix4_by_handle(
+            program, priv->sdf_handles.model, priv->model, &error);
+    if (!error)
+        psy_shader_program_set_uniform_4f_by_handle(
+            program, priv->sdf_handles.color, rgba, &error);
+    if (!error)
+        psy_shader_program_set_uniform_4f_by_handle(
+            program, priv->sdf_handles.sdf_params, (gfloat *) params, &error);
+    if (!error)
+        psy_vbuffer_draw_triangle_fan(quad, &error);
+
+    if (error) {
+        g_critical("PsyArtist: unable to draw a smooth shape: %s",
+                   error->message);
+        g_clear_error(&error);
+    }
+}
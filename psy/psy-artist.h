@@ -34,14 +34,27 @@ G_DECLARE_DERIVABLE_TYPE(PsyArtist, psy_artist, PSY, ARTIST, GObject)
  * @get_program: This function obtains the shader program for this object. It
  *               is virtual, so that deriving classes may choose their own
  *               shader.
+ * @get_instance: Deriving classes that draw a uniformly colored shape or a
+ *                picture from a texture atlas may implement this in order to
+ *                be drawn in a batch with other instances of the same shape,
+ *                see [method@Artist.get_instance].
+ * @is_translucent: Returns whether the stimulus is blended with what is
+ *                  behind it. The default checks the alpha of the color of
+ *                  the stimulus, deriving classes that draw with their own
+ *                  alpha should override it, see
+ *                  [method@Artist.is_translucent].
  */
 typedef struct _PsyArtistClass {
     GObjectClass parent;
 
     void (*draw)(PsyArtist *self);
     PsyShaderProgram *(*get_program)(PsyArtist *self);
+    PsyVBuffer *(*get_instance)(PsyArtist          *self,
+                                PsyVBufferInstance *instance,
+                                PsyTexture        **texture);
+    gboolean (*is_translucent)(PsyArtist *self);
 
-    gpointer reserved[16];
+    gpointer reserved[14];
 
 } PsyArtistClass;
 
@@ -69,4 +82,15 @@ psy_artist_get_context(PsyArtist *self);
 G_MODULE_EXPORT PsyShaderProgram *
 psy_artist_get_program(PsyArtist *self);
 
+G_MODULE_EXPORT PsyMatrix4 *
+psy_artist_get_model(PsyArtist *self);
+
+G_MODULE_EXPORT PsyVBuffer *
+psy_artist_get_instance(PsyArtist          *self,
+                        PsyVBufferInstance *instance,
+                        PsyTexture        **texture);
+
+G_MODULE_EXPORT gboolean
+psy_artist_is_translucent(PsyArtist *self);
+
 G_END_DECLS
@@ -13,10 +13,17 @@
  * 2. Draw the stimuli.
  *    The [vfunc@Psy.Canvas.draw_stimuli] method should do two things:
  *      1. It will check the scheduled stimuli, to see whether there is
- *         a stimulus ready to present.
+ *         a stimulus ready to present. Stimuli that are scheduled, but not
+ *         yet started, wait in a queue sorted on their start frame, so only
+ *         the stimuli that start in this frame are looked at.
  *      2. It will allow the client to update the stimuli that should be
  *         presented and makes sure that the `PsyArtist`s will actually draw
  *         every stimulus.
+ *
+ * The OpenGL canvases draw with alpha blending enabled, the anti-aliased
+ * edges of smooth shapes and text need it. Hence, every stimulus whose color
+ * has an alpha below 1.0 is blended with what is behind it, see
+ * [property@VisualStimulus:color] and [property@Canvas:sort-stimuli].
  */
 
 #include <math.h>
@@ -31,6 +38,8 @@
 #include "psy-cross.h"
 #include "psy-drawing-context.h"
 #include "psy-duration.h"
+#include "psy-frame-stats.h"
+#include "psy-gpu-timer.h"
 #include "psy-matrix4.h"
 #include "psy-picture-artist.h"
 #include "psy-picture.h"
@@ -39,6 +48,7 @@
 #include "psy-shader-program.h"
 #include "psy-stimulus.h"
 #include "psy-time-point.h"
+#include "psy-vbuffer.h"
 #include "psy-visual-stimulus.h"
 
 typedef struct PsyCanvasPrivate {
@@ -49,17 +59,243 @@ typedef struct PsyCanvasPrivate {
     PsyFrameCount frame_count;
 
     PsyColor          *background_color;
-    GPtrArray         *stimuli; // owns a ref on the PsyStimulus
+    GArray            *stimuli;  // ScheduledStimulus'es drawn, in draw order
+    GArray            *incoming; // ScheduledStimulus'es without start frame
+    GArray            *pending;  // min-heap of ScheduledStimulus'es
+    guint64            num_scheduled; // the order of the next stimulus
     GHashTable        *artists; // owns a ref on the PsyStimulus and PsyArtist
     PsyDuration       *frame_dur;
     PsyDrawingContext *context;
 
     gint        projection_style;
     PsyMatrix4 *projection_matrix;
+
+    gboolean    batch_stimuli;
+    gboolean    sort_stimuli;
+    GArray     *draw_list;       // DrawItem's of the current frame
+    guint       num_translucent; // translucent DrawItem's in draw_list
+    PsyVBuffer *batch_mesh;      // the mesh of the current batch, not owned
+    PsyTexture *batch_texture;   // the atlas of the current batch, not owned
+    GArray     *batch;           // PsyVBufferInstance of the current batch
+    GPtrArray  *batch_artists;   // the artists of batch, not owned
+
+    gboolean       instrument;
+    PsyFrameStats *frame_stats;
+    PsyGpuTimer   *gpu_timer; // NULL when the context has no GPU timers
+    gboolean       gpu_timer_created;
 } PsyCanvasPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyCanvas, psy_canvas, G_TYPE_OBJECT)
 
+/*
+ * A stimulus that is scheduled on the canvas. The order in which stimuli
+ * are scheduled is also the order in which they are drawn.
+ */
+typedef struct ScheduledStimulus {
+    PsyVisualStimulus *stimulus; // owns a reference
+    guint64            order;
+} ScheduledStimulus;
+
+/*
+ * A stimulus that is drawn in the current frame, together with the state
+ * it needs to be drawn. None of the pointers is owned.
+ */
+typedef struct DrawItem {
+    PsyArtist         *artist;
+    PsyVisualStimulus *stimulus;
+    PsyShaderProgram  *program;  // only set when sorting
+    PsyVBuffer        *mesh;     // NULL when not drawn as an instance
+    PsyTexture        *texture;  // the atlas of an instanced picture
+    PsyVBufferInstance instance; // valid when mesh isn't NULL
+    gfloat             z;
+    gboolean           translucent;
+    guint              index; // the position in the draw order
+} DrawItem;
+
+/*
+ * Compares draw items such that the stimuli are drawn from back to front.
+ * Within a depth layer, the opaque stimuli come first, grouped on program,
+ * texture and mesh. The translucent ones follow in the reverse draw order,
+ * as they don't write depth, the stimulus scheduled last must be drawn last.
+ */
+static gint
+draw_item_compare(gconstpointer a, gconstpointer b)
+{
+    const DrawItem *item_a = a;
+    const DrawItem *item_b = b;
+
+    if (item_a->z != item_b->z)
+        return item_a->z < item_b->z ? -1 : 1;
+    if (item_a->translucent != item_b->translucent)
+        return item_a->translucent ? 1 : -1;
+    if (item_a->translucent)
+        return item_a->index > item_b->index ? -1
+                                             : item_a->index < item_b->index;
+    if (item_a->program != item_b->program)
+        return item_a->program < item_b->program ? -1 : 1;
+    if (item_a->texture != item_b->texture)
+        return item_a->texture < item_b->texture ? -1 : 1;
+    if (item_a->mesh != item_b->mesh)
+        return item_a->mesh < item_b->mesh ? -1 : 1;
+    return item_a->index < item_b->index ? -1 : item_a->index > item_b->index;
+}
+
+/*
+ * Compares draw items when the stimuli aren't sorted. The opaque stimuli
+ * keep their draw order and the depth test sorts them out. The translucent
+ * stimuli are drawn after them, from back to front.
+ */
+static gint
+draw_item_compare_translucent(gconstpointer a, gconstpointer b)
+{
+    const DrawItem *item_a = a;
+    const DrawItem *item_b = b;
+
+    if (item_a->translucent != item_b->translucent)
+        return item_a->translucent ? 1 : -1;
+    if (!item_a->translucent)
+        return item_a->index < item_b->index ? -1
+                                             : item_a->index > item_b->index;
+    return draw_item_compare(a, b);
+}
+
+static void
+scheduled_stimuli_clear(GArray *stimuli)
+{
+    for (guint i = 0; i < stimuli->len; i++)
+        g_object_unref(g_array_index(stimuli, ScheduledStimulus, i).stimulus);
+    g_array_set_size(stimuli, 0);
+}
+
+/*
+ * The pending stimuli form a binary min-heap on their start frame, so the
+ * stimuli that start in the current frame are found in O(log n) each.
+ */
+static gboolean
+pending_less(ScheduledStimulus *a, ScheduledStimulus *b)
+{
+    gint64 start_a = psy_visual_stimulus_get_start_frame(a->stimulus);
+    gint64 start_b = psy_visual_stimulus_get_start_frame(b->stimulus);
+
+    if (start_a != start_b)
+        return start_a < start_b;
+    return a->order < b->order;
+}
+
+static void
+pending_swap(GArray *heap, guint i, guint j)
+{
+    ScheduledStimulus temp = g_array_index(heap, ScheduledStimulus, i);
+    g_array_index(heap, ScheduledStimulus, i)
+        = g_array_index(heap, ScheduledStimulus, j);
+    g_array_index(heap, ScheduledStimulus, j) = temp;
+}
+
+static void
+pending_sift_up(GArray *heap, guint i)
+{
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+        if (!pending_less(&g_array_index(heap, ScheduledStimulus, i),
+                          &g_array_index(heap, ScheduledStimulus, parent)))
+            break;
+        pending_swap(heap, i, parent);
+        i = parent;
+    }
+}
+
+static void
+pending_sift_down(GArray *heap, guint i)
+{
+    for (;;) {
+        guint left     = 2 * i + 1;
+        guint right    = left + 1;
+        guint smallest = i;
+
+        if (left < heap->len
+            && pending_less(&g_array_index(heap, ScheduledStimulus, left),
+                            &g_array_index(heap, ScheduledStimulus, smallest)))
+            smallest = left;
+        if (right < heap->len
+            && pending_less(&g_array_index(heap, ScheduledStimulus, right),
+                            &g_array_index(heap, ScheduledStimulus, smallest)))
+            smallest = right;
+        if (smallest == i)
+            break;
+
+        pending_swap(heap, i, smallest);
+        i = smallest;
+    }
+}
+
+static void
+pending_push(GArray *heap, ScheduledStimulus *scheduled)
+{
+    g_array_append_val(heap, *scheduled);
+    pending_sift_up(heap, heap->len - 1);
+}
+
+/*
+ * Removes the element at index i from the heap, the reference of the
+ * stimulus is handed over to the caller.
+ */
+static ScheduledStimulus
+pending_remove(GArray *heap, guint i)
+{
+    ScheduledStimulus removed = g_array_index(heap, ScheduledStimulus, i);
+    guint             last    = heap->len - 1;
+
+    if (i != last) {
+        g_array_index(heap, ScheduledStimulus, i)
+            = g_array_index(heap, ScheduledStimulus, last);
+    }
+    g_array_set_size(heap, last);
+
+    if (i < heap->len) {
+        pending_sift_down(heap, i);
+        pending_sift_up(heap, i);
+    }
+    return removed;
+}
+
+/*
+ * Adds a stimulus to the stimuli that are drawn, at the position that
+ * corresponds with the order of scheduling.
+ */
+static void
+stimuli_insert(GArray *stimuli, ScheduledStimulus *scheduled)
+{
+    guint low = 0, high = stimuli->len;
+
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (g_array_index(stimuli, ScheduledStimulus, mid).order
+            < scheduled->order)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    g_array_insert_val(stimuli, low, *scheduled);
+}
+
+/*
+ * Removes stimulus from stimuli, returns TRUE when it was found.
+ */
+static gboolean
+stimuli_remove(GArray *stimuli, PsyVisualStimulus *stimulus)
+{
+    for (guint i = stimuli->len; i > 0; i--) {
+        ScheduledStimulus *scheduled
+            = &g_array_index(stimuli, ScheduledStimulus, i - 1);
+        if (scheduled->stimulus == stimulus) {
+            g_object_unref(scheduled->stimulus);
+            g_array_remove_index(stimuli, i - 1);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 typedef enum {
     CLEAR,
     DRAW_STIMULI,
@@ -80,6 +316,9 @@ typedef enum {
     PROJECTION_STYLE,
     CONTEXT,
     NUM_STIMULI,
+    BATCH_STIMULI,
+    SORT_STIMULI,
+    INSTRUMENT,
     N_PROPS
 } PsyCanvasProperty;
 
@@ -119,6 +358,15 @@ psy_canvas_set_property(GObject      *object,
     case FRAME_DUR:
         psy_canvas_set_frame_dur(self, g_value_get_boxed(value));
         break;
+    case BATCH_STIMULI:
+        psy_canvas_set_batch_stimuli(self, g_value_get_boolean(value));
+        break;
+    case SORT_STIMULI:
+        psy_canvas_set_sort_stimuli(self, g_value_get_boolean(value));
+        break;
+    case INSTRUMENT:
+        psy_canvas_set_instrument(self, g_value_get_boolean(value));
+        break;
     case NUM_STIMULI:
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
@@ -170,6 +418,15 @@ psy_canvas_get_property(GObject    *object,
     case NUM_STIMULI:
         g_value_set_uint(value, psy_canvas_get_num_stimuli(self));
         break;
+    case BATCH_STIMULI:
+        g_value_set_boolean(value, psy_canvas_get_batch_stimuli(self));
+        break;
+    case SORT_STIMULI:
+        g_value_set_boolean(value, psy_canvas_get_sort_stimuli(self));
+        break;
+    case INSTRUMENT:
+        g_value_set_boolean(value, psy_canvas_get_instrument(self));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
     }
@@ -183,7 +440,9 @@ psy_canvas_init(PsyCanvas *self)
     gfloat r = 0.5, g = 0.5, b = 0.5;
 
     // Both the stimuli and artist own a reference
-    priv->stimuli = g_ptr_array_new_with_free_func(g_object_unref);
+    priv->stimuli  = g_array_new(FALSE, FALSE, sizeof(ScheduledStimulus));
+    priv->incoming = g_array_new(FALSE, FALSE, sizeof(ScheduledStimulus));
+    priv->pending  = g_array_new(FALSE, FALSE, sizeof(ScheduledStimulus));
     priv->artists = g_hash_table_new_full(
         g_direct_hash, g_direct_equal, g_object_unref, g_object_unref);
 
@@ -191,6 +450,13 @@ psy_canvas_init(PsyCanvas *self)
 
     // Assume a default frame dur based on 60Hz frame rate
     priv->frame_dur = psy_duration_new(1.0 / 60);
+
+    priv->batch_stimuli = TRUE;
+    priv->draw_list     = g_array_new(FALSE, FALSE, sizeof(DrawItem));
+    priv->batch = g_array_new(FALSE, FALSE, sizeof(PsyVBufferInstance));
+    priv->batch_artists = g_ptr_array_new();
+
+    priv->frame_stats = psy_frame_stats_new();
 }
 
 static void
@@ -200,8 +466,12 @@ psy_canvas_dispose(GObject *gobject)
         = psy_canvas_get_instance_private(PSY_CANVAS(gobject));
 
     if (priv->stimuli) {
-        g_ptr_array_unref(priv->stimuli);
-        priv->stimuli = NULL;
+        scheduled_stimuli_clear(priv->stimuli);
+        scheduled_stimuli_clear(priv->incoming);
+        scheduled_stimuli_clear(priv->pending);
+        g_clear_pointer(&priv->stimuli, g_array_unref);
+        g_clear_pointer(&priv->incoming, g_array_unref);
+        g_clear_pointer(&priv->pending, g_array_unref);
     }
 
     if (priv->artists) {
@@ -209,9 +479,11 @@ psy_canvas_dispose(GObject *gobject)
         priv->artists = NULL;
     }
 
+    g_clear_object(&priv->gpu_timer);
     g_clear_object(&priv->context);
     g_clear_object(&priv->projection_matrix);
     g_clear_object(&priv->background_color);
+    g_clear_object(&priv->frame_stats);
 
     G_OBJECT_CLASS(psy_canvas_parent_class)->dispose(gobject);
 }
@@ -224,6 +496,9 @@ psy_canvas_finalize(GObject *gobject)
     (void) priv;
 
     g_clear_pointer(&priv->frame_dur, psy_duration_free);
+    g_clear_pointer(&priv->batch, g_array_unref);
+    g_clear_pointer(&priv->batch_artists, g_ptr_array_unref);
+    g_clear_pointer(&priv->draw_list, g_array_unref);
 
     G_OBJECT_CLASS(psy_canvas_parent_class)->finalize(gobject);
 }
@@ -278,9 +553,13 @@ schedule_stimulus(PsyCanvas *self, PsyVisualStimulus *stimulus)
 
     PsyArtist *artist = psy_visual_stimulus_create_artist(stimulus);
 
-    // add a reference for insertion in array and hashtable
-    g_object_ref(stimulus);
-    g_ptr_array_add(priv->stimuli, stimulus);
+    // add a reference for insertion in array and hashtable. The start frame
+    // is determined at the next frame, then it is queued.
+    ScheduledStimulus scheduled = {
+        .stimulus = g_object_ref(stimulus),
+        .order    = priv->num_scheduled++,
+    };
+    g_array_append_val(priv->incoming, scheduled);
     g_object_ref(stimulus);
     g_hash_table_insert(priv->artists, stimulus, artist);
 }
@@ -290,27 +569,286 @@ remove_stimulus(PsyCanvas *self, PsyVisualStimulus *stimulus)
 {
     PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
 
-    g_ptr_array_remove(priv->stimuli, stimulus);
+    if (!g_hash_table_contains(priv->artists, stimulus))
+        return;
+
+    // Most stimuli are removed when they are finished, hence when drawn.
+    if (!stimuli_remove(priv->stimuli, stimulus)
+        && !stimuli_remove(priv->incoming, stimulus)) {
+        for (guint i = 0; i < priv->pending->len; i++) {
+            if (g_array_index(priv->pending, ScheduledStimulus, i).stimulus
+                == stimulus) {
+                g_object_unref(pending_remove(priv->pending, i).stimulus);
+                break;
+            }
+        }
+    }
     g_hash_table_remove(priv->artists, stimulus);
 }
 
+/*
+ * Determines the start frame of the newly scheduled stimuli, and moves the
+ * stimuli that start at or before frame_num to the stimuli that are drawn.
+ */
+static void
+activate_stimuli(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
+{
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    for (guint i = 0; i < priv->incoming->len; i++) {
+        ScheduledStimulus *scheduled
+            = &g_array_index(priv->incoming, ScheduledStimulus, i);
+        PsyVisualStimulus *vstim = scheduled->stimulus;
+
+        if (!psy_visual_stimulus_is_scheduled(vstim)) {
+            PsyTimePoint *start
+                = psy_stimulus_get_start_time(PSY_STIMULUS(vstim));
+            PsyDuration *wait = psy_time_point_subtract(start, tp);
+            gint64       num_frames_away
+                = psy_duration_divide_rounded(wait, priv->frame_dur);
+            psy_duration_free(wait);
+            if (num_frames_away < 0) {
+                g_warning(
+                    "Scheduling a stimulus that should have been presented "
+                    "in the past, the stimulus will be presented as "
+                    "quickly as possible.");
+                num_frames_away = 0;
+            }
+
+            psy_visual_stimulus_set_start_frame(vstim,
+                                                frame_num + num_frames_away);
+        }
+        pending_push(priv->pending, scheduled);
+    }
+    g_array_set_size(priv->incoming, 0);
+
+    while (priv->pending->len > 0) {
+        ScheduledStimulus *first
+            = &g_array_index(priv->pending, ScheduledStimulus, 0);
+        if (psy_visual_stimulus_get_start_frame(first->stimulus)
+            > (gint64) frame_num)
+            break;
+
+        ScheduledStimulus scheduled = pending_remove(priv->pending, 0);
+        stimuli_insert(priv->stimuli, &scheduled);
+    }
+}
+
+/*
+ * The sections below measure the time of a part of the frame when the canvas
+ * is instrumented, otherwise they do nothing.
+ */
+static guint
+canvas_begin_section(PsyCanvas *self, const gchar *name)
+{
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    if (!priv->instrument)
+        return 0;
+    return psy_frame_stats_begin_section(priv->frame_stats, name);
+}
+
+static void
+canvas_end_section(PsyCanvas *self, guint section)
+{
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    if (priv->instrument)
+        psy_frame_stats_end_section(priv->frame_stats, section);
+}
+
+static void
+canvas_begin_frame_stats(PsyCanvas *self)
+{
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    // The timer is created while drawing, so the backend is current.
+    if (!priv->gpu_timer_created && priv->context) {
+        priv->gpu_timer
+            = psy_drawing_context_create_gpu_timer(priv->context);
+        priv->gpu_timer_created = TRUE;
+    }
+
+    psy_frame_stats_begin_frame(priv->frame_stats, priv->gpu_timer);
+}
+
 static void
 draw(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
 {
     PsyCanvasClass   *cls  = PSY_CANVAS_GET_CLASS(self);
     PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+    guint             section, frame_section;
 
     // upload the default projection matrices.
     g_return_if_fail(cls->clear);
     g_return_if_fail(cls->draw_stimuli);
     g_return_if_fail(cls->update_frame_stats);
 
+    if (priv->instrument)
+        canvas_begin_frame_stats(self);
+    frame_section = canvas_begin_section(self, "draw");
+
+    section = canvas_begin_section(self, "clear");
     cls->clear(self);
+    canvas_end_section(self, section);
+
+    section = canvas_begin_section(self, "upload-projection-matrices");
     cls->upload_projection_matrices(self);
+    canvas_end_section(self, section);
+
     cls->draw_stimuli(self, frame_num, tp);
+
+    canvas_end_section(self, frame_section);
+
     cls->update_frame_stats(self, &priv->frame_count);
 }
 
+/*
+ * Draws the instances that are collected in flush_draw_list. A batch with
+ * a single instance isn't worth the extra upload of the instance buffer, so
+ * then the artist draws the stimulus itself.
+ *
+ * Only an instanced draw is measured as "flush-batch". A stimulus that is
+ * drawn by its artist is measured as its own type, as it would have been
+ * without batching, so its time isn't counted in two sections.
+ */
+static void
+flush_batch(PsyCanvas *self)
+{
+    PsyCanvasPrivate *priv    = psy_canvas_get_instance_private(self);
+    PsyShaderProgram *program = NULL;
+    GError           *error   = NULL;
+
+    if (priv->batch->len == 0)
+        return;
+
+    if (priv->batch->len > 1)
+        program = psy_drawing_context_get_program(
+            priv->context,
+            priv->batch_texture ? PSY_INSTANCED_PICTURE_PROGRAM_NAME
+                                : PSY_INSTANCED_COLOR_PROGRAM_NAME);
+
+    if (program) {
+        guint section = canvas_begin_section(self, "flush-batch");
+
+        psy_shader_program_use(program, &error);
+        if (!error && priv->batch_texture)
+            psy_texture_bind(priv->batch_texture, &error);
+        if (!error)
+            psy_vbuffer_draw_triangle_fan_instanced(
+                priv->batch_mesh,
+                (const PsyVBufferInstance *) priv->batch->data,
+                priv->batch->len,
+                &error);
+        if (error) {
+            g_critical("PsyCanvas: unable to draw a batch of stimuli: %s",
+                       error->message);
+            g_clear_error(&error);
+        }
+
+        canvas_end_section(self, section);
+    }
+    else {
+        for (guint i = 0; i < priv->batch_artists->len; i++) {
+            PsyArtist   *artist = g_ptr_array_index(priv->batch_artists, i);
+            const gchar *name   = G_OBJECT_TYPE_NAME(
+                psy_artist_get_stimulus(artist));
+            guint artist_section = canvas_begin_section(self, name);
+            psy_artist_draw(artist);
+            canvas_end_section(self, artist_section);
+        }
+    }
+
+    g_array_set_size(priv->batch, 0);
+    g_ptr_array_set_size(priv->batch_artists, 0);
+    priv->batch_mesh    = NULL;
+    priv->batch_texture = NULL;
+}
+
+static void
+draw_stimulus(PsyCanvas *self, PsyVisualStimulus *stimulus)
+{
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+    DrawItem          item = {0};
+
+    // The stimuli are collected, they are drawn at the end of the frame by
+    // flush_draw_list.
+    item.artist   = g_hash_table_lookup(priv->artists, stimulus);
+    item.stimulus = stimulus;
+    item.index    = priv->draw_list->len;
+
+    if (priv->batch_stimuli)
+        item.mesh = psy_artist_get_instance(
+            item.artist, &item.instance, &item.texture);
+
+    if (priv->sort_stimuli)
+        item.program = psy_artist_get_program(item.artist);
+
+    item.z           = psy_visual_stimulus_get_z(stimulus);
+    item.translucent = psy_artist_is_translucent(item.artist) != FALSE;
+    if (item.translucent)
+        priv->num_translucent++;
+
+    g_array_append_val(priv->draw_list, item);
+}
+
+/*
+ * Draws the stimuli collected in this frame. When the stimuli are sorted,
+ * the stimuli that share their state are drawn after each other. Consecutive
+ * stimuli of the same shape, and pictures in the same texture atlas, are
+ * drawn in one batch. Without sorting, only stimuli that are consecutive in
+ * the draw order are batched, so the opaque stimuli are still drawn in the
+ * same order as they would have been drawn one by one. The translucent
+ * stimuli are always drawn after the opaque ones they are blended with.
+ */
+static void
+flush_draw_list(PsyCanvas *self)
+{
+    PsyCanvasPrivate *priv        = psy_canvas_get_instance_private(self);
+    PsyCanvasClass   *klass       = PSY_CANVAS_GET_CLASS(self);
+    gboolean          translucent = FALSE;
+
+    if (priv->sort_stimuli)
+        g_array_sort(priv->draw_list, draw_item_compare);
+    else if (priv->num_translucent > 0)
+        g_array_sort(priv->draw_list, draw_item_compare_translucent);
+
+    for (guint i = 0; i < priv->draw_list->len; i++) {
+        DrawItem *item = &g_array_index(priv->draw_list, DrawItem, i);
+
+        if (item->translucent != translucent) {
+            flush_batch(self);
+            translucent = item->translucent;
+            if (klass->set_translucent)
+                klass->set_translucent(self, translucent);
+        }
+
+        if (item->mesh != priv->batch_mesh
+            || item->texture != priv->batch_texture)
+            flush_batch(self);
+
+        if (item->mesh) {
+            priv->batch_mesh    = item->mesh;
+            priv->batch_texture = item->texture;
+            g_array_append_val(priv->batch, item->instance);
+            g_ptr_array_add(priv->batch_artists, item->artist);
+        }
+        else {
+            guint section = canvas_begin_section(
+                self, G_OBJECT_TYPE_NAME(item->stimulus));
+            psy_artist_draw(item->artist);
+            canvas_end_section(self, section);
+        }
+    }
+    flush_batch(self);
+
+    if (translucent && klass->set_translucent)
+        klass->set_translucent(self, FALSE);
+
+    g_array_set_size(priv->draw_list, 0);
+    priv->num_translucent = 0;
+}
+
 static void
 draw_stimuli(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
 {
@@ -318,43 +856,26 @@ draw_stimuli(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
     PsyCanvasClass   *klass           = PSY_CANVAS_GET_CLASS(self);
     GPtrArray        *nodes_to_remove = g_ptr_array_new();
 
+    activate_stimuli(self, frame_num, tp);
+
     // Draw stimuli from top to bottom, this means that the stimulus
     // that was added the latest, is drawn the first. This means that if
     // they are presented at the same depth (z-coordinate) that the last
     // stimulus is dominant and will be visible.
     for (gint i = priv->stimuli->len - 1; i >= 0; i--) {
 
-        PsyStimulus       *stim  = priv->stimuli->pdata[i];
-        PsyVisualStimulus *vstim = PSY_VISUAL_STIMULUS(stim);
-        gint64             start_frame, nth_frame, num_frames;
+        PsyVisualStimulus *vstim
+            = g_array_index(priv->stimuli, ScheduledStimulus, i).stimulus;
+        PsyStimulus *stim = PSY_STIMULUS(vstim);
+        gint64       nth_frame, num_frames;
 
-        /* Schedule if necessary*/
-        if (!psy_visual_stimulus_is_scheduled(vstim)) {
-            PsyTimePoint *start = psy_stimulus_get_start_time(stim);
-            PsyDuration  *wait  = psy_time_point_subtract(start, tp);
-            gint64        num_frames_away
-                = psy_duration_divide_rounded(wait, priv->frame_dur);
-            psy_duration_free(wait);
-            if (num_frames_away < 0) {
-                g_warning(
-                    "Scheduling a stimulus that should have been presented "
-                    "in the past, the stimulus will be presented as "
-                    "quickly as possible.");
-                num_frames_away = 0;
-            }
+        // All stimuli in the list have started.
+        nth_frame  = psy_visual_stimulus_get_nth_frame(vstim);
+        num_frames = psy_visual_stimulus_get_num_frames(vstim);
+        psy_visual_stimulus_emit_update(vstim, tp, nth_frame);
+        g_assert(klass->draw_stimulus);
+        klass->draw_stimulus(self, vstim);
 
-            psy_visual_stimulus_set_start_frame(vstim,
-                                                frame_num + num_frames_away);
-        }
-
-        start_frame = psy_visual_stimulus_get_start_frame(vstim);
-        nth_frame   = psy_visual_stimulus_get_nth_frame(vstim);
-        num_frames  = psy_visual_stimulus_get_num_frames(vstim);
-        if (start_frame <= (gint64) frame_num) {
-            psy_visual_stimulus_emit_update(vstim, tp, nth_frame);
-            g_assert(klass->draw_stimulus);
-            klass->draw_stimulus(self, vstim);
-        }
         nth_frame = psy_visual_stimulus_get_nth_frame(vstim);
         if (nth_frame == 1) {
             // perhaps mark the stimulus as scheduled here
@@ -366,6 +887,9 @@ draw_stimuli(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
             g_ptr_array_add(nodes_to_remove, stim);
     }
 
+    // The artists must be alive while they are drawn.
+    flush_draw_list(self);
+
     PsyTimePoint *tend = psy_time_point_add(tp, priv->frame_dur);
     for (gsize i = 0; i < nodes_to_remove->len; i++) {
         PsyStimulus *stim = g_ptr_array_index(nodes_to_remove, i);
@@ -377,16 +901,6 @@ draw_stimuli(PsyCanvas *self, guint64 frame_num, PsyTimePoint *tp)
     g_ptr_array_unref(nodes_to_remove);
 }
 
-static void
-draw_stimulus(PsyCanvas *self, PsyVisualStimulus *stimulus)
-{
-    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
-    PsyArtist        *artist;
-
-    artist = g_hash_table_lookup(priv->artists, stimulus);
-    psy_artist_draw(artist);
-}
-
 // static void
 // set_monitor_size_mm(PsyCanvas *self, gint width_mm, gint height_mm)
 // {
@@ -516,7 +1030,9 @@ reset(PsyCanvas *self)
                  NULL);
     // clang-format on
 
-    g_ptr_array_set_size(priv->stimuli, 0);
+    scheduled_stimuli_clear(priv->stimuli);
+    scheduled_stimuli_clear(priv->incoming);
+    scheduled_stimuli_clear(priv->pending);
     g_hash_table_remove_all(priv->artists);
     priv->projection_style = PSY_CANVAS_PROJECTION_STYLE_CENTER
                              | PSY_CANVAS_PROJECTION_STYLE_PIXELS;
@@ -776,6 +1292,72 @@ psy_canvas_class_init(PsyCanvasClass *klass)
                             0,
                             G_PARAM_READABLE);
 
+    /**
+     * PsyCanvas:batch-stimuli:
+     *
+     * When TRUE, consecutive stimuli that have the same shape, such as
+     * rectangles, circles and crosses, are drawn in one batch instead of one
+     * by one. The same holds for pictures that are stored in the texture atlas
+     * of the drawing context. This saves a lot of work when drawing many
+     * stimuli. The stimuli are drawn in the same order, so the result should
+     * be identical to drawing them one by one.
+     */
+    obj_properties[BATCH_STIMULI]
+        = g_param_spec_boolean("batch-stimuli",
+                               "BatchStimuli",
+                               "Whether to draw stimuli of the same shape in "
+                               "one batch",
+                               TRUE,
+                               G_PARAM_READWRITE);
+
+    /**
+     * PsyCanvas:sort-stimuli:
+     *
+     * When TRUE, the stimuli of a frame are sorted before they are drawn, so
+     * that stimuli that use the same shader program, texture and shape are
+     * drawn after each other. This avoids switching the state of the GPU and
+     * allows more stimuli to be drawn in one batch, see
+     * [property@Canvas:batch-stimuli].
+     *
+     * The stimuli are drawn from back to front, that is from low to high
+     * z-values, so stimuli that are partly transparent are blended with the
+     * stimuli behind them. Within the same z-value, the opaque stimuli are
+     * drawn first and the translucent stimuli, see
+     * [method@Artist.is_translucent], are drawn after them, the stimulus
+     * scheduled last on top. Text, pictures with an alpha channel and
+     * shapes with smooth edges are translucent, other stimuli are when the
+     * alpha of their color is below 1.0. Without sorting, the translucent
+     * stimuli are drawn from back to front after all opaque stimuli. Opaque
+     * stimuli with the same z-value may be drawn in another order than they
+     * were scheduled, so stimuli that overlap should get a different z-value
+     * when this is enabled.
+     */
+    obj_properties[SORT_STIMULI]
+        = g_param_spec_boolean("sort-stimuli",
+                               "SortStimuli",
+                               "Whether to sort the stimuli on their depth "
+                               "and state before drawing",
+                               FALSE,
+                               G_PARAM_READWRITE);
+
+    /**
+     * PsyCanvas:instrument:
+     *
+     * When TRUE, the canvas measures how long the CPU and, when the drawing
+     * backend supports it, the GPU spend on clearing the canvas, uploading
+     * the projection matrices, each stimulus and the whole frame. The
+     * measurements are collected in the [class@FrameStats] returned by
+     * [method@Canvas.get_frame_stats]. The stimuli are measured per type,
+     * this reveals which stimuli push a frame past its budget.
+     */
+    obj_properties[INSTRUMENT]
+        = g_param_spec_boolean("instrument",
+                               "Instrument",
+                               "Whether to measure the time spent in the "
+                               "parts of a frame",
+                               FALSE,
+                               G_PARAM_READWRITE);
+
     g_object_class_install_properties(object_class, N_PROPS, obj_properties);
 
     canvas_signals[RESIZE]
@@ -1320,6 +1902,8 @@ psy_canvas_set_context(PsyCanvas *self, PsyDrawingContext *context)
     g_return_if_fail(PSY_IS_DRAWING_CONTEXT(context));
 
     PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+    g_clear_object(&priv->gpu_timer);
+    priv->gpu_timer_created = FALSE;
     g_clear_object(&priv->context);
     priv->context = context;
 }
@@ -1346,10 +1930,13 @@ psy_canvas_get_context(PsyCanvas *self)
  * psy_canvas_swap_stimuli:
  * @self: an instance of `PsyCanvas`
  * @i1: The index of the first stimulus must be larger or equal than
- *      0 but smaller than PsyCanvas:num-stims
+ *      0 but smaller than the number of stimuli that are being presented
  * @i2: the same for @i1
  *
- * Swap the order in which the visual stimuli are drawn.
+ * Swap the order in which the visual stimuli are drawn. The indices refer to
+ * the stimuli that have started and are being presented, stimuli that are
+ * scheduled to start in a future frame are drawn in the order in which they
+ * have been scheduled.
  */
 void
 psy_canvas_swap_stimuli(PsyCanvas *self, guint i1, guint i2)
@@ -1359,10 +1946,14 @@ psy_canvas_swap_stimuli(PsyCanvas *self, guint i1, guint i2)
     g_return_if_fail(i1 < priv->stimuli->len);
     g_return_if_fail(i2 < priv->stimuli->len);
 
-    PsyStimulus *stim_temp;
-    stim_temp                = priv->stimuli->pdata[i1];
-    priv->stimuli->pdata[i1] = priv->stimuli->pdata[i2];
-    priv->stimuli->pdata[i2] = stim_temp;
+    // Swap the stimuli, not their order, so the list remains sorted.
+    GArray            *stimuli = priv->stimuli;
+    ScheduledStimulus *s1      = &g_array_index(stimuli, ScheduledStimulus, i1);
+    ScheduledStimulus *s2      = &g_array_index(stimuli, ScheduledStimulus, i2);
+    PsyVisualStimulus *temp    = s1->stimulus;
+
+    s1->stimulus = s2->stimulus;
+    s2->stimulus = temp;
 }
 
 /**
@@ -1377,7 +1968,118 @@ psy_canvas_get_num_stimuli(PsyCanvas *self)
     PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
     g_return_val_if_fail(PSY_CANVAS(self), 0);
 
-    return priv->stimuli->len;
+    return priv->stimuli->len + priv->incoming->len + priv->pending->len;
+}
+
+/**
+ * psy_canvas_set_batch_stimuli:
+ * @self: A `PsyCanvas` instance
+ * @batch_stimuli: whether or not to draw stimuli in batches
+ *
+ * See [property@Canvas:batch-stimuli].
+ */
+void
+psy_canvas_set_batch_stimuli(PsyCanvas *self, gboolean batch_stimuli)
+{
+    g_return_if_fail(PSY_IS_CANVAS(self));
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    priv->batch_stimuli = batch_stimuli != FALSE;
+}
+
+/**
+ * psy_canvas_get_batch_stimuli:
+ * @self: A `PsyCanvas` instance
+ *
+ * Returns: whether stimuli of the same shape are drawn in one batch.
+ */
+gboolean
+psy_canvas_get_batch_stimuli(PsyCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_CANVAS(self), FALSE);
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    return priv->batch_stimuli;
+}
+
+/**
+ * psy_canvas_set_sort_stimuli:
+ * @self: A `PsyCanvas` instance
+ * @sort_stimuli: whether or not to sort the stimuli before drawing
+ *
+ * See [property@Canvas:sort-stimuli].
+ */
+void
+psy_canvas_set_sort_stimuli(PsyCanvas *self, gboolean sort_stimuli)
+{
+    g_return_if_fail(PSY_IS_CANVAS(self));
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    priv->sort_stimuli = sort_stimuli != FALSE;
+}
+
+/**
+ * psy_canvas_get_sort_stimuli:
+ * @self: A `PsyCanvas` instance
+ *
+ * Returns: whether the stimuli are sorted on depth and state before drawing.
+ */
+gboolean
+psy_canvas_get_sort_stimuli(PsyCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_CANVAS(self), FALSE);
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    return priv->sort_stimuli;
+}
+
+/**
+ * psy_canvas_set_instrument:
+ * @self: A `PsyCanvas` instance
+ * @instrument: whether or not to measure the time spent on the frames
+ *
+ * See [property@Canvas:instrument].
+ */
+void
+psy_canvas_set_instrument(PsyCanvas *self, gboolean instrument)
+{
+    g_return_if_fail(PSY_IS_CANVAS(self));
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    priv->instrument = instrument != FALSE;
+}
+
+/**
+ * psy_canvas_get_instrument:
+ * @self: A `PsyCanvas` instance
+ *
+ * Returns: whether the time spent on the frames is measured.
+ */
+gboolean
+psy_canvas_get_instrument(PsyCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_CANVAS(self), FALSE);
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    return priv->instrument;
+}
+
+/**
+ * psy_canvas_get_frame_stats:
+ * @self: A `PsyCanvas` instance
+ *
+ * Obtains the measurements of the frames, these are collected while
+ * [property@Canvas:instrument] is TRUE.
+ *
+ * Returns:(transfer none): the [class@FrameStats] of this canvas.
+ */
+PsyFrameStats *
+psy_canvas_get_frame_stats(PsyCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_CANVAS(self), NULL);
+    PsyCanvasPrivate *priv = psy_canvas_get_instance_private(self);
+
+    return priv->frame_stats;
 }
 
 /**
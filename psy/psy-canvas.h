@@ -6,6 +6,7 @@
 #include "psy-color.h"
 #include "psy-drawing-context.h"
 #include "psy-enums.h"
+#include "psy-frame-stats.h"
 #include "psy-image.h"
 #include "psy-time-point.h"
 #include "psy-visual-stimulus.h"
@@ -48,6 +49,10 @@ typedef struct PsyFrameCount {
  *                            for the current value of
  * @reset: Clears the canvas, remove scheduled stimuli and allow extra clearing
  *         in deriving classes(e.g. ImageCanvas will reset its time).
+ * @set_translucent: Called with TRUE before the translucent stimuli are
+ *                   drawn and with FALSE after them. Translucent stimuli are
+ *                   tested against the depth buffer, but shouldn't write to
+ *                   it, so the stimuli drawn after them are still blended.
  */
 typedef struct _PsyCanvasClass {
     GObjectClass parent_class;
@@ -84,9 +89,11 @@ typedef struct _PsyCanvasClass {
 
     void (*reset)(PsyCanvas *self);
 
+    void (*set_translucent)(PsyCanvas *self, gboolean translucent);
+
     /*< private >*/
 
-    gpointer padding[12];
+    gpointer padding[11];
 } PsyCanvasClass;
 
 G_MODULE_EXPORT void
@@ -169,6 +176,27 @@ psy_canvas_swap_stimuli(PsyCanvas *self, guint i1, guint i2);
 G_MODULE_EXPORT guint
 psy_canvas_get_num_stimuli(PsyCanvas *self);
 
+G_MODULE_EXPORT void
+psy_canvas_set_batch_stimuli(PsyCanvas *self, gboolean batch_stimuli);
+
+G_MODULE_EXPORT gboolean
+psy_canvas_get_batch_stimuli(PsyCanvas *self);
+
+G_MODULE_EXPORT void
+psy_canvas_set_sort_stimuli(PsyCanvas *self, gboolean sort_stimuli);
+
+G_MODULE_EXPORT gboolean
+psy_canvas_get_sort_stimuli(PsyCanvas *self);
+
+G_MODULE_EXPORT void
+psy_canvas_set_instrument(PsyCanvas *self, gboolean instrument);
+
+G_MODULE_EXPORT gboolean
+psy_canvas_get_instrument(PsyCanvas *self);
+
+G_MODULE_EXPORT PsyFrameStats *
+psy_canvas_get_frame_stats(PsyCanvas *self);
+
 G_MODULE_EXPORT PsyImage *
 psy_canvas_get_image(PsyCanvas *self);
 
@@ -1,6 +1,7 @@
 
 #include <math.h>
 
+#include "psy-artist-private.h"
 #include "psy-circle-artist.h"
 #include "psy-circle.h"
 #include "psy-drawing-context.h"
@@ -12,6 +13,7 @@
 typedef struct _PsyCircleArtist {
     PsyArtist   parent_instance;
     PsyVBuffer *vertices;
+    PsyVBuffer *unit_mesh; // shared via the drawing context, not owned
     gfloat      x, y, z;
     gfloat      radius;
 } PsyCircleArtist;
@@ -53,43 +55,38 @@ psy_circle_artist_finalize(GObject *object)
 static void
 circle_artist_draw(PsyArtist *self)
 {
+    PsyCircle *stim         = PSY_CIRCLE(psy_artist_get_stimulus(self));
+    gfloat     inner_radius = psy_circle_get_inner_radius(stim);
+
+    if (inner_radius > 0) {
+        gfloat outer = psy_circle_get_radius(stim);
+        psy_artist_draw_sdf(self,
+                            PSY_SDF_SHAPE_ANNULUS,
+                            outer,
+                            outer,
+                            MIN(inner_radius, outer));
+        return;
+    }
+    else if (psy_circle_get_smooth(stim)) {
+        gfloat radius = psy_circle_get_radius(stim);
+        psy_artist_draw_sdf(self, PSY_SDF_SHAPE_ELLIPSE, radius, radius, 0);
+        return;
+    }
+
     // First let the psy artist setup the model matrix
     PSY_ARTIST_CLASS(psy_circle_artist_parent_class)->draw(self);
 
-    gfloat       rgba[4]        = {0.0, 0.0, 0.0, 1.0};
-    PsyColor    *color          = NULL;
-    GError      *error          = NULL;
-    gboolean     store_vertices = FALSE;
-    gfloat       radius;
-    guint        num_vertices;
-    const gchar *color_name = "ourColor";
+    GError  *error          = NULL;
+    gboolean store_vertices = FALSE;
+    gfloat   radius;
+    guint    num_vertices;
 
     PsyCircleArtist *artist = PSY_CIRCLE_ARTIST(self);
     PsyCircle       *circle = PSY_CIRCLE(psy_artist_get_stimulus(self));
 
-    PsyShaderProgram *program = psy_artist_get_program(self);
-
-    // clang-format off
-    g_object_get(circle,
-            "num-vertices", &num_vertices,
-            "radius", &radius,
-            "color", &color,
-            NULL
-            );
-    // clang-format on
-
-    if (color) {
-        // clang-format off
-        g_object_get(color,
-                "r", &rgba[0],
-                "g", &rgba[1],
-                "b", &rgba[2],
-                "a", &rgba[3],
-                NULL);
-        // clang-format on
-    }
+    num_vertices = psy_circle_get_num_vertices(circle);
 
-    psy_shader_program_set_uniform_4f(program, color_name, rgba, &error);
+    psy_artist_set_color_uniform(self, &error);
     if (error) {
         g_critical("%s: Unable to set the color: %s", __func__, error->message);
         g_clear_error(&error);
@@ -118,7 +115,7 @@ circle_artist_draw(PsyArtist *self)
         if (error) {
             g_critical("PsyCircleArtist: unable to upload vertices: %s",
                        error->message);
-            g_error_free(error);
+            g_clear_error(&error);
         }
     }
     psy_vbuffer_draw_triangle_fan(artist->vertices, &error);
@@ -127,8 +124,89 @@ circle_artist_draw(PsyArtist *self)
                    error->message);
         g_error_free(error);
     }
+}
+
+/*
+ * A circle with a radius of 1 around the origin, it is shared by all circle
+ * artists of a drawing context that use the same number of vertices.
+ */
+static PsyVBuffer *
+circle_artist_get_unit_mesh(PsyCircleArtist *self, guint num_vertices)
+{
+    if (self->unit_mesh
+        && psy_vbuffer_get_nvertices(self->unit_mesh) == num_vertices)
+        return self->unit_mesh;
+
+    PsyDrawingContext *context = psy_artist_get_context(PSY_ARTIST(self));
+    gchar *name = g_strdup_printf("psy-unit-circle-%u", num_vertices);
+    PsyVBuffer *mesh = psy_drawing_context_get_vbuffer(context, name);
+
+    if (!mesh) {
+        GError *error = NULL;
+        gfloat  twopi = M_PI * 2.0;
+
+        mesh = psy_drawing_context_create_vbuffer(context);
+        psy_vbuffer_set_nvertices(mesh, num_vertices);
+        for (gsize i = 0; i < num_vertices; i++) {
+            psy_vbuffer_set_xyz(mesh,
+                                i,
+                                cos(i * twopi / num_vertices),
+                                sin(i * twopi / num_vertices),
+                                0);
+        }
+
+        psy_drawing_context_register_vbuffer(context, name, mesh, &error);
+        if (error) {
+            g_critical("PsyCircleArtist: unable to register mesh: %s",
+                       error->message);
+            g_error_free(error);
+            mesh = NULL;
+        }
+    }
+    g_free(name);
+
+    self->unit_mesh = mesh;
+    return mesh;
+}
+
+static PsyVBuffer *
+circle_artist_get_instance(PsyArtist          *self,
+                           PsyVBufferInstance *instance,
+                           PsyTexture        **texture)
+{
+    (void) texture;
+    PsyCircleArtist *artist = PSY_CIRCLE_ARTIST(self);
+    PsyCircle       *circle = PSY_CIRCLE(psy_artist_get_stimulus(self));
+
+    // Smooth circles and rings are drawn one by one.
+    if (psy_circle_get_smooth(circle)
+        || psy_circle_get_inner_radius(circle) > 0)
+        return NULL;
+
+    guint num_vertices = psy_circle_get_num_vertices(circle);
+    if (num_vertices < 3)
+        return NULL;
 
-    g_object_unref(color);
+    PsyVBuffer *mesh = circle_artist_get_unit_mesh(artist, num_vertices);
+    if (!mesh)
+        return NULL;
+
+    gfloat radius = psy_circle_get_radius(circle);
+    psy_artist_fill_instance(self, radius, radius, instance);
+    return mesh;
+}
+
+static gboolean
+circle_artist_is_translucent(PsyArtist *self)
+{
+    PsyCircle *circle = PSY_CIRCLE(psy_artist_get_stimulus(self));
+
+    // The smooth edges of smooth circles and rings are blended.
+    if (psy_circle_get_smooth(circle)
+        || psy_circle_get_inner_radius(circle) > 0)
+        return TRUE;
+    return PSY_ARTIST_CLASS(psy_circle_artist_parent_class)
+        ->is_translucent(self);
 }
 
 static void
@@ -141,7 +219,9 @@ psy_circle_artist_class_init(PsyCircleArtistClass *class)
     gobject_class->dispose     = psy_circle_artist_dispose;
     gobject_class->constructed = psy_circle_artist_constructed;
 
-    artist_class->draw = circle_artist_draw;
+    artist_class->draw           = circle_artist_draw;
+    artist_class->get_instance   = circle_artist_get_instance;
+    artist_class->is_translucent = circle_artist_is_translucent;
 }
 
 /* ************ public functions ******************** */
@@ -8,12 +8,16 @@
  * A PsyCircle is a stimulus that is mostly characterized by it's position
  * which it derives from [class@VisualStimulus] and it's radius. The circle
  * is rendered by a number of triangles, the more triangles are used the
- * better the set of triangles approaches a circle
+ * better the set of triangles approaches a circle. Alternatively, a smooth
+ * circle is rendered on a single quad, see [property@Circle:smooth]. A circle
+ * with an inner radius is drawn as a ring.
  */
 
 typedef struct _PsyCirclePrivate {
-    gfloat radius;
-    guint  num_vertices;
+    gfloat   radius;
+    gfloat   inner_radius;
+    guint    num_vertices;
+    gboolean smooth;
 } PsyCirclePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(PsyCircle, psy_circle, PSY_TYPE_VISUAL_STIMULUS)
@@ -22,6 +26,8 @@ typedef enum {
     PROP_NULL, // not used required by GObject
     PROP_RADIUS,
     PROP_NUM_VERTICES,
+    PROP_INNER_RADIUS,
+    PROP_SMOOTH,
     NUM_PROPERTIES
 } CircleProperty;
 
@@ -42,6 +48,12 @@ circle_set_property(GObject      *object,
     case PROP_NUM_VERTICES:
         psy_circle_set_num_vertices(self, g_value_get_uint(value));
         break;
+    case PROP_INNER_RADIUS:
+        psy_circle_set_inner_radius(self, g_value_get_float(value));
+        break;
+    case PROP_SMOOTH:
+        psy_circle_set_smooth(self, g_value_get_boolean(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -63,6 +75,12 @@ circle_get_property(GObject    *object,
     case PROP_NUM_VERTICES:
         g_value_set_uint(value, priv->num_vertices);
         break;
+    case PROP_INNER_RADIUS:
+        g_value_set_float(value, priv->inner_radius);
+        break;
+    case PROP_SMOOTH:
+        g_value_set_boolean(value, priv->smooth);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -128,6 +146,37 @@ psy_circle_class_init(PsyCircleClass *klass)
         25,
         G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
 
+    /**
+     * Circle:inner-radius:
+     *
+     * When the inner radius is larger than 0, the circle is drawn as a ring,
+     * from the inner radius to the radius. A ring is always drawn smooth.
+     */
+    circle_properties[PROP_INNER_RADIUS]
+        = g_param_spec_float("inner-radius",
+                             "InnerRadius",
+                             "The inner radius of a ring",
+                             0.f,
+                             G_MAXFLOAT,
+                             0,
+                             G_PARAM_READWRITE);
+
+    /**
+     * Circle:smooth:
+     *
+     * When TRUE, the circle is drawn perfectly round on a single quad,
+     * regardless of its size, and the edge of the circle is anti-aliased.
+     * [property@Circle:num-vertices] is not used then. Changing the radius of
+     * a smooth circle is cheap, as its vertices remain the same.
+     * Smooth circles are drawn one by one, not in a batch with other circles.
+     */
+    circle_properties[PROP_SMOOTH]
+        = g_param_spec_boolean("smooth",
+                               "Smooth",
+                               "Draw a round anti-aliased circle",
+                               FALSE,
+                               G_PARAM_READWRITE);
+
     g_object_class_install_properties(
         object_class, NUM_PROPERTIES, circle_properties);
 }
@@ -183,6 +232,12 @@ psy_circle_new_full(
  * Frees Circles previously allocated with the psy_circle_new_* family
  * of constructors.
  */
+void
+psy_circle_free(PsyCircle *self)
+{
+    g_return_if_fail(PSY_IS_CIRCLE(self));
+    g_object_unref(self);
+}
 
 /**
  * psy_circle_set_radius:
@@ -249,3 +304,75 @@ psy_circle_get_num_vertices(PsyCircle *circle)
     PsyCirclePrivate *priv = psy_circle_get_instance_private(circle);
     return priv->num_vertices;
 }
+
+/**
+ * psy_circle_set_inner_radius:
+ * @circle: an instance of %PsyCircle
+ * @inner_radius: a positive number, 0 draws a disc, larger values a ring.
+ *
+ * Set the inner radius of the circle, see [property@Circle:inner-radius].
+ */
+void
+psy_circle_set_inner_radius(PsyCircle *circle, gfloat inner_radius)
+{
+    g_return_if_fail(PSY_IS_CIRCLE(circle));
+    g_return_if_fail(inner_radius >= 0.0);
+
+    PsyCirclePrivate *priv = psy_circle_get_instance_private(circle);
+    if (priv->inner_radius == inner_radius)
+        return;
+
+    priv->inner_radius = inner_radius;
+    g_object_notify_by_pspec(G_OBJECT(circle),
+                             circle_properties[PROP_INNER_RADIUS]);
+}
+
+/**
+ * psy_circle_get_inner_radius:
+ * @circle: an instance of %PsyCircle
+ *
+ * Returns: The inner radius of the circle.
+ */
+gfloat
+psy_circle_get_inner_radius(PsyCircle *circle)
+{
+    g_return_val_if_fail(PSY_IS_CIRCLE(circle), 0.0);
+    PsyCirclePrivate *priv = psy_circle_get_instance_private(circle);
+    return priv->inner_radius;
+}
+
+/**
+ * psy_circle_set_smooth:
+ * @circle: an instance of %PsyCircle
+ * @smooth: whether to draw a round anti-aliased circle
+ *
+ * See [property@Circle:smooth].
+ */
+void
+psy_circle_set_smooth(PsyCircle *circle, gboolean smooth)
+{
+    g_return_if_fail(PSY_IS_CIRCLE(circle));
+
+    PsyCirclePrivate *priv = psy_circle_get_instance_private(circle);
+
+    smooth = smooth != FALSE;
+    if (priv->smooth == smooth)
+        return;
+
+    priv->smooth = smooth;
+    g_object_notify_by_pspec(G_OBJECT(circle), circle_properties[PROP_SMOOTH]);
+}
+
+/**
+ * psy_circle_get_smooth:
+ * @circle: an instance of %PsyCircle
+ *
+ * Returns: whether the circle is drawn round and anti-aliased.
+ */
+gboolean
+psy_circle_get_smooth(PsyCircle *circle)
+{
+    g_return_val_if_fail(PSY_IS_CIRCLE(circle), FALSE);
+    PsyCirclePrivate *priv = psy_circle_get_instance_private(circle);
+    return priv->smooth;
+}
@@ -35,4 +35,16 @@ psy_circle_set_num_vertices(PsyCircle *circle, guint num_vertices);
 G_MODULE_EXPORT guint
 psy_circle_get_num_vertices(PsyCircle *circle);
 
+G_MODULE_EXPORT void
+psy_circle_set_inner_radius(PsyCircle *circle, gfloat inner_radius);
+
+G_MODULE_EXPORT gfloat
+psy_circle_get_inner_radius(PsyCircle *circle);
+
+G_MODULE_EXPORT void
+psy_circle_set_smooth(PsyCircle *circle, gboolean smooth);
+
+G_MODULE_EXPORT gboolean
+psy_circle_get_smooth(PsyCircle *circle);
+
 G_END_DECLS
@@ -0,0 +1,320 @@
+
+#include "psy-clock-source-private.h"
+
+#include <time.h>
+
+#if (defined(__x86_64__) || defined(__i386__))                                \
+    && (defined(__GNUC__) || defined(__clang__))
+    #define PSY_HAVE_TSC 1
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+
+/*
+ * The time stamp counter (TSC) of x86 CPUs is read with one instruction,
+ * so reading it takes a few nanoseconds, whereas the monotonic clock of the
+ * OS takes a vDSO call or a system call. When the CPU reports that its TSC
+ * is invariant, it ticks at a constant rate in all P-, C- and T-states and
+ * the TSC may be used as clock.
+ *
+ * The TSC is calibrated against the monotonic clock that is used by
+ * g_get_monotonic_time(), so both clocks run on the same timebase. NTP may
+ * slew that clock, hence the TSC is recalibrated each RECALIBRATE_NS: the
+ * rate is measured since the previous calibration and the small error
+ * that has accumulated in the meanwhile is steered away during the next
+ * interval, so the clock never jumps. When the error is larger than
+ * MAX_ERROR_NS, the TSC is deemed unreliable and psylib falls back to the
+ * monotonic clock.
+ *
+ * The calibration parameters are protected by a sequence lock: a
+ * recalibration makes the sequence number odd while it writes them and even
+ * again afterwards. Readers never take a lock, they copy the parameters and
+ * retry when the sequence number was odd or has changed in the meanwhile,
+ * so they never use a set that is partly overwritten.
+ */
+
+#define CALIBRATION_US 20000
+#define RECALIBRATE_NS G_GINT64_CONSTANT(1000000000)
+#define MAX_ERROR_NS G_GINT64_CONSTANT(1000000)
+#define NUM_PAIR_SAMPLES 5
+
+typedef struct TscParams {
+    guint64 base_tsc;        // the tsc at base_ns
+    gint64  base_ns;         // the clock at base_tsc
+    gdouble ns_per_tick;     // the rate of the clock
+    guint64 ref_tsc;         // the tsc at the last calibration
+    gint64  ref_ns;          // the monotonic clock at ref_tsc
+    guint64 recalibrate_tsc; // the tsc after which we recalibrate
+} TscParams;
+
+static TscParams g_params;     // protected by g_seq
+static guint     g_seq;        // odd while g_params is written
+static gint      g_calibrated; // atomic
+static gint      g_failed;     // atomic
+static GMutex    g_lock;       // held while calibrating
+
+/**
+ * psy_clock_source_monotonic_ns:(skip)
+ *
+ * Returns: the time of the monotonic clock that g_get_monotonic_time() uses
+ *          in nanoseconds.
+ */
+gint64
+psy_clock_source_monotonic_ns(void)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+#else
+    return g_get_monotonic_time() * 1000;
+#endif
+}
+
+#if defined(PSY_HAVE_TSC)
+
+/*
+ * Reads the monotonic clock in between two reads of the TSC, the pair with
+ * the smallest gap between the TSC reads is the most accurate one.
+ */
+static void
+sample_pair(guint64 *tsc, gint64 *ns)
+{
+    guint64 best_gap = G_MAXUINT64;
+
+    for (gint i = 0; i < NUM_PAIR_SAMPLES; i++) {
+        guint64 t0  = __rdtsc();
+        gint64  ref = psy_clock_source_monotonic_ns();
+        guint64 t1  = __rdtsc();
+
+        if (t1 > t0 && t1 - t0 < best_gap) {
+            best_gap = t1 - t0;
+            *tsc     = t0 + (t1 - t0) / 2;
+            *ns      = ref;
+        }
+    }
+}
+
+static inline gint64
+params_to_ns(const TscParams *params, guint64 tsc)
+{
+    gint64 ticks = (gint64) (tsc - params->base_tsc);
+    return params->base_ns + (gint64) ((gdouble) ticks * params->ns_per_tick);
+}
+
+static void
+params_set_interval(TscParams *params)
+{
+    params->recalibrate_tsc
+        = params->base_tsc
+          + (guint64) ((gdouble) RECALIBRATE_NS / params->ns_per_tick);
+}
+
+/*
+ * Copies the calibration parameters into params and returns the sequence
+ * number of that copy.
+ */
+static guint
+params_read(TscParams *params)
+{
+    guint seq;
+
+    do {
+        seq     = __atomic_load_n(&g_seq, __ATOMIC_ACQUIRE);
+        *params = g_params;
+        // The copy must be complete before the sequence number is checked.
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&g_seq, __ATOMIC_RELAXED) != seq);
+
+    return seq;
+}
+
+/*
+ * Publishes new calibration parameters, the caller must hold g_lock.
+ */
+static void
+params_write(const TscParams *params)
+{
+    guint seq = __atomic_load_n(&g_seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&g_seq, seq + 1, __ATOMIC_RELAXED);
+    // Readers must see the odd sequence number before any of the new values.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    g_params = *params;
+    __atomic_store_n(&g_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void
+tsc_recalibrate(guint seq)
+{
+    if (!g_mutex_trylock(&g_lock))
+        return; // Another thread is recalibrating
+
+    if (__atomic_load_n(&g_seq, __ATOMIC_RELAXED) != seq) {
+        g_mutex_unlock(&g_lock);
+        return; // Another thread has just recalibrated
+    }
+
+    // Only the holder of g_lock writes g_params, so it may read it directly.
+    const TscParams *old    = &g_params;
+    TscParams        params = {0};
+    guint64          tsc    = 0;
+    gint64           ref    = 0;
+
+    sample_pair(&tsc, &ref);
+
+    gint64 estimate = params_to_ns(old, tsc);
+    gint64 error    = ref - estimate;
+
+    if (tsc <= old->ref_tsc || ref <= old->ref_ns
+        || ABS(error) > MAX_ERROR_NS) {
+        g_warning("The TSC is %" G_GINT64_FORMAT
+                  " ns off from the monotonic clock, psylib falls back to "
+                  "the monotonic clock",
+                  error);
+        g_atomic_int_set(&g_failed, TRUE);
+        g_mutex_unlock(&g_lock);
+        return;
+    }
+
+    gdouble rate
+        = (gdouble) (ref - old->ref_ns) / (gdouble) (tsc - old->ref_tsc);
+    gdouble interval_ticks = (gdouble) RECALIBRATE_NS / rate;
+
+    params.base_tsc    = tsc;
+    params.base_ns     = estimate;
+    params.ns_per_tick = rate + (gdouble) error / interval_ticks;
+    params.ref_tsc     = tsc;
+    params.ref_ns      = ref;
+    params_set_interval(&params);
+
+    params_write(&params);
+
+    g_mutex_unlock(&g_lock);
+}
+
+#endif // PSY_HAVE_TSC
+
+/**
+ * psy_clock_source_tsc_is_invariant:(skip)
+ *
+ * Returns: TRUE when this is an x86 CPU that has an invariant TSC.
+ */
+gboolean
+psy_clock_source_tsc_is_invariant(void)
+{
+#if defined(PSY_HAVE_TSC)
+    guint eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+        return FALSE;
+
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+
+    return (edx & (1u << 8)) != 0;
+#else
+    return FALSE;
+#endif
+}
+
+/**
+ * psy_clock_source_tsc_calibrate:(skip)
+ *
+ * Calibrates the TSC against the monotonic clock, this takes about
+ * CALIBRATION_US microseconds the first time it is called.
+ *
+ * Returns: TRUE when the TSC may be used as clock.
+ */
+gboolean
+psy_clock_source_tsc_calibrate(void)
+{
+#if defined(PSY_HAVE_TSC)
+    gboolean ret = FALSE;
+
+    if (!psy_clock_source_tsc_is_invariant())
+        return FALSE;
+
+    g_mutex_lock(&g_lock);
+
+    if (g_atomic_int_get(&g_calibrated)) {
+        ret = !g_atomic_int_get(&g_failed);
+        goto out;
+    }
+
+    guint64 t0 = 0, t1 = 0;
+    gint64  n0 = 0, n1 = 0;
+
+    sample_pair(&t0, &n0);
+    g_usleep(CALIBRATION_US);
+    sample_pair(&t1, &n1);
+
+    if (t1 <= t0 || n1 <= n0)
+        goto out;
+
+    TscParams params   = {0};
+    params.base_tsc    = t1;
+    params.base_ns     = n1;
+    params.ns_per_tick = (gdouble) (n1 - n0) / (gdouble) (t1 - t0);
+    params.ref_tsc     = t1;
+    params.ref_ns      = n1;
+    params_set_interval(&params);
+
+    params_write(&params);
+    g_atomic_int_set(&g_calibrated, TRUE);
+    ret = TRUE;
+
+out:
+    g_mutex_unlock(&g_lock);
+    return ret;
+#else
+    return FALSE;
+#endif
+}
+
+/**
+ * psy_clock_source_tsc_failed:(skip)
+ *
+ * Returns: TRUE when a recalibration detected that the TSC isn't reliable.
+ */
+gboolean
+psy_clock_source_tsc_failed(void)
+{
+    return g_atomic_int_get(&g_failed);
+}
+
+/**
+ * psy_clock_source_tsc_ns:(skip)
+ * @ns:(out): the current time of the monotonic clock in nanoseconds
+ *
+ * Reads the TSC and converts it to the time of the monotonic clock.
+ *
+ * Returns: FALSE when the TSC isn't calibrated or isn't reliable, @ns
+ *          isn't set in that case.
+ */
+gboolean
+psy_clock_source_tsc_ns(gint64 *ns)
+{
+#if defined(PSY_HAVE_TSC)
+    if (G_UNLIKELY(!g_atomic_int_get(&g_calibrated)
+                   || g_atomic_int_get(&g_failed)))
+        return FALSE;
+
+    TscParams params;
+    guint     seq = params_read(&params);
+    guint64   tsc = __rdtsc();
+
+    if (G_UNLIKELY(tsc >= params.recalibrate_tsc)) {
+        tsc_recalibrate(seq);
+        if (g_atomic_int_get(&g_failed))
+            return FALSE;
+        params_read(&params);
+        tsc = __rdtsc();
+    }
+
+    *ns = params_to_ns(&params, tsc);
+    return TRUE;
+#else
+    (void) ns;
+    return FALSE;
+#endif
+}
@@ -0,0 +1,23 @@
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gint64
+psy_clock_source_monotonic_ns(void);
+
+gboolean
+psy_clock_source_tsc_is_invariant(void);
+
+gboolean
+psy_clock_source_tsc_calibrate(void);
+
+gboolean
+psy_clock_source_tsc_failed(void);
+
+gboolean
+psy_clock_source_tsc_ns(gint64 *ns);
+
+G_END_DECLS
@@ -1,5 +1,6 @@
 
 #include "psy-clock.h"
+#include "psy-clock-source-private.h"
 
 /**
  * PsyClock:
@@ -17,6 +18,13 @@
  * All timestamps are compared to a "zero" time, that is the time that
  * This class is being defined, when you or psylib create the first
  * instance of [class@PsyClock]
+ *
+ * By default the time is read from the monotonic clock of the OS. On x86
+ * CPUs with an invariant time stamp counter, the clock may read the TSC
+ * instead, see [func@Clock.set_source]. Reading the TSC takes a few
+ * nanoseconds and it has a nanosecond resolution, it is calibrated against
+ * the monotonic clock, so the time remains comparable with
+ * [func@GLib.get_monotonic_time].
  */
 
 typedef struct _PsyClock {
@@ -25,6 +33,7 @@ typedef struct _PsyClock {
 } PsyClock;
 
 static gint64 g_zero_time;
+static gint   g_clock_source = PSY_CLOCK_SOURCE_MONOTONIC; // atomic
 
 typedef enum {
     PROP_NULL, //
@@ -129,7 +138,7 @@ psy_clock_now(PsyClock *self)
 {
     g_return_val_if_fail(PSY_IS_CLOCK(self), NULL);
 
-    gint64        num_ticks = g_get_monotonic_time() - self->zero_time;
+    gint64        num_ticks = psy_clock_get_monotonic_time() - self->zero_time;
     PsyTimePoint *tp        = psy_time_point_new();
     tp->ticks_since_start   = num_ticks;
     return tp;
@@ -155,3 +164,80 @@ psy_clock_get_zero_time(void)
     }
     return g_zero_time;
 }
+
+/**
+ * psy_clock_set_source:
+ * @source: the source from which the time should be read
+ *
+ * Selects the source of the time for all clocks. When @source is
+ * #PSY_CLOCK_SOURCE_TSC, the TSC is calibrated first, which takes a few
+ * milliseconds. When the CPU doesn't have an invariant TSC, the monotonic
+ * clock remains in use. The TSC is checked against the monotonic clock
+ * periodically, when they drift apart, psylib falls back to the monotonic
+ * clock as well.
+ *
+ * Returns: TRUE when @source is used from now on, FALSE otherwise.
+ */
+gboolean
+psy_clock_set_source(PsyClockSource source)
+{
+    if (source == PSY_CLOCK_SOURCE_TSC && !psy_clock_source_tsc_calibrate()) {
+        g_info("The TSC can't be used as clock source");
+        return FALSE;
+    }
+
+    g_atomic_int_set(&g_clock_source, source);
+    return TRUE;
+}
+
+/**
+ * psy_clock_get_source:
+ *
+ * Returns: the source from which the time is read.
+ */
+PsyClockSource
+psy_clock_get_source(void)
+{
+    PsyClockSource source = g_atomic_int_get(&g_clock_source);
+
+    if (source == PSY_CLOCK_SOURCE_TSC && psy_clock_source_tsc_failed())
+        return PSY_CLOCK_SOURCE_MONOTONIC;
+
+    return source;
+}
+
+/**
+ * psy_clock_get_monotonic_time_ns:
+ *
+ * Reads the clock source selected with [func@Clock.set_source]. This
+ * doesn't allocate and is cheap enough to be called in spin loops.
+ *
+ * Returns: the time of the monotonic clock in nanoseconds, this is the same
+ *          clock as [func@GLib.get_monotonic_time] uses.
+ */
+gint64
+psy_clock_get_monotonic_time_ns(void)
+{
+    gint64 ns;
+
+    if (g_atomic_int_get(&g_clock_source) == PSY_CLOCK_SOURCE_TSC
+        && psy_clock_source_tsc_ns(&ns))
+        return ns;
+
+    return psy_clock_source_monotonic_ns();
+}
+
+/**
+ * psy_clock_get_monotonic_time:
+ *
+ * Similar to [func@Clock.get_monotonic_time_ns], the result may be used where
+ * the result of [func@GLib.get_monotonic_time] is expected, such as
+ * [ctor@TimePoint.new_monotonic].
+ *
+ * Returns: the time of the monotonic clock in microseconds.
+ */
+gint64
+psy_clock_get_monotonic_time(void)
+{
+    return psy_clock_get_monotonic_time_ns() / 1000;
+}
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "psy-enums.h"
 #include "psy-time-point.h"
 
 G_BEGIN_DECLS
@@ -21,4 +22,16 @@ psy_clock_now(PsyClock *self);
 G_MODULE_EXPORT gint64
 psy_clock_get_zero_time(void);
 
+G_MODULE_EXPORT gboolean
+psy_clock_set_source(PsyClockSource source);
+
+G_MODULE_EXPORT PsyClockSource
+psy_clock_get_source(void);
+
+G_MODULE_EXPORT gint64
+psy_clock_get_monotonic_time_ns(void);
+
+G_MODULE_EXPORT gint64
+psy_clock_get_monotonic_time(void);
+
 G_END_DECLS
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "psy-color.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The instance struct is shared with the artists, so they are able to read
+ * the color without going through GObject properties while drawing.
+ */
+typedef struct _PsyColor {
+    GObject parent;
+
+    union {
+        gfloat rgba[4];
+
+        struct {
+            gfloat red;
+            gfloat green;
+            gfloat blue;
+            gfloat alpha;
+        } colors;
+    } values;
+} PsyColor;
+
+/*
+ * psy_color_get_rgba_values:
+ * @self: an instance of `PsyColor`
+ *
+ * Returns:(transfer none): the red, green, blue and alpha values of @self
+ */
+static inline const gfloat *
+psy_color_get_rgba_values(PsyColor *self)
+{
+    return self->values.rgba;
+}
+
+G_END_DECLS
@@ -1,6 +1,7 @@
 
 #include <math.h>
 
+#include "psy-color-private.h"
 #include "psy-color.h"
 
 PsyRgba *
@@ -100,21 +101,6 @@ psy_rgba_free(PsyRgba *self)
  * to do with the color values.
  */
 
-typedef struct _PsyColor {
-    GObject parent;
-
-    union {
-        gfloat rgba[4];
-
-        struct {
-            gfloat red;
-            gfloat green;
-            gfloat blue;
-            gfloat alpha;
-        } colors;
-    } values;
-} PsyColor;
-
 G_DEFINE_TYPE(PsyColor, psy_color, G_TYPE_OBJECT)
 
 typedef enum {
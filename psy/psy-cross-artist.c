@@ -1,7 +1,6 @@
 
-
+#include "psy-artist-private.h"
 #include "psy-cross-artist.h"
-#include "psy-color.h"
 #include "psy-cross.h"
 #include "psy-drawing-context.h"
 #include "psy-matrix4.h"
@@ -12,6 +11,9 @@
 typedef struct _PsyCrossArtist {
     PsyArtist   parent_instance;
     PsyVBuffer *vertices;
+    PsyVBuffer *unit_mesh; // shared via the drawing context
+    gchar      *unit_mesh_name;
+    gfloat      unit_xwidth, unit_ywidth; // relative line widths of unit_mesh
     gfloat      x, y, z;
     gfloat      xwidth, ywidth;
     gfloat      xlength, ylength;
@@ -19,6 +21,41 @@ typedef struct _PsyCrossArtist {
 
 G_DEFINE_TYPE(PsyCrossArtist, psy_cross_artist, PSY_TYPE_ARTIST)
 
+/*
+ * The number of cross artists that use a unit mesh is stored with the mesh,
+ * the last one removes it from the drawing context.
+ */
+G_DEFINE_QUARK("psy-cross-artist-num-users", cross_mesh_users)
+
+static guint
+cross_mesh_add_users(PsyVBuffer *mesh, gint num)
+{
+    GQuark quark = cross_mesh_users_quark();
+    guint  num_users
+        = GPOINTER_TO_UINT(g_object_get_qdata(G_OBJECT(mesh), quark)) + num;
+
+    g_object_set_qdata(G_OBJECT(mesh), quark, GUINT_TO_POINTER(num_users));
+    return num_users;
+}
+
+static void
+cross_artist_release_unit_mesh(PsyCrossArtist *self)
+{
+    if (!self->unit_mesh)
+        return;
+
+    guint num_users = cross_mesh_add_users(self->unit_mesh, -1);
+
+    PsyDrawingContext *context = psy_artist_get_context(PSY_ARTIST(self));
+    if (num_users == 0 && context
+        && psy_drawing_context_get_vbuffer(context, self->unit_mesh_name)
+               == self->unit_mesh)
+        psy_drawing_context_unregister_vbuffer(context, self->unit_mesh_name);
+
+    g_clear_object(&self->unit_mesh);
+    g_clear_pointer(&self->unit_mesh_name, g_free);
+}
+
 static void
 psy_cross_artist_init(PsyCrossArtist *self)
 {
@@ -42,6 +79,7 @@ psy_cross_artist_dispose(GObject *object)
     PsyCrossArtist *self = PSY_CROSS_ARTIST(object);
 
     g_clear_object(&self->vertices);
+    cross_artist_release_unit_mesh(self);
 
     G_OBJECT_CLASS(psy_cross_artist_parent_class)->dispose(object);
 }
@@ -52,47 +90,63 @@ psy_cross_artist_finalize(GObject *object)
     G_OBJECT_CLASS(psy_cross_artist_parent_class)->finalize(object);
 }
 
+/*
+ * Sets the origin and 13 vertices in a clockwise manner, the last vertex
+ * closes the loop.
+ */
+static void
+cross_set_vertices(PsyVBuffer *vertices,
+                   gfloat      xlength,
+                   gfloat      ylength,
+                   gfloat      xwidth,
+                   gfloat      ywidth)
+{
+    const gfloat hxl = xlength / 2.0f, hyl = ylength / 2.0f;
+    const gfloat hxw = xwidth / 2.0f, hyw = ywidth / 2.0f;
+
+    // clang-format off
+    const gfloat xy[][2] = {
+        {0, 0},
+        {hyw, hyl},
+        {hyw, hxw},
+        {hxl, hxw},
+        {hxl, -hxw},
+        {hyw, -hxw},
+        {hyw, -hyl},
+        {-hyw, -hyl},
+        {-hyw, -hxw},
+        {-hxl, -hxw},
+        {-hxl, hxw},
+        {-hyw, hxw},
+        {-hyw, hyl},
+        {hyw, hyl},
+    };
+    // clang-format on
+
+    for (guint i = 0; i < G_N_ELEMENTS(xy); i++)
+        psy_vbuffer_set_xyz(vertices, i, xy[i][0], xy[i][1], 0);
+}
+
 static void
 cross_artist_draw(PsyArtist *self)
 {
     PSY_ARTIST_CLASS(psy_cross_artist_parent_class)->draw(self);
 
-    gfloat          rgba[4]    = {0, 0, 0, 1};
-    PsyCrossArtist *artist     = PSY_CROSS_ARTIST(self);
-    PsyCross       *cross      = PSY_CROSS(psy_artist_get_stimulus(self));
-    PsyColor       *color      = NULL;
-    GError         *error      = NULL;
-    const guint     nverts     = 14; // origin + 12 corners + the first corner
-    const gchar    *color_name = "ourColor";
+    PsyCrossArtist *artist = PSY_CROSS_ARTIST(self);
+    PsyCross       *cross  = PSY_CROSS(psy_artist_get_stimulus(self));
+    GError         *error  = NULL;
+    const guint     nverts = 14; // origin + 12 corners + the first corner
 
     gboolean store_vertices = FALSE;
     gfloat   line_length_x, line_length_y;
     gfloat   line_width_x, line_width_y;
 
-    PsyShaderProgram *program = psy_artist_get_program(self);
+    line_length_x = psy_cross_get_line_length_x(cross);
+    line_length_y = psy_cross_get_line_length_y(cross);
+    line_width_x  = psy_cross_get_line_width_x(cross);
+    line_width_y  = psy_cross_get_line_width_y(cross);
 
-    // clang-format off
-    g_object_get(cross,
-            "line-length-x", &line_length_x,
-            "line-length-y", &line_length_y,
-            "line-width-x", &line_width_x,
-            "line-width-y", &line_width_y,
-            "color", &color,
-            NULL
-            );
-    // clang-format on
-
-    if (color) {
-        // clang-format off
-        g_object_get(color,
-                "r", &rgba[0],
-                "g", &rgba[1],
-                "b", &rgba[2],
-                "a", &rgba[3],
-                NULL);
-        // clang-format on
-    }
-    psy_shader_program_set_uniform_4f(program, color_name, rgba, &error);
+    psy_artist_set_color_uniform(self, &error);
     if (error) {
         g_critical("%s: failed to set color: %s", __func__, error->message);
         g_clear_error(&error);
@@ -103,9 +157,9 @@ cross_artist_draw(PsyArtist *self)
         store_vertices = TRUE;
     }
 
-    if (artist->xwidth != line_width_x || artist->ywidth != line_length_x
+    if (artist->xwidth != line_width_x || artist->ywidth != line_width_y
         || artist->xlength != line_length_x
-        || artist->ylength + line_length_y) {
+        || artist->ylength != line_length_y) {
         artist->xlength = line_length_x;
         artist->ylength = line_length_y;
         artist->xwidth  = line_width_x;
@@ -114,67 +168,17 @@ cross_artist_draw(PsyArtist *self)
     }
 
     if (store_vertices) {
-        // set origin and add 13 vertices in a clockwise manner
-        psy_vbuffer_set_xyz(artist->vertices, 0, 0, 0, 0);
-
-        gfloat x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12;
-        gfloat y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12;
-
-        x1 = artist->ywidth / 2.0f;
-        y1 = artist->ylength / 2.0f;
-
-        x2 = artist->ywidth / 2.0f;
-        y2 = artist->xwidth / 2.0f;
-
-        x3 = artist->xlength / 2.0f;
-        y3 = artist->xwidth / 2.0f;
-
-        x4 = artist->xlength / 2.0f;
-        y4 = -artist->xwidth / 2.0f;
-
-        x5 = artist->ywidth / 2.0f;
-        y5 = -artist->xwidth / 2.0f;
-
-        x6 = artist->ywidth / 2.0f;
-        y6 = -artist->xlength / 2.0f;
-
-        x7 = -artist->ywidth / 2.0f;
-        y7 = -artist->xlength / 2.0f;
-
-        x8 = -artist->ywidth / 2.0f;
-        y8 = -artist->xwidth / 2.0f;
-
-        x9 = -artist->xlength / 2.0f;
-        y9 = -artist->xwidth / 2.0f;
-
-        x10 = -artist->xlength / 2.0f;
-        y10 = artist->xwidth / 2.0f;
-
-        x11 = -artist->ywidth / 2.0f;
-        y11 = artist->xwidth / 2.0f;
-
-        x12 = -artist->ywidth / 2.0f;
-        y12 = artist->ylength / 2.0f;
-
-        psy_vbuffer_set_xyz(artist->vertices, 1, x1, y1, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 2, x2, y2, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 3, x3, y3, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 4, x4, y4, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 5, x5, y5, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 6, x6, y6, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 7, x7, y7, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 8, x8, y8, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 9, x9, y9, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 10, x10, y10, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 11, x11, y11, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 12, x12, y12, 0);
-        psy_vbuffer_set_xyz(artist->vertices, 13, x1, y1, 0); // close the loop
+        cross_set_vertices(artist->vertices,
+                           artist->xlength,
+                           artist->ylength,
+                           artist->xwidth,
+                           artist->ywidth);
 
         psy_vbuffer_upload(artist->vertices, &error);
         if (error) {
             g_critical("PsyCrossArtist: unable to upload vertices: %s",
                        error->message);
-            g_error_free(error);
+            g_clear_error(&error);
         }
     }
     psy_vbuffer_draw_triangle_fan(artist->vertices, &error);
@@ -183,8 +187,78 @@ cross_artist_draw(PsyArtist *self)
                    error->message);
         g_error_free(error);
     }
+}
+
+/*
+ * A cross that is 1 * 1 long, the line widths are relative to the line
+ * lengths. Crosses with the same proportions share this mesh, it is scaled
+ * to the line lengths of each cross. When the proportions of a cross
+ * change, it releases its previous mesh, so animating the line widths
+ * doesn't accumulate meshes.
+ */
+static PsyVBuffer *
+cross_artist_get_unit_mesh(PsyCrossArtist *self, gfloat xwidth, gfloat ywidth)
+{
+    if (self->unit_mesh && self->unit_xwidth == xwidth
+        && self->unit_ywidth == ywidth)
+        return self->unit_mesh;
+
+    cross_artist_release_unit_mesh(self);
+
+    PsyDrawingContext *context = psy_artist_get_context(PSY_ARTIST(self));
+    gchar *name = g_strdup_printf("psy-unit-cross-%a-%a", xwidth, ywidth);
+    PsyVBuffer *mesh = psy_drawing_context_get_vbuffer(context, name);
+
+    if (!mesh) {
+        GError *error = NULL;
+
+        mesh = psy_drawing_context_create_vbuffer(context);
+        psy_vbuffer_set_nvertices(mesh, 14);
+        cross_set_vertices(mesh, 1.0f, 1.0f, xwidth, ywidth);
+
+        psy_drawing_context_register_vbuffer(context, name, mesh, &error);
+        if (error) {
+            g_critical("PsyCrossArtist: unable to register mesh: %s",
+                       error->message);
+            g_error_free(error);
+            g_free(name);
+            return NULL;
+        }
+    }
+
+    cross_mesh_add_users(mesh, 1);
 
-    g_object_unref(color);
+    self->unit_mesh      = g_object_ref(mesh);
+    self->unit_mesh_name = name;
+    self->unit_xwidth    = xwidth;
+    self->unit_ywidth    = ywidth;
+    return mesh;
+}
+
+static PsyVBuffer *
+cross_artist_get_instance(PsyArtist          *self,
+                          PsyVBufferInstance *instance,
+                          PsyTexture        **texture)
+{
+    (void) texture;
+    PsyCrossArtist *artist = PSY_CROSS_ARTIST(self);
+    PsyCross       *cross  = PSY_CROSS(psy_artist_get_stimulus(self));
+
+    gfloat xlength = psy_cross_get_line_length_x(cross);
+    gfloat ylength = psy_cross_get_line_length_y(cross);
+    if (xlength == 0 || ylength == 0)
+        return NULL;
+
+    // The horizontal line width scales along the y-axis and vice versa.
+    PsyVBuffer *mesh = cross_artist_get_unit_mesh(
+        artist,
+        psy_cross_get_line_width_x(cross) / ylength,
+        psy_cross_get_line_width_y(cross) / xlength);
+    if (!mesh)
+        return NULL;
+
+    psy_artist_fill_instance(self, xlength, ylength, instance);
+    return mesh;
 }
 
 static void
@@ -197,7 +271,8 @@ psy_cross_artist_class_init(PsyCrossArtistClass *class)
     gobject_class->dispose     = psy_cross_artist_dispose;
     gobject_class->constructed = psy_cross_artist_constructed;
 
-    artist_class->draw = cross_artist_draw;
+    artist_class->draw         = cross_artist_draw;
+    artist_class->get_instance = cross_artist_get_instance;
 }
 
 /* ************ public functions ******************** */
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "psy-drawing-context.h"
+
+G_BEGIN_DECLS
+
+PsyTexture *
+psy_drawing_context_lookup_texture(PsyDrawingContext *self, const gchar *name);
+
+G_END_DECLS
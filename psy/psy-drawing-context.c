@@ -1,9 +1,11 @@
 
 
+#include "psy-drawing-context-private.h"
 #include "psy-drawing-context.h"
 #include "psy-enums.h"
 #include "psy-shader-program.h"
 #include "psy-shader.h"
+#include "psy-texture-atlas.h"
 #include "psy-vbuffer.h"
 
 /**
@@ -20,305 +22,1555 @@
  *
  * The drawing context may contain some general shader programs in order to
  * render pictures or shapes in an arbitrary color.
+ *
+ * Small textures with 4 channels are also copied into a [class@TextureAtlas]
+ * when they are registered, this allows pictures to be drawn in batches.
+ *
+ * The registered textures form a cache, whose memory use may be bounded with
+ * the [property@DrawingContext:texture-budget] and
+ * [property@DrawingContext:image-budget] properties. When a budget is
+ * exceeded, the least recently used textures are evicted. Evicted textures
+ * are decoded and uploaded again when they are obtained with
+ * [method@DrawingContext.get_texture]. Textures that must stay resident
+ * may be pinned with [method@DrawingContext.pin_texture]. The mipmaps of the
+ * textures and the atlases count towards the budgets, but the atlases are
+ * never evicted.
+ */
+
+// clang-format off
+G_DEFINE_QUARK(psy-drawing-context-error-quark,
+               psy_drawing_context_error)
+// clang-format on
+
+/**
+ * PSY_UNIFORM_COLOR_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * draws using a uniform color.
+ */
+const gchar *PSY_UNIFORM_COLOR_PROGRAM_NAME = "uniform-color-program";
+
+/**
+ * PSY_PICTURE_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * is able to draw a picture/texture.
+ */
+const gchar *PSY_PICTURE_PROGRAM_NAME = "picture-program";
+
+/**
+ * PSY_INSTANCED_COLOR_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * draws many instances of a mesh at once, each with its own model matrix
+ * and color. See [method@VBuffer.draw_triangle_fan_instanced].
+ */
+const gchar *PSY_INSTANCED_COLOR_PROGRAM_NAME = "instanced-color-program";
+
+/**
+ * PSY_SDF_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * draws smooth discs, ellipses, rings and rounded rectangles on a single
+ * quad, using the signed distance to the edge of the shape.
+ */
+const gchar *PSY_SDF_PROGRAM_NAME = "sdf-program";
+
+/**
+ * PSY_INSTANCED_PICTURE_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * draws many instances of a mesh at once, each showing its own part of
+ * a texture atlas. See [method@DrawingContext.get_atlas].
+ */
+const gchar *PSY_INSTANCED_PICTURE_PROGRAM_NAME = "instanced-picture-program";
+
+/**
+ * PSY_INSTANCED_GLYPH_PROGRAM_NAME:
+ *
+ * The name for a string constant used to register a shader program that
+ * draws text as instances of a quad, each showing a glyph of the glyph atlas
+ * in its own color. See [method@DrawingContext.get_glyph_atlas].
+ */
+const gchar *PSY_INSTANCED_GLYPH_PROGRAM_NAME = "instanced-glyph-program";
+
+// The size of the texture atlas and of the largest texture that is put in it
+#define ATLAS_SIZE           2048
+#define ATLAS_MAX_IMAGE_SIZE (ATLAS_SIZE / 4)
+// The size of the atlas with the glyphs of text stimuli
+#define GLYPH_ATLAS_SIZE 1024
+// The atlases store their pixels as RGBA
+#define ATLAS_NUM_CHANNELS 4
+
+/*
+ * Bookkeeping of a registered texture for the texture cache. The entries are
+ * kept in a list in order of use, the most recently used first.
+ */
+typedef struct CacheEntry {
+    GList       link;
+    gchar      *name;
+    PsyTexture *texture; // owned by the textures table
+    gsize       texture_bytes;
+    gsize       image_bytes;
+    guint       num_pins; // pinned textures are never evicted
+    gboolean    evicted;
+} CacheEntry;
+
+typedef struct _PsyDrawingContextPrivate {
+    GHashTable      *shader_programs;
+    GHashTable      *textures;
+    GHashTable      *vbuffers;
+    PsyTextureAtlas *atlas;
+    PsyTextureAtlas *glyph_atlas;
+    GThreadPool     *decode_pool;
+
+    GHashTable *cache_entries;
+    GQueue      lru;
+    guint64     texture_budget, image_budget;
+    guint64     texture_bytes, image_bytes;
+    guint64     num_hits, num_misses, num_evictions;
+} PsyDrawingContextPrivate;
+
+G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyDrawingContext,
+                                    psy_drawing_context,
+                                    G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_TEXTURE_BUDGET,
+    PROP_IMAGE_BUDGET,
+    NUM_PROPERTIES
+} PsyDrawingContextProperty;
+
+static GParamSpec *drawing_context_properties[NUM_PROPERTIES];
+
+typedef enum { PRELOAD_PROGRESS, NUM_SIGNALS } PsyDrawingContextSignal;
+
+static guint drawing_context_signals[NUM_SIGNALS];
+
+/*
+ * A PreloadJob is a set of image files that are decoded by the decode pool.
+ * The decoded textures are returned via the decoded queue to the thread that
+ * draws, which uploads and registers them as they come in.
+ */
+typedef struct PreloadJob {
+    gint               ref_count;
+    PsyDrawingContext *context;
+    GAsyncQueue       *decoded;
+    GCancellable      *cancellable;
+    GMainContext      *main_context; // only for asynchronous jobs
+    GTask             *task;         // only for asynchronous jobs
+    guint              num_to_load;
+    guint              num_done;
+    GError            *error; // the first error that occurred
+} PreloadJob;
+
+typedef struct PreloadItem {
+    PreloadJob *job;
+    gchar      *path;
+    PsyTexture *texture;
+    GError     *error;
+} PreloadItem;
+
+static PreloadJob *
+preload_job_new(PsyDrawingContext *context, GCancellable *cancellable)
+{
+    PreloadJob *job = g_new0(PreloadJob, 1);
+
+    job->ref_count = 1;
+    job->context   = g_object_ref(context);
+    job->decoded   = g_async_queue_new();
+    if (cancellable)
+        job->cancellable = g_object_ref(cancellable);
+
+    return job;
+}
+
+static PreloadJob *
+preload_job_ref(PreloadJob *job)
+{
+    g_atomic_int_inc(&job->ref_count);
+    return job;
+}
+
+static void
+preload_job_unref(PreloadJob *job)
+{
+    if (!g_atomic_int_dec_and_test(&job->ref_count))
+        return;
+
+    g_object_unref(job->context);
+    g_async_queue_unref(job->decoded);
+    g_clear_object(&job->cancellable);
+    g_clear_pointer(&job->main_context, g_main_context_unref);
+    g_clear_object(&job->task);
+    g_clear_error(&job->error);
+    g_free(job);
+}
+
+static void
+preload_item_free(PreloadItem *item)
+{
+    preload_job_unref(item->job);
+    g_free(item->path);
+    g_clear_object(&item->texture);
+    g_clear_error(&item->error);
+    g_free(item);
+}
+
+static gboolean preload_job_dispatch(gpointer data);
+
+/*
+ * Hands a (decoded) item back to the thread that draws.
+ */
+static void
+preload_job_return_item(PreloadJob *job, PreloadItem *item)
+{
+    GSource *source = NULL;
+
+    // Create the source before the push, the item may be freed as soon as it
+    // is in the queue. An idle source, rather than g_main_context_invoke, makes
+    // sure the dispatch never runs in a thread of the pool.
+    if (job->main_context) {
+        source = g_idle_source_new();
+        g_source_set_callback(source,
+                              preload_job_dispatch,
+                              preload_job_ref(job),
+                              (GDestroyNotify) preload_job_unref);
+    }
+
+    g_async_queue_push(job->decoded, item);
+
+    if (source) {
+        g_source_attach(source, job->main_context);
+        g_source_unref(source);
+    }
+}
+
+/*
+ * Runs in a thread of the decode pool.
+ */
+static void
+decode_worker(gpointer data, gpointer user_data)
+{
+    PreloadItem *item = data;
+    PreloadJob  *job  = item->job;
+    (void) user_data;
+
+    if (!g_cancellable_set_error_if_cancelled(job->cancellable, &item->error))
+        psy_texture_decode_path(item->texture, item->path, &item->error);
+
+    preload_job_return_item(job, item);
+}
+
+static CacheEntry *
+cache_entry_new(const gchar *name, PsyTexture *texture)
+{
+    CacheEntry *entry = g_new0(CacheEntry, 1);
+
+    entry->link.data = entry;
+    entry->name      = g_strdup(name);
+    entry->texture   = texture;
+
+    return entry;
+}
+
+static void
+cache_entry_free(CacheEntry *entry)
+{
+    g_free(entry->name);
+    g_free(entry);
+}
+
+/*
+ * The number of bytes a texture of width * height pixels occupies on the
+ * graphics hardware. Uploaded textures always get mipmaps, which together
+ * add about a third to the size of the base level.
+ */
+static gsize
+mipmapped_num_bytes(guint width, guint height, guint num_channels)
+{
+    gsize num_bytes = 0;
+
+    if (width == 0 || height == 0)
+        return 0;
+
+    while (TRUE) {
+        num_bytes += (gsize) width * height * num_channels;
+        if (width == 1 && height == 1)
+            break;
+        width  = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+
+    return num_bytes;
+}
+
+/*
+ * The atlases are never evicted, but their texture and the copy of its
+ * pixels in main memory count towards the budgets.
+ */
+static void
+drawing_context_account_atlas(PsyDrawingContextPrivate *priv,
+                              PsyTextureAtlas          *atlas)
+{
+    guint width  = psy_texture_atlas_get_width(atlas);
+    guint height = psy_texture_atlas_get_height(atlas);
+
+    priv->texture_bytes
+        += mipmapped_num_bytes(width, height, ATLAS_NUM_CHANNELS);
+    priv->image_bytes += (guint64) width * height * ATLAS_NUM_CHANNELS;
+}
+
+/*
+ * Updates the memory that is accounted to entry to the current state of its
+ * texture.
+ */
+static void
+cache_entry_account(PsyDrawingContextPrivate *priv, CacheEntry *entry)
+{
+    PsyTexture *texture = entry->texture;
+
+    priv->texture_bytes -= entry->texture_bytes;
+    priv->image_bytes -= entry->image_bytes;
+
+    entry->texture_bytes = 0;
+    if (psy_texture_is_uploaded(texture)
+        || psy_texture_is_upload_pending(texture))
+        entry->texture_bytes
+            = mipmapped_num_bytes(psy_texture_get_width(texture),
+                                  psy_texture_get_height(texture),
+                                  psy_texture_get_num_channels(texture));
+    entry->image_bytes = psy_texture_get_data(texture)
+                             ? psy_texture_get_num_bytes(texture)
+                             : 0;
+
+    priv->texture_bytes += entry->texture_bytes;
+    priv->image_bytes += entry->image_bytes;
+}
+
+/*
+ * A texture can only be evicted when it can be loaded from its file again
+ * and when it isn't pinned, see [method@DrawingContext.pin_texture].
+ */
+static gboolean
+cache_entry_is_evictable(CacheEntry *entry)
+{
+    return psy_texture_get_filename(entry->texture) != NULL
+           && entry->num_pins == 0;
+}
+
+/*
+ * Evicts the least recently used textures until the memory used fits within
+ * the budgets again. The texture keep, which is about to be used, is never
+ * evicted.
+ */
+static void
+drawing_context_enforce_budget(PsyDrawingContextPrivate *priv,
+                               PsyTexture               *keep)
+{
+    GList *link = priv->lru.tail;
+
+    while (link) {
+        gboolean over_texture = priv->texture_budget
+                                && priv->texture_bytes > priv->texture_budget;
+        gboolean over_image
+            = priv->image_budget && priv->image_bytes > priv->image_budget;
+        if (!over_texture && !over_image)
+            break;
+
+        CacheEntry *entry = link->data;
+        link              = link->prev;
+
+        cache_entry_account(priv, entry);
+        if (entry->texture == keep || !cache_entry_is_evictable(entry))
+            continue;
+
+        gboolean evicted = FALSE;
+        if (over_image && entry->image_bytes) {
+            psy_texture_release_data(entry->texture);
+            evicted = TRUE;
+        }
+        if (over_texture && entry->texture_bytes) {
+            psy_texture_unload(entry->texture);
+            evicted = TRUE;
+        }
+        if (evicted) {
+            entry->evicted = TRUE;
+            priv->num_evictions++;
+            cache_entry_account(priv, entry);
+        }
+    }
+}
+
+/*
+ * Marks entry as most recently used and restores its texture when it has been
+ * evicted from the graphics hardware.
+ */
+static void
+drawing_context_cache_touch(PsyDrawingContextPrivate *priv, CacheEntry *entry)
+{
+    GError     *error   = NULL;
+    PsyTexture *texture = entry->texture;
+
+    g_queue_unlink(&priv->lru, &entry->link);
+    g_queue_push_head_link(&priv->lru, &entry->link);
+
+    if (!entry->evicted || psy_texture_is_uploaded(texture)
+        || psy_texture_is_upload_pending(texture)) {
+        priv->num_hits++;
+        return;
+    }
+
+    priv->num_misses++;
+    if (!psy_texture_get_data(texture))
+        psy_texture_decode_path(
+            texture, psy_texture_get_filename(texture), &error);
+    if (!error)
+        psy_texture_upload_async(texture, &error);
+
+    if (error) {
+        g_warning("Unable to restore texture %s: %s",
+                  entry->name,
+                  error->message);
+        g_error_free(error);
+    }
+    else {
+        entry->evicted = FALSE;
+    }
+
+    cache_entry_account(priv, entry);
+    drawing_context_enforce_budget(priv, texture);
+}
+
+static void
+psy_drawing_context_set_property(GObject      *object,
+                                 guint         property_id,
+                                 const GValue *value,
+                                 GParamSpec   *spec)
+{
+    PsyDrawingContext *self = PSY_DRAWING_CONTEXT(object);
+
+    switch ((PsyDrawingContextProperty) property_id) {
+    case PROP_TEXTURE_BUDGET:
+        psy_drawing_context_set_texture_budget(self, g_value_get_uint64(value));
+        break;
+    case PROP_IMAGE_BUDGET:
+        psy_drawing_context_set_image_budget(self, g_value_get_uint64(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_drawing_context_get_property(GObject    *object,
+                                 guint       property_id,
+                                 GValue     *value,
+                                 GParamSpec *spec)
+{
+    PsyDrawingContext        *self = PSY_DRAWING_CONTEXT(object);
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    switch ((PsyDrawingContextProperty) property_id) {
+    case PROP_TEXTURE_BUDGET:
+        g_value_set_uint64(value, priv->texture_budget);
+        break;
+    case PROP_IMAGE_BUDGET:
+        g_value_set_uint64(value, priv->image_budget);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+psy_drawing_context_init(PsyDrawingContext *self)
+{
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+    priv->shader_programs = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->textures = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->vbuffers = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->cache_entries = g_hash_table_new_full(
+        g_str_hash, g_str_equal, NULL, (GDestroyNotify) cache_entry_free);
+    g_queue_init(&priv->lru);
+}
+
+static void
+psy_drawing_context_dispose(GObject *object)
+{
+    PsyDrawingContext *self = PSY_DRAWING_CONTEXT(object);
+
+    // frees priv->shader_programs, priv->textures and priv->vbuffers
+    psy_drawing_context_free_resources(self);
+
+    G_OBJECT_CLASS(psy_drawing_context_parent_class)->dispose(object);
+}
+
+static void
+psy_drawing_context_finalize(GObject *object)
+{
+    PsyDrawingContext        *self = PSY_DRAWING_CONTEXT(object);
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    // Every job holds a reference to self, so the pool is idle by now.
+    if (priv->decode_pool)
+        g_thread_pool_free(priv->decode_pool, FALSE, TRUE);
+
+    G_OBJECT_CLASS(psy_drawing_context_parent_class)->finalize(object);
+}
+
+static void
+psy_drawing_context_class_init(PsyDrawingContextClass *class)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(class);
+
+    gobject_class->set_property = psy_drawing_context_set_property;
+    gobject_class->get_property = psy_drawing_context_get_property;
+    gobject_class->finalize     = psy_drawing_context_finalize;
+    gobject_class->dispose      = psy_drawing_context_dispose;
+
+    /**
+     * PsyDrawingContext:texture-budget:
+     *
+     * The number of bytes the registered textures, including their mipmaps,
+     * and the atlases may occupy on the graphics hardware. When more is used,
+     * the least recently used textures are unloaded from the graphics
+     * hardware. 0 means there is no limit.
+     */
+    drawing_context_properties[PROP_TEXTURE_BUDGET] = g_param_spec_uint64(
+        "texture-budget",
+        "Texture budget",
+        "The graphics memory in bytes that textures may use, 0 is unlimited",
+        0,
+        G_MAXUINT64,
+        0,
+        G_PARAM_READWRITE);
+
+    /**
+     * PsyDrawingContext:image-budget:
+     *
+     * The number of bytes the decoded images of the registered textures may
+     * occupy in main memory. When more is used, the decoded images of the
+     * least recently used textures are freed. 0 means there is no limit.
+     */
+    drawing_context_properties[PROP_IMAGE_BUDGET] = g_param_spec_uint64(
+        "image-budget",
+        "Image budget",
+        "The memory in bytes that decoded images may use, 0 is unlimited",
+        0,
+        G_MAXUINT64,
+        0,
+        G_PARAM_READWRITE);
+
+    g_object_class_install_properties(
+        gobject_class, NUM_PROPERTIES, drawing_context_properties);
+
+    /**
+     * PsyDrawingContext::preload-progress:
+     * @self: the instance of [class@DrawingContext] that loads the textures
+     * @num_loaded: the number of files that have been handled, including the
+     *              files that failed to load
+     * @num_to_load: the total number of files that are being loaded
+     *
+     * Emitted by [method@DrawingContext.load_files_as_texture] and
+     * [method@DrawingContext.preload_textures_async] each time an image has
+     * been decoded and its upload has started.
+     */
+    drawing_context_signals[PRELOAD_PROGRESS]
+        = g_signal_new("preload-progress",
+                       G_TYPE_FROM_CLASS(class),
+                       G_SIGNAL_RUN_LAST,
+                       0,
+                       NULL,
+                       NULL,
+                       NULL,
+                       G_TYPE_NONE,
+                       2,
+                       G_TYPE_UINT,
+                       G_TYPE_UINT);
+}
+
+/*
+ * The number of decoding threads is bounded by the number of cores.
+ */
+static GThreadPool *
+drawing_context_get_decode_pool(PsyDrawingContext *self, GError **error)
+{
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!priv->decode_pool)
+        priv->decode_pool = g_thread_pool_new(
+            decode_worker, NULL, (gint) g_get_num_processors(), FALSE, error);
+
+    return priv->decode_pool;
+}
+
+/*
+ * Collects the canonical paths of files without duplicates.
+ */
+static GPtrArray *
+canonical_unique_paths(gchar **files, gsize num_files)
+{
+    GPtrArray  *paths   = g_ptr_array_new_with_free_func(g_free);
+    GHashTable *uniques = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (gsize i = 0; i < num_files; i++) {
+        GFile *file      = g_file_new_for_path(files[i]);
+        char  *canonical = g_file_get_path(file);
+        if (!canonical)
+            g_warning("Unable to get canonical path for %s", files[i]);
+        else if (!g_hash_table_add(uniques, canonical))
+            g_free(canonical);
+        else
+            g_ptr_array_add(paths, canonical);
+        g_object_unref(file);
+    }
+    g_hash_table_destroy(uniques);
+
+    return paths;
+}
+
+/*
+ * Hands all paths to the decode pool.
+ */
+static gboolean
+preload_job_start(PreloadJob *job, GPtrArray *paths, GError **error)
+{
+    GThreadPool *pool = drawing_context_get_decode_pool(job->context, error);
+    if (!pool)
+        return FALSE;
+
+    job->num_to_load = paths->len;
+
+    for (guint i = 0; i < paths->len; i++) {
+        PreloadItem *item = g_new0(PreloadItem, 1);
+
+        item->job     = preload_job_ref(job);
+        item->path    = g_strdup(g_ptr_array_index(paths, i));
+        item->texture = psy_drawing_context_create_texture(job->context);
+        psy_texture_set_num_channels(item->texture, 4);
+
+        if (!g_thread_pool_push(pool, item, &item->error))
+            // Let the item fail in the drawing thread, like the others.
+            preload_job_return_item(job, item);
+    }
+    return TRUE;
+}
+
+/*
+ * Uploads and registers a decoded texture, runs in the thread that draws.
+ */
+static void
+preload_job_finish_item(PreloadJob *job, PreloadItem *item)
+{
+    PsyDrawingContext        *self = job->context;
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!item->error)
+        g_cancellable_set_error_if_cancelled(job->cancellable, &item->error);
+
+    if (!item->error && !priv->textures)
+        g_set_error(&item->error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_FAILED,
+                    "The resources of the context have been freed");
+
+    if (!item->error)
+        psy_texture_upload_async(item->texture, &item->error);
+
+    if (!item->error)
+        psy_drawing_context_register_texture(
+            self, item->path, item->texture, &item->error);
+
+    if (item->error && !job->error)
+        job->error = g_steal_pointer(&item->error);
+
+    job->num_done++;
+    g_signal_emit(self,
+                  drawing_context_signals[PRELOAD_PROGRESS],
+                  0,
+                  job->num_done,
+                  job->num_to_load);
+
+    preload_item_free(item);
+}
+
+static gboolean
+preload_job_dispatch(gpointer data)
+{
+    PreloadJob  *job = data;
+    PreloadItem *item;
+
+    if (!job->task)
+        return G_SOURCE_REMOVE;
+
+    while ((item = g_async_queue_try_pop(job->decoded)))
+        preload_job_finish_item(job, item);
+
+    if (job->num_done == job->num_to_load) {
+        GTask *task = g_steal_pointer(&job->task);
+        if (job->error)
+            g_task_return_error(task, g_steal_pointer(&job->error));
+        else
+            g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_drawing_context_free_resources:
+ * @self: The `PsyDrawingContext` instance that needs to free it's resources
+ *
+ * This function should be called when the context should giveup it's resources
+ * for example when the window is unrealized, there should not be any
+ * drawing any more. Also OpenGL needs to be current, in order to function,
+ * these resources may be managed by the window, so the window can tell
+ * when the drawing context can free the resources.
+ */
+void
+psy_drawing_context_free_resources(PsyDrawingContext *self)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (priv->shader_programs) {
+        g_hash_table_destroy(priv->shader_programs);
+        priv->shader_programs = NULL;
+    }
+    if (priv->cache_entries) {
+        g_hash_table_destroy(priv->cache_entries);
+        priv->cache_entries = NULL;
+        g_queue_init(&priv->lru);
+    }
+    if (priv->textures) {
+        g_hash_table_destroy(priv->textures);
+        priv->textures = NULL;
+    }
+    if (priv->vbuffers) {
+        g_hash_table_destroy(priv->vbuffers);
+        priv->vbuffers = NULL;
+    }
+    g_clear_object(&priv->atlas);
+    g_clear_object(&priv->glyph_atlas);
+    priv->texture_bytes = 0;
+    priv->image_bytes   = 0;
+}
+
+/*
+ * Copies small decoded textures into the atlas, so pictures using them can
+ * be drawn in batches. Failing to do so isn't an error, the texture is then
+ * just drawn on its own.
+ */
+static void
+drawing_context_add_to_atlas(PsyDrawingContext *self,
+                             const gchar       *texture_name,
+                             PsyTexture        *texture)
+{
+    GError *error = NULL;
+
+    if (!(psy_texture_is_uploaded(texture)
+          || psy_texture_is_upload_pending(texture))
+        || !psy_texture_get_data(texture)
+        || psy_texture_get_num_channels(texture) != 4
+        || psy_texture_get_width(texture) > ATLAS_MAX_IMAGE_SIZE
+        || psy_texture_get_height(texture) > ATLAS_MAX_IMAGE_SIZE)
+        return;
+
+    PsyTextureAtlas *atlas = psy_drawing_context_get_atlas(self);
+    if (!atlas)
+        return;
+
+    if (!psy_texture_atlas_add_texture(atlas, texture_name, texture, &error)) {
+        g_info("Unable to add %s to the texture atlas: %s",
+               texture_name,
+               error->message);
+        g_error_free(error);
+    }
+}
+
+/**
+ * psy_drawing_context_register_program:
+ * @self: an instance of `PsyDrawingContext`
+ * @name: the name to use to register the program, it should not have been used
+ *        to register a `PsyProgram` before.
+ * @program:(transfer full):The program which you'd like to have registered. To
+ *           make sure the program works with this context, you should use
+ *           `psy_drawing_context_create` to make it.
+ * @error:(out):If an error occurs such as using the same name twice will be
+ *              returned here.
+ *
+ * Register an Shader program with this context. The program is registered
+ * with the drawing context for future use. The context just stores the program,
+ * so you'll have to add the necessary shaders and do compilation steps
+ * yourself.
+ */
+void
+psy_drawing_context_register_program(PsyDrawingContext *self,
+                                     const gchar       *name,
+                                     PsyShaderProgram  *program,
+                                     GError           **error)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(name);
+    g_return_if_fail(PSY_IS_SHADER_PROGRAM(program));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (g_hash_table_lookup(priv->shader_programs, name) != NULL) {
+        g_set_error(error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
+                    "A program with the name %s has already been registered.",
+                    name);
+        return;
+    }
+    g_hash_table_insert(priv->shader_programs, g_strdup(name), program);
+}
+
+/**
+ * psy_drawing_context_register_texture:
+ * @self: An instance of [class@DrawingContext]
+ * @texture_name: The name the texture to use when retrieving the texture.
+ * @texture:(transfer full): The texture to store inside of this context. We
+ *          advise to use a Texture returned by
+ *          psy_drawing_context_create_texture.
+ * @error:(out): Errors might be returned here.
+ *
+ * Register a shader by name for future use. You are free to choose any name
+ * not yet used by this context. Psy-lib might use absolute path names of
+ * images etc.
+ */
+void
+psy_drawing_context_register_texture(PsyDrawingContext *self,
+                                     const gchar       *texture_name,
+                                     PsyTexture        *texture,
+                                     GError           **error)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(texture_name);
+    g_return_if_fail(PSY_IS_TEXTURE(texture));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (g_hash_table_lookup(priv->shader_programs, texture_name) != NULL) {
+        g_set_error(error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
+                    "A texture with the name %s has already been registered.",
+                    texture_name);
+        return;
+    }
+    g_hash_table_insert(priv->textures, g_strdup(texture_name), texture);
+    g_object_ref(texture);
+
+    drawing_context_add_to_atlas(self, texture_name, texture);
+
+    // A texture registered under the same name before is replaced.
+    CacheEntry *entry = g_hash_table_lookup(priv->cache_entries, texture_name);
+    if (entry) {
+        priv->texture_bytes -= entry->texture_bytes;
+        priv->image_bytes -= entry->image_bytes;
+        g_queue_unlink(&priv->lru, &entry->link);
+        g_hash_table_remove(priv->cache_entries, texture_name);
+    }
+
+    entry = cache_entry_new(texture_name, texture);
+    g_hash_table_insert(priv->cache_entries, entry->name, entry);
+    g_queue_push_head_link(&priv->lru, &entry->link);
+    cache_entry_account(priv, entry);
+    drawing_context_enforce_budget(priv, texture);
+}
+
+/**
+ * psy_drawing_context_register_vbuffer:
+ * @self: An instance of [class@DrawingContext]
+ * @name: The name to use when retrieving the vertex buffer.
+ * @vbuffer:(transfer full): The vertex buffer to store inside of this
+ *          context. It should be created with
+ *          [method@DrawingContext.create_vbuffer].
+ * @error:(out): Errors might be returned here.
+ *
+ * Register a vertex buffer by name, so that it can be shared among artists.
+ * This is used for meshes that are drawn instanced, e.g. a unit circle that
+ * is scaled to the radius of each circle. When an error is returned, e.g.
+ * because the resources of @self have been freed, @vbuffer is released.
+ */
+void
+psy_drawing_context_register_vbuffer(PsyDrawingContext *self,
+                                     const gchar       *name,
+                                     PsyVBuffer        *vbuffer,
+                                     GError           **error)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(name);
+    g_return_if_fail(PSY_IS_VBUFFER(vbuffer));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!priv->vbuffers) {
+        g_set_error(error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_FAILED,
+                    "Unable to register vbuffer %s, the resources of the "
+                    "context have been freed.",
+                    name);
+        g_object_unref(vbuffer);
+        return;
+    }
+
+    if (g_hash_table_lookup(priv->vbuffers, name) != NULL) {
+        g_set_error(error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
+                    "A vbuffer with the name %s has already been registered.",
+                    name);
+        g_object_unref(vbuffer);
+        return;
+    }
+    g_hash_table_insert(priv->vbuffers, g_strdup(name), vbuffer);
+}
+
+/**
+ * psy_drawing_context_unregister_vbuffer:
+ * @self: An instance of [class@DrawingContext]
+ * @name: The name used to register the vertex buffer.
+ *
+ * Removes a vertex buffer that was registered with
+ * [method@DrawingContext.register_vbuffer], e.g. when no artist uses it
+ * anymore. It is freed unless someone else holds a reference to it.
+ *
+ * Returns: TRUE when a vertex buffer with @name was registered
+ */
+gboolean
+psy_drawing_context_unregister_vbuffer(PsyDrawingContext *self,
+                                       const gchar       *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!priv->vbuffers)
+        return FALSE;
+
+    return g_hash_table_remove(priv->vbuffers, name);
+}
+
+/**
+ * psy_drawing_context_load_files_as_texture:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @files:(array length=num_files)(transfer none): An array with filenames in
+ *       utf8
+ * @num_files: The number fo files.
+ * @error: Errors may be returned here.
+ *
+ * This functions loads the files, into memory and will decode them. The files
+ * are decoded in parallel by a pool of threads, as soon as a file is decoded,
+ * its upload to the GPU is started asynchronously, see
+ * [method@DrawingContext.ensure_texture_resident] to make sure the upload is
+ * finished before a picture is presented. This function returns when all
+ * files are decoded, see [method@DrawingContext.preload_textures_async] for
+ * a version that doesn't block.
+ * The files should be unique and the will be stored inside of this drawing
+ * context. They will be registered with a full canonical file name, but
+ * The names may be relative. If files would have the same full path name,
+ * the latter might override the first, although, the file presumably will not
+ * change between
+ *
+ * The [signal@DrawingContext::preload-progress] signal is emitted for every
+ * file. When some files fail to load, the others are still loaded and the
+ * first error is returned.
+ */
+void
+psy_drawing_context_load_files_as_texture(PsyDrawingContext *self,
+                                          gchar            **files,
+                                          gsize              num_files,
+                                          GError           **error)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(files);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    GPtrArray  *paths = canonical_unique_paths(files, num_files);
+    PreloadJob *job   = preload_job_new(self, NULL);
+
+    if (preload_job_start(job, paths, &job->error)) {
+        for (guint i = 0; i < job->num_to_load; i++)
+            preload_job_finish_item(job, g_async_queue_pop(job->decoded));
+    }
+
+    if (job->error)
+        g_propagate_error(error, g_steal_pointer(&job->error));
+
+    preload_job_unref(job);
+    g_ptr_array_unref(paths);
+}
+
+/**
+ * psy_drawing_context_preload_textures_async:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @files:(array length=num_files)(transfer none): the image files to load
+ * @num_files: the number of files
+ * @cancellable:(nullable): allows to cancel the preload
+ * @callback: called when all files have been handled
+ * @data: passed to @callback
+ *
+ * Loads the files like [method@DrawingContext.load_files_as_texture], but
+ * returns immediately. The files are decoded in a pool of threads, the
+ * decoded images are uploaded and registered in the thread default main
+ * context of the caller, which should be the thread that draws. Progress is
+ * reported with [signal@DrawingContext::preload-progress]. Call
+ * [method@DrawingContext.preload_textures_finish] from @callback.
+ */
+void
+psy_drawing_context_preload_textures_async(PsyDrawingContext  *self,
+                                           gchar             **files,
+                                           gsize               num_files,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            data)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(files || num_files == 0);
+
+    GError     *error = NULL;
+    GTask      *task  = g_task_new(self, cancellable, callback, data);
+    GPtrArray  *paths = canonical_unique_paths(files, num_files);
+    PreloadJob *job   = preload_job_new(self, cancellable);
+
+    g_task_set_source_tag(task, psy_drawing_context_preload_textures_async);
+
+    if (paths->len == 0) {
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+    }
+    else {
+        job->task         = task;
+        job->main_context = g_main_context_ref_thread_default();
+        if (!preload_job_start(job, paths, &error)) {
+            job->task = NULL;
+            g_task_return_error(task, error);
+            g_object_unref(task);
+        }
+    }
+
+    preload_job_unref(job);
+    g_ptr_array_unref(paths);
+}
+
+/**
+ * psy_drawing_context_preload_manifest_async:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @manifest: the path of a text file with one image file per line
+ * @cancellable:(nullable): allows to cancel the preload
+ * @callback: called when all files have been handled
+ * @data: passed to @callback
+ *
+ * Preloads all images listed in @manifest, see
+ * [method@DrawingContext.preload_textures_async]. Empty lines and lines that
+ * start with a '#' are skipped. Relative paths are relative to the directory
+ * of @manifest. Call [method@DrawingContext.preload_textures_finish] from
+ * @callback.
+ */
+void
+psy_drawing_context_preload_manifest_async(PsyDrawingContext  *self,
+                                           const gchar        *manifest,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            data)
+{
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(manifest);
+
+    GError *error    = NULL;
+    gchar  *contents = NULL;
+
+    if (!g_file_get_contents(manifest, &contents, NULL, &error)) {
+        g_task_report_error(self,
+                            callback,
+                            data,
+                            psy_drawing_context_preload_textures_async,
+                            error);
+        return;
+    }
+
+    gchar    **lines = g_strsplit(contents, "\n", -1);
+    gchar     *dir   = g_path_get_dirname(manifest);
+    GPtrArray *files = g_ptr_array_new_with_free_func(g_free);
+
+    for (gchar **line = lines; *line; line++) {
+        gchar *name = g_strstrip(*line);
+        if (name[0] == '\0' || name[0] == '#')
+            continue;
+        if (g_path_is_absolute(name))
+            g_ptr_array_add(files, g_strdup(name));
+        else
+            g_ptr_array_add(files, g_build_filename(dir, name, NULL));
+    }
+
+    psy_drawing_context_preload_textures_async(self,
+                                               (gchar **) files->pdata,
+                                               files->len,
+                                               cancellable,
+                                               callback,
+                                               data);
+
+    g_ptr_array_unref(files);
+    g_free(dir);
+    g_strfreev(lines);
+    g_free(contents);
+}
+
+/**
+ * psy_drawing_context_preload_textures_finish:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @result: the result passed to the callback
+ * @error: the first error that occurred may be returned here
+ *
+ * Finishes [method@DrawingContext.preload_textures_async] or
+ * [method@DrawingContext.preload_manifest_async]. The files that did load
+ * are registered, even when an error is returned.
+ *
+ * Returns: TRUE when all files have been loaded, FALSE otherwise.
+ */
+gboolean
+psy_drawing_context_preload_textures_finish(PsyDrawingContext *self,
+                                            GAsyncResult      *result,
+                                            GError           **error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/**
+ * psy_drawing_context_get_program:
+ * @self: an instance of `PsyDrawingContext`
+ * @name: the name used to register the Program
+ *
+ * Obtain a PsyShaderProgram that was previously registered.
+ *
+ * Returns:(transfer none): an Instance of [class@PsyShaderProgram] or NULL
+ */
+PsyShaderProgram *
+psy_drawing_context_get_program(PsyDrawingContext *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
+    g_return_val_if_fail(name, NULL);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    return g_hash_table_lookup(priv->shader_programs, name);
+}
+
+/**
+ * psy_drawing_context_get_texture:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @name: the name used to register the Program
+ *
+ * Obtain a PsyTexture that was previously registered. This marks the
+ * texture as recently used. When the texture has been evicted from the cache,
+ * it is decoded again if necessary and its upload is started.
+ *
+ * Returns:(transfer none): an Instance of [class@PsyTexture] or NULL
  */
+PsyTexture *
+psy_drawing_context_get_texture(PsyDrawingContext *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
+    g_return_val_if_fail(name, NULL);
 
-// clang-format off
-G_DEFINE_QUARK(psy-drawing-context-error-quark,
-               psy_drawing_context_error)
-// clang-format on
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!priv->cache_entries)
+        return NULL;
+
+    CacheEntry *entry = g_hash_table_lookup(priv->cache_entries, name);
+    if (!entry)
+        return NULL;
+
+    drawing_context_cache_touch(priv, entry);
+    return entry->texture;
+}
 
 /**
- * PSY_UNIFORM_COLOR_PROGRAM_NAME:
+ * psy_drawing_context_lookup_texture:(skip)
+ * @self: an instance of [class@PsyDrawingContext]
+ * @name: the name used to register the texture
  *
- * The name for a string constant used to register a shader program that
- * draws using a uniform color.
+ * Obtain a registered texture without side effects. Unlike
+ * [method@DrawingContext.get_texture] it doesn't mark the texture as used,
+ * doesn't count towards the cache statistics and doesn't restore an evicted
+ * texture. This is meant for queries, such as whether a picture is
+ * translucent.
+ *
+ * Stability: private
+ *
+ * Returns:(transfer none)(nullable): the texture registered as @name
  */
-const gchar *PSY_UNIFORM_COLOR_PROGRAM_NAME = "uniform-color-program";
+PsyTexture *
+psy_drawing_context_lookup_texture(PsyDrawingContext *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
+    g_return_val_if_fail(name, NULL);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    if (!priv->textures)
+        return NULL;
+
+    return g_hash_table_lookup(priv->textures, name);
+}
 
 /**
- * PSY_PICTURE_PROGRAM_NAME:
+ * psy_drawing_context_pin_texture:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @name: the name used to register the texture
  *
- * The name for a string constant used to register a shader program that
- * is able to draw a picture/texture.
+ * Pin a registered texture, pinned textures are never evicted from the cache.
+ * The texture is marked as recently used and restored when it had been
+ * evicted. Pins are counted, every pin should be released with
+ * [method@DrawingContext.unpin_texture]. A texture that is registered again
+ * under the same name is no longer pinned.
+ *
+ * Returns: TRUE when the texture was pinned, FALSE when no texture has been
+ *          registered with @name
  */
-const gchar *PSY_PICTURE_PROGRAM_NAME = "picture-program";
+gboolean
+psy_drawing_context_pin_texture(PsyDrawingContext *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
 
-typedef struct TextureAsyncLoad {
-    GCancellable *cancelable;
-    gsize         num_to_load;
-    gsize         num_loaded;
-} TextureAsyncLoad;
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
 
-typedef struct _PsyDrawingContextPrivate {
-    GHashTable      *shader_programs;
-    GHashTable      *textures;
-    TextureAsyncLoad tload_info;
-} PsyDrawingContextPrivate;
+    if (!priv->cache_entries)
+        return FALSE;
 
-G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyDrawingContext,
-                                    psy_drawing_context,
-                                    G_TYPE_OBJECT)
+    CacheEntry *entry = g_hash_table_lookup(priv->cache_entries, name);
+    if (!entry)
+        return FALSE;
 
-typedef enum { PROP_NULL, NUM_PROPERTIES } PsyDrawingContextProperty;
+    entry->num_pins++;
+    drawing_context_cache_touch(priv, entry);
+    return TRUE;
+}
 
-/*
- * static GParamSpec* drawing_context_properties[NUM_PROPERTIES];
+/**
+ * psy_drawing_context_unpin_texture:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @name: the name used to register the texture
+ *
+ * Release a pin obtained with [method@DrawingContext.pin_texture]. When
+ * the last pin is released, the texture may be evicted again and the budgets
+ * are enforced immediately.
  */
-
-static void
-psy_drawing_context_init(PsyDrawingContext *self)
+void
+psy_drawing_context_unpin_texture(PsyDrawingContext *self, const gchar *name)
 {
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+    g_return_if_fail(name);
+
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
-    priv->shader_programs = g_hash_table_new_full(
-        g_str_hash, g_str_equal, g_free, g_object_unref);
-    priv->textures = g_hash_table_new_full(
-        g_str_hash, g_str_equal, g_free, g_object_unref);
-}
 
-static void
-psy_drawing_context_dispose(GObject *object)
-{
-    PsyDrawingContext *self = PSY_DRAWING_CONTEXT(object);
+    if (!priv->cache_entries)
+        return;
 
-    // frees priv->shader_programs and priv->textures
-    psy_drawing_context_free_resources(self);
+    CacheEntry *entry = g_hash_table_lookup(priv->cache_entries, name);
+    g_return_if_fail(entry && entry->num_pins > 0);
 
-    G_OBJECT_CLASS(psy_drawing_context_parent_class)->dispose(object);
+    entry->num_pins--;
+    if (entry->num_pins == 0)
+        drawing_context_enforce_budget(priv, NULL);
 }
 
-static void
-psy_drawing_context_finalize(GObject *object)
+/**
+ * psy_drawing_context_set_texture_budget:
+ * @self: an instance of [class@DrawingContext]
+ * @num_bytes: the budget in bytes, 0 means unlimited
+ *
+ * Set the [property@DrawingContext:texture-budget], textures are evicted
+ * immediately when the current use exceeds the new budget.
+ */
+void
+psy_drawing_context_set_texture_budget(PsyDrawingContext *self,
+                                       guint64            num_bytes)
 {
-    PsyDrawingContext        *self = PSY_DRAWING_CONTEXT(object);
+    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
-    (void) priv;
 
-    G_OBJECT_CLASS(psy_drawing_context_parent_class)->finalize(object);
+    priv->texture_budget = num_bytes;
+    drawing_context_enforce_budget(priv, NULL);
 }
 
-static void
-psy_drawing_context_class_init(PsyDrawingContextClass *class)
+/**
+ * psy_drawing_context_get_texture_budget:
+ * @self: an instance of [class@DrawingContext]
+ *
+ * Returns: the [property@DrawingContext:texture-budget] in bytes
+ */
+guint64
+psy_drawing_context_get_texture_budget(PsyDrawingContext *self)
 {
-    GObjectClass *gobject_class = G_OBJECT_CLASS(class);
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), 0);
 
-    gobject_class->finalize = psy_drawing_context_finalize;
-    gobject_class->dispose  = psy_drawing_context_dispose;
-}
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
 
-/* ************ public functions ******************** */
+    return priv->texture_budget;
+}
 
 /**
- * psy_drawing_context_free_resources:
- * @self: The `PsyDrawingContext` instance that needs to free it's resources
+ * psy_drawing_context_set_image_budget:
+ * @self: an instance of [class@DrawingContext]
+ * @num_bytes: the budget in bytes, 0 means unlimited
  *
- * This function should be called when the context should giveup it's resources
- * for example when the window is unrealized, there should not be any
- * drawing any more. Also OpenGL needs to be current, in order to function,
- * these resources may be managed by the window, so the window can tell
- * when the drawing context can free the resources.
+ * Set the [property@DrawingContext:image-budget], decoded images are freed
+ * immediately when the current use exceeds the new budget.
  */
 void
-psy_drawing_context_free_resources(PsyDrawingContext *self)
+psy_drawing_context_set_image_budget(PsyDrawingContext *self,
+                                     guint64            num_bytes)
 {
     g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
+
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
 
-    if (priv->shader_programs) {
-        g_hash_table_destroy(priv->shader_programs);
-        priv->shader_programs = NULL;
-    }
-    if (priv->textures) {
-        g_hash_table_destroy(priv->textures);
-        priv->textures = NULL;
-    }
+    priv->image_budget = num_bytes;
+    drawing_context_enforce_budget(priv, NULL);
 }
 
 /**
- * psy_drawing_context_register_program:
- * @self: an instance of `PsyDrawingContext`
- * @name: the name to use to register the program, it should not have been used
- *        to register a `PsyProgram` before.
- * @program:(transfer full):The program which you'd like to have registered. To
- *           make sure the program works with this context, you should use
- *           `psy_drawing_context_create` to make it.
- * @error:(out):If an error occurs such as using the same name twice will be
- *              returned here.
+ * psy_drawing_context_get_image_budget:
+ * @self: an instance of [class@DrawingContext]
  *
- * Register an Shader program with this context. The program is registered
- * with the drawing context for future use. The context just stores the program,
- * so you'll have to add the necessary shaders and do compilation steps
- * yourself.
+ * Returns: the [property@DrawingContext:image-budget] in bytes
+ */
+guint64
+psy_drawing_context_get_image_budget(PsyDrawingContext *self)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), 0);
+
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
+
+    return priv->image_budget;
+}
+
+/**
+ * psy_drawing_context_get_cache_stats:
+ * @self: an instance of [class@DrawingContext]
+ * @num_hits:(out)(optional): the number of times a texture was obtained that
+ *           was resident
+ * @num_misses:(out)(optional): the number of times a texture was obtained
+ *             that had to be restored
+ * @num_evictions:(out)(optional): the number of times a texture was evicted
+ * @texture_bytes:(out)(optional): the bytes the textures, including their
+ *                mipmaps, and the atlases currently occupy on the graphics
+ *                hardware
+ * @image_bytes:(out)(optional): the bytes the decoded images currently
+ *              occupy in main memory
+ *
+ * Obtain statistics of the texture cache, these help to choose the budgets
+ * for an experiment. The counters may be cleared with
+ * [method@DrawingContext.reset_cache_stats].
  */
 void
-psy_drawing_context_register_program(PsyDrawingContext *self,
-                                     const gchar       *name,
-                                     PsyShaderProgram  *program,
-                                     GError           **error)
+psy_drawing_context_get_cache_stats(PsyDrawingContext *self,
+                                    guint64           *num_hits,
+                                    guint64           *num_misses,
+                                    guint64           *num_evictions,
+                                    guint64           *texture_bytes,
+                                    guint64           *image_bytes)
 {
     g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
-    g_return_if_fail(name);
-    g_return_if_fail(PSY_IS_SHADER_PROGRAM(program));
-    g_return_if_fail(error == NULL || *error == NULL);
 
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
 
-    if (g_hash_table_lookup(priv->shader_programs, name) != NULL) {
-        g_set_error(error,
-                    PSY_DRAWING_CONTEXT_ERROR,
-                    PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
-                    "A program with the name %s has already been registered.",
-                    name);
-        return;
-    }
-    g_hash_table_insert(priv->shader_programs, g_strdup(name), program);
+    if (num_hits)
+        *num_hits = priv->num_hits;
+    if (num_misses)
+        *num_misses = priv->num_misses;
+    if (num_evictions)
+        *num_evictions = priv->num_evictions;
+    if (texture_bytes)
+        *texture_bytes = priv->texture_bytes;
+    if (image_bytes)
+        *image_bytes = priv->image_bytes;
 }
 
 /**
- * psy_drawing_context_register_texture:
- * @self: An instance of [class@DrawingContext]
- * @texture_name: The name the texture to use when retrieving the texture.
- * @texture:(transfer full): The texture to store inside of this context. We
- *          advise to use a Texture returned by
- *          psy_drawing_context_create_texture.
- * @error:(out): Errors might be returned here.
+ * psy_drawing_context_reset_cache_stats:
+ * @self: an instance of [class@DrawingContext]
  *
- * Register a shader by name for future use. You are free to choose any name
- * not yet used by this context. Psy-lib might use absolute path names of
- * images etc.
+ * Clears the hit, miss and eviction counters of the texture cache.
  */
 void
-psy_drawing_context_register_texture(PsyDrawingContext *self,
-                                     const gchar       *texture_name,
-                                     PsyTexture        *texture,
-                                     GError           **error)
+psy_drawing_context_reset_cache_stats(PsyDrawingContext *self)
 {
     g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
-    g_return_if_fail(texture_name);
-    g_return_if_fail(PSY_IS_TEXTURE(texture));
-    g_return_if_fail(error == NULL || *error == NULL);
 
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
 
-    if (g_hash_table_lookup(priv->shader_programs, texture_name) != NULL) {
-        g_set_error(error,
-                    PSY_DRAWING_CONTEXT_ERROR,
-                    PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
-                    "A texture with the name %s has already been registered.",
-                    texture_name);
-        return;
-    }
-    g_hash_table_insert(priv->textures, g_strdup(texture_name), texture);
-    g_object_ref(texture);
+    priv->num_hits      = 0;
+    priv->num_misses    = 0;
+    priv->num_evictions = 0;
 }
 
 /**
- * psy_drawing_context_load_files_as_texture:
+ * psy_drawing_context_ensure_texture_resident:
  * @self: an instance of [class@PsyDrawingContext]
- * @files:(array length=num_files)(transfer none): An array with filenames in
- *       utf8
- * @num_files: The number fo files.
- * @error: Errors may be returned here.
+ * @name: the name used to register the texture
+ * @deadline:(nullable): the time at which the texture should be resident,
+ *           NULL waits as long as it takes
+ * @error: errors may be returned here
  *
- * This functions loads the files, into memory and will decode them.
- * TODO, also upload the files to GPU if possible.
- * The files should be unique and the will be stored inside of this drawing
- * context. They will be registered with a full canonical file name, but
- * The names may be relative. If files would have the same full path name,
- * the latter might override the first, although, the file presumably will not
- * change between
+ * Makes sure a registered texture is available to the graphics hardware by
+ * @deadline, see [method@Texture.ensure_resident]. Call this e.g. in the
+ * interval between two trials for the pictures of the next trial, so that
+ * the first frame of a picture doesn't have to wait for its upload.
  *
- * When this is done, the texture-uploaded signal will be emitted.
+ * Returns: TRUE if the texture is resident, FALSE otherwise
  */
-void
-psy_drawing_context_load_files_as_texture(PsyDrawingContext *self,
-                                          gchar            **files,
-                                          gsize              num_files,
-                                          GError           **error)
+gboolean
+psy_drawing_context_ensure_texture_resident(PsyDrawingContext *self,
+                                            const gchar       *name,
+                                            PsyTimePoint      *deadline,
+                                            GError           **error)
 {
-    g_return_if_fail(PSY_IS_DRAWING_CONTEXT(self));
-    g_return_if_fail(files);
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-    GHashTable *uniques
-        = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-
-    for (gsize i = 0; i < num_files; i++) {
-        GFile *file      = g_file_new_for_path(files[i]);
-        char  *canonical = g_file_get_path(file);
-        if (canonical)
-            g_hash_table_insert(uniques, canonical, NULL);
-        else
-            g_warning("Unable to get canonical path for %s", files[i]);
-        g_object_unref(file);
+    PsyTexture *texture = psy_drawing_context_get_texture(self, name);
+    if (!texture) {
+        g_set_error(error,
+                    PSY_DRAWING_CONTEXT_ERROR,
+                    PSY_DRAWING_CONTEXT_ERROR_NAME_NOT_FOUND,
+                    "No texture with the name %s has been registered.",
+                    name);
+        return FALSE;
     }
 
-    GHashTableIter iter;
-    gpointer       key;
-    g_hash_table_iter_init(&iter, uniques);
+    return psy_texture_ensure_resident(texture, deadline, error);
+}
 
-    while (g_hash_table_iter_next(&iter, &key, NULL)) {
-        gchar      *path    = key;
-        PsyTexture *texture = psy_drawing_context_create_texture(self);
-        psy_texture_set_num_channels(texture, 4);
+/**
+ * psy_drawing_context_get_vbuffer:
+ * @self: an instance of [class@PsyDrawingContext]
+ * @name: the name used to register the vertex buffer
+ *
+ * Obtain a PsyVBuffer that was previously registered.
+ *
+ * Returns:(transfer none): an Instance of [class@PsyVBuffer] or NULL
+ */
+PsyVBuffer *
+psy_drawing_context_get_vbuffer(PsyDrawingContext *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
+    g_return_val_if_fail(name, NULL);
 
-        psy_texture_set_path(texture, path);
-        psy_texture_upload(texture, error);
+    PsyDrawingContextPrivate *priv
+        = psy_drawing_context_get_instance_private(self);
 
-        if (error && *error) {
-            g_object_unref(texture);
-            continue;
-        }
+    if (!priv->vbuffers)
+        return NULL;
 
-        psy_drawing_context_register_texture(self, path, texture, error);
-        g_object_unref(texture);
-    }
-    g_hash_table_destroy(uniques);
+    return g_hash_table_lookup(priv->vbuffers, name);
 }
 
 /**
- * psy_drawing_context_get_program:
- * @self: an instance of `PsyDrawingContext`
- * @name: the name used to register the Program
+ * psy_drawing_context_get_atlas:
+ * @self: an instance of [class@PsyDrawingContext]
  *
- * Obtain a PsyShaderProgram that was previously registered.
+ * Obtain the texture atlas of this context, it is created the first time it is
+ * needed. Small textures that are registered with
+ * [method@DrawingContext.register_texture] are copied into the atlas under
+ * the same name, so artists may draw them in batches by looking them up in
+ * the atlas.
  *
- * Returns:(transfer none): an Instance of [class@PsyShaderProgram] or NULL
+ * Returns:(transfer none)(nullable): the [class@TextureAtlas] of this context
  */
-PsyShaderProgram *
-psy_drawing_context_get_program(PsyDrawingContext *self, const gchar *name)
+PsyTextureAtlas *
+psy_drawing_context_get_atlas(PsyDrawingContext *self)
 {
     g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
-    g_return_val_if_fail(name, NULL);
 
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
 
-    return g_hash_table_lookup(priv->shader_programs, name);
+    if (!priv->atlas && priv->textures) {
+        PsyTexture *texture = psy_drawing_context_create_texture(self);
+        priv->atlas = psy_texture_atlas_new(texture, ATLAS_SIZE, ATLAS_SIZE);
+        g_object_unref(texture);
+        drawing_context_account_atlas(priv, priv->atlas);
+        drawing_context_enforce_budget(priv, NULL);
+    }
+
+    return priv->atlas;
 }
 
 /**
- * psy_drawing_context_get_texture:
+ * psy_drawing_context_get_glyph_atlas:
  * @self: an instance of [class@PsyDrawingContext]
- * @name: the name used to register the Program
  *
- * Obtain a PsyTexture that was previously registered.
+ * Obtain the atlas in which the glyphs of text stimuli are cached, it is
+ * created the first time it is needed. Each glyph is rasterized once, after
+ * which text is drawn as a quad per glyph. The glyphs that haven't been used
+ * for the longest time are evicted when the atlas is full.
  *
- * Returns:(transfer none): an Instance of [class@PsyTexture] or NULL
+ * Returns:(transfer none)(nullable): the glyph atlas of this context, or NULL
+ *          when the resources of the context have been freed.
  */
-PsyTexture *
-psy_drawing_context_get_texture(PsyDrawingContext *self, const gchar *name)
+PsyTextureAtlas *
+psy_drawing_context_get_glyph_atlas(PsyDrawingContext *self)
 {
     g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
-    g_return_val_if_fail(name, NULL);
 
     PsyDrawingContextPrivate *priv
         = psy_drawing_context_get_instance_private(self);
 
-    return g_hash_table_lookup(priv->textures, name);
+    if (!priv->glyph_atlas && priv->textures) {
+        PsyTexture *texture = psy_drawing_context_create_texture(self);
+        priv->glyph_atlas   = psy_texture_atlas_new(
+            texture, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
+        g_object_unref(texture);
+        drawing_context_account_atlas(priv, priv->glyph_atlas);
+        drawing_context_enforce_budget(priv, NULL);
+    }
+
+    return priv->glyph_atlas;
 }
 
 /**
@@ -409,3 +1661,25 @@ psy_drawing_context_create_vbuffer(PsyDrawingContext *self)
     g_return_val_if_fail(cls->create_vbuffer, NULL);
     return cls->create_vbuffer(self);
 }
+
+/**
+ * psy_drawing_context_create_gpu_timer:
+ * @self: An instance of `PsyDrawingContext`
+ *
+ * Creates a timer that measures the time the GPU spends drawing, the
+ * drawing backend should be current.
+ *
+ * Returns:(transfer full)(nullable): A `PsyGpuTimer` suitable for use with
+ *          this context, or NULL when the backend is unable to measure the
+ *          GPU.
+ */
+PsyGpuTimer *
+psy_drawing_context_create_gpu_timer(PsyDrawingContext *self)
+{
+    g_return_val_if_fail(PSY_IS_DRAWING_CONTEXT(self), NULL);
+    PsyDrawingContextClass *cls = PSY_DRAWING_CONTEXT_GET_CLASS(self);
+
+    if (!cls->create_gpu_timer)
+        return NULL;
+    return cls->create_gpu_timer(self);
+}
@@ -3,8 +3,10 @@
 
 #include <gio/gio.h>
 
+#include <psy-gpu-timer.h>
 #include <psy-matrix4.h>
 #include <psy-shader-program.h>
+#include <psy-texture-atlas.h>
 #include <psy-texture.h>
 #include <psy-vbuffer.h>
 
@@ -27,8 +29,9 @@ typedef struct _PsyDrawingContextClass {
     PsyShader *(*create_fragment_shader)(PsyDrawingContext *self);
     PsyTexture *(*create_texture)(PsyDrawingContext *self);
     PsyVBuffer *(*create_vbuffer)(PsyDrawingContext *self);
+    PsyGpuTimer *(*create_gpu_timer)(PsyDrawingContext *self);
 
-    gpointer extensions[16];
+    gpointer extensions[15];
 
 } PsyDrawingContextClass;
 
@@ -50,6 +53,9 @@ psy_drawing_context_create_texture(PsyDrawingContext *self);
 G_MODULE_EXPORT PsyVBuffer *
 psy_drawing_context_create_vbuffer(PsyDrawingContext *self);
 
+G_MODULE_EXPORT PsyGpuTimer *
+psy_drawing_context_create_gpu_timer(PsyDrawingContext *self);
+
 G_MODULE_EXPORT void
 psy_drawing_context_register_program(PsyDrawingContext *self,
                                      const gchar       *name,
@@ -62,20 +68,100 @@ psy_drawing_context_register_texture(PsyDrawingContext *self,
                                      PsyTexture        *texture,
                                      GError           **error);
 
+G_MODULE_EXPORT void
+psy_drawing_context_register_vbuffer(PsyDrawingContext *self,
+                                     const gchar       *name,
+                                     PsyVBuffer        *vbuffer,
+                                     GError           **error);
+
+G_MODULE_EXPORT gboolean
+psy_drawing_context_unregister_vbuffer(PsyDrawingContext *self,
+                                       const gchar       *name);
+
 G_MODULE_EXPORT void
 psy_drawing_context_load_files_as_texture(PsyDrawingContext *self,
                                           gchar            **files,
                                           gsize              num_files,
                                           GError           **error);
 
+G_MODULE_EXPORT void
+psy_drawing_context_preload_textures_async(PsyDrawingContext  *self,
+                                           gchar             **files,
+                                           gsize               num_files,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            data);
+
+G_MODULE_EXPORT void
+psy_drawing_context_preload_manifest_async(PsyDrawingContext  *self,
+                                           const gchar        *manifest,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            data);
+
+G_MODULE_EXPORT gboolean
+psy_drawing_context_preload_textures_finish(PsyDrawingContext *self,
+                                            GAsyncResult      *result,
+                                            GError           **error);
+
 G_MODULE_EXPORT PsyShaderProgram *
 psy_drawing_context_get_program(PsyDrawingContext *self, const gchar *name);
 
 G_MODULE_EXPORT PsyTexture *
 psy_drawing_context_get_texture(PsyDrawingContext *self, const gchar *name);
 
+G_MODULE_EXPORT gboolean
+psy_drawing_context_pin_texture(PsyDrawingContext *self, const gchar *name);
+
+G_MODULE_EXPORT void
+psy_drawing_context_unpin_texture(PsyDrawingContext *self, const gchar *name);
+
+G_MODULE_EXPORT void
+psy_drawing_context_set_texture_budget(PsyDrawingContext *self,
+                                       guint64            num_bytes);
+
+G_MODULE_EXPORT guint64
+psy_drawing_context_get_texture_budget(PsyDrawingContext *self);
+
+G_MODULE_EXPORT void
+psy_drawing_context_set_image_budget(PsyDrawingContext *self,
+                                     guint64            num_bytes);
+
+G_MODULE_EXPORT guint64
+psy_drawing_context_get_image_budget(PsyDrawingContext *self);
+
+G_MODULE_EXPORT void
+psy_drawing_context_get_cache_stats(PsyDrawingContext *self,
+                                    guint64           *num_hits,
+                                    guint64           *num_misses,
+                                    guint64           *num_evictions,
+                                    guint64           *texture_bytes,
+                                    guint64           *image_bytes);
+
+G_MODULE_EXPORT void
+psy_drawing_context_reset_cache_stats(PsyDrawingContext *self);
+
+G_MODULE_EXPORT PsyVBuffer *
+psy_drawing_context_get_vbuffer(PsyDrawingContext *self, const gchar *name);
+
+G_MODULE_EXPORT gboolean
+psy_drawing_context_ensure_texture_resident(PsyDrawingContext *self,
+                                            const gchar       *name,
+                                            PsyTimePoint      *deadline,
+                                            GError           **error);
+
+G_MODULE_EXPORT PsyTextureAtlas *
+psy_drawing_context_get_atlas(PsyDrawingContext *self);
+
+G_MODULE_EXPORT PsyTextureAtlas *
+psy_drawing_context_get_glyph_atlas(PsyDrawingContext *self);
+
 G_MODULE_EXPORT extern const gchar *PSY_UNIFORM_COLOR_PROGRAM_NAME;
 G_MODULE_EXPORT extern const gchar *PSY_PICTURE_PROGRAM_NAME;
+G_MODULE_EXPORT extern const gchar *PSY_INSTANCED_COLOR_PROGRAM_NAME;
+G_MODULE_EXPORT extern const gchar *PSY_SDF_PROGRAM_NAME;
+G_MODULE_EXPORT extern const gchar *PSY_INSTANCED_PICTURE_PROGRAM_NAME;
+G_MODULE_EXPORT extern const gchar *PSY_INSTANCED_GLYPH_PROGRAM_NAME;
 
 G_END_DECLS
 
@@ -110,6 +110,22 @@ typedef enum {
     = PSY_AUDIO_CHANNEL_STRATEGY_DUPLICATE_INPUTS
 } PsyAudioChannelStrategy;
 
+/**
+ * PsyClockSource:
+ * @PSY_CLOCK_SOURCE_MONOTONIC: The time is read from the monotonic clock of
+ *     the OS via g_get_monotonic_time().
+ * @PSY_CLOCK_SOURCE_TSC: The time is read from the time stamp counter of the
+ *     CPU, which is calibrated against the monotonic clock of the OS. This
+ *     is only available on x86 CPUs with an invariant TSC.
+ *
+ * The source from which [class@Clock] obtains the current time. Both sources
+ * run on the same timebase.
+ */
+typedef enum {
+    PSY_CLOCK_SOURCE_MONOTONIC,
+    PSY_CLOCK_SOURCE_TSC,
+} PsyClockSource;
+
 /**
  * PsyDrawingContextError:
  * @PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS: A resouce with that name has
@@ -118,6 +134,8 @@ typedef enum {
  *      in progress
  * @PSY_DRAWING_CONTEXT_ERROR_NAME_FAILED: Some less specified error regarding
  *      the context occured.
+ * @PSY_DRAWING_CONTEXT_ERROR_NAME_NOT_FOUND: No resource with that name has
+ *      been registered.
  *
  * These errors may be the result of invalid operations on an instance
  * of `PsyDrawingContext`
@@ -125,7 +143,8 @@ typedef enum {
 typedef enum {
     PSY_DRAWING_CONTEXT_ERROR_NAME_EXISTS,
     PSY_DRAWING_CONTEXT_ERROR_BUSY,
-    PSY_DRAWING_CONTEXT_ERROR_FAILED
+    PSY_DRAWING_CONTEXT_ERROR_FAILED,
+    PSY_DRAWING_CONTEXT_ERROR_NAME_NOT_FOUND
 } PsyDrawingContextError;
 
 /**
@@ -273,6 +292,39 @@ typedef enum {
     PSY_PARALLEL_TRIGGER_ERROR_FAILED,
 } PsyParallelTriggerError;
 
+/**
+ * PsyResponseBoxError:
+ * @PSY_RESPONSE_BOX_ERROR_PORT: The port isn't open or isn't configured
+ *     as input.
+ * @PSY_RESPONSE_BOX_ERROR_RUNNING: The response box is already sampling
+ *     the port.
+ * @PSY_RESPONSE_BOX_ERROR_FAILED: Operation failed (check error message?).
+ *
+ * Errors that may occur while starting a `PsyResponseBox`.
+ */
+typedef enum {
+    PSY_RESPONSE_BOX_ERROR_PORT,
+    PSY_RESPONSE_BOX_ERROR_RUNNING,
+    PSY_RESPONSE_BOX_ERROR_FAILED,
+} PsyResponseBoxError;
+
+/**
+ * PsySerialPortError:
+ * @PSY_SERIAL_PORT_ERROR_OPEN: Unable to open or configure the device
+ * @PSY_SERIAL_PORT_ERROR_DEV_CLOSED: Unable to perform action on a device
+ *     that isn't open yet.
+ * @PSY_SERIAL_PORT_ERROR_BAUD_RATE: The requested baud rate isn't supported
+ * @PSY_SERIAL_PORT_ERROR_FAILED: Operation failed (check error message?).
+ *
+ * Errors that may occur while operating a `PsySerialPort`.
+ */
+typedef enum {
+    PSY_SERIAL_PORT_ERROR_OPEN,
+    PSY_SERIAL_PORT_ERROR_DEV_CLOSED,
+    PSY_SERIAL_PORT_ERROR_BAUD_RATE,
+    PSY_SERIAL_PORT_ERROR_FAILED,
+} PsySerialPortError;
+
 /**
  * PsyStepError:
  * @PSY_STEP_ERROR_NO_SUCH_LOOP: An error returned when the traversing the step
@@ -306,12 +358,30 @@ typedef enum {
  * @PSY_TEXTURE_ERROR_DECODE:Error occured because we were not able to decode
  * the image.
  * @PSY_TEXTURE_ERROR_FAILED:Another error regarding the texture occurred.
+ * @PSY_TEXTURE_ERROR_ATLAS_FULL:An image doesn't fit in a texture atlas, not
+ * even after evicting the other images.
  */
 typedef enum {
     PSY_TEXTURE_ERROR_DECODE, // failed to decode the texture.
-    PSY_TEXTURE_ERROR_FAILED
+    PSY_TEXTURE_ERROR_FAILED,
+    PSY_TEXTURE_ERROR_ATLAS_FULL
 } PsyTextureError;
 
+/**
+ * PsyVideoExporterError:
+ * @PSY_VIDEO_EXPORTER_ERROR_PIPELINE:The GStreamer pipeline couldn't be
+ * created or it reported an error while encoding.
+ * @PSY_VIDEO_EXPORTER_ERROR_FORMAT:A frame doesn't match the size or format
+ * of the video.
+ * @PSY_VIDEO_EXPORTER_ERROR_STATE:The exporter isn't open, or it is open
+ * already.
+ */
+typedef enum {
+    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+    PSY_VIDEO_EXPORTER_ERROR_FORMAT,
+    PSY_VIDEO_EXPORTER_ERROR_STATE
+} PsyVideoExporterError;
+
 /**
  * PsyWindowProjectionStyle:
  * @PSY_CANVAS_PROJECTION_STYLE_C: The origin is in the upper left corner of the
@@ -0,0 +1,585 @@
+
+#include <string.h>
+
+#include "psy-clock.h"
+#include "psy-frame-stats.h"
+
+/**
+ * PsyFrameStats:
+ *
+ * PsyFrameStats collects where the time of the frames of a [class@Canvas]
+ * goes. A frame is divided into named sections, such as clearing the canvas
+ * and drawing each stimulus. For every section, the time spent by the CPU is
+ * measured with the monotonic clock, and when the drawing backend supports it,
+ * the time the GPU spends on it is measured with a [class@GpuTimer]. The
+ * durations are aggregated per name, the stimuli are aggregated per type.
+ *
+ * The GPU durations of a frame become available a few frames later, so they
+ * lag behind the CPU durations. Optionally, every section is stored as an
+ * event that may be saved in the Trace Event Format, which can be inspected
+ * with e.g. chrome://tracing or https://ui.perfetto.dev. Since every event
+ * is kept in memory, only enable the trace for the frames of interest.
+ *
+ * Use [method@Canvas.set_instrument] in order to have the canvas fill in
+ * its PsyFrameStats.
+ */
+
+typedef struct FrameSection {
+    const gchar *name; // interned
+    gint64       cpu_start, cpu_end;
+    guint        gpu_start, gpu_end;
+} FrameSection;
+
+typedef struct PendingFrame {
+    GArray *sections;       // FrameSection
+    gint64  gpu_origin_cpu; // the CPU time of the first GPU timestamp
+} PendingFrame;
+
+typedef struct SectionStats {
+    guint64 num_samples;
+    gint64  cpu_total_ns, cpu_max_ns;
+    guint64 num_gpu_samples;
+    guint64 gpu_total_ns, gpu_max_ns;
+} SectionStats;
+
+typedef struct TraceEvent {
+    const gchar *name; // interned
+    gint64       start_ns;
+    gint64       dur_ns;
+    gboolean     gpu;
+} TraceEvent;
+
+typedef struct _PsyFrameStats {
+    GObject      parent;
+    PendingFrame frames[PSY_GPU_TIMER_NUM_FRAMES];
+    guint        frame;   // the index of the current frame in frames
+    gboolean     started; // whether a frame has begun
+    PsyGpuTimer *timer;   // the timer of the pending frames
+    GHashTable  *sections;
+    guint64      num_frames;
+    gboolean     trace_enabled;
+    GArray      *trace; // TraceEvent
+} PsyFrameStats;
+
+G_DEFINE_FINAL_TYPE(PsyFrameStats, psy_frame_stats, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_NUM_FRAMES,
+    PROP_TRACE_ENABLED,
+    NUM_PROPERTIES
+} PsyFrameStatsProperty;
+
+static GParamSpec *frame_stats_properties[NUM_PROPERTIES];
+
+static void
+psy_frame_stats_set_property(GObject      *object,
+                             guint         prop_id,
+                             const GValue *value,
+                             GParamSpec   *pspec)
+{
+    PsyFrameStats *self = PSY_FRAME_STATS(object);
+
+    switch ((PsyFrameStatsProperty) prop_id) {
+    case PROP_TRACE_ENABLED:
+        psy_frame_stats_set_trace_enabled(self, g_value_get_boolean(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_frame_stats_get_property(GObject    *object,
+                             guint       prop_id,
+                             GValue     *value,
+                             GParamSpec *pspec)
+{
+    PsyFrameStats *self = PSY_FRAME_STATS(object);
+
+    switch ((PsyFrameStatsProperty) prop_id) {
+    case PROP_NUM_FRAMES:
+        g_value_set_uint64(value, self->num_frames);
+        break;
+    case PROP_TRACE_ENABLED:
+        g_value_set_boolean(value, self->trace_enabled);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_frame_stats_init(PsyFrameStats *self)
+{
+    for (guint i = 0; i < PSY_GPU_TIMER_NUM_FRAMES; i++)
+        self->frames[i].sections
+            = g_array_new(FALSE, TRUE, sizeof(FrameSection));
+
+    self->sections
+        = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+    self->trace    = g_array_new(FALSE, TRUE, sizeof(TraceEvent));
+}
+
+static void
+psy_frame_stats_finalize(GObject *object)
+{
+    PsyFrameStats *self = PSY_FRAME_STATS(object);
+
+    for (guint i = 0; i < PSY_GPU_TIMER_NUM_FRAMES; i++)
+        g_array_unref(self->frames[i].sections);
+
+    g_clear_object(&self->timer);
+    g_hash_table_destroy(self->sections);
+    g_array_unref(self->trace);
+
+    G_OBJECT_CLASS(psy_frame_stats_parent_class)->finalize(object);
+}
+
+static void
+psy_frame_stats_class_init(PsyFrameStatsClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = psy_frame_stats_set_property;
+    object_class->get_property = psy_frame_stats_get_property;
+    object_class->finalize     = psy_frame_stats_finalize;
+
+    /**
+     * PsyFrameStats:num-frames:
+     *
+     * The number of frames that have been measured.
+     */
+    frame_stats_properties[PROP_NUM_FRAMES]
+        = g_param_spec_uint64("num-frames",
+                              "NumFrames",
+                              "The number of frames that have been measured",
+                              0,
+                              G_MAXUINT64,
+                              0,
+                              G_PARAM_READABLE);
+
+    /**
+     * PsyFrameStats:trace-enabled:
+     *
+     * Whether every section is stored, so that it can be saved with
+     * [method@FrameStats.save_trace].
+     */
+    frame_stats_properties[PROP_TRACE_ENABLED]
+        = g_param_spec_boolean("trace-enabled",
+                               "TraceEnabled",
+                               "Whether to store every section as trace event",
+                               FALSE,
+                               G_PARAM_READWRITE);
+
+    g_object_class_install_properties(
+        object_class, NUM_PROPERTIES, frame_stats_properties);
+}
+
+static SectionStats *
+frame_stats_lookup_section(PsyFrameStats *self, const gchar *name)
+{
+    SectionStats *stats = g_hash_table_lookup(self->sections, name);
+    if (!stats) {
+        stats = g_new0(SectionStats, 1);
+        g_hash_table_insert(self->sections, (gpointer) name, stats);
+    }
+    return stats;
+}
+
+static void
+frame_stats_add_event(PsyFrameStats *self,
+                      const gchar   *name,
+                      gint64         start_ns,
+                      gint64         dur_ns,
+                      gboolean       gpu)
+{
+    if (!self->trace_enabled)
+        return;
+
+    TraceEvent event = {
+        .name = name, .start_ns = start_ns, .dur_ns = dur_ns, .gpu = gpu};
+    g_array_append_val(self->trace, event);
+}
+
+/*
+ * Adds the GPU durations of a frame that was recorded a few frames ago.
+ */
+static void
+frame_stats_resolve(PsyFrameStats *self,
+                    PendingFrame  *frame,
+                    const guint64 *results,
+                    guint          num_results)
+{
+    for (guint i = 0; results && i < frame->sections->len; i++) {
+        FrameSection *section
+            = &g_array_index(frame->sections, FrameSection, i);
+        if (section->gpu_start >= num_results
+            || section->gpu_end >= num_results)
+            continue;
+
+        guint64 start = results[section->gpu_start];
+        guint64 end   = results[section->gpu_end];
+        guint64 dur   = end > start ? end - start : 0;
+
+        SectionStats *stats = frame_stats_lookup_section(self, section->name);
+        stats->num_gpu_samples++;
+        stats->gpu_total_ns += dur;
+        stats->gpu_max_ns = MAX(stats->gpu_max_ns, dur);
+
+        // The GPU clock is aligned to the CPU at the first timestamp.
+        frame_stats_add_event(self,
+                              section->name,
+                              frame->gpu_origin_cpu + (start - results[0]),
+                              dur,
+                              TRUE);
+    }
+}
+
+static void
+frame_stats_clear_pending(PsyFrameStats *self)
+{
+    for (guint i = 0; i < PSY_GPU_TIMER_NUM_FRAMES; i++)
+        g_array_set_size(self->frames[i].sections, 0);
+    self->frame   = 0;
+    self->started = FALSE;
+}
+
+/*
+ * Writes a string as JSON string literal.
+ */
+static void
+append_json_string(GString *out, const gchar *str)
+{
+    g_string_append_c(out, '"');
+    for (const gchar *c = str; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            g_string_append_printf(out, "\\%c", *c);
+        else if ((guchar) *c < 0x20)
+            g_string_append_printf(out, "\\u%04x", (guint) *c);
+        else
+            g_string_append_c(out, *c);
+    }
+    g_string_append_c(out, '"');
+}
+
+static gint
+compare_names(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(*(const gchar *const *) a, *(const gchar *const *) b);
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_frame_stats_new:(constructor)
+ *
+ * Returns: a new [class@FrameStats] without any measurements.
+ */
+PsyFrameStats *
+psy_frame_stats_new(void)
+{
+    return g_object_new(PSY_TYPE_FRAME_STATS, NULL);
+}
+
+/**
+ * psy_frame_stats_free:(skip)
+ * @self: an instance of [class@FrameStats]
+ *
+ * Frees instances of [class@FrameStats]
+ */
+void
+psy_frame_stats_free(PsyFrameStats *self)
+{
+    g_return_if_fail(PSY_IS_FRAME_STATS(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_frame_stats_reset:
+ * @self: an instance of [class@FrameStats]
+ *
+ * Forgets all measurements and trace events.
+ */
+void
+psy_frame_stats_reset(PsyFrameStats *self)
+{
+    g_return_if_fail(PSY_IS_FRAME_STATS(self));
+
+    frame_stats_clear_pending(self);
+    g_hash_table_remove_all(self->sections);
+    g_array_set_size(self->trace, 0);
+    self->num_frames = 0;
+}
+
+/**
+ * psy_frame_stats_get_num_frames:
+ * @self: an instance of [class@FrameStats]
+ *
+ * Returns: the number of frames that have been measured.
+ */
+guint64
+psy_frame_stats_get_num_frames(PsyFrameStats *self)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), 0);
+    return self->num_frames;
+}
+
+/**
+ * psy_frame_stats_get_section_names:
+ * @self: an instance of [class@FrameStats]
+ *
+ * Obtains the names of the sections that have been measured. The canvas
+ * measures "draw" for the whole frame, "clear", "upload-projection-matrices"
+ * and "flush-batch" for every instanced draw of a batch. Stimuli that are
+ * drawn one by one are measured by the name of their type, e.g. "PsyCircle".
+ *
+ * Returns:(transfer full): A sorted, NULL terminated array of names.
+ */
+gchar **
+psy_frame_stats_get_section_names(PsyFrameStats *self)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), NULL);
+
+    GPtrArray     *names = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer       name;
+
+    g_hash_table_iter_init(&iter, self->sections);
+    while (g_hash_table_iter_next(&iter, &name, NULL))
+        g_ptr_array_add(names, g_strdup(name));
+
+    g_ptr_array_sort(names, compare_names);
+    g_ptr_array_add(names, NULL);
+
+    return (gchar **) g_ptr_array_free(names, FALSE);
+}
+
+/**
+ * psy_frame_stats_get_section:
+ * @self: an instance of [class@FrameStats]
+ * @name: the name of the section
+ * @num_samples:(out)(optional): the number of times the section was measured
+ * @cpu_mean_ms:(out)(optional): the mean time the CPU spent in the section
+ * @cpu_max_ms:(out)(optional): the maximum time the CPU spent in the section
+ * @num_gpu_samples:(out)(optional): the number of GPU measurements, this is
+ *                  0 when the drawing backend doesn't support GPU timers
+ * @gpu_mean_ms:(out)(optional): the mean time the GPU spent in the section
+ * @gpu_max_ms:(out)(optional): the maximum time the GPU spent in the section
+ *
+ * Obtains the aggregated durations of a section, in milliseconds.
+ *
+ * Returns: TRUE when the section has been measured, FALSE otherwise.
+ */
+gboolean
+psy_frame_stats_get_section(PsyFrameStats *self,
+                            const gchar   *name,
+                            guint64       *num_samples,
+                            gdouble       *cpu_mean_ms,
+                            gdouble       *cpu_max_ms,
+                            guint64       *num_gpu_samples,
+                            gdouble       *gpu_mean_ms,
+                            gdouble       *gpu_max_ms)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+
+    SectionStats *stats = g_hash_table_lookup(self->sections, name);
+    SectionStats  none  = {0};
+    if (!stats)
+        stats = &none;
+
+    if (num_samples)
+        *num_samples = stats->num_samples;
+    if (cpu_mean_ms)
+        *cpu_mean_ms = stats->num_samples ? stats->cpu_total_ns / 1e6
+                                                / stats->num_samples
+                                          : 0.0;
+    if (cpu_max_ms)
+        *cpu_max_ms = stats->cpu_max_ns / 1e6;
+    if (num_gpu_samples)
+        *num_gpu_samples = stats->num_gpu_samples;
+    if (gpu_mean_ms)
+        *gpu_mean_ms = stats->num_gpu_samples ? stats->gpu_total_ns / 1e6
+                                                    / stats->num_gpu_samples
+                                              : 0.0;
+    if (gpu_max_ms)
+        *gpu_max_ms = stats->gpu_max_ns / 1e6;
+
+    return stats != &none;
+}
+
+/**
+ * psy_frame_stats_set_trace_enabled:
+ * @self: an instance of [class@FrameStats]
+ * @enabled: whether to store trace events
+ *
+ * See [property@FrameStats:trace-enabled].
+ */
+void
+psy_frame_stats_set_trace_enabled(PsyFrameStats *self, gboolean enabled)
+{
+    g_return_if_fail(PSY_IS_FRAME_STATS(self));
+    self->trace_enabled = enabled != FALSE;
+}
+
+/**
+ * psy_frame_stats_get_trace_enabled:
+ * @self: an instance of [class@FrameStats]
+ *
+ * Returns: whether trace events are stored.
+ */
+gboolean
+psy_frame_stats_get_trace_enabled(PsyFrameStats *self)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), FALSE);
+    return self->trace_enabled;
+}
+
+/**
+ * psy_frame_stats_save_trace:
+ * @self: an instance of [class@FrameStats]
+ * @filename: the name of the JSON file to write
+ * @error: errors may be returned here
+ *
+ * Saves the stored events in the Trace Event Format. The CPU sections are
+ * in the first track and the GPU sections in the second.
+ *
+ * Returns: TRUE when the file has been written, FALSE otherwise.
+ */
+gboolean
+psy_frame_stats_save_trace(PsyFrameStats *self,
+                           const gchar   *filename,
+                           GError       **error)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), FALSE);
+    g_return_val_if_fail(filename, FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    GString *out = g_string_new("{\"traceEvents\":[\n");
+
+    for (guint i = 0; i < self->trace->len; i++) {
+        TraceEvent *event = &g_array_index(self->trace, TraceEvent, i);
+
+        g_string_append(out, "{\"name\":");
+        append_json_string(out, event->name);
+        g_string_append_printf(out,
+                               ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                               "\"dur\":%.3f,\"pid\":1,\"tid\":%d}%s\n",
+                               event->gpu ? "gpu" : "cpu",
+                               event->start_ns / 1e3,
+                               event->dur_ns / 1e3,
+                               event->gpu ? 2 : 1,
+                               i + 1 < self->trace->len ? "," : "");
+    }
+    g_string_append(out, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    gboolean ret = g_file_set_contents(filename, out->str, out->len, error);
+    g_string_free(out, TRUE);
+
+    return ret;
+}
+
+/**
+ * psy_frame_stats_begin_frame:(skip)
+ * @self: an instance of [class@FrameStats]
+ * @timer:(nullable): the timer used to measure the GPU
+ *
+ * Starts measuring a new frame, this adds the GPU durations of the frame
+ * that was measured [const@GPU_TIMER_NUM_FRAMES] frames ago.
+ *
+ * Stability: private
+ */
+void
+psy_frame_stats_begin_frame(PsyFrameStats *self, PsyGpuTimer *timer)
+{
+    g_return_if_fail(PSY_IS_FRAME_STATS(self));
+    g_return_if_fail(timer == NULL || PSY_IS_GPU_TIMER(timer));
+
+    // The pending frames are from another timer.
+    if (g_set_object(&self->timer, timer))
+        frame_stats_clear_pending(self);
+
+    if (self->started)
+        self->frame = (self->frame + 1) % PSY_GPU_TIMER_NUM_FRAMES;
+    self->started = TRUE;
+
+    PendingFrame *frame = &self->frames[self->frame];
+
+    if (self->timer) {
+        guint          num_results = 0;
+        const guint64 *results;
+
+        psy_gpu_timer_begin_frame(self->timer);
+        results = psy_gpu_timer_get_results(self->timer, &num_results);
+        frame_stats_resolve(self, frame, results, num_results);
+    }
+
+    g_array_set_size(frame->sections, 0);
+    self->num_frames++;
+}
+
+/**
+ * psy_frame_stats_begin_section:(skip)
+ * @self: an instance of [class@FrameStats]
+ * @name: the name of the section
+ *
+ * Starts measuring a section of the current frame. Sections may be nested.
+ *
+ * Stability: private
+ * Returns: a handle to pass to [method@FrameStats.end_section]
+ */
+guint
+psy_frame_stats_begin_section(PsyFrameStats *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_FRAME_STATS(self), 0);
+    g_return_val_if_fail(name, 0);
+
+    PendingFrame *frame   = &self->frames[self->frame];
+    FrameSection  section = {
+        .name      = g_intern_string(name),
+        .cpu_start = psy_clock_get_monotonic_time_ns(),
+        .gpu_start = PSY_GPU_TIMER_INVALID,
+        .gpu_end   = PSY_GPU_TIMER_INVALID,
+    };
+
+    if (self->timer)
+        section.gpu_start = psy_gpu_timer_query_timestamp(self->timer);
+    if (section.gpu_start == 0)
+        frame->gpu_origin_cpu = section.cpu_start;
+
+    g_array_append_val(frame->sections, section);
+    return frame->sections->len - 1;
+}
+
+/**
+ * psy_frame_stats_end_section:(skip)
+ * @self: an instance of [class@FrameStats]
+ * @section: the handle returned by [method@FrameStats.begin_section]
+ *
+ * Ends measuring a section of the current frame.
+ *
+ * Stability: private
+ */
+void
+psy_frame_stats_end_section(PsyFrameStats *self, guint section)
+{
+    g_return_if_fail(PSY_IS_FRAME_STATS(self));
+
+    PendingFrame *frame = &self->frames[self->frame];
+    g_return_if_fail(section < frame->sections->len);
+
+    FrameSection *sec = &g_array_index(frame->sections, FrameSection, section);
+
+    if (self->timer)
+        sec->gpu_end = psy_gpu_timer_query_timestamp(self->timer);
+    sec->cpu_end = psy_clock_get_monotonic_time_ns();
+
+    gint64        dur   = sec->cpu_end - sec->cpu_start;
+    SectionStats *stats = frame_stats_lookup_section(self, sec->name);
+    stats->num_samples++;
+    stats->cpu_total_ns += dur;
+    stats->cpu_max_ns = MAX(stats->cpu_max_ns, dur);
+
+    frame_stats_add_event(self, sec->name, sec->cpu_start, dur, FALSE);
+}
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "psy-gpu-timer.h"
+
+G_BEGIN_DECLS
+
+#define PSY_TYPE_FRAME_STATS psy_frame_stats_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(PsyFrameStats, psy_frame_stats, PSY, FRAME_STATS, GObject)
+
+G_MODULE_EXPORT PsyFrameStats *
+psy_frame_stats_new(void);
+
+G_MODULE_EXPORT void
+psy_frame_stats_free(PsyFrameStats *self);
+
+G_MODULE_EXPORT void
+psy_frame_stats_reset(PsyFrameStats *self);
+
+G_MODULE_EXPORT guint64
+psy_frame_stats_get_num_frames(PsyFrameStats *self);
+
+G_MODULE_EXPORT gchar **
+psy_frame_stats_get_section_names(PsyFrameStats *self);
+
+G_MODULE_EXPORT gboolean
+psy_frame_stats_get_section(PsyFrameStats *self,
+                            const gchar   *name,
+                            guint64       *num_samples,
+                            gdouble       *cpu_mean_ms,
+                            gdouble       *cpu_max_ms,
+                            guint64       *num_gpu_samples,
+                            gdouble       *gpu_mean_ms,
+                            gdouble       *gpu_max_ms);
+
+G_MODULE_EXPORT void
+psy_frame_stats_set_trace_enabled(PsyFrameStats *self, gboolean enabled);
+
+G_MODULE_EXPORT gboolean
+psy_frame_stats_get_trace_enabled(PsyFrameStats *self);
+
+G_MODULE_EXPORT gboolean
+psy_frame_stats_save_trace(PsyFrameStats *self,
+                           const gchar   *filename,
+                           GError       **error);
+
+void
+psy_frame_stats_begin_frame(PsyFrameStats *self, PsyGpuTimer *timer);
+
+guint
+psy_frame_stats_begin_section(PsyFrameStats *self, const gchar *name);
+
+void
+psy_frame_stats_end_section(PsyFrameStats *self, guint section);
+
+G_END_DECLS
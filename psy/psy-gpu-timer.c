@@ -0,0 +1,100 @@
+
+#include "psy-gpu-timer.h"
+
+/**
+ * PsyGpuTimer:
+ *
+ * A PsyGpuTimer measures when the GPU executes the commands of a frame. The
+ * CPU only queues the drawing commands, so timing them on the CPU doesn't
+ * tell when the GPU has done the work. A timestamp is recorded in the
+ * command stream with [method@GpuTimer.query_timestamp]. Waiting for the
+ * result would stall the CPU until the GPU catches up, hence, the results
+ * are read back [const@GPU_TIMER_NUM_FRAMES] frames later, by
+ * [method@GpuTimer.begin_frame].
+ *
+ * A PsyGpuTimer is created by the drawing backend, see
+ * [method@DrawingContext.create_gpu_timer].
+ */
+
+G_DEFINE_ABSTRACT_TYPE(PsyGpuTimer, psy_gpu_timer, G_TYPE_OBJECT)
+
+static void
+psy_gpu_timer_init(PsyGpuTimer *self)
+{
+    (void) self;
+}
+
+static void
+psy_gpu_timer_class_init(PsyGpuTimerClass *klass)
+{
+    (void) klass;
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_gpu_timer_begin_frame:
+ * @self: an instance of [class@GpuTimer]
+ *
+ * Starts recording the timestamps of a new frame. The timestamps of the
+ * frame that was begun [const@GPU_TIMER_NUM_FRAMES] frames ago are read back
+ * and are available via [method@GpuTimer.get_results] afterwards.
+ */
+void
+psy_gpu_timer_begin_frame(PsyGpuTimer *self)
+{
+    g_return_if_fail(PSY_IS_GPU_TIMER(self));
+
+    PsyGpuTimerClass *cls = PSY_GPU_TIMER_GET_CLASS(self);
+    g_return_if_fail(cls->begin_frame);
+
+    cls->begin_frame(self);
+}
+
+/**
+ * psy_gpu_timer_query_timestamp:
+ * @self: an instance of [class@GpuTimer]
+ *
+ * Records the time at which the GPU has executed all preceding commands.
+ *
+ * Returns: the index of the timestamp in the results of the current frame,
+ *          or [const@GPU_TIMER_INVALID] when the backend is unable to
+ *          record timestamps.
+ */
+guint
+psy_gpu_timer_query_timestamp(PsyGpuTimer *self)
+{
+    g_return_val_if_fail(PSY_IS_GPU_TIMER(self), PSY_GPU_TIMER_INVALID);
+
+    PsyGpuTimerClass *cls = PSY_GPU_TIMER_GET_CLASS(self);
+    g_return_val_if_fail(cls->query_timestamp, PSY_GPU_TIMER_INVALID);
+
+    return cls->query_timestamp(self);
+}
+
+/**
+ * psy_gpu_timer_get_results:
+ * @self: an instance of [class@GpuTimer]
+ * @num_results:(out): the number of timestamps that are returned
+ *
+ * Obtains the timestamps in nanoseconds that were read back by the last
+ * call to [method@GpuTimer.begin_frame]. The timestamps are indexed by the
+ * values returned by [method@GpuTimer.query_timestamp]. When the GPU didn't
+ * finish the frame yet, no results are returned, rather than waiting for
+ * the GPU.
+ *
+ * Returns:(transfer none)(array length=num_results)(nullable): the
+ *          timestamps of the frame
+ */
+const guint64 *
+psy_gpu_timer_get_results(PsyGpuTimer *self, guint *num_results)
+{
+    g_return_val_if_fail(PSY_IS_GPU_TIMER(self), NULL);
+    g_return_val_if_fail(num_results, NULL);
+
+    PsyGpuTimerClass *cls = PSY_GPU_TIMER_GET_CLASS(self);
+    *num_results          = 0;
+    g_return_val_if_fail(cls->get_results, NULL);
+
+    return cls->get_results(self, num_results);
+}
@@ -0,0 +1,57 @@
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PSY_GPU_TIMER_NUM_FRAMES:
+ *
+ * The number of frames for which a [class@GpuTimer] keeps queries in flight,
+ * the timestamps of a frame are read back this many frames later.
+ */
+#define PSY_GPU_TIMER_NUM_FRAMES 2
+
+/**
+ * PSY_GPU_TIMER_INVALID:
+ *
+ * Returned by [method@GpuTimer.query_timestamp] when no timestamp is
+ * recorded.
+ */
+#define PSY_GPU_TIMER_INVALID G_MAXUINT
+
+#define PSY_TYPE_GPU_TIMER psy_gpu_timer_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(PsyGpuTimer, psy_gpu_timer, PSY, GPU_TIMER, GObject)
+
+/**
+ * PsyGpuTimerClass:
+ * @begin_frame: start recording the timestamps of a new frame, and read back
+ *               the timestamps of the frame that was recorded
+ *               PSY_GPU_TIMER_NUM_FRAMES frames ago.
+ * @query_timestamp: record the time at which the GPU reaches this point in
+ *                   the command stream.
+ * @get_results: obtain the timestamps that were read back by begin_frame.
+ */
+typedef struct _PsyGpuTimerClass {
+    GObjectClass parent_class;
+
+    void (*begin_frame)(PsyGpuTimer *self);
+    guint (*query_timestamp)(PsyGpuTimer *self);
+    const guint64 *(*get_results)(PsyGpuTimer *self, guint *num_results);
+
+    gpointer padding[8];
+} PsyGpuTimerClass;
+
+G_MODULE_EXPORT void
+psy_gpu_timer_begin_frame(PsyGpuTimer *self);
+
+G_MODULE_EXPORT guint
+psy_gpu_timer_query_timestamp(PsyGpuTimer *self);
+
+G_MODULE_EXPORT const guint64 *
+psy_gpu_timer_get_results(PsyGpuTimer *self, guint *num_results);
+
+G_END_DECLS
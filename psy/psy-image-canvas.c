@@ -8,6 +8,13 @@
  * environments. And to run the unit test without the need to open a window.
  * This way we can do some tests regarding the rendering procedures and
  * inspect whether the algorithms work as desired.
+ *
+ * The time of the canvas is virtual, every iteration advances it with
+ * [property@Canvas:frame-dur], and the stimuli are scheduled and updated
+ * according to this time. With [property@ImageCanvas:auto-iterate] the
+ * canvas iterates at the pace of the clock, whereas in
+ * [property@ImageCanvas:offline] mode it iterates as fast as it can draw,
+ * which renders a stimulus sequence in a fraction of its duration.
  */
 #include "psy-image-canvas.h"
 #include "psy-clock.h"
@@ -19,6 +26,13 @@ typedef struct PsyImageCanvasPrivate {
     PsyTimePoint *time;
     PsyTimer     *iter_timer;
     gboolean      auto_iterate;
+    gboolean      offline;
+    guint         idle_id; // the source that iterates in offline mode
+
+    // The wall clock time in µs spent on the frames iterated since a reset
+    gint64  first_iter_us;
+    gint64  last_iter_us;
+    guint64 num_iterations;
 } PsyImageCanvasPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyImageCanvas,
@@ -29,6 +43,8 @@ typedef enum {
     PROP_NULL,
     PROP_TIME,
     PROP_AUTO_ITERATE,
+    PROP_OFFLINE,
+    PROP_FRAMES_PER_SECOND,
     N_PROPS
 } PsyImageCanvasProperty;
 
@@ -49,6 +65,9 @@ psy_image_canvas_set_property(GObject      *object,
     case PROP_AUTO_ITERATE:
         psy_image_canvas_set_auto_iterate(self, g_value_get_boolean(value));
         break;
+    case PROP_OFFLINE:
+        psy_image_canvas_set_offline(self, g_value_get_boolean(value));
+        break;
     default:
 
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
@@ -71,11 +90,61 @@ psy_image_canvas_get_property(GObject    *object,
     case PROP_AUTO_ITERATE:
         g_value_set_boolean(value, priv->auto_iterate);
         break;
+    case PROP_OFFLINE:
+        g_value_set_boolean(value, priv->offline);
+        break;
+    case PROP_FRAMES_PER_SECOND:
+        g_value_set_double(value, psy_image_canvas_get_frames_per_second(self));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
     }
 }
 
+static void
+on_iter_timer_fired(PsyTimer *timer, PsyTimePoint *tp, gpointer data)
+{
+    (void) timer;
+    (void) tp;
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(data));
+}
+
+static gboolean
+on_offline_idle(gpointer data)
+{
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(data));
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Iterates either when the clock reaches the time of the next frame, or
+ * as soon as possible in offline mode.
+ */
+static void
+image_canvas_start_iterating(PsyImageCanvas *self)
+{
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    if (priv->offline) {
+        priv->idle_id = g_idle_add(on_offline_idle, self);
+    }
+    else {
+        PsyDuration  *frame_dur = psy_canvas_get_frame_dur(PSY_CANVAS(self));
+        PsyTimePoint *new_frame_tp = psy_time_point_add(priv->time, frame_dur);
+        psy_timer_set_fire_time(priv->iter_timer, new_frame_tp);
+        psy_time_point_free(new_frame_tp);
+    }
+}
+
+static void
+image_canvas_stop_iterating(PsyImageCanvas *self)
+{
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    g_clear_handle_id(&priv->idle_id, g_source_remove);
+    psy_timer_cancel(priv->iter_timer);
+}
+
 static void
 psy_image_canvas_init(PsyImageCanvas *self)
 {
@@ -87,6 +156,8 @@ psy_image_canvas_init(PsyImageCanvas *self)
 
     priv->time       = psy_time_point_new();
     priv->iter_timer = psy_timer_new();
+    g_signal_connect(
+        priv->iter_timer, "fired", G_CALLBACK(on_iter_timer_fired), self);
 }
 
 static void
@@ -95,6 +166,9 @@ psy_image_canvas_dispose(GObject *gobject)
     PsyImageCanvasPrivate *priv
         = psy_image_canvas_get_instance_private(PSY_IMAGE_CANVAS(gobject));
 
+    g_clear_handle_id(&priv->idle_id, g_source_remove);
+    if (priv->iter_timer)
+        g_signal_handlers_disconnect_by_data(priv->iter_timer, gobject);
     g_clear_object(&priv->iter_timer);
 
     G_OBJECT_CLASS(psy_image_canvas_parent_class)->dispose(gobject);
@@ -124,17 +198,27 @@ image_canvas_iterate(PsyImageCanvas *self)
 {
     PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
     gint64 nf = psy_canvas_get_num_frames_total(PSY_CANVAS(self));
+    gint64 start_us = g_get_monotonic_time();
 
     PsyDuration  *dur      = psy_canvas_get_frame_dur(PSY_CANVAS(self));
     PsyTimePoint *new_time = psy_time_point_add(priv->time, dur);
 
     psy_image_canvas_set_time(self, new_time);
 
-    if (priv->auto_iterate) {
-        psy_timer_set_fire_time(priv->iter_timer, new_time);
+    // In offline mode the idle source iterates again, not the timer. The
+    // timer fires when the clock reaches the time of the next frame.
+    if (priv->auto_iterate && !priv->offline) {
+        PsyTimePoint *next_time = psy_time_point_add(new_time, dur);
+        psy_timer_set_fire_time(priv->iter_timer, next_time);
+        psy_time_point_free(next_time);
     }
 
     PSY_CANVAS_GET_CLASS(self)->draw(PSY_CANVAS(self), nf + 1, new_time);
+
+    if (priv->num_iterations == 0)
+        priv->first_iter_us = start_us;
+    priv->last_iter_us = g_get_monotonic_time();
+    priv->num_iterations++;
 }
 
 /**
@@ -150,8 +234,13 @@ image_canvas_reset(PsyCanvas *self)
 {
     PSY_CANVAS_CLASS(psy_image_canvas_parent_class)->reset(self);
 
+    PsyImageCanvasPrivate *priv
+        = psy_image_canvas_get_instance_private(PSY_IMAGE_CANVAS(self));
+
     PsyTimePoint *new_time = psy_time_point_new();
     psy_image_canvas_set_time(PSY_IMAGE_CANVAS(self), new_time);
+
+    priv->num_iterations = 0;
 }
 
 static GParamSpec *obj_properties[N_PROPS];
@@ -203,6 +292,39 @@ psy_image_canvas_class_init(PsyImageCanvasClass *klass)
                                FALSE,
                                G_PARAM_READWRITE);
 
+    /**
+     * PsyImageCanvas:offline:
+     *
+     * When TRUE, [property@ImageCanvas:auto-iterate] doesn't wait until the
+     * clock reaches the time of the next frame, but iterates from an idle
+     * source as fast as the canvas can draw. The time of the canvas still
+     * increments with [property@Canvas:frame-dur] per frame, so stimuli are
+     * presented on the same frames as in real time. This is useful to
+     * render or verify a long stimulus sequence quickly.
+     */
+    obj_properties[PROP_OFFLINE] = g_param_spec_boolean(
+        "offline",
+        "Offline",
+        "Iterate as fast as possible, instead of at the pace of the clock",
+        FALSE,
+        G_PARAM_READWRITE);
+
+    /**
+     * PsyImageCanvas:frames-per-second:
+     *
+     * The number of frames the canvas has iterated per second of wall clock
+     * time, measured since the canvas was created or reset. In offline mode
+     * this tells how much faster than real time the canvas renders.
+     */
+    obj_properties[PROP_FRAMES_PER_SECOND]
+        = g_param_spec_double("frames-per-second",
+                              "FramesPerSecond",
+                              "The number of frames iterated per second",
+                              0,
+                              G_MAXDOUBLE,
+                              0,
+                              G_PARAM_READABLE);
+
     g_object_class_install_properties(object_class, N_PROPS, obj_properties);
 }
 
@@ -318,15 +440,94 @@ psy_image_canvas_set_auto_iterate(PsyImageCanvas *self, gboolean iterate)
         return;
 
     if (iterate) {
-        PsyDuration *frame_dur = psy_canvas_get_frame_dur(PSY_CANVAS(self));
-        g_return_if_fail(frame_dur != NULL);
-
-        PsyTimePoint *new_frame_tp = psy_time_point_add(priv->time, frame_dur);
-        psy_timer_set_fire_time(priv->iter_timer, new_frame_tp);
-        psy_time_point_free(new_frame_tp);
+        g_return_if_fail(psy_canvas_get_frame_dur(PSY_CANVAS(self)) != NULL);
+        image_canvas_start_iterating(self);
     }
     else {
-        psy_timer_cancel(priv->iter_timer);
+        image_canvas_stop_iterating(self);
     }
     priv->auto_iterate = iterate;
 }
+
+/**
+ * psy_image_canvas_get_auto_iterate:
+ * @self: An instance of [class@ImageCanvas]
+ *
+ * Returns: whether @self iterates automatically
+ */
+gboolean
+psy_image_canvas_get_auto_iterate(PsyImageCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_IMAGE_CANVAS(self), FALSE);
+
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    return priv->auto_iterate;
+}
+
+/**
+ * psy_image_canvas_set_offline:
+ * @self: An instance of [class@ImageCanvas]
+ * @offline: whether to iterate as fast as possible
+ *
+ * See [property@ImageCanvas:offline]. This may be changed while the canvas
+ * iterates automatically.
+ */
+void
+psy_image_canvas_set_offline(PsyImageCanvas *self, gboolean offline)
+{
+    g_return_if_fail(PSY_IS_IMAGE_CANVAS(self));
+
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    offline = offline != FALSE;
+    if (priv->offline == offline)
+        return;
+
+    if (priv->auto_iterate)
+        image_canvas_stop_iterating(self);
+
+    priv->offline = offline;
+
+    if (priv->auto_iterate)
+        image_canvas_start_iterating(self);
+}
+
+/**
+ * psy_image_canvas_get_offline:
+ * @self: An instance of [class@ImageCanvas]
+ *
+ * Returns: whether @self iterates as fast as possible, see
+ *          [property@ImageCanvas:offline]
+ */
+gboolean
+psy_image_canvas_get_offline(PsyImageCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_IMAGE_CANVAS(self), FALSE);
+
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    return priv->offline;
+}
+
+/**
+ * psy_image_canvas_get_frames_per_second:
+ * @self: An instance of [class@ImageCanvas]
+ *
+ * Returns: the number of frames iterated per second of wall clock time,
+ *          see [property@ImageCanvas:frames-per-second], or 0 when this
+ *          isn't known yet.
+ */
+gdouble
+psy_image_canvas_get_frames_per_second(PsyImageCanvas *self)
+{
+    g_return_val_if_fail(PSY_IS_IMAGE_CANVAS(self), 0);
+
+    PsyImageCanvasPrivate *priv = psy_image_canvas_get_instance_private(self);
+
+    gint64 elapsed_us = priv->last_iter_us - priv->first_iter_us;
+    if (priv->num_iterations == 0 || elapsed_us <= 0)
+        return 0;
+
+    return priv->num_iterations * (gdouble) G_USEC_PER_SEC / elapsed_us;
+}
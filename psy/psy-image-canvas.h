@@ -50,4 +50,13 @@ psy_image_canvas_set_auto_iterate(PsyImageCanvas *self, gboolean iterate);
 G_MODULE_EXPORT gboolean
 psy_image_canvas_get_auto_iterate(PsyImageCanvas *self);
 
+G_MODULE_EXPORT void
+psy_image_canvas_set_offline(PsyImageCanvas *self, gboolean offline);
+
+G_MODULE_EXPORT gboolean
+psy_image_canvas_get_offline(PsyImageCanvas *self);
+
+G_MODULE_EXPORT gdouble
+psy_image_canvas_get_frames_per_second(PsyImageCanvas *self);
+
 G_END_DECLS
@@ -1,10 +1,28 @@
-
-#include <glm/glm.hpp>
+#pragma once
 
 #include "psy-matrix4.h"
 
+#ifdef __cplusplus
+
+    #include <glm/glm.hpp>
+
 glm::mat4&
 psy_matrix4_get_priv_reference(PsyMatrix4 *self);
 
 glm::mat4 *
 psy_matrix4_get_priv_pointer(PsyMatrix4 *self);
+
+#endif
+
+G_BEGIN_DECLS
+
+void
+psy_matrix4_set_model_transform(PsyMatrix4 *self,
+                                gfloat      x,
+                                gfloat      y,
+                                gfloat      z,
+                                gfloat      rotation,
+                                gfloat      scale_x,
+                                gfloat      scale_y);
+
+G_END_DECLS
@@ -2,6 +2,7 @@
 #include <glm/detail/type_mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "psy-matrix4-private.h"
 #include "psy-matrix4.h"
 #include "psy-vector3-private.h"
 #include "psy-vector4-private.h"
@@ -656,3 +657,37 @@ psy_matrix4_get_priv_pointer(PsyMatrix4 *self)
 
     return self->matrix;
 }
+
+/**
+ * psy_matrix4_set_model_transform:(skip)
+ * @self: an instance of [class@Matrix4]
+ * @x: the translation along the x axis
+ * @y: the translation along the y axis
+ * @z: the translation along the z axis
+ * @rotation: the rotation around the z axis in radians
+ * @scale_x: the scaling along the x axis
+ * @scale_y: the scaling along the y axis
+ *
+ * Sets @self to translate * rotate * scale. This is equivalent to setting
+ * @self to identity and calling [method@Matrix4.translate],
+ * [method@Matrix4.rotate] and [method@Matrix4.scale], but it doesn't need
+ * temporary [class@Vector3] instances. This is used by [class@Artist] for
+ * each stimulus it draws.
+ *
+ * Stability: private
+ */
+void
+psy_matrix4_set_model_transform(PsyMatrix4 *self,
+                                gfloat      x,
+                                gfloat      y,
+                                gfloat      z,
+                                gfloat      rotation,
+                                gfloat      scale_x,
+                                gfloat      scale_y)
+{
+    g_assert(PSY_IS_MATRIX4(self));
+
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+    model           = glm::rotate(model, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+    *self->matrix   = glm::scale(model, glm::vec3(scale_x, scale_y, 0.0f));
+}
@@ -1,10 +1,15 @@
 
+#include <string.h>
+
 #include "psy-picture-artist.h"
+#include "psy-artist-private.h"
 #include "psy-artist.h"
+#include "psy-drawing-context-private.h"
 #include "psy-drawing-context.h"
 #include "psy-matrix4.h"
 #include "psy-picture.h"
 #include "psy-shader-program.h"
+#include "psy-texture-atlas.h"
 #include "psy-vbuffer.h"
 #include "psy-window.h"
 
@@ -67,6 +72,84 @@ picture_artist_get_program(PsyArtist *artist)
     return psy_drawing_context_get_program(context, PSY_PICTURE_PROGRAM_NAME);
 }
 
+static gboolean
+picture_artist_is_translucent(PsyArtist *artist)
+{
+    if (PSY_ARTIST_CLASS(psy_picture_artist_parent_class)->is_translucent(
+            artist))
+        return TRUE;
+
+    PsyPicture        *picture = PSY_PICTURE(psy_artist_get_stimulus(artist));
+    PsyDrawingContext *context = psy_artist_get_context(artist);
+    const gchar       *fn      = psy_picture_get_filename(picture);
+    PsyTexture        *texture = NULL;
+
+    // A query while sorting mustn't touch the texture cache.
+    if (fn)
+        texture = psy_drawing_context_lookup_texture(context, fn);
+    if (!texture)
+        return TRUE; // Unknown, so be on the safe side.
+
+    // Images with an alpha channel are blended, 0 means not decoded yet.
+    guint num_channels = psy_texture_get_num_channels(texture);
+    return num_channels != 1 && num_channels != 3;
+}
+
+/*
+ * Lets the picture take the size of its texture, when it has the automatic
+ * size strategy.
+ */
+static void
+picture_artist_auto_resize(PsyPicture *picture, PsyTexture *texture)
+{
+    if (psy_picture_get_size_strategy(picture)
+        != PSY_PICTURE_STRATEGY_AUTOMATIC)
+        return;
+
+    g_debug("Texture size = %d * %d",
+            psy_texture_get_width(texture),
+            psy_texture_get_height(texture));
+    g_signal_emit_by_name(picture,
+                          "auto-resize",
+                          (float) psy_texture_get_width(texture),
+                          (float) psy_texture_get_height(texture));
+}
+
+static PsyVBuffer *
+picture_artist_get_instance(PsyArtist          *self,
+                            PsyVBufferInstance *instance,
+                            PsyTexture        **texture)
+{
+    PsyPicture        *picture = PSY_PICTURE(psy_artist_get_stimulus(self));
+    PsyDrawingContext *context = psy_artist_get_context(self);
+    gfloat             tex_rect[4];
+
+    const gchar *fn = psy_picture_get_filename(picture);
+    if (!fn)
+        return NULL;
+
+    // Only pictures in the atlas can share a texture with other pictures.
+    PsyTextureAtlas *atlas = psy_drawing_context_get_atlas(context);
+    if (!atlas || !psy_texture_atlas_lookup(atlas, fn, tex_rect))
+        return NULL;
+
+    PsyTexture *picture_texture = psy_drawing_context_get_texture(context, fn);
+    PsyVBuffer *mesh            = psy_artist_get_unit_square(self);
+    if (!picture_texture || !mesh)
+        return NULL;
+
+    picture_artist_auto_resize(picture, picture_texture);
+
+    psy_artist_fill_instance(self,
+                             psy_rectangle_get_width(PSY_RECTANGLE(picture)),
+                             psy_rectangle_get_height(PSY_RECTANGLE(picture)),
+                             instance);
+    memcpy(instance->tex_rect, tex_rect, sizeof(instance->tex_rect));
+
+    *texture = psy_texture_atlas_get_texture(atlas);
+    return mesh;
+}
+
 static void
 picture_artist_draw(PsyArtist *self)
 {
@@ -76,34 +159,23 @@ picture_artist_draw(PsyArtist *self)
     gboolean    store_vertices = FALSE;
     gfloat      width, height;
     const guint num_vertices = 4;
-    gchar      *fn           = NULL;
 
     PsyPictureArtist  *artist  = PSY_PICTURE_ARTIST(self);
     PsyPicture        *picture = PSY_PICTURE(psy_artist_get_stimulus(self));
     PsyCanvas         *canvas  = psy_artist_get_canvas(self);
     PsyDrawingContext *context = psy_canvas_get_context(canvas);
 
-    gint strategy;
-
-    // clang-format off
-    g_object_get(picture,
-            "width", &width,
-            "height", &height,
-            "filename", &fn,
-            "size-strategy", &strategy,
-            NULL
-            );
-    // clang-format on
+    const gchar *fn = psy_picture_get_filename(picture);
 
     PsyTexture *texture = psy_drawing_context_get_texture(context, fn);
     if (!texture) {
         g_critical("Unable to obtain texture \"%s\"from drawing context", fn);
-        g_free(fn);
         return;
     }
-    g_free(fn);
 
-    if (!psy_texture_is_uploaded(texture)) {
+    // A pending upload is finished by the GL before the texture is sampled.
+    if (!psy_texture_is_uploaded(texture)
+        && !psy_texture_is_upload_pending(texture)) {
         static int warn_once = 0;
         if (!warn_once) {
             g_warning("Texture %s is not uploaded, we recommend to do so "
@@ -126,15 +198,7 @@ picture_artist_draw(PsyArtist *self)
         g_clear_error(&error);
     }
 
-    if (strategy == PSY_PICTURE_STRATEGY_AUTOMATIC) {
-        g_debug("Texture size = %d * %d",
-                psy_texture_get_width(texture),
-                psy_texture_get_height(texture));
-        g_signal_emit_by_name(picture,
-                              "auto-resize",
-                              (float) psy_texture_get_width(texture),
-                              (float) psy_texture_get_height(texture));
-    }
+    picture_artist_auto_resize(picture, texture);
 
     if (psy_vbuffer_get_nvertices(artist->vertices) != num_vertices) {
         psy_vbuffer_set_nvertices(artist->vertices, num_vertices);
@@ -201,8 +265,10 @@ psy_picture_artist_class_init(PsyPictureArtistClass *class)
     gobject_class->dispose     = psy_picture_artist_dispose;
     gobject_class->constructed = psy_picture_artist_constructed;
 
-    artist_class->draw        = picture_artist_draw;
-    artist_class->get_program = picture_artist_get_program;
+    artist_class->draw           = picture_artist_draw;
+    artist_class->get_program    = picture_artist_get_program;
+    artist_class->get_instance   = picture_artist_get_instance;
+    artist_class->is_translucent = picture_artist_is_translucent;
 }
 
 /* ************ public functions ******************** */
@@ -0,0 +1,298 @@
+
+#include "psy-presentation-log.h"
+
+/**
+ * PsyPresentationLog:
+ *
+ * A PsyPresentationLog is a ring buffer of [struct@PresentationRecord]s,
+ * one for every frame of which the display backend reported when it has
+ * actually been presented. The log is filled by the thread that draws, while
+ * other threads, e.g. a thread that writes the log of an experiment, may read
+ * it without taking a lock, so reading never delays drawing.
+ *
+ * A reader keeps a cursor, the number of records it has read so far, and
+ * [method@PresentationLog.read] continues from there. When a reader falls
+ * behind by more than the capacity of the log, the oldest records are
+ * overwritten and skipped.
+ */
+
+/*
+ * A slot is guarded by a sequence number. It is odd while the slot is
+ * written and it encodes the index of the record when the slot is complete,
+ * so a reader can tell whether it copied a complete and current record.
+ */
+typedef struct LogSlot {
+    gint                  seq;
+    PsyPresentationRecord record;
+} LogSlot;
+
+static inline gint
+slot_seq(guint64 index)
+{
+    return (gint) ((index * 2 + 2) & G_MAXINT32);
+}
+
+typedef struct _PsyPresentationLog {
+    GObject  parent;
+    LogSlot *slots;
+    guint    capacity; // a power of 2
+    gsize    head;     // the number of records pushed, atomic
+} PsyPresentationLog;
+
+G_DEFINE_FINAL_TYPE(PsyPresentationLog, psy_presentation_log, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_CAPACITY,
+    PROP_NUM_RECORDS,
+    NUM_PROPERTIES
+} PsyPresentationLogProperty;
+
+static GParamSpec *presentation_log_properties[NUM_PROPERTIES];
+
+static void
+psy_presentation_log_set_property(GObject      *object,
+                                  guint         prop_id,
+                                  const GValue *value,
+                                  GParamSpec   *pspec)
+{
+    PsyPresentationLog *self = PSY_PRESENTATION_LOG(object);
+
+    switch ((PsyPresentationLogProperty) prop_id) {
+    case PROP_CAPACITY:
+        // Round up to a power of two, so the index wraps with a mask.
+        self->capacity = 1;
+        while (self->capacity < g_value_get_uint(value))
+            self->capacity <<= 1;
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_presentation_log_get_property(GObject    *object,
+                                  guint       prop_id,
+                                  GValue     *value,
+                                  GParamSpec *pspec)
+{
+    PsyPresentationLog *self = PSY_PRESENTATION_LOG(object);
+
+    switch ((PsyPresentationLogProperty) prop_id) {
+    case PROP_CAPACITY:
+        g_value_set_uint(value, self->capacity);
+        break;
+    case PROP_NUM_RECORDS:
+        g_value_set_uint64(value, psy_presentation_log_get_num_records(self));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_presentation_log_init(PsyPresentationLog *self)
+{
+    (void) self;
+}
+
+static void
+psy_presentation_log_constructed(GObject *object)
+{
+    PsyPresentationLog *self = PSY_PRESENTATION_LOG(object);
+
+    G_OBJECT_CLASS(psy_presentation_log_parent_class)->constructed(object);
+
+    self->slots = g_new0(LogSlot, self->capacity);
+    for (guint i = 0; i < self->capacity; i++)
+        self->slots[i].seq = -1; // never written
+}
+
+static void
+psy_presentation_log_finalize(GObject *object)
+{
+    PsyPresentationLog *self = PSY_PRESENTATION_LOG(object);
+
+    g_free(self->slots);
+
+    G_OBJECT_CLASS(psy_presentation_log_parent_class)->finalize(object);
+}
+
+static void
+psy_presentation_log_class_init(PsyPresentationLogClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = psy_presentation_log_set_property;
+    object_class->get_property = psy_presentation_log_get_property;
+    object_class->constructed  = psy_presentation_log_constructed;
+    object_class->finalize     = psy_presentation_log_finalize;
+
+    /**
+     * PsyPresentationLog:capacity:
+     *
+     * The number of records the log retains, this is rounded up to a power
+     * of two.
+     */
+    presentation_log_properties[PROP_CAPACITY]
+        = g_param_spec_uint("capacity",
+                            "Capacity",
+                            "The number of records the log retains",
+                            1,
+                            1u << 24,
+                            1024,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyPresentationLog:num-records:
+     *
+     * The number of records that have been added to the log.
+     */
+    presentation_log_properties[PROP_NUM_RECORDS]
+        = g_param_spec_uint64("num-records",
+                              "NumRecords",
+                              "The number of records added to the log",
+                              0,
+                              G_MAXUINT64,
+                              0,
+                              G_PARAM_READABLE);
+
+    g_object_class_install_properties(
+        object_class, NUM_PROPERTIES, presentation_log_properties);
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_presentation_log_new:(constructor)
+ * @capacity: the number of records to retain
+ *
+ * Returns: a new and empty [class@PresentationLog]
+ */
+PsyPresentationLog *
+psy_presentation_log_new(guint capacity)
+{
+    return g_object_new(PSY_TYPE_PRESENTATION_LOG, "capacity", capacity, NULL);
+}
+
+/**
+ * psy_presentation_log_free:(skip)
+ * @self: an instance of [class@PresentationLog]
+ *
+ * Frees instances of [class@PresentationLog]
+ */
+void
+psy_presentation_log_free(PsyPresentationLog *self)
+{
+    g_return_if_fail(PSY_IS_PRESENTATION_LOG(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_presentation_log_get_capacity:
+ * @self: an instance of [class@PresentationLog]
+ *
+ * Returns: the number of records @self retains.
+ */
+guint
+psy_presentation_log_get_capacity(PsyPresentationLog *self)
+{
+    g_return_val_if_fail(PSY_IS_PRESENTATION_LOG(self), 0);
+    return self->capacity;
+}
+
+/**
+ * psy_presentation_log_get_num_records:
+ * @self: an instance of [class@PresentationLog]
+ *
+ * This may be called from any thread.
+ *
+ * Returns: the number of records that have been added to @self, including
+ *          the ones that have been overwritten.
+ */
+guint64
+psy_presentation_log_get_num_records(PsyPresentationLog *self)
+{
+    g_return_val_if_fail(PSY_IS_PRESENTATION_LOG(self), 0);
+    return (guint64) g_atomic_pointer_get(&self->head);
+}
+
+/**
+ * psy_presentation_log_read:
+ * @self: an instance of [class@PresentationLog]
+ * @cursor:(inout): the number of records the reader has seen, start with 0
+ * @records:(out caller-allocates)(array length=max_records): the records
+ *          that are read
+ * @max_records: the maximum number of records to read
+ *
+ * Copies the records that were added after @cursor, and updates @cursor.
+ * This may be called from any thread, without blocking the thread that
+ * adds records. Records that have been overwritten before they could be
+ * read are skipped.
+ *
+ * Returns: the number of records stored in @records
+ */
+guint
+psy_presentation_log_read(PsyPresentationLog    *self,
+                          guint64               *cursor,
+                          PsyPresentationRecord *records,
+                          guint                  max_records)
+{
+    g_return_val_if_fail(PSY_IS_PRESENTATION_LOG(self), 0);
+    g_return_val_if_fail(cursor != NULL, 0);
+    g_return_val_if_fail(records != NULL || max_records == 0, 0);
+
+    guint64 head = psy_presentation_log_get_num_records(self);
+    guint   n    = 0;
+
+    // Skip what has already been overwritten.
+    if (head - *cursor > self->capacity)
+        *cursor = head - self->capacity;
+
+    while (*cursor < head && n < max_records) {
+        LogSlot *slot = &self->slots[*cursor & (self->capacity - 1)];
+        gint     seq  = slot_seq(*cursor);
+
+        gint before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        records[n]  = slot->record;
+        // The copy must be complete before the sequence number is checked.
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        gint after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+        (*cursor)++;
+
+        // Otherwise, the slot has been rewritten meanwhile, the record is lost
+        if (before == seq && after == seq)
+            n++;
+    }
+
+    return n;
+}
+
+/**
+ * psy_presentation_log_push:
+ * @self: an instance of [class@PresentationLog]
+ * @record: the record to add
+ *
+ * Adds a record, this is done by the canvas that owns the log. Only one
+ * thread may add records.
+ */
+void
+psy_presentation_log_push(PsyPresentationLog          *self,
+                          const PsyPresentationRecord *record)
+{
+    g_return_if_fail(PSY_IS_PRESENTATION_LOG(self));
+    g_return_if_fail(record != NULL);
+
+    gsize    head = (gsize) g_atomic_pointer_get(&self->head);
+    LogSlot *slot = &self->slots[head & (self->capacity - 1)];
+    gint     seq  = slot_seq(head);
+
+    __atomic_store_n(&slot->seq, seq - 1, __ATOMIC_RELAXED); // odd, writing
+    // Readers must see the odd sequence number before any part of the record.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->record = *record;
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+
+    g_atomic_pointer_set(&self->head, head + 1);
+}
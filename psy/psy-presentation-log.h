@@ -0,0 +1,58 @@
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PsyPresentationRecord:
+ * @frame_counter: the number of the frame
+ * @predicted_time: the monotonic time in µs at which the frame was predicted
+ *                  to be presented
+ * @presentation_time: the monotonic time in µs at which the frame has been
+ *                     presented, or 0 when the backend didn't report it
+ * @refresh_interval: the refresh interval of the display in µs, or 0 when
+ *                    unknown
+ * @num_dropped: the number of refresh intervals between the previous and
+ *               this frame at which no new frame was presented
+ *
+ * The presentation feedback of a single frame.
+ */
+typedef struct PsyPresentationRecord {
+    gint64 frame_counter;
+    gint64 predicted_time;
+    gint64 presentation_time;
+    gint64 refresh_interval;
+    gint   num_dropped;
+} PsyPresentationRecord;
+
+#define PSY_TYPE_PRESENTATION_LOG psy_presentation_log_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyPresentationLog, psy_presentation_log, PSY, PRESENTATION_LOG, GObject)
+
+G_MODULE_EXPORT PsyPresentationLog *
+psy_presentation_log_new(guint capacity);
+
+G_MODULE_EXPORT void
+psy_presentation_log_free(PsyPresentationLog *self);
+
+G_MODULE_EXPORT guint
+psy_presentation_log_get_capacity(PsyPresentationLog *self);
+
+G_MODULE_EXPORT guint64
+psy_presentation_log_get_num_records(PsyPresentationLog *self);
+
+G_MODULE_EXPORT guint
+psy_presentation_log_read(PsyPresentationLog    *self,
+                          guint64               *cursor,
+                          PsyPresentationRecord *records,
+                          guint                  max_records);
+
+G_MODULE_EXPORT void
+psy_presentation_log_push(PsyPresentationLog          *self,
+                          const PsyPresentationRecord *record);
+
+G_END_DECLS
@@ -189,3 +189,132 @@ psy_audio_queue_clear(PsyAudioQueue *self)
     g_return_if_fail(self != NULL);
     self->p_queue->reset();
 }
+
+/**
+ * PsyInputQueue:(skip)
+ *
+ * This queue is used to hand samples of input lines from a thread that
+ * samples a device to the main context. Pushing and popping is lock free,
+ * as long as there is one producer and one consumer.
+ *
+ * Stability: private
+ */
+
+struct PsyInputQueue {
+    boost::lockfree::spsc_queue<PsyInputSample> *p_queue;
+    guint                                        capacity;
+};
+
+/**
+ * psy_input_queue_new:(skip)
+ * @num_samples: the number of samples the queue is able to hold
+ *
+ * Allocates a new queue. The returned value should be freed with
+ * psy_input_queue_free.
+ *
+ * Returns: A new queue, that is empty or NULL when allocation failed.
+ * Stability: private
+ */
+PsyInputQueue *
+psy_input_queue_new(guint num_samples)
+{
+    PsyInputQueue *queue
+        = static_cast<PsyInputQueue *>(g_malloc0(sizeof(PsyInputQueue)));
+
+    try {
+        queue->p_queue
+            = new boost::lockfree::spsc_queue<PsyInputSample>(num_samples);
+    } catch (std::exception& exception) {
+        g_critical(
+            "Unable to alloc boost::lockfree::spsc_queue<PsyInputSample>(%u): "
+            "%s",
+            num_samples,
+            exception.what());
+        g_free(queue);
+        return NULL;
+    }
+
+    queue->capacity = queue->p_queue->write_available();
+
+    g_assert(queue->capacity == num_samples);
+
+    return queue;
+}
+
+/**
+ * psy_input_queue_free:(skip)
+ *
+ * Frees an instance of PsyInputQueue
+ *
+ * Stability: private
+ */
+void
+psy_input_queue_free(PsyInputQueue *self)
+{
+    delete self->p_queue;
+    g_free(self);
+}
+
+/**
+ * psy_input_queue_size:(skip)
+ *
+ * This should only be called from the consuming thread.
+ *
+ * Returns: the number of samples that are ready to be popped.
+ * Stability: private
+ */
+guint
+psy_input_queue_size(PsyInputQueue *self)
+{
+    g_return_val_if_fail(self, 0);
+    return self->p_queue->read_available();
+}
+
+/**
+ * psy_input_queue_capacity:(skip)
+ *
+ * Returns: The number of samples the queue is able to hold.
+ * Stability: private
+ */
+guint
+psy_input_queue_capacity(PsyInputQueue *self)
+{
+    g_return_val_if_fail(self, 0);
+    return self->capacity;
+}
+
+/**
+ * psy_input_queue_push:(skip)
+ * @self: the instance of the queue
+ * @sample:(in): the sample to add to the queue
+ *
+ * Pushes one sample on the queue, this never blocks or allocates memory.
+ *
+ * Returns: TRUE when the sample was added, FALSE when the queue is full.
+ * Stability: private
+ */
+gboolean
+psy_input_queue_push(PsyInputQueue *self, const PsyInputSample *sample)
+{
+    g_return_val_if_fail(self, FALSE);
+    g_return_val_if_fail(sample, FALSE);
+
+    return self->p_queue->push(*sample) ? TRUE : FALSE;
+}
+
+/**
+ * psy_input_queue_pop:(skip)
+ * @self: the instance of the queue
+ * @sample:(out): the sample popped from the queue
+ *
+ * Returns: TRUE when a sample was popped, FALSE when the queue was empty.
+ * Stability: private
+ */
+gboolean
+psy_input_queue_pop(PsyInputQueue *self, PsyInputSample *sample)
+{
+    g_return_val_if_fail(self, FALSE);
+    g_return_val_if_fail(sample, FALSE);
+
+    return self->p_queue->pop(*sample) ? TRUE : FALSE;
+}
@@ -35,4 +35,38 @@ psy_audio_queue_pop_samples(PsyAudioQueue *self,
 G_MODULE_EXPORT void
 psy_audio_queue_clear(PsyAudioQueue *self);
 
+/**
+ * PsyInputSample:(skip)
+ * @time: the time of the sample in us since the zero time of PsyClock
+ * @pins: the state of the input lines
+ * @changed: the lines that have changed since the previous sample
+ *
+ * Stability: private
+ */
+typedef struct PsyInputSample {
+    gint64 time;
+    guint8 pins;
+    guint8 changed;
+} PsyInputSample;
+
+typedef struct PsyInputQueue PsyInputQueue;
+
+G_MODULE_EXPORT PsyInputQueue *
+psy_input_queue_new(guint num_samples);
+
+G_MODULE_EXPORT void
+psy_input_queue_free(PsyInputQueue *self);
+
+G_MODULE_EXPORT guint
+psy_input_queue_size(PsyInputQueue *self);
+
+G_MODULE_EXPORT guint
+psy_input_queue_capacity(PsyInputQueue *self);
+
+G_MODULE_EXPORT gboolean
+psy_input_queue_push(PsyInputQueue *self, const PsyInputSample *sample);
+
+G_MODULE_EXPORT gboolean
+psy_input_queue_pop(PsyInputQueue *self, PsyInputSample *sample);
+
 G_END_DECLS
@@ -1,6 +1,7 @@
 
 #include <math.h>
 
+#include "psy-artist-private.h"
 #include "psy-drawing-context.h"
 #include "psy-matrix4.h"
 #include "psy-rectangle-artist.h"
@@ -52,41 +53,32 @@ psy_rectangle_artist_finalize(GObject *object)
 static void
 rectangle_artist_draw(PsyArtist *self)
 {
+    PsyRectangle *stim   = PSY_RECTANGLE(psy_artist_get_stimulus(self));
+    gfloat        radius = psy_rectangle_get_corner_radius(stim);
+
+    if (radius > 0) {
+        gfloat half_width  = fabsf(psy_rectangle_get_width(stim)) / 2;
+        gfloat half_height = fabsf(psy_rectangle_get_height(stim)) / 2;
+
+        psy_artist_draw_sdf(self,
+                            PSY_SDF_SHAPE_ROUNDED_RECTANGLE,
+                            half_width,
+                            half_height,
+                            MIN(radius, MIN(half_width, half_height)));
+        return;
+    }
+
     PSY_ARTIST_CLASS(psy_rectangle_artist_parent_class)->draw(self);
 
-    gfloat       rgba[4]        = {0.0, 0.0, 0.0, 1.0};
-    PsyColor    *color          = NULL;
-    GError      *error          = NULL;
-    gboolean     store_vertices = FALSE;
-    gfloat       width, height;
-    const gchar *color_name   = "ourColor";
-    const guint  num_vertices = 4;
+    GError     *error          = NULL;
+    gboolean    store_vertices = FALSE;
+    gfloat      width, height;
+    const guint num_vertices = 4;
 
     PsyRectangleArtist *artist = PSY_RECTANGLE_ARTIST(self);
     PsyRectangle *rectangle    = PSY_RECTANGLE(psy_artist_get_stimulus(self));
 
-    PsyShaderProgram *program = psy_artist_get_program(self);
-
-    // clang-format off
-    g_object_get(rectangle,
-            "width", &width,
-            "height", &height,
-            "color", &color,
-            NULL
-            );
-    // clang-format on
-
-    if (color) {
-        // clang-format off
-        g_object_get(color,
-                "r", &rgba[0],
-                "g", &rgba[1],
-                "b", &rgba[2],
-                "a", &rgba[3],
-                NULL);
-        // clang-format on
-    }
-    psy_shader_program_set_uniform_4f(program, color_name, rgba, &error);
+    psy_artist_set_color_uniform(self, &error);
     if (error) {
         g_critical("%s: Unable to set the color: %s", __func__, error->message);
         g_clear_error(&error);
@@ -118,7 +110,7 @@ rectangle_artist_draw(PsyArtist *self)
         if (error) {
             g_critical("PsyRectangleArtist: unable to upload vertices: %s",
                        error->message);
-            g_error_free(error);
+            g_clear_error(&error);
         }
     }
     psy_vbuffer_draw_triangle_fan(artist->vertices, &error);
@@ -127,8 +119,41 @@ rectangle_artist_draw(PsyArtist *self)
                    error->message);
         g_error_free(error);
     }
+}
+
+static PsyVBuffer *
+rectangle_artist_get_instance(PsyArtist          *self,
+                              PsyVBufferInstance *instance,
+                              PsyTexture        **texture)
+{
+    (void) texture;
+    PsyRectangle *rectangle = PSY_RECTANGLE(psy_artist_get_stimulus(self));
+
+    // Rounded rectangles are drawn smooth, one by one.
+    if (psy_rectangle_get_corner_radius(rectangle) > 0)
+        return NULL;
+
+    PsyVBuffer *mesh = psy_artist_get_unit_square(self);
+    if (!mesh)
+        return NULL;
+
+    psy_artist_fill_instance(self,
+                             psy_rectangle_get_width(rectangle),
+                             psy_rectangle_get_height(rectangle),
+                             instance);
+    return mesh;
+}
+
+static gboolean
+rectangle_artist_is_translucent(PsyArtist *self)
+{
+    PsyRectangle *rectangle = PSY_RECTANGLE(psy_artist_get_stimulus(self));
 
-    g_object_unref(color);
+    // The smooth edges of rounded rectangles are blended.
+    if (psy_rectangle_get_corner_radius(rectangle) > 0)
+        return TRUE;
+    return PSY_ARTIST_CLASS(psy_rectangle_artist_parent_class)
+        ->is_translucent(self);
 }
 
 static void
@@ -141,7 +166,9 @@ psy_rectangle_artist_class_init(PsyRectangleArtistClass *class)
     gobject_class->dispose     = psy_rectangle_artist_dispose;
     gobject_class->constructed = psy_rectangle_artist_constructed;
 
-    artist_class->draw = rectangle_artist_draw;
+    artist_class->draw           = rectangle_artist_draw;
+    artist_class->get_instance   = rectangle_artist_get_instance;
+    artist_class->is_translucent = rectangle_artist_is_translucent;
 }
 
 /* ************ public functions ******************** */
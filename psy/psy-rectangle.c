@@ -5,6 +5,7 @@
 typedef struct _PsyRectanglePrivate {
     gfloat width;
     gfloat height;
+    gfloat corner_radius;
 } PsyRectanglePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(PsyRectangle,
@@ -15,6 +16,7 @@ typedef enum {
     PROP_NULL, // not used required by GObject
     PROP_WIDTH,
     PROP_HEIGHT,
+    PROP_CORNER_RADIUS,
     NUM_PROPERTIES
 } RectangleProperty;
 
@@ -35,6 +37,9 @@ rectangle_set_property(GObject      *object,
     case PROP_HEIGHT:
         psy_rectangle_set_height(self, g_value_get_float(value));
         break;
+    case PROP_CORNER_RADIUS:
+        psy_rectangle_set_corner_radius(self, g_value_get_float(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -56,6 +61,9 @@ rectangle_get_property(GObject    *object,
     case PROP_HEIGHT:
         g_value_set_float(value, priv->height);
         break;
+    case PROP_CORNER_RADIUS:
+        g_value_set_float(value, priv->corner_radius);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -136,6 +144,22 @@ psy_rectangle_class_init(PsyRectangleClass *klass)
                              0,
                              G_PARAM_READWRITE);
 
+    /**
+     * Rectangle:corner-radius:
+     *
+     * When larger than 0, the corners of the rectangle are rounded with this
+     * radius. A rectangle with rounded corners is drawn on a single quad with
+     * anti-aliased edges.
+     */
+    rectangle_properties[PROP_CORNER_RADIUS]
+        = g_param_spec_float("corner-radius",
+                             "CornerRadius",
+                             "The radius of the rounded corners",
+                             0,
+                             G_MAXFLOAT,
+                             0,
+                             G_PARAM_READWRITE);
+
     g_object_class_install_properties(
         object_class, NUM_PROPERTIES, rectangle_properties);
 }
@@ -269,3 +293,39 @@ psy_rectangle_set_size(PsyRectangle *self, gfloat width, gfloat height)
     psy_rectangle_set_width(self, width);
     psy_rectangle_set_height(self, height);
 }
+
+/**
+ * psy_rectangle_set_corner_radius:
+ * @self: an instance of [class@PsyRectangle]
+ * @corner_radius: a positive number, 0 draws square corners
+ *
+ * See [property@Rectangle:corner-radius].
+ */
+void
+psy_rectangle_set_corner_radius(PsyRectangle *self, gfloat corner_radius)
+{
+    g_return_if_fail(PSY_IS_RECTANGLE(self));
+    g_return_if_fail(corner_radius >= 0.0);
+
+    PsyRectanglePrivate *priv = psy_rectangle_get_instance_private(self);
+    if (priv->corner_radius == corner_radius)
+        return;
+
+    priv->corner_radius = corner_radius;
+    g_object_notify_by_pspec(G_OBJECT(self),
+                             rectangle_properties[PROP_CORNER_RADIUS]);
+}
+
+/**
+ * psy_rectangle_get_corner_radius:
+ * @self: an instance of [class@PsyRectangle]
+ *
+ * Returns: The radius of the corners of the rectangle.
+ */
+gfloat
+psy_rectangle_get_corner_radius(PsyRectangle *self)
+{
+    g_return_val_if_fail(PSY_IS_RECTANGLE(self), 0.0);
+    PsyRectanglePrivate *priv = psy_rectangle_get_instance_private(self);
+    return priv->corner_radius;
+}
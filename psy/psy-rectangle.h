@@ -54,4 +54,10 @@ psy_rectangle_get_height(PsyRectangle *self);
 G_MODULE_EXPORT void
 psy_rectangle_set_size(PsyRectangle *self, gfloat width, gfloat height);
 
+G_MODULE_EXPORT void
+psy_rectangle_set_corner_radius(PsyRectangle *self, gfloat corner_radius);
+
+G_MODULE_EXPORT gfloat
+psy_rectangle_get_corner_radius(PsyRectangle *self);
+
 G_END_DECLS
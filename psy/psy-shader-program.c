@@ -429,3 +429,83 @@ psy_shader_program_set_uniform_4f(PsyShaderProgram *self,
     g_return_if_fail(class->set_uniform_4f);
     class->set_uniform_4f(self, name, values, error);
 }
+
+/**
+ * psy_shader_program_get_uniform_handle:
+ * @self: an instance of `PsyShaderProgram`
+ * @name: the name of the uniform in the shader source
+ * @error: An error might be returned here.
+ *
+ * Looks up a uniform of a linked program. The handle may be used with
+ * [method@ShaderProgram.set_uniform_matrix4_by_handle] and
+ * [method@ShaderProgram.set_uniform_4f_by_handle], which avoids looking up
+ * the uniform by name each time it is set. A handle remains valid as long
+ * as the program exists.
+ *
+ * Returns: a handle >= 0 that refers to the uniform or -1 when the program
+ *          doesn't have an active uniform with @name.
+ */
+gint
+psy_shader_program_get_uniform_handle(PsyShaderProgram *self,
+                                      const gchar      *name,
+                                      GError          **error)
+{
+    g_return_val_if_fail(PSY_IS_SHADER_PROGRAM(self), -1);
+    g_return_val_if_fail(name, -1);
+    g_return_val_if_fail(error == NULL || *error == NULL, -1);
+
+    PsyShaderProgramClass *class = PSY_SHADER_PROGRAM_GET_CLASS(self);
+
+    g_return_val_if_fail(class->get_uniform_handle, -1);
+    return class->get_uniform_handle(self, name, error);
+}
+
+/**
+ * psy_shader_program_set_uniform_matrix4_by_handle:
+ * @self: an instance of `PsyShaderProgram`
+ * @handle: a handle obtained with [method@ShaderProgram.get_uniform_handle]
+ * @matrix: the matrix to send to the uniform
+ * @error: An error might be returned here.
+ *
+ * Set a uniform 4*4 matrix in the shader
+ */
+void
+psy_shader_program_set_uniform_matrix4_by_handle(PsyShaderProgram *self,
+                                                 gint              handle,
+                                                 PsyMatrix4       *matrix,
+                                                 GError          **error)
+{
+    g_return_if_fail(PSY_IS_SHADER_PROGRAM(self));
+    g_return_if_fail(PSY_IS_MATRIX4(matrix));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyShaderProgramClass *class = PSY_SHADER_PROGRAM_GET_CLASS(self);
+
+    g_return_if_fail(class->set_uniform_matrix4_by_handle);
+    class->set_uniform_matrix4_by_handle(self, handle, matrix, error);
+}
+
+/**
+ * psy_shader_program_set_uniform_4f_by_handle:
+ * @self: an instance of `PsyShaderProgram`
+ * @handle: a handle obtained with [method@ShaderProgram.get_uniform_handle]
+ * @values:(array fixed-size=4): the 4 value to send to the uniform
+ * @error: An error might be returned here.
+ *
+ * Set a uniform property with 4 floats in the shader
+ */
+void
+psy_shader_program_set_uniform_4f_by_handle(PsyShaderProgram *self,
+                                            gint              handle,
+                                            gfloat           *values,
+                                            GError          **error)
+{
+    g_return_if_fail(PSY_IS_SHADER_PROGRAM(self));
+    g_return_if_fail(values);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyShaderProgramClass *class = PSY_SHADER_PROGRAM_GET_CLASS(self);
+
+    g_return_if_fail(class->set_uniform_4f_by_handle);
+    class->set_uniform_4f_by_handle(self, handle, values, error);
+}
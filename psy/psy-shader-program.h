@@ -65,6 +65,20 @@ typedef struct _PsyShaderProgramClass {
                            gfloat           *values,
                            GError          **error);
 
+    gint (*get_uniform_handle)(PsyShaderProgram *self,
+                               const gchar      *name,
+                               GError          **error);
+
+    void (*set_uniform_matrix4_by_handle)(PsyShaderProgram *self,
+                                          gint              handle,
+                                          PsyMatrix4       *matrix,
+                                          GError          **error);
+
+    void (*set_uniform_4f_by_handle)(PsyShaderProgram *self,
+                                     gint              handle,
+                                     gfloat           *values,
+                                     GError          **error);
+
 } PsyShaderProgramClass;
 
 G_MODULE_EXPORT void
@@ -134,6 +148,23 @@ psy_shader_program_set_uniform_4f(PsyShaderProgram *self,
                                   gfloat           *values,
                                   GError          **error);
 
+G_MODULE_EXPORT gint
+psy_shader_program_get_uniform_handle(PsyShaderProgram *self,
+                                      const gchar      *name,
+                                      GError          **error);
+
+G_MODULE_EXPORT void
+psy_shader_program_set_uniform_matrix4_by_handle(PsyShaderProgram *self,
+                                                 gint              handle,
+                                                 PsyMatrix4       *matrix,
+                                                 GError          **error);
+
+G_MODULE_EXPORT void
+psy_shader_program_set_uniform_4f_by_handle(PsyShaderProgram *self,
+                                            gint              handle,
+                                            gfloat           *values,
+                                            GError          **error);
+
 G_END_DECLS
 
 #endif
@@ -1,27 +1,38 @@
 
+#include <string.h>
+
 #include "psy-text-artist.h"
+#include "psy-artist-private.h"
 #include "psy-artist.h"
 #include "psy-drawing-context.h"
-#include "psy-duration.h"
+#include "psy-image.h"
 #include "psy-matrix4.h"
 #include "psy-shader-program.h"
 #include "psy-text.h"
+#include "psy-texture-atlas.h"
 #include "psy-texture.h"
 #include "psy-vbuffer.h"
-#include "psy-window.h"
 
 /**
  * PsyTextArtist:
  *
  * The artist that is capable of drawing instances of [class@Text]
  * to a canvas.
+ *
+ * The text is shaped and rasterized by the [class@Text] itself on a worker
+ * thread. The glyphs are added once to the glyph atlas of the drawing
+ * context, see [method@DrawingContext.get_glyph_atlas]. The text is then drawn
+ * as one quad per glyph, in a single instanced draw call.
  */
 
+// The name of the white entry in the glyph atlas, used for the background
+#define SOLID_NAME "solid"
+
 typedef struct _PsyTextArtist {
-    PsyArtist   parent_instance;
-    gfloat      width, height;
-    PsyVBuffer *vertices;
-    PsyTexture *texture;
+    PsyArtist parent_instance;
+    GArray   *glyphs;    // PsyTextGlyph, prepared by the PsyText
+    GArray   *instances; // PsyVBufferInstance
+    guint     pixel_width, pixel_height;
 } PsyTextArtist;
 
 G_DEFINE_TYPE(PsyTextArtist, psy_text_artist, PSY_TYPE_ARTIST)
@@ -29,128 +40,188 @@ G_DEFINE_TYPE(PsyTextArtist, psy_text_artist, PSY_TYPE_ARTIST)
 static void
 psy_text_artist_init(PsyTextArtist *self)
 {
-    (void) self;
-}
-
-static void
-psy_text_artist_constructed(GObject *self)
-{
-    PsyArtist *artist = PSY_ARTIST(self);
-    G_OBJECT_CLASS(psy_text_artist_parent_class)->constructed(self);
-
-    PsyTextArtist     *text_artist = PSY_TEXT_ARTIST(self);
-    PsyDrawingContext *context     = psy_artist_get_context(artist);
-
-    text_artist->vertices = psy_drawing_context_create_vbuffer(context);
-    text_artist->texture  = psy_drawing_context_create_texture(context);
+    self->instances = g_array_new(FALSE, TRUE, sizeof(PsyVBufferInstance));
 }
 
 static void
-psy_text_artist_dispose(GObject *object)
+psy_text_artist_finalize(GObject *object)
 {
     PsyTextArtist *self = PSY_TEXT_ARTIST(object);
 
-    g_clear_object(&self->vertices);
-    g_clear_object(&self->texture);
+    g_clear_pointer(&self->glyphs, g_array_unref);
+    g_array_unref(self->instances);
 
-    G_OBJECT_CLASS(psy_text_artist_parent_class)->dispose(object);
+    G_OBJECT_CLASS(psy_text_artist_parent_class)->finalize(object);
 }
 
 static PsyShaderProgram *
 text_artist_get_program(PsyArtist *artist)
 {
     PsyDrawingContext *context = psy_artist_get_context(artist);
-    return psy_drawing_context_get_program(context, PSY_PICTURE_PROGRAM_NAME);
+    return psy_drawing_context_get_program(context,
+                                           PSY_INSTANCED_GLYPH_PROGRAM_NAME);
 }
 
-static void
-text_artist_draw(PsyArtist *self)
+static gboolean
+text_artist_is_translucent(PsyArtist *artist)
 {
-    PSY_ARTIST_CLASS(psy_text_artist_parent_class)->draw(self);
-
-    gfloat   width, height; // dimensions of the rectangle
-    gboolean is_dirty;      // Whether or not the TextStim changed
-
-    GError     *error          = NULL;
-    gboolean    store_vertices = FALSE;
-    const guint num_vertices   = 4;
-
-    PsyTextArtist *artist = PSY_TEXT_ARTIST(self);
-    PsyText       *text   = PSY_TEXT(psy_artist_get_stimulus(self));
+    (void) artist;
+    // The edges of the glyphs are antialiased, so text is always blended.
+    return TRUE;
+}
 
-    // clang-format off
-    g_object_get(text,
-            "width", &width,
-            "height", &height,
-            "is-dirty", &is_dirty,
-            NULL
-            );
-    // clang-format on
+static void
+glyph_atlas_add(PsyTextureAtlas *atlas, const gchar *name, PsyImage *image)
+{
+    GError *error = NULL;
 
-    if (is_dirty) {
-        PsyImage *img = psy_text_create_stimulus(text);
-        psy_texture_upload_image(artist->texture, img, &error);
-        psy_text_set_is_dirty(text, FALSE);
+    if (!psy_texture_atlas_add_image(atlas, name, image, &error)) {
+        g_warning("PsyTextArtist: unable to add %s to the glyph atlas: %s",
+                  name,
+                  error->message);
+        g_error_free(error);
     }
+}
 
-    psy_texture_bind(artist->texture, &error);
+/*
+ * Makes sure the glyphs are in the atlas, the glyphs that are already in the
+ * atlas are shared with other texts.
+ */
+static void
+text_artist_ensure_glyphs(PsyTextArtist *self, PsyTextureAtlas *atlas)
+{
+    if (!psy_texture_atlas_contains(atlas, SOLID_NAME)) {
+        PsyImage *solid = psy_image_new(1, 1, PSY_IMAGE_FORMAT_RGBA);
+        memset(psy_image_get_ptr(solid), 255, 4);
+        glyph_atlas_add(atlas, SOLID_NAME, solid);
+        g_object_unref(solid);
+    }
 
-    if (error) {
-        g_critical(
-            "%s: Unable to bind texture: %s\n", __func__, error->message);
-        g_clear_error(&error);
+    for (guint i = 0; i < self->glyphs->len; i++) {
+        PsyTextGlyph *glyph = &g_array_index(self->glyphs, PsyTextGlyph, i);
+        if (!psy_texture_atlas_contains(atlas, glyph->name))
+            glyph_atlas_add(atlas, glyph->name, glyph->image);
     }
+}
 
-    if (psy_vbuffer_get_nvertices(artist->vertices) != num_vertices) {
-        psy_vbuffer_set_nvertices(artist->vertices, num_vertices);
-        store_vertices = TRUE;
+/*
+ * Appends an instance that shows the rectangle (in pixels) of the text box.
+ */
+static void
+text_artist_add_instance(PsyTextArtist *self,
+                         const gfloat   model[16],
+                         const gfloat   size[2],
+                         gint           x,
+                         gint           y,
+                         gint           width,
+                         gint           height,
+                         const gfloat   color[4],
+                         const gfloat   tex_rect[4])
+{
+    PsyVBufferInstance instance;
+
+    // The size of a pixel in the units of the canvas
+    gfloat unit_x = size[0] / self->pixel_width;
+    gfloat unit_y = size[1] / self->pixel_height;
+
+    // The center of the box relative to the center of the text, y is up.
+    gfloat cx = -size[0] / 2 + (x + width / 2.0f) * unit_x;
+    gfloat cy = size[1] / 2 - (y + height / 2.0f) * unit_y;
+
+    // model * translate(cx, cy) * scale(width, height), column major.
+    for (guint row = 0; row < 4; row++) {
+        instance.model[row]      = model[row] * width * unit_x;
+        instance.model[4 + row]  = model[4 + row] * height * unit_y;
+        instance.model[8 + row]  = model[8 + row];
+        instance.model[12 + row] = model[row] * cx + model[4 + row] * cy
+                                   + model[12 + row];
     }
+    memcpy(instance.color, color, sizeof(instance.color));
+    memcpy(instance.tex_rect, tex_rect, sizeof(instance.tex_rect));
 
-    width  = psy_rectangle_get_width(PSY_RECTANGLE(text));
-    height = psy_rectangle_get_height(PSY_RECTANGLE(text));
-    if (width != artist->width || height != artist->height) {
-        artist->width  = width;
-        artist->height = height;
-        store_vertices = TRUE;
+    g_array_append_val(self->instances, instance);
+}
+
+static void
+text_artist_draw(PsyArtist *self)
+{
+    // This artist doesn't chain up, the model matrix is part of each instance.
+    GError            *error   = NULL;
+    PsyTextArtist     *artist  = PSY_TEXT_ARTIST(self);
+    PsyText           *text    = PSY_TEXT(psy_artist_get_stimulus(self));
+    PsyDrawingContext *context = psy_artist_get_context(self);
+    PsyShaderProgram  *program = psy_artist_get_program(self);
+    PsyTextureAtlas   *atlas   = psy_drawing_context_get_glyph_atlas(context);
+    PsyVBuffer        *mesh    = psy_artist_get_unit_square(self);
+    PsyVBufferInstance base;
+    gfloat             tex_rect[4];
+
+    if (!program || !atlas || !mesh)
+        return;
+
+    if (psy_text_get_is_dirty(text)) {
+        if (!psy_text_is_render_ready(text))
+            g_info("PsyTextArtist: the text \"%s\" wasn't prepared before its "
+                   "frame, see psy_text_wait_render_ready()",
+                   psy_text_get_content(text));
+        g_clear_pointer(&artist->glyphs, g_array_unref);
+        artist->glyphs = psy_text_get_glyphs(
+            text, &artist->pixel_width, &artist->pixel_height);
+        if (!artist->glyphs)
+            return;
+        psy_text_set_is_dirty(text, FALSE);
     }
 
-    if (store_vertices) {
-        gfloat half_width  = width / 2;
-        gfloat half_height = height / 2;
-
-        // clang-format off
-        PsyVertex vertices[4] = {
-            {
-                .pos = {-half_width, half_height, 0}, // left top
-                .texture_pos = {0.0, 0.0}
-            },
-            {
-                .pos = {half_width, half_height, 0}, // right top
-                .texture_pos = {1.0, 0.0}
-            },
-            {
-                .pos = {half_width, -half_height, 0}, // right bottom
-                .texture_pos = {1.0, 1.0}
-            },
-            {
-                .pos = {-half_width, -half_height, 0}, // left bottom
-                .texture_pos = {0.0, 1.0}
-            }
-        };
-        // clang-format on
-
-        psy_vbuffer_set_from_data(artist->vertices, vertices, num_vertices);
-
-        psy_vbuffer_upload(artist->vertices, &error);
-        if (error) {
-            g_critical("PsyTextArtist: unable to upload vertices: %s",
-                       error->message);
-            g_error_free(error);
-        }
+    if (!artist->glyphs || artist->pixel_width == 0
+        || artist->pixel_height == 0)
+        return;
+
+    // Adding glyphs may repack the atlas, so look them up afterwards.
+    text_artist_ensure_glyphs(artist, atlas);
+
+    gfloat size[2] = {psy_rectangle_get_width(PSY_RECTANGLE(text)),
+                      psy_rectangle_get_height(PSY_RECTANGLE(text))};
+    psy_artist_fill_instance(self, 1, 1, &base);
+
+    g_array_set_size(artist->instances, 0);
+
+    if (psy_texture_atlas_lookup(atlas, SOLID_NAME, tex_rect))
+        text_artist_add_instance(artist,
+                                 base.model,
+                                 size,
+                                 0,
+                                 0,
+                                 (gint) artist->pixel_width,
+                                 (gint) artist->pixel_height,
+                                 base.color,
+                                 tex_rect);
+
+    for (guint i = 0; i < artist->glyphs->len; i++) {
+        PsyTextGlyph *glyph = &g_array_index(artist->glyphs, PsyTextGlyph, i);
+        if (!psy_texture_atlas_lookup(atlas, glyph->name, tex_rect))
+            continue;
+        text_artist_add_instance(artist,
+                                 base.model,
+                                 size,
+                                 glyph->x,
+                                 glyph->y,
+                                 glyph->width,
+                                 glyph->height,
+                                 glyph->color,
+                                 tex_rect);
     }
-    psy_vbuffer_draw_triangle_fan(artist->vertices, &error);
+
+    psy_shader_program_use(program, &error);
+    if (!error)
+        psy_texture_bind(psy_texture_atlas_get_texture(atlas), &error);
+    if (!error)
+        psy_vbuffer_draw_triangle_fan_instanced(
+            mesh,
+            (const PsyVBufferInstance *) artist->instances->data,
+            artist->instances->len,
+            &error);
     if (error) {
-        g_critical("PsyTextArtist: unable to draw triangle_fan: %s",
+        g_critical("PsyTextArtist: unable to draw the glyphs: %s",
                    error->message);
         g_error_free(error);
     }
@@ -162,11 +233,11 @@ psy_text_artist_class_init(PsyTextArtistClass *class)
     GObjectClass   *gobject_class = G_OBJECT_CLASS(class);
     PsyArtistClass *artist_class  = PSY_ARTIST_CLASS(class);
 
-    gobject_class->dispose     = psy_text_artist_dispose;
-    gobject_class->constructed = psy_text_artist_constructed;
+    gobject_class->finalize = psy_text_artist_finalize;
 
-    artist_class->draw        = text_artist_draw;
-    artist_class->get_program = text_artist_get_program;
+    artist_class->draw           = text_artist_draw;
+    artist_class->get_program    = text_artist_get_program;
+    artist_class->is_translucent = text_artist_is_translucent;
 }
 
 /* ************ public functions ******************** */
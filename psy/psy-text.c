@@ -1,6 +1,9 @@
 
 
 #include <math.h>
+#include <string.h>
+
+#include <gio/gio.h>
 #include <pango/pango.h>
 #include <pango/pangocairo.h>
 
@@ -28,6 +31,13 @@
  * The font color will be used by default when drawing and laying out the
  * text on the rectangle, the fontcolor may also be adapted by using the
  * pango markup language see: https://docs.gtk.org/Pango/pango_markup.html
+ *
+ * The glyphs of the text are shaped and rasterized on a worker thread as soon
+ * as the content, font or size changes, so that they are usually ready
+ * before the text is drawn for the first time. Use
+ * [method@Text.is_render_ready], [method@Text.wait_render_ready] or the
+ * [signal@Text::render-ready] signal in order to make sure the text doesn't
+ * need to be prepared while its first frame is rendered.
  */
 
 // Using PangoCairo, you create a context for a specific `cairo_t* cr`;
@@ -39,6 +49,17 @@ typedef struct _PsyTextPrivate {
     PsyColor             *font_color;       // the default color of the font.
     PangoFontDescription *font_description; // A description of the font.
     gboolean is_dirty; // whether or not the image should be uploaded.
+
+    GMutex   lock;           // protects the members below
+    GCond    cond;           // signalled when glyphs are stored
+    guint64  serial;         // incremented for each change of the glyphs
+    guint64  ready_serial;   // the serial of the glyphs below
+    guint64  emitted_serial; // the serial for which render-ready was emitted
+    gboolean in_flight;      // whether a worker is preparing glyphs
+    gboolean constructed;    // glyphs are only prepared once constructed
+    GArray  *glyphs;         // the prepared PsyTextGlyph's
+    guint    glyphs_width;   // the width of the layout of the glyphs
+    guint    glyphs_height;  // the height of the layout of the glyphs
 } PsyTextPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(PsyText, psy_text, PSY_TYPE_RECTANGLE)
@@ -56,6 +77,16 @@ typedef enum {
 
 static GParamSpec *text_properties[NUM_PROPERTIES] = {0};
 
+typedef enum { RENDER_READY, NUM_SIGNALS } TextSignal;
+
+static guint text_signals[NUM_SIGNALS];
+
+static void
+text_invalidate(PsyText *self);
+
+static void
+text_schedule_prepare(PsyText *self);
+
 static void
 text_set_property(GObject      *object,
                   guint         property_id,
@@ -123,6 +154,38 @@ psy_text_init(PsyText *self)
     priv->font_description = pango_font_description_from_string("Sans 25pt");
     priv->is_dirty         = TRUE;
     priv->use_markup       = FALSE;
+    priv->serial           = 1;
+
+    g_mutex_init(&priv->lock);
+    g_cond_init(&priv->cond);
+}
+
+static void
+text_constructed(GObject *object)
+{
+    PsyText        *self = PSY_TEXT(object);
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    G_OBJECT_CLASS(psy_text_parent_class)->constructed(object);
+
+    priv->constructed = TRUE;
+    text_schedule_prepare(self);
+}
+
+static void
+text_finalize(GObject *object)
+{
+    PsyText        *self = PSY_TEXT(object);
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    g_clear_pointer(&priv->content, g_free);
+    g_clear_object(&priv->font_color);
+    g_clear_pointer(&priv->font_description, pango_font_description_free);
+    g_clear_pointer(&priv->glyphs, g_array_unref);
+    g_mutex_clear(&priv->lock);
+    g_cond_clear(&priv->cond);
+
+    G_OBJECT_CLASS(psy_text_parent_class)->finalize(object);
 }
 
 static PsyArtist *
@@ -148,25 +211,25 @@ text_set_color(PsyVisualStimulus *stimulus, PsyColor *color)
 static void
 text_set_width(PsyRectangle *rect, gfloat width)
 {
-    PsyText        *self = PSY_TEXT(rect);
-    PsyTextPrivate *priv = psy_text_get_instance_private(self);
-
-    if (width != psy_rectangle_get_width(rect))
-        priv->is_dirty = TRUE;
+    PsyText *self    = PSY_TEXT(rect);
+    gboolean changed = width != psy_rectangle_get_width(rect);
 
     PSY_RECTANGLE_CLASS(psy_text_parent_class)->set_width(rect, width);
+
+    if (changed)
+        text_invalidate(self);
 }
 
 static void
 text_set_height(PsyRectangle *rect, gfloat height)
 {
-    PsyText        *self = PSY_TEXT(rect);
-    PsyTextPrivate *priv = psy_text_get_instance_private(self);
-
-    if (height != psy_rectangle_get_height(rect))
-        priv->is_dirty = TRUE;
+    PsyText *self    = PSY_TEXT(rect);
+    gboolean changed = height != psy_rectangle_get_height(rect);
 
     PSY_RECTANGLE_CLASS(psy_text_parent_class)->set_height(rect, height);
+
+    if (changed)
+        text_invalidate(self);
 }
 
 static void
@@ -175,6 +238,8 @@ psy_text_class_init(PsyTextClass *klass)
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
     object_class->get_property = text_get_property;
     object_class->set_property = text_set_property;
+    object_class->constructed  = text_constructed;
+    object_class->finalize     = text_finalize;
 
     PsyVisualStimulusClass *vstim_cls = PSY_VISUAL_STIMULUS_CLASS(klass);
     vstim_cls->create_artist          = text_create_artist;
@@ -262,6 +327,24 @@ psy_text_class_init(PsyTextClass *klass)
 
     g_object_class_install_properties(
         object_class, NUM_PROPERTIES, text_properties);
+
+    /**
+     * PsyText::render-ready:
+     * @self: the instance of [class@Text] that is ready
+     *
+     * Emitted in the main context when the glyphs of the current content of
+     * the text have been prepared, hence the text may be drawn without
+     * shaping or rasterizing it in the frame in which it is presented.
+     */
+    text_signals[RENDER_READY] = g_signal_new("render-ready",
+                                              G_TYPE_FROM_CLASS(klass),
+                                              G_SIGNAL_RUN_LAST,
+                                              0,
+                                              NULL,
+                                              NULL,
+                                              NULL,
+                                              G_TYPE_NONE,
+                                              0);
 }
 
 /**
@@ -352,8 +435,12 @@ psy_text_set_content(PsyText *self, const gchar *content)
 
     PsyTextPrivate *priv = psy_text_get_instance_private(self);
 
+    if (g_strcmp0(priv->content, content) == 0)
+        return;
+
     g_clear_pointer(&priv->content, g_free);
     priv->content = g_strdup(content);
+    text_invalidate(self);
 }
 
 /**
@@ -387,7 +474,11 @@ psy_text_set_use_markup(PsyText *self, gboolean use_markup)
 
     PsyTextPrivate *priv = psy_text_get_instance_private(self);
 
+    if (priv->use_markup == use_markup)
+        return;
+
     priv->use_markup = use_markup;
+    text_invalidate(self);
 }
 
 /**
@@ -421,12 +512,12 @@ psy_text_set_font_color(PsyText *self, PsyColor *font_color)
 
     PsyTextPrivate *priv = psy_text_get_instance_private(self);
 
-    if (psy_color_equal(priv->font_color, font_color)) { // no reason to redraw.
-        priv->is_dirty = TRUE;
-    }
+    gboolean changed = !psy_color_equal(priv->font_color, font_color);
 
-    g_clear_object(&priv->font_color);
-    priv->font_color = g_object_ref(font_color);
+    g_set_object(&priv->font_color, font_color);
+
+    if (changed)
+        text_invalidate(self);
 }
 
 /**
@@ -513,7 +604,7 @@ psy_text_set_font_family(PsyText *self, const gchar *font_fam)
     PsyTextPrivate *priv = psy_text_get_instance_private(self);
 
     pango_font_description_set_family(priv->font_description, font_fam);
-    priv->is_dirty = TRUE;
+    text_invalidate(self);
 }
 
 const gchar *
@@ -567,12 +658,8 @@ psy_text_draw_stimulus(PsyText *text, PsyImage *img)
     context = pango_layout_get_context(layout);
 
     pango_context_set_base_gravity(context, PANGO_GRAVITY_AUTO);
-    g_print("width = %d    height = %d\n", width, height);
     pango_layout_set_width(layout, width * PANGO_SCALE);
     pango_layout_set_height(layout, height * PANGO_SCALE);
-    g_print("width = %d    height = %d\n",
-            pango_layout_get_width(layout),
-            pango_layout_get_height(layout));
 
     pango_layout_set_font_description(layout,
                                       psy_text_get_font_description(text));
@@ -619,23 +706,22 @@ psy_text_draw_stimulus(PsyText *text, PsyImage *img)
 }
 
 /**
- * psy_text_create_stimulus:
- * @self: An instance of[class@Text]
+ * psy_text_get_pixel_size:(skip)
+ * @self: an instance of [class@Text]
+ * @width:(out): the width of the text box in pixels
+ * @height:(out): the height of the text box in pixels
  *
- * This creates an image of the stimulus. This function is used by the
- * PsyTextArtist in order to have a picture to draw as [class@Psy.Texture]
- * You may find it handy to save the resulting images to files. Then the
- * files can be loaded as an instance of [class@Image]. You should take care,
- * that the pixel format of these stimuli is CAIRO_ARGB.
+ * Computes the size in pixels of the rectangle in which the text is laid
+ * out, from the size of the rectangle in the units of the canvas.
  *
- * Returns:(transfer full): an image that represents the text.
+ * Stability: private
+ * Returns: TRUE when the size is valid, FALSE otherwise
  */
-PsyImage *
-psy_text_create_stimulus(PsyText *self)
+gboolean
+psy_text_get_pixel_size(PsyText *self, guint *width, guint *height)
 {
-    g_return_val_if_fail(PSY_IS_TEXT(self), NULL);
-
-    PsyImage *img = NULL;
+    g_return_val_if_fail(PSY_IS_TEXT(self), FALSE);
+    g_return_val_if_fail(width && height, FALSE);
 
     gfloat rect_width  = psy_rectangle_get_width(PSY_RECTANGLE(self));
     gfloat rect_height = psy_rectangle_get_height(PSY_RECTANGLE(self));
@@ -682,11 +768,507 @@ psy_text_create_stimulus(PsyText *self)
     if (img_width < 0 || img_height < 0) {
         g_critical(
             "creating an image with dimensions %d * %d", img_width, img_height);
+        return FALSE;
+    }
+
+    *width  = (guint) img_width;
+    *height = (guint) img_height;
+    return TRUE;
+}
+
+/* ************ preparing the glyphs ******************** */
+
+/*
+ * A snapshot of everything that determines the glyphs of a text, so the
+ * glyphs can be prepared on another thread, while the text may change.
+ */
+typedef struct PrepareJob {
+    guint64               serial;
+    gchar                *content;
+    gboolean              use_markup;
+    PangoFontDescription *font_description;
+    gfloat                font_color[4];
+    guint                 width, height;
+} PrepareJob;
+
+static PrepareJob *
+prepare_job_new(PsyText *self)
+{
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+    guint           width, height;
+
+    if (!psy_visual_stimulus_get_canvas(PSY_VISUAL_STIMULUS(self))
+        || !psy_text_get_pixel_size(self, &width, &height))
         return NULL;
+
+    PrepareJob *job = g_new0(PrepareJob, 1);
+
+    g_mutex_lock(&priv->lock);
+    job->serial = priv->serial;
+    g_mutex_unlock(&priv->lock);
+
+    job->content          = g_strdup(priv->content ? priv->content : "");
+    job->use_markup       = priv->use_markup;
+    job->font_description = pango_font_description_copy(priv->font_description);
+    job->width            = width;
+    job->height           = height;
+    memcpy(job->font_color,
+           psy_color_get_rgba_values(priv->font_color),
+           sizeof(job->font_color));
+
+    return job;
+}
+
+static void
+prepare_job_free(PrepareJob *job)
+{
+    g_free(job->content);
+    pango_font_description_free(job->font_description);
+    g_free(job);
+}
+
+static void
+text_glyph_clear(gpointer data)
+{
+    PsyTextGlyph *glyph = data;
+    g_free(glyph->name);
+    g_clear_object(&glyph->image);
+}
+
+/*
+ * Obtains the foreground color of a run, which is either specified by markup
+ * or the font color of the text.
+ */
+static void
+run_get_color(PangoGlyphItem *run, const gfloat font_color[4], gfloat color[4])
+{
+    memcpy(color, font_color, sizeof(gfloat) * 4);
+
+    for (GSList *l = run->item->analysis.extra_attrs; l; l = l->next) {
+        PangoAttribute *attr = l->data;
+        if (attr->klass->type == PANGO_ATTR_FOREGROUND) {
+            PangoColor *c = &((PangoAttrColor *) attr)->color;
+            color[0]      = c->red / 65535.0f;
+            color[1]      = c->green / 65535.0f;
+            color[2]      = c->blue / 65535.0f;
+        }
+        else if (attr->klass->type == PANGO_ATTR_FOREGROUND_ALPHA) {
+            color[3] = ((PangoAttrInt *) attr)->value / 65535.0f;
+        }
     }
+}
+
+/*
+ * Renders a single white glyph, its coverage ends up in the alpha channel.
+ * left and top are the offset of the box of glyph relative to its origin.
+ */
+static PsyImage *
+rasterize_glyph(PangoFont *font, PangoGlyph glyph, PsyTextGlyph *box)
+{
+    gint left = box->x, top = box->y; // still relative to the origin here
+
+    cairo_surface_t *surf
+        = cairo_image_surface_create(CAIRO_FORMAT_A8, box->width, box->height);
+    cairo_t *cr = cairo_create(surf);
+
+    PangoGlyphString *string = pango_glyph_string_new();
+    pango_glyph_string_set_size(string, 1);
+    string->glyphs[0].glyph = glyph;
+    memset(&string->glyphs[0].geometry, 0, sizeof(PangoGlyphGeometry));
+    string->glyphs[0].attr.is_cluster_start = 1;
+
+    // Place the origin of the glyph such that its ink is inside the surface.
+    cairo_move_to(cr, -left, -top);
+    pango_cairo_show_glyph_string(cr, font, string);
+    cairo_surface_flush(surf);
+
+    PsyImage *image
+        = psy_image_new(box->width, box->height, PSY_IMAGE_FORMAT_RGBA);
+    const guint8 *surf_data = cairo_image_surface_get_data(surf);
+    guint8       *img_data  = psy_image_get_ptr(image);
+
+    for (gint r = 0; r < box->height; r++) {
+        const guint8 *in_row
+            = surf_data + r * cairo_image_surface_get_stride(surf);
+        guint8 *out_row = img_data + r * psy_image_get_stride(image);
+        for (gint c = 0; c < box->width; c++) {
+            guint8 *opix = out_row + c * 4;
+            opix[0] = opix[1] = opix[2] = 255;
+            opix[3]                     = in_row[c];
+        }
+    }
+
+    pango_glyph_string_free(string);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surf);
+
+    return image;
+}
+
+/*
+ * Shapes the content of job and rasterizes each distinct glyph once. This
+ * doesn't touch the PsyText, so it may run on any thread. Pango creates a
+ * cairo font map per thread.
+ */
+static GArray *
+prepare_glyphs(PrepareJob *job)
+{
+    GArray *glyphs = g_array_new(FALSE, TRUE, sizeof(PsyTextGlyph));
+    g_array_set_clear_func(glyphs, text_glyph_clear);
+
+    // The glyphs that have been rasterized for this text.
+    GHashTable *images
+        = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    PangoContext *context
+        = pango_font_map_create_context(pango_cairo_font_map_get_default());
+    pango_context_set_base_gravity(context, PANGO_GRAVITY_AUTO);
+
+    PangoLayout *layout = pango_layout_new(context);
+    pango_layout_set_width(layout, (gint) job->width * PANGO_SCALE);
+    pango_layout_set_height(layout, (gint) job->height * PANGO_SCALE);
+    pango_layout_set_font_description(layout, job->font_description);
+    if (job->use_markup)
+        pango_layout_set_markup(layout, job->content, -1);
+    else
+        pango_layout_set_text(layout, job->content, -1);
+
+    PangoLayoutIter *iter = pango_layout_get_iter(layout);
+
+    do {
+        PangoGlyphItem *run = pango_layout_iter_get_run_readonly(iter);
+        if (!run)
+            continue; // the end of a line
+
+        PangoRectangle run_rect;
+        pango_layout_iter_get_run_extents(iter, NULL, &run_rect);
+        gint baseline = pango_layout_iter_get_baseline(iter);
+
+        PangoFont            *font = run->item->analysis.font;
+        PangoFontDescription *desc
+            = pango_font_describe_with_absolute_size(font);
+        gchar *font_name = pango_font_description_to_string(desc);
+        pango_font_description_free(desc);
+
+        gfloat color[4];
+        run_get_color(run, job->font_color, color);
+
+        gint pen_x = run_rect.x;
+        for (gint i = 0; i < run->glyphs->num_glyphs; i++) {
+            PangoGlyphInfo *info = &run->glyphs->glyphs[i];
+            PangoRectangle  ink;
+
+            gint x = pen_x + info->geometry.x_offset;
+            gint y = baseline + info->geometry.y_offset;
+            pen_x += info->geometry.width;
+
+            if (info->glyph == PANGO_GLYPH_EMPTY)
+                continue;
+
+            pango_font_get_glyph_extents(font, info->glyph, &ink, NULL);
+            if (ink.width <= 0 || ink.height <= 0)
+                continue;
+
+            // The pixel box of the glyph relative to its origin, with a pixel
+            // of margin for the anti aliased edges.
+            gint left   = (gint) floor((double) ink.x / PANGO_SCALE) - 1;
+            gint top    = (gint) floor((double) ink.y / PANGO_SCALE) - 1;
+            gint right  = PANGO_PIXELS_CEIL(ink.x + ink.width);
+            gint bottom = PANGO_PIXELS_CEIL(ink.y + ink.height);
+
+            PsyTextGlyph glyph = {
+                .name   = g_strdup_printf("%s/%u", font_name, info->glyph),
+                .x      = left,
+                .y      = top,
+                .width  = right - left + 1,
+                .height = bottom - top + 1,
+            };
+            memcpy(glyph.color, color, sizeof(color));
+
+            PsyImage *image = g_hash_table_lookup(images, glyph.name);
+            if (!image) {
+                image = rasterize_glyph(font, info->glyph, &glyph);
+                g_hash_table_insert(images, g_strdup(glyph.name), image);
+            }
+            glyph.image = g_object_ref(image);
+
+            // Relative to the left top of the layout from here.
+            glyph.x += PANGO_PIXELS(x);
+            glyph.y += PANGO_PIXELS(y);
+
+            g_array_append_val(glyphs, glyph);
+        }
+        g_free(font_name);
+    } while (pango_layout_iter_next_run(iter));
+
+    pango_layout_iter_free(iter);
+    g_object_unref(layout);
+    g_object_unref(context);
+
+    // The glyphs hold a reference to their image.
+    GHashTableIter hiter;
+    gpointer       image;
+    g_hash_table_iter_init(&hiter, images);
+    while (g_hash_table_iter_next(&hiter, NULL, &image))
+        g_object_unref(image);
+    g_hash_table_destroy(images);
+
+    return glyphs;
+}
+
+/*
+ * Installs glyphs unless newer glyphs have been installed, the lock must be
+ * held.
+ */
+static void
+text_store_glyphs(PsyTextPrivate *priv, PrepareJob *job, GArray *glyphs)
+{
+    if (job->serial > priv->ready_serial) {
+        g_clear_pointer(&priv->glyphs, g_array_unref);
+        priv->glyphs        = glyphs;
+        priv->glyphs_width  = job->width;
+        priv->glyphs_height = job->height;
+        priv->ready_serial  = job->serial;
+        g_cond_broadcast(&priv->cond);
+    }
+    else {
+        g_array_unref(glyphs);
+    }
+}
+
+static void
+text_emit_render_ready(PsyText *self)
+{
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+    gboolean        emit = FALSE;
+
+    g_mutex_lock(&priv->lock);
+    if (priv->ready_serial == priv->serial
+        && priv->emitted_serial != priv->serial) {
+        priv->emitted_serial = priv->serial;
+        emit                 = TRUE;
+    }
+    g_mutex_unlock(&priv->lock);
+
+    if (emit)
+        g_signal_emit(self, text_signals[RENDER_READY], 0);
+}
+
+static void
+text_prepare_thread(GTask        *task,
+                    gpointer      source,
+                    gpointer      data,
+                    GCancellable *cancellable)
+{
+    PsyTextPrivate *priv = psy_text_get_instance_private(PSY_TEXT(source));
+    PrepareJob     *job  = data;
+    (void) cancellable;
+
+    GArray *glyphs = prepare_glyphs(job);
+
+    g_mutex_lock(&priv->lock);
+    text_store_glyphs(priv, job, glyphs);
+    priv->in_flight = FALSE;
+    g_cond_broadcast(&priv->cond);
+    g_mutex_unlock(&priv->lock);
+
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+text_prepare_done(GObject *source, GAsyncResult *result, gpointer data)
+{
+    PsyText        *self = PSY_TEXT(source);
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+    (void) result;
+    (void) data;
+
+    g_mutex_lock(&priv->lock);
+    gboolean outdated = priv->ready_serial != priv->serial;
+    g_mutex_unlock(&priv->lock);
+
+    // The text changed while it was prepared.
+    if (outdated)
+        text_schedule_prepare(self);
+    else
+        text_emit_render_ready(self);
+}
+
+/*
+ * Starts preparing the glyphs on a worker thread, unless that is already
+ * happening; the changes made in the mean time are prepared afterwards.
+ */
+static void
+text_schedule_prepare(PsyText *self)
+{
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    if (!priv->constructed)
+        return;
+
+    g_mutex_lock(&priv->lock);
+    gboolean busy = priv->in_flight || priv->ready_serial == priv->serial;
+    g_mutex_unlock(&priv->lock);
+    if (busy)
+        return;
+
+    PrepareJob *job = prepare_job_new(self);
+    if (!job)
+        return;
+
+    g_mutex_lock(&priv->lock);
+    priv->in_flight = TRUE;
+    g_mutex_unlock(&priv->lock);
+
+    GTask *task = g_task_new(self, NULL, text_prepare_done, NULL);
+    g_task_set_source_tag(task, text_schedule_prepare);
+    g_task_set_task_data(task, job, (GDestroyNotify) prepare_job_free);
+    g_task_run_in_thread(task, text_prepare_thread);
+    g_object_unref(task);
+}
+
+/*
+ * Called when something changed that affects the glyphs.
+ */
+static void
+text_invalidate(PsyText *self)
+{
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    priv->is_dirty = TRUE;
+
+    g_mutex_lock(&priv->lock);
+    priv->serial++;
+    g_mutex_unlock(&priv->lock);
+
+    text_schedule_prepare(self);
+}
+
+/**
+ * psy_text_is_render_ready:
+ * @self: an instance of [class@Text]
+ *
+ * Returns: TRUE when the glyphs of the current content of @self have been
+ *          prepared, FALSE otherwise.
+ */
+gboolean
+psy_text_is_render_ready(PsyText *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXT(self), FALSE);
+
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    g_mutex_lock(&priv->lock);
+    gboolean ready = priv->ready_serial == priv->serial;
+    g_mutex_unlock(&priv->lock);
+
+    return ready;
+}
+
+/**
+ * psy_text_wait_render_ready:
+ * @self: an instance of [class@Text]
+ *
+ * Waits until the glyphs of the current content of @self have been prepared.
+ * When no worker is preparing them, they are prepared by the calling thread.
+ * Call this e.g. before scheduling a text with [method@Stimulus.play], so
+ * that it is drawn without delay in its first frame.
+ *
+ * Returns: TRUE when @self is ready to be drawn, FALSE when the size of the
+ *          text is invalid.
+ */
+gboolean
+psy_text_wait_render_ready(PsyText *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXT(self), FALSE);
+
+    PsyTextPrivate *priv = psy_text_get_instance_private(self);
+
+    g_mutex_lock(&priv->lock);
+    while (priv->ready_serial != priv->serial) {
+        if (priv->in_flight) {
+            g_cond_wait(&priv->cond, &priv->lock);
+            continue;
+        }
+        g_mutex_unlock(&priv->lock);
+
+        PrepareJob *job = prepare_job_new(self);
+        if (!job)
+            return FALSE;
+        GArray *glyphs = prepare_glyphs(job);
+
+        g_mutex_lock(&priv->lock);
+        text_store_glyphs(priv, job, glyphs);
+        prepare_job_free(job);
+    }
+    g_mutex_unlock(&priv->lock);
+
+    text_emit_render_ready(self);
+    return TRUE;
+}
+
+/**
+ * psy_text_get_glyphs:(skip)
+ * @self: an instance of [class@Text]
+ * @width:(out): the width in pixels of the box in which the glyphs are laid
+ *         out
+ * @height:(out): the height in pixels of the box in which the glyphs are
+ *          laid out
+ *
+ * Obtains the prepared glyphs of the current content, waiting for them when
+ * necessary. This is used by [class@TextArtist].
+ *
+ * Stability: private
+ * Returns:(transfer full)(nullable): An array of PsyTextGlyph, or NULL when
+ *         the size of the text is invalid.
+ */
+GArray *
+psy_text_get_glyphs(PsyText *self, guint *width, guint *height)
+{
+    g_return_val_if_fail(PSY_IS_TEXT(self), NULL);
+    g_return_val_if_fail(width && height, NULL);
+
+    PsyTextPrivate *priv   = psy_text_get_instance_private(self);
+    GArray         *glyphs = NULL;
+
+    if (!psy_text_wait_render_ready(self))
+        return NULL;
+
+    g_mutex_lock(&priv->lock);
+    if (priv->glyphs) {
+        glyphs  = g_array_ref(priv->glyphs);
+        *width  = priv->glyphs_width;
+        *height = priv->glyphs_height;
+    }
+    g_mutex_unlock(&priv->lock);
+
+    return glyphs;
+}
+
+/**
+ * psy_text_create_stimulus:
+ * @self: An instance of[class@Text]
+ *
+ * This creates an image of the stimulus. This function is used by the
+ * PsyTextArtist in order to have a picture to draw as [class@Psy.Texture]
+ * You may find it handy to save the resulting images to files. Then the
+ * files can be loaded as an instance of [class@Image]. You should take care,
+ * that the pixel format of these stimuli is CAIRO_ARGB.
+ *
+ * Returns:(transfer full): an image that represents the text.
+ */
+PsyImage *
+psy_text_create_stimulus(PsyText *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXT(self), NULL);
+
+    PsyImage *img = NULL;
+
+    guint img_width, img_height;
+    if (!psy_text_get_pixel_size(self, &img_width, &img_height))
+        return NULL;
 
-    img = psy_image_new(
-        (guint) img_width, (guint) img_height, PSY_IMAGE_FORMAT_RGBA);
+    img = psy_image_new(img_width, img_height, PSY_IMAGE_FORMAT_RGBA);
 
     psy_text_draw_stimulus(self, img);
 
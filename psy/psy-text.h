@@ -24,6 +24,27 @@ typedef struct _PsyTextClass {
     gpointer reserved[16];
 } PsyTextClass;
 
+/**
+ * PsyTextGlyph:(skip)
+ * @name: identifies the rasterized glyph, equal glyphs have an equal name
+ * @image: the white glyph, its coverage is in the alpha channel
+ * @x: the left of the glyph in pixels relative to the left of the layout
+ * @y: the top of the glyph in pixels relative to the top of the layout
+ * @width: the width of @image
+ * @height: the height of @image
+ * @color: the rgba color of the glyph
+ *
+ * A glyph of a [class@Text] as it is prepared for drawing.
+ *
+ * Stability: private
+ */
+typedef struct PsyTextGlyph {
+    gchar    *name;
+    PsyImage *image;
+    gint      x, y, width, height;
+    gfloat    color[4];
+} PsyTextGlyph;
+
 G_MODULE_EXPORT PsyText *
 psy_text_new(PsyCanvas *canvas);
 
@@ -75,4 +96,16 @@ psy_text_set_is_dirty(PsyText *self, gboolean dirty);
 PangoFontDescription *
 psy_text_get_font_description(PsyText *self);
 
+gboolean
+psy_text_get_pixel_size(PsyText *self, guint *width, guint *height);
+
+G_MODULE_EXPORT gboolean
+psy_text_is_render_ready(PsyText *self);
+
+G_MODULE_EXPORT gboolean
+psy_text_wait_render_ready(PsyText *self);
+
+GArray *
+psy_text_get_glyphs(PsyText *self, guint *width, guint *height);
+
 G_END_DECLS
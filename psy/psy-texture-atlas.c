@@ -0,0 +1,865 @@
+
+#include <string.h>
+
+#include "psy-enums.h"
+#include "psy-texture-atlas.h"
+
+/**
+ * PsyTextureAtlas:
+ *
+ * A PsyTextureAtlas packs many small images into one large [class@Texture].
+ * Pictures that live in the same atlas can be drawn with one instanced draw
+ * call, because they don't need to bind a texture of their own. Every image
+ * is stored under a name, e.g. the filename of a picture, and
+ * [method@TextureAtlas.lookup] returns the part of the atlas texture that
+ * holds it, in texture coordinates.
+ *
+ * The images are placed using a skyline bottom left packer. Every image is
+ * surrounded by a border of a few pixels in which the edges of the image are
+ * repeated, so that filtering doesn't bleed neighbouring images into each
+ * other. When a new image doesn't fit anymore, the atlas is repacked from
+ * scratch, and if that doesn't help, the images that haven't been looked up
+ * for the longest time are evicted until the new image fits.
+ *
+ * Adding an image may upload (a part of) the texture, so the drawing backend
+ * should be current. Since repacking moves the images around, don't add
+ * images while a frame is being drawn; [class@DrawingContext] adds images
+ * when they are registered as textures.
+ */
+
+#define ATLAS_PADDING 2
+#define ATLAS_BPP     4
+
+typedef struct AtlasEntry {
+    gchar  *name;
+    guint   x, y; // top left of the image, excluding the padding
+    guint   width, height;
+    guint64 last_used;
+} AtlasEntry;
+
+typedef struct SkylineNode {
+    guint x, y, width;
+} SkylineNode;
+
+typedef struct _PsyTextureAtlas {
+    GObject     parent;
+    PsyTexture *texture;
+    PsyImage   *pixels; // A copy of the texture in main memory
+    guint       width, height;
+    GHashTable *entries;
+    GArray     *skyline;
+    guint64     clock;
+} PsyTextureAtlas;
+
+G_DEFINE_FINAL_TYPE(PsyTextureAtlas, psy_texture_atlas, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_TEXTURE,
+    PROP_WIDTH,
+    PROP_HEIGHT,
+    PROP_NUM_ENTRIES,
+    NUM_PROPERTIES
+} PsyTextureAtlasProperty;
+
+static GParamSpec *atlas_properties[NUM_PROPERTIES];
+
+static void
+atlas_entry_free(gpointer data)
+{
+    AtlasEntry *entry = data;
+    g_free(entry->name);
+    g_free(entry);
+}
+
+/* ************ skyline packing ************ */
+
+static void
+skyline_reset(GArray *skyline, guint width)
+{
+    SkylineNode node = {.x = 0, .y = 0, .width = width};
+    g_array_set_size(skyline, 0);
+    g_array_append_val(skyline, node);
+}
+
+/*
+ * Returns whether a rectangle of width * height fits with its left side at
+ * the start of the node at index. The lowest possible top is returned in y.
+ */
+static gboolean
+skyline_fits(GArray *skyline,
+             guint   index,
+             guint   width,
+             guint   height,
+             guint   atlas_width,
+             guint   atlas_height,
+             guint  *y)
+{
+    SkylineNode *node = &g_array_index(skyline, SkylineNode, index);
+    if (node->x + width > atlas_width)
+        return FALSE;
+
+    guint top        = node->y;
+    guint width_left = width;
+
+    for (guint i = index; width_left > 0; i++) {
+        if (i >= skyline->len)
+            return FALSE;
+        node = &g_array_index(skyline, SkylineNode, i);
+        top  = MAX(top, node->y);
+        if (top + height > atlas_height)
+            return FALSE;
+        width_left -= MIN(width_left, node->width);
+    }
+
+    *y = top;
+    return TRUE;
+}
+
+/*
+ * Finds the place where the bottom of the rectangle would be as low as
+ * possible (the lowest y in image coordinates), and adds the rectangle to
+ * the skyline.
+ */
+static gboolean
+skyline_add(GArray *skyline,
+            guint   width,
+            guint   height,
+            guint   atlas_width,
+            guint   atlas_height,
+            guint  *x,
+            guint  *y)
+{
+    guint best_index = G_MAXUINT, best_bottom = G_MAXUINT;
+    guint best_width = G_MAXUINT, best_y = 0;
+
+    for (guint i = 0; i < skyline->len; i++) {
+        guint        top;
+        SkylineNode *node = &g_array_index(skyline, SkylineNode, i);
+        if (!skyline_fits(
+                skyline, i, width, height, atlas_width, atlas_height, &top))
+            continue;
+
+        if (top + height < best_bottom
+            || (top + height == best_bottom && node->width < best_width)) {
+            best_index  = i;
+            best_bottom = top + height;
+            best_width  = node->width;
+            best_y      = top;
+        }
+    }
+
+    if (best_index == G_MAXUINT)
+        return FALSE;
+
+    SkylineNode new_node = {
+        .x     = g_array_index(skyline, SkylineNode, best_index).x,
+        .y     = best_y + height,
+        .width = width,
+    };
+    g_array_insert_val(skyline, best_index, new_node);
+
+    // Shrink or remove the nodes that are now covered by the new node.
+    for (guint i = best_index + 1; i < skyline->len;) {
+        SkylineNode *prev  = &g_array_index(skyline, SkylineNode, i - 1);
+        SkylineNode *node  = &g_array_index(skyline, SkylineNode, i);
+        guint        right = prev->x + prev->width;
+
+        if (node->x >= right)
+            break;
+
+        guint shrink = right - node->x;
+        if (node->width <= shrink) {
+            g_array_remove_index(skyline, i);
+            continue;
+        }
+        node->x += shrink;
+        node->width -= shrink;
+        break;
+    }
+
+    // Merge neighbours at the same height.
+    for (guint i = 0; i + 1 < skyline->len;) {
+        SkylineNode *node = &g_array_index(skyline, SkylineNode, i);
+        SkylineNode *next = &g_array_index(skyline, SkylineNode, i + 1);
+        if (node->y == next->y) {
+            node->width += next->width;
+            g_array_remove_index(skyline, i + 1);
+            continue;
+        }
+        i++;
+    }
+
+    *x = new_node.x;
+    *y = best_y;
+    return TRUE;
+}
+
+/* ************ pixel management ************ */
+
+/*
+ * Repeats the outer pixels of the image at x, y into the padding around it.
+ */
+static void
+atlas_extrude(PsyTextureAtlas *self, guint x, guint y, guint w, guint h)
+{
+    guint8 *data   = psy_image_get_ptr(self->pixels);
+    guint   stride = psy_image_get_stride(self->pixels);
+
+    for (guint row = y; row < y + h; row++) {
+        guint8 *line = data + row * stride;
+        for (guint p = 1; p <= ATLAS_PADDING; p++) {
+            memcpy(line + (x - p) * ATLAS_BPP, line + x * ATLAS_BPP, ATLAS_BPP);
+            memcpy(line + (x + w - 1 + p) * ATLAS_BPP,
+                   line + (x + w - 1) * ATLAS_BPP,
+                   ATLAS_BPP);
+        }
+    }
+
+    guint8 *top    = data + y * stride + (x - ATLAS_PADDING) * ATLAS_BPP;
+    guint8 *bottom = top + (h - 1) * stride;
+    gsize   nbytes = (w + 2 * ATLAS_PADDING) * ATLAS_BPP;
+
+    for (guint p = 1; p <= ATLAS_PADDING; p++) {
+        memcpy(top - p * stride, top, nbytes);
+        memcpy(bottom + p * stride, bottom, nbytes);
+    }
+}
+
+static void
+atlas_blit(PsyTextureAtlas *self,
+           AtlasEntry      *entry,
+           const guint8    *source,
+           guint            source_stride)
+{
+    guint8 *data   = psy_image_get_ptr(self->pixels);
+    guint   stride = psy_image_get_stride(self->pixels);
+
+    for (guint row = 0; row < entry->height; row++)
+        memcpy(data + (entry->y + row) * stride + entry->x * ATLAS_BPP,
+               source + row * source_stride,
+               entry->width * ATLAS_BPP);
+
+    atlas_extrude(self, entry->x, entry->y, entry->width, entry->height);
+}
+
+static gboolean
+atlas_upload(PsyTextureAtlas *self, GError **error)
+{
+    GError *local_error = NULL;
+
+    psy_texture_upload_image(self->texture, self->pixels, &local_error);
+    if (local_error) {
+        g_propagate_error(error, local_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Uploads the image of the entry, including its padding, straight from the
+ * pixels of the atlas.
+ */
+static gboolean
+atlas_upload_entry(PsyTextureAtlas *self, AtlasEntry *entry, GError **error)
+{
+    GError *local_error = NULL;
+
+    psy_texture_upload_sub_image(self->texture,
+                                 self->pixels,
+                                 entry->x - ATLAS_PADDING,
+                                 entry->y - ATLAS_PADDING,
+                                 entry->width + 2 * ATLAS_PADDING,
+                                 entry->height + 2 * ATLAS_PADDING,
+                                 &local_error);
+    if (local_error) {
+        g_propagate_error(error, local_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gint
+compare_entry_height(gconstpointer a, gconstpointer b)
+{
+    const AtlasEntry *ea = *(AtlasEntry *const *) a;
+    const AtlasEntry *eb = *(AtlasEntry *const *) b;
+
+    if (ea->height != eb->height)
+        return ea->height > eb->height ? -1 : 1;
+    if (ea->width != eb->width)
+        return ea->width > eb->width ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Packs all entries and incoming from scratch, tallest first. When everything
+ * fits, the pixels of the entries are moved to their new location. Otherwise
+ * the atlas is left untouched and FALSE is returned.
+ */
+static gboolean
+atlas_repack(PsyTextureAtlas *self, AtlasEntry *incoming)
+{
+    GPtrArray *order  = g_ptr_array_new();
+    GArray    *places = g_array_new(FALSE, FALSE, sizeof(guint) * 2);
+    GArray    *skyline
+        = g_array_sized_new(FALSE, FALSE, sizeof(SkylineNode), 16);
+    gboolean       fits = TRUE;
+    GHashTableIter iter;
+    gpointer       value;
+
+    g_hash_table_iter_init(&iter, self->entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        g_ptr_array_add(order, value);
+    g_ptr_array_add(order, incoming);
+    g_ptr_array_sort(order, compare_entry_height);
+
+    skyline_reset(skyline, self->width);
+    g_array_set_size(places, order->len);
+
+    for (guint i = 0; i < order->len && fits; i++) {
+        AtlasEntry *entry = g_ptr_array_index(order, i);
+        guint      *place = &g_array_index(places, guint, i * 2);
+        fits              = skyline_add(skyline,
+                           entry->width + 2 * ATLAS_PADDING,
+                           entry->height + 2 * ATLAS_PADDING,
+                           self->width,
+                           self->height,
+                           &place[0],
+                           &place[1]);
+    }
+
+    if (fits) {
+        gsize   nbytes = psy_image_get_num_bytes(self->pixels);
+        guint   stride = psy_image_get_stride(self->pixels);
+        guint8 *old    = g_malloc(nbytes);
+        memcpy(old, psy_image_get_ptr(self->pixels), nbytes);
+        memset(psy_image_get_ptr(self->pixels), 0, nbytes);
+
+        for (guint i = 0; i < order->len; i++) {
+            AtlasEntry *entry = g_ptr_array_index(order, i);
+            guint      *place = &g_array_index(places, guint, i * 2);
+            guint       old_x = entry->x, old_y = entry->y;
+
+            entry->x = place[0] + ATLAS_PADDING;
+            entry->y = place[1] + ATLAS_PADDING;
+            if (entry != incoming)
+                atlas_blit(self,
+                           entry,
+                           old + old_y * stride + old_x * ATLAS_BPP,
+                           stride);
+        }
+        g_free(old);
+
+        g_array_unref(self->skyline);
+        self->skyline = g_steal_pointer(&skyline);
+    }
+
+    if (skyline)
+        g_array_unref(skyline);
+    g_array_unref(places);
+    g_ptr_array_unref(order);
+    return fits;
+}
+
+static gboolean
+atlas_evict_least_recently_used(PsyTextureAtlas *self)
+{
+    GHashTableIter iter;
+    gpointer       value;
+    AtlasEntry    *oldest = NULL;
+
+    g_hash_table_iter_init(&iter, self->entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        AtlasEntry *entry = value;
+        if (!oldest || entry->last_used < oldest->last_used)
+            oldest = entry;
+    }
+
+    if (!oldest)
+        return FALSE;
+
+    g_debug("Evicting %s from the texture atlas", oldest->name);
+    g_hash_table_remove(self->entries, oldest->name);
+    return TRUE;
+}
+
+static gboolean
+atlas_add_pixels(PsyTextureAtlas *self,
+                 const gchar     *name,
+                 guint            width,
+                 guint            height,
+                 const guint8    *pixels,
+                 guint            stride,
+                 GError         **error)
+{
+    if (g_hash_table_contains(self->entries, name))
+        return TRUE;
+
+    if (width == 0 || height == 0 || width + 2 * ATLAS_PADDING > self->width
+        || height + 2 * ATLAS_PADDING > self->height) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_ATLAS_FULL,
+                    "An image of %u * %u doesn't fit in an atlas of %u * %u",
+                    width,
+                    height,
+                    self->width,
+                    self->height);
+        return FALSE;
+    }
+
+    AtlasEntry *entry = g_new0(AtlasEntry, 1);
+    entry->width      = width;
+    entry->height     = height;
+
+    gboolean full_upload = !psy_texture_is_uploaded(self->texture);
+    guint    x, y;
+
+    if (skyline_add(self->skyline,
+                    width + 2 * ATLAS_PADDING,
+                    height + 2 * ATLAS_PADDING,
+                    self->width,
+                    self->height,
+                    &x,
+                    &y)) {
+        entry->x = x + ATLAS_PADDING;
+        entry->y = y + ATLAS_PADDING;
+    }
+    else {
+        full_upload = TRUE;
+        while (!atlas_repack(self, entry)) {
+            if (!atlas_evict_least_recently_used(self)) {
+                g_set_error(error,
+                            PSY_TEXTURE_ERROR,
+                            PSY_TEXTURE_ERROR_ATLAS_FULL,
+                            "Unable to fit %s in the texture atlas",
+                            name);
+                g_free(entry);
+                return FALSE;
+            }
+        }
+    }
+
+    entry->name      = g_strdup(name);
+    entry->last_used = ++self->clock;
+    g_hash_table_insert(self->entries, entry->name, entry);
+    atlas_blit(self, entry, pixels, stride);
+
+    gboolean uploaded = full_upload ? atlas_upload(self, error)
+                                    : atlas_upload_entry(self, entry, error);
+    if (!uploaded)
+        g_hash_table_remove(self->entries, name);
+
+    return uploaded;
+}
+
+/* ************ GObject ************ */
+
+static void
+psy_texture_atlas_set_property(GObject      *object,
+                               guint         prop_id,
+                               const GValue *value,
+                               GParamSpec   *pspec)
+{
+    PsyTextureAtlas *self = PSY_TEXTURE_ATLAS(object);
+
+    switch ((PsyTextureAtlasProperty) prop_id) {
+    case PROP_TEXTURE:
+        self->texture = g_value_dup_object(value);
+        break;
+    case PROP_WIDTH:
+        self->width = g_value_get_uint(value);
+        break;
+    case PROP_HEIGHT:
+        self->height = g_value_get_uint(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_texture_atlas_get_property(GObject    *object,
+                               guint       prop_id,
+                               GValue     *value,
+                               GParamSpec *pspec)
+{
+    PsyTextureAtlas *self = PSY_TEXTURE_ATLAS(object);
+
+    switch ((PsyTextureAtlasProperty) prop_id) {
+    case PROP_TEXTURE:
+        g_value_set_object(value, self->texture);
+        break;
+    case PROP_WIDTH:
+        g_value_set_uint(value, self->width);
+        break;
+    case PROP_HEIGHT:
+        g_value_set_uint(value, self->height);
+        break;
+    case PROP_NUM_ENTRIES:
+        g_value_set_uint(value, psy_texture_atlas_get_num_entries(self));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_texture_atlas_init(PsyTextureAtlas *self)
+{
+    self->entries = g_hash_table_new_full(
+        g_str_hash, g_str_equal, NULL, atlas_entry_free);
+    self->skyline = g_array_sized_new(FALSE, FALSE, sizeof(SkylineNode), 16);
+}
+
+static void
+psy_texture_atlas_constructed(GObject *object)
+{
+    PsyTextureAtlas *self = PSY_TEXTURE_ATLAS(object);
+
+    G_OBJECT_CLASS(psy_texture_atlas_parent_class)->constructed(object);
+
+    self->pixels
+        = psy_image_new(self->width, self->height, PSY_IMAGE_FORMAT_RGBA);
+    memset(psy_image_get_ptr(self->pixels),
+           0,
+           psy_image_get_num_bytes(self->pixels));
+    skyline_reset(self->skyline, self->width);
+}
+
+static void
+psy_texture_atlas_dispose(GObject *object)
+{
+    PsyTextureAtlas *self = PSY_TEXTURE_ATLAS(object);
+
+    g_clear_object(&self->texture);
+    g_clear_object(&self->pixels);
+
+    G_OBJECT_CLASS(psy_texture_atlas_parent_class)->dispose(object);
+}
+
+static void
+psy_texture_atlas_finalize(GObject *object)
+{
+    PsyTextureAtlas *self = PSY_TEXTURE_ATLAS(object);
+
+    g_hash_table_destroy(self->entries);
+    g_array_unref(self->skyline);
+
+    G_OBJECT_CLASS(psy_texture_atlas_parent_class)->finalize(object);
+}
+
+static void
+psy_texture_atlas_class_init(PsyTextureAtlasClass *klass)
+{
+    GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+    obj_class->set_property = psy_texture_atlas_set_property;
+    obj_class->get_property = psy_texture_atlas_get_property;
+    obj_class->constructed  = psy_texture_atlas_constructed;
+    obj_class->dispose      = psy_texture_atlas_dispose;
+    obj_class->finalize     = psy_texture_atlas_finalize;
+
+    /**
+     * TextureAtlas:texture:
+     *
+     * The texture in which the images are packed. It should be created by the
+     * [class@DrawingContext] that is going to draw with the atlas.
+     */
+    atlas_properties[PROP_TEXTURE]
+        = g_param_spec_object("texture",
+                              "Texture",
+                              "The texture that holds the images",
+                              PSY_TYPE_TEXTURE,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * TextureAtlas:width:
+     *
+     * The width of the atlas in pixels.
+     */
+    atlas_properties[PROP_WIDTH]
+        = g_param_spec_uint("width",
+                            "Width",
+                            "The width of the atlas in pixels",
+                            1,
+                            G_MAXINT,
+                            1024,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * TextureAtlas:height:
+     *
+     * The height of the atlas in pixels.
+     */
+    atlas_properties[PROP_HEIGHT]
+        = g_param_spec_uint("height",
+                            "Height",
+                            "The height of the atlas in pixels",
+                            1,
+                            G_MAXINT,
+                            1024,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * TextureAtlas:num-entries:
+     *
+     * The number of images that are currently packed in the atlas.
+     */
+    atlas_properties[PROP_NUM_ENTRIES]
+        = g_param_spec_uint("num-entries",
+                            "Num entries",
+                            "The number of images in the atlas",
+                            0,
+                            G_MAXUINT,
+                            0,
+                            G_PARAM_READABLE);
+
+    g_object_class_install_properties(
+        obj_class, NUM_PROPERTIES, atlas_properties);
+}
+
+/* ************ public functions ************ */
+
+/**
+ * psy_texture_atlas_new:
+ * @texture: a texture created by a [class@DrawingContext], the atlas will
+ *           (re)upload it, so it shouldn't be used for something else.
+ * @width: the width of the atlas in pixels
+ * @height: the height of the atlas in pixels
+ *
+ * Returns: a new, empty [class@TextureAtlas]
+ */
+PsyTextureAtlas *
+psy_texture_atlas_new(PsyTexture *texture, guint width, guint height)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE(texture), NULL);
+
+    // clang-format off
+    return g_object_new(PSY_TYPE_TEXTURE_ATLAS,
+                        "texture", texture,
+                        "width", width,
+                        "height", height,
+                        NULL);
+    // clang-format on
+}
+
+/**
+ * psy_texture_atlas_free:(skip)
+ *
+ * Frees atlases created by [ctor@TextureAtlas.new]
+ */
+void
+psy_texture_atlas_free(PsyTextureAtlas *self)
+{
+    g_return_if_fail(PSY_IS_TEXTURE_ATLAS(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_texture_atlas_add_image:
+ * @self: an instance of [class@TextureAtlas]
+ * @name: the name by which the image can be looked up
+ * @image: an image with the format PSY_IMAGE_FORMAT_RGBA
+ * @error: errors may be returned here
+ *
+ * Copies @image into the atlas. When the atlas is full, it is repacked and
+ * when necessary, the images that haven't been looked up for the longest time
+ * are evicted. If @name is already in the atlas, nothing happens.
+ *
+ * Returns: TRUE when @image is in the atlas, FALSE otherwise
+ */
+gboolean
+psy_texture_atlas_add_image(PsyTextureAtlas *self,
+                            const gchar     *name,
+                            PsyImage        *image,
+                            GError         **error)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+    g_return_val_if_fail(PSY_IS_IMAGE(image), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (psy_image_get_format(image) != PSY_IMAGE_FORMAT_RGBA) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_FAILED,
+                    "Only RGBA images can be added to a texture atlas");
+        return FALSE;
+    }
+
+    return atlas_add_pixels(self,
+                            name,
+                            psy_image_get_width(image),
+                            psy_image_get_height(image),
+                            psy_image_get_ptr(image),
+                            psy_image_get_stride(image),
+                            error);
+}
+
+/**
+ * psy_texture_atlas_add_texture:
+ * @self: an instance of [class@TextureAtlas]
+ * @name: the name by which the image can be looked up
+ * @texture: a decoded texture with 4 channels
+ *
+ * Copies the decoded pixels of @texture into the atlas, see
+ * [method@TextureAtlas.add_image].
+ *
+ * Returns: TRUE when @texture is in the atlas, FALSE otherwise
+ */
+gboolean
+psy_texture_atlas_add_texture(PsyTextureAtlas *self,
+                              const gchar     *name,
+                              PsyTexture      *texture,
+                              GError         **error)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+    g_return_val_if_fail(PSY_IS_TEXTURE(texture), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    const guint8 *data  = psy_texture_get_data(texture);
+    guint         width = psy_texture_get_width(texture);
+
+    if (!data || psy_texture_get_num_channels(texture) != ATLAS_BPP) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_FAILED,
+                    "Only decoded textures with 4 channels can be added to a "
+                    "texture atlas");
+        return FALSE;
+    }
+
+    return atlas_add_pixels(self,
+                            name,
+                            width,
+                            psy_texture_get_height(texture),
+                            data,
+                            width * ATLAS_BPP,
+                            error);
+}
+
+/**
+ * psy_texture_atlas_lookup:
+ * @self: an instance of [class@TextureAtlas]
+ * @name: the name of the image
+ * @tex_rect:(out caller-allocates)(array fixed-size=4)(nullable): the texture
+ *           coordinates of the top left (u, v) and bottom right (u, v) of the
+ *           image in the atlas
+ *
+ * Finds an image in the atlas. A found image counts as recently used, so it
+ * will be one of the last to be evicted.
+ *
+ * Returns: TRUE if @name is in the atlas, FALSE otherwise
+ */
+gboolean
+psy_texture_atlas_lookup(PsyTextureAtlas *self,
+                         const gchar     *name,
+                         gfloat           tex_rect[4])
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+
+    AtlasEntry *entry = g_hash_table_lookup(self->entries, name);
+    if (!entry)
+        return FALSE;
+
+    entry->last_used = ++self->clock;
+
+    if (tex_rect) {
+        tex_rect[0] = (gfloat) entry->x / (gfloat) self->width;
+        tex_rect[1] = (gfloat) entry->y / (gfloat) self->height;
+        tex_rect[2] = (gfloat) (entry->x + entry->width) / (gfloat) self->width;
+        tex_rect[3]
+            = (gfloat) (entry->y + entry->height) / (gfloat) self->height;
+    }
+    return TRUE;
+}
+
+/**
+ * psy_texture_atlas_contains:
+ * @self: an instance of [class@TextureAtlas]
+ * @name: the name of an image
+ *
+ * Returns: whether @name is in the atlas, unlike [method@TextureAtlas.lookup]
+ *          this doesn't count as using the image.
+ */
+gboolean
+psy_texture_atlas_contains(PsyTextureAtlas *self, const gchar *name)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), FALSE);
+    g_return_val_if_fail(name, FALSE);
+
+    return g_hash_table_contains(self->entries, name);
+}
+
+/**
+ * psy_texture_atlas_remove:
+ * @self: an instance of [class@TextureAtlas]
+ * @name: the name of an image
+ *
+ * Removes an image from the atlas. The space it occupied is reused the next
+ * time the atlas is repacked.
+ */
+void
+psy_texture_atlas_remove(PsyTextureAtlas *self, const gchar *name)
+{
+    g_return_if_fail(PSY_IS_TEXTURE_ATLAS(self));
+    g_return_if_fail(name);
+
+    g_hash_table_remove(self->entries, name);
+}
+
+/**
+ * psy_texture_atlas_get_texture:
+ * @self: an instance of [class@TextureAtlas]
+ *
+ * Returns:(transfer none): the texture that holds the images of the atlas
+ */
+PsyTexture *
+psy_texture_atlas_get_texture(PsyTextureAtlas *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), NULL);
+    return self->texture;
+}
+
+/**
+ * psy_texture_atlas_get_width:
+ * @self: an instance of [class@TextureAtlas]
+ *
+ * Returns: the width of the atlas in pixels
+ */
+guint
+psy_texture_atlas_get_width(PsyTextureAtlas *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), 0);
+    return self->width;
+}
+
+/**
+ * psy_texture_atlas_get_height:
+ * @self: an instance of [class@TextureAtlas]
+ *
+ * Returns: the height of the atlas in pixels
+ */
+guint
+psy_texture_atlas_get_height(PsyTextureAtlas *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), 0);
+    return self->height;
+}
+
+/**
+ * psy_texture_atlas_get_num_entries:
+ * @self: an instance of [class@TextureAtlas]
+ *
+ * Returns: the number of images in the atlas
+ */
+guint
+psy_texture_atlas_get_num_entries(PsyTextureAtlas *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE_ATLAS(self), 0);
+    return g_hash_table_size(self->entries);
+}
@@ -0,0 +1,58 @@
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "psy-image.h"
+#include "psy-texture.h"
+
+G_BEGIN_DECLS
+
+#define PSY_TYPE_TEXTURE_ATLAS psy_texture_atlas_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyTextureAtlas, psy_texture_atlas, PSY, TEXTURE_ATLAS, GObject)
+
+G_MODULE_EXPORT PsyTextureAtlas *
+psy_texture_atlas_new(PsyTexture *texture, guint width, guint height);
+
+G_MODULE_EXPORT void
+psy_texture_atlas_free(PsyTextureAtlas *self);
+
+G_MODULE_EXPORT gboolean
+psy_texture_atlas_add_image(PsyTextureAtlas *self,
+                            const gchar     *name,
+                            PsyImage        *image,
+                            GError         **error);
+
+G_MODULE_EXPORT gboolean
+psy_texture_atlas_add_texture(PsyTextureAtlas *self,
+                              const gchar     *name,
+                              PsyTexture      *texture,
+                              GError         **error);
+
+G_MODULE_EXPORT gboolean
+psy_texture_atlas_lookup(PsyTextureAtlas *self,
+                         const gchar     *name,
+                         gfloat           tex_rect[4]);
+
+G_MODULE_EXPORT gboolean
+psy_texture_atlas_contains(PsyTextureAtlas *self, const gchar *name);
+
+G_MODULE_EXPORT void
+psy_texture_atlas_remove(PsyTextureAtlas *self, const gchar *name);
+
+G_MODULE_EXPORT PsyTexture *
+psy_texture_atlas_get_texture(PsyTextureAtlas *self);
+
+G_MODULE_EXPORT guint
+psy_texture_atlas_get_width(PsyTextureAtlas *self);
+
+G_MODULE_EXPORT guint
+psy_texture_atlas_get_height(PsyTextureAtlas *self);
+
+G_MODULE_EXPORT guint
+psy_texture_atlas_get_num_entries(PsyTextureAtlas *self);
+
+G_END_DECLS
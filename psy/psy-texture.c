@@ -1,5 +1,7 @@
 
 #include "psy-texture.h"
+#include "psy-clock.h"
+#include "psy-duration.h"
 #include "psy-enums.h"
 #include "psy-image.h"
 
@@ -317,53 +319,42 @@ psy_texture_class_init(PsyTextureClass *klass)
 
 /* *********** helper functions ************* */
 
-static GByteArray *
-read_file(PsyTexture *texture, GFile *file, GError **error)
-{
-    GByteArray       *bytes   = g_byte_array_sized_new(1024 * 1024 * 10);
-    GFileInputStream *istream = g_file_read(file, NULL, error);
-    (void) texture;
-    if (*error)
-        goto on_error;
-
-    while (TRUE) {
-        guint8 buffer[1024];
-        gsize  nread;
-
-        if (!g_input_stream_read_all(G_INPUT_STREAM(istream),
-                                     buffer,
-                                     sizeof(buffer),
-                                     &nread,
-                                     NULL,
-                                     error))
-            goto on_error;
-
-        g_byte_array_append(bytes, buffer, nread);
-        if (nread < sizeof(buffer))
-            break;
-    }
+/*
+ * Decodes the image file at path. The file is memory mapped, instead of read
+ * into a buffer, so no more memory is used than the size of the file. This
+ * function doesn't touch a PsyTexture, so it may run in any thread.
+ */
+static gboolean
+decode_path(const gchar      *path,
+            guint             num_channels,
+            ImageDescription *image,
+            GError          **error)
+{
+    int width, height, file_channels;
 
-on_error:
-    g_object_unref(istream);
-    if (*error) {
-        g_object_unref(bytes);
-        bytes = NULL;
-    }
-    return bytes;
-}
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, error);
+    if (!mapped)
+        return FALSE;
 
-static void
-decode_picture(PsyTexture *self, GByteArray *bytes, GFile *file, GError **error)
-{
-    int                width, height, num_channels;
-    PsyTexturePrivate *priv = psy_texture_get_instance_private(self);
+    gsize length = g_mapped_file_get_length(mapped);
+    if (length == 0 || length > G_MAXINT) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_DECODE,
+                    "Unable to load '%s': the file has an invalid size",
+                    path);
+        g_mapped_file_unref(mapped);
+        return FALSE;
+    }
 
-    guint8 *data = stbi_load_from_memory(bytes->data,
-                                         (int) bytes->len,
-                                         &width,
-                                         &height,
-                                         &num_channels,
-                                         (int) priv->image.num_channels);
+    guint8 *data = stbi_load_from_memory(
+        (const stbi_uc *) g_mapped_file_get_contents(mapped),
+        (int) length,
+        &width,
+        &height,
+        &file_channels,
+        (int) num_channels);
+    g_mapped_file_unref(mapped);
 
     if (!data) {
         const char *msg = stbi_failure_reason();
@@ -371,26 +362,32 @@ decode_picture(PsyTexture *self, GByteArray *bytes, GFile *file, GError **error)
                     PSY_TEXTURE_ERROR,
                     PSY_TEXTURE_ERROR_DECODE,
                     "Unable to load '%s': %s",
-                    g_file_peek_path(file),
+                    path,
                     msg);
+        return FALSE;
     }
-    else {
-        if (priv->image.num_channels == 0)
-            priv->image.num_channels = num_channels;
-        priv->image.width      = width;
-        priv->image.height     = height;
-        priv->image.image_data = data;
-    }
+
+    image->num_channels = num_channels ? num_channels : (guint) file_channels;
+    image->width        = (guint) width;
+    image->height       = (guint) height;
+    image->image_data   = data;
+    return TRUE;
 }
 
 static void
 load_and_decode(PsyTexture *self, GFile *file, GError **error)
 {
-    GByteArray *bytes = read_file(self, file, error);
-    if (*error) {
+    gchar *path = g_file_get_path(file);
+    if (!path) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_DECODE,
+                    "Unable to load '%s': it isn't a local file",
+                    g_file_peek_path(file));
         return;
     }
-    decode_picture(self, bytes, file, error);
+    psy_texture_decode_path(self, path, error);
+    g_free(path);
 }
 
 static void
@@ -404,54 +401,11 @@ load_picture(GTask        *task,
     TextureData *tdata = task_data;
     PsyTexture  *self  = source_object;
     (void) self; // we currently do not use self.
-    // 10 megabytes should be enough to store most image files
-    GByteArray *bytes = g_byte_array_sized_new(1024 * 1024 * 10);
-
-    GFileInputStream *istream = g_file_read(tdata->file, NULL, &error);
-    if (error)
-        goto on_error;
-
-    while (error == NULL) {
-        guint8 buffer[1024];
-        gsize  nread;
-
-        if (!g_input_stream_read_all(G_INPUT_STREAM(istream),
-                                     buffer,
-                                     sizeof(buffer),
-                                     &nread,
-                                     NULL,
-                                     &error))
-            goto on_error;
-
-        g_byte_array_append(bytes, buffer, nread);
-        if (nread < sizeof(buffer))
-            break;
-    }
-
-    int width, height, num_channels;
-
-    tdata->img_description.image_data
-        = stbi_load_from_memory(bytes->data,
-                                (int) bytes->len,
-                                &width,
-                                &height,
-                                &num_channels,
-                                (int) tdata->img_description.num_channels);
-
-    if (!tdata->img_description.image_data) {
-        const char *msg = stbi_failure_reason();
-        g_set_error(&error,
-                    PSY_TEXTURE_ERROR,
-                    PSY_TEXTURE_ERROR_DECODE,
-                    "Unable to load '%s': %s",
-                    g_file_peek_path(tdata->file),
-                    msg);
-    }
 
-on_error:
-
-    g_object_unref(istream);
-    g_byte_array_unref(bytes);
+    decode_path(g_file_peek_path(tdata->file),
+                tdata->img_description.num_channels,
+                &tdata->img_description,
+                &error);
 
     if (error)
         g_task_return_error(task, error);
@@ -462,6 +416,48 @@ on_error:
 
 /* *********** public texture functions ************* */
 
+/**
+ * psy_texture_decode_path:
+ * @self: an instance of [class@Texture]
+ * @path: the path of an image file
+ * @error: errors may be returned here
+ *
+ * Decodes the image at @path into @self, using [property@Texture:num-channels]
+ * as the number of channels to decode to. This function may be called from
+ * another thread than the one that draws, as long as @self isn't used
+ * elsewhere while it's decoding. The decoded image may be uploaded afterwards.
+ *
+ * Returns: TRUE when the image is decoded, FALSE otherwise
+ */
+gboolean
+psy_texture_decode_path(PsyTexture *self, const gchar *path, GError **error)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE(self), FALSE);
+    g_return_val_if_fail(path, FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    PsyTexturePrivate *priv  = psy_texture_get_instance_private(self);
+    ImageDescription   image = {0};
+
+    g_mutex_lock(&priv->lock);
+    guint num_channels = priv->image.num_channels;
+    g_mutex_unlock(&priv->lock);
+
+    if (!decode_path(path, num_channels, &image, error))
+        return FALSE;
+
+    g_mutex_lock(&priv->lock);
+    if (priv->image.image_data)
+        stbi_image_free(priv->image.image_data);
+    priv->image = image;
+    priv->state = STATE_DECODED;
+    g_free(priv->path);
+    priv->path = g_strdup(path);
+    g_mutex_unlock(&priv->lock);
+
+    return TRUE;
+}
+
 void
 psy_texture_upload(PsyTexture *self, GError **error)
 {
@@ -482,6 +478,167 @@ psy_texture_is_uploaded(PsyTexture *self)
     return klass->is_uploaded(self);
 }
 
+/**
+ * psy_texture_upload_async:
+ * @self: an instance of [class@Texture] whose image has been decoded
+ * @error: errors may be returned here
+ *
+ * Starts uploading the decoded image to the graphics hardware, without
+ * waiting for the transfer to finish. The texture may be drawn straight away,
+ * but the first draw will wait for the transfer, so it's best to start the
+ * upload well before the texture is needed, e.g. during the interval between
+ * two trials. [method@Texture.is_uploaded] returns TRUE once the transfer has
+ * finished, until then [method@Texture.is_upload_pending] returns TRUE.
+ *
+ * Backends that cannot upload asynchronously upload synchronously instead.
+ */
+void
+psy_texture_upload_async(PsyTexture *self, GError **error)
+{
+    g_return_if_fail(PSY_IS_TEXTURE(self));
+    g_return_if_fail(error == NULL || *error == NULL);
+    PsyTextureClass *klass = PSY_TEXTURE_GET_CLASS(self);
+
+    if (klass->upload_async)
+        klass->upload_async(self, error);
+    else
+        psy_texture_upload(self, error);
+}
+
+/**
+ * psy_texture_is_upload_pending:
+ * @self: an instance of [class@Texture]
+ *
+ * Returns: TRUE when an upload started with [method@Texture.upload_async] is
+ *          still in progress, FALSE otherwise.
+ */
+gboolean
+psy_texture_is_upload_pending(PsyTexture *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE(self), FALSE);
+    PsyTextureClass *klass = PSY_TEXTURE_GET_CLASS(self);
+
+    if (!klass->is_upload_pending)
+        return FALSE;
+    return klass->is_upload_pending(self);
+}
+
+/**
+ * psy_texture_ensure_resident:
+ * @self: an instance of [class@Texture] whose image has been decoded
+ * @deadline:(nullable): the time at which the texture should be resident on
+ *           the graphics hardware, NULL waits as long as it takes
+ * @error: errors may be returned here
+ *
+ * Makes sure the texture is available to the graphics hardware by @deadline.
+ * If the texture hasn't been uploaded yet, an asynchronous upload is started,
+ * then this function waits for the upload until @deadline. This allows to
+ * prepare the pictures of the next trial, without paying the cost of the
+ * upload in the first frame in which a picture is presented.
+ *
+ * Returns: TRUE when the texture is resident, FALSE when it isn't at
+ *          @deadline or an error occurred.
+ */
+gboolean
+psy_texture_ensure_resident(PsyTexture   *self,
+                            PsyTimePoint *deadline,
+                            GError      **error)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE(self), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+    PsyTextureClass *klass = PSY_TEXTURE_GET_CLASS(self);
+
+    if (psy_texture_is_uploaded(self))
+        return TRUE;
+
+    if (!psy_texture_is_upload_pending(self)) {
+        GError *local_error = NULL;
+        psy_texture_upload_async(self, &local_error);
+        if (local_error) {
+            g_propagate_error(error, local_error);
+            return FALSE;
+        }
+    }
+
+    if (!klass->wait_uploaded)
+        return psy_texture_is_uploaded(self);
+
+    gint64 timeout_us = -1;
+    if (deadline) {
+        PsyClock     *clock = psy_clock_new();
+        PsyTimePoint *now   = psy_clock_now(clock);
+        PsyDuration  *left  = psy_time_point_subtract(deadline, now);
+
+        timeout_us = left ? MAX(psy_duration_get_us(left), 0) : 0;
+
+        g_clear_pointer(&left, psy_duration_free);
+        psy_time_point_free(now);
+        psy_clock_free(clock);
+    }
+
+    return klass->wait_uploaded(self, timeout_us);
+}
+
+/**
+ * psy_texture_unload:
+ * @self: an instance of [class@Texture]
+ *
+ * Releases the copy of the texture on the graphics hardware, a pending upload
+ * is abandoned. The texture can be uploaded again, provided that the decoded
+ * image is still available, see [method@Texture.release_data].
+ */
+void
+psy_texture_unload(PsyTexture *self)
+{
+    g_return_if_fail(PSY_IS_TEXTURE(self));
+    PsyTextureClass *klass = PSY_TEXTURE_GET_CLASS(self);
+
+    if (klass->unload)
+        klass->unload(self);
+}
+
+/**
+ * psy_texture_release_data:
+ * @self: an instance of [class@Texture]
+ *
+ * Frees the decoded image, in order to save memory once the texture has been
+ * uploaded. The size and path of the texture are kept, so the image can be
+ * decoded again using [method@Texture.decode_path].
+ */
+void
+psy_texture_release_data(PsyTexture *self)
+{
+    g_return_if_fail(PSY_IS_TEXTURE(self));
+
+    PsyTexturePrivate *priv = psy_texture_get_instance_private(self);
+
+    g_mutex_lock(&priv->lock);
+    if (priv->image.image_data) {
+        stbi_image_free(priv->image.image_data);
+        priv->image.image_data = NULL;
+    }
+    priv->state = STATE_NULL;
+    g_mutex_unlock(&priv->lock);
+}
+
+/**
+ * psy_texture_get_num_bytes:
+ * @self: an instance of [class@Texture]
+ *
+ * Returns: the number of bytes the pixels of this texture occupy, both in
+ *          the decoded image and on the graphics hardware.
+ */
+gsize
+psy_texture_get_num_bytes(PsyTexture *self)
+{
+    g_return_val_if_fail(PSY_IS_TEXTURE(self), 0);
+
+    PsyTexturePrivate *priv = psy_texture_get_instance_private(self);
+
+    return (gsize) priv->image.width * priv->image.height
+           * priv->image.num_channels;
+}
+
 void
 psy_texture_bind(PsyTexture *self, GError **error)
 {
@@ -496,7 +653,6 @@ psy_texture_bind(PsyTexture *self, GError **error)
 void
 psy_texture_set_file(PsyTexture *self, GFile *file)
 {
-    PsyTexturePrivate *priv = psy_texture_get_instance_private(self);
     g_return_if_fail(PSY_IS_TEXTURE(self));
     g_return_if_fail(G_IS_FILE(file));
 
@@ -507,12 +663,7 @@ psy_texture_set_file(PsyTexture *self, GFile *file)
     if (error) {
         g_warning("%s", error->message);
         g_error_free(error);
-        return;
     }
-
-    if (priv->path)
-        g_free(priv->path);
-    priv->path = g_file_get_path(file);
 }
 
 void
@@ -635,3 +786,57 @@ psy_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error)
     PsyTextureClass *cls = PSY_TEXTURE_GET_CLASS(self);
     cls->upload_image(self, image, error);
 }
+
+/**
+ * psy_texture_upload_sub_image:
+ * @self: an instance of [class@Texture] that has been uploaded before
+ * @image: an image of the same size as @self, e.g. a copy of its pixels
+ * @x: the left column of the region
+ * @y: the top row of the region
+ * @width: the width of the region
+ * @height: the height of the region
+ * @error: errors may be returned here
+ *
+ * Replaces a region of an uploaded texture with the same region of @image,
+ * the remainder of the texture is left intact. The pixels are read from
+ * @image directly, so nothing is copied. The mipmaps of @self are updated
+ * when it is bound the next time, so many regions may be uploaded at the
+ * cost of one update.
+ */
+void
+psy_texture_upload_sub_image(PsyTexture *self,
+                             PsyImage   *image,
+                             guint       x,
+                             guint       y,
+                             guint       width,
+                             guint       height,
+                             GError    **error)
+{
+    g_return_if_fail(PSY_IS_TEXTURE(self));
+    g_return_if_fail(PSY_IS_IMAGE(image));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    if (psy_image_get_width(image) != psy_texture_get_width(self)
+        || psy_image_get_height(image) != psy_texture_get_height(self)
+        || x + width > psy_texture_get_width(self)
+        || y + height > psy_texture_get_height(self)) {
+        g_set_error(error,
+                    PSY_TEXTURE_ERROR,
+                    PSY_TEXTURE_ERROR_FAILED,
+                    "A region of %u * %u at (%u, %u) of an image of %u * %u "
+                    "can't be uploaded to a texture of %u * %u",
+                    width,
+                    height,
+                    x,
+                    y,
+                    psy_image_get_width(image),
+                    psy_image_get_height(image),
+                    psy_texture_get_width(self),
+                    psy_texture_get_height(self));
+        return;
+    }
+
+    PsyTextureClass *cls = PSY_TEXTURE_GET_CLASS(self);
+    g_return_if_fail(cls->upload_sub_image);
+    cls->upload_sub_image(self, image, x, y, width, height, error);
+}
@@ -6,6 +6,7 @@
 #include <glib-object.h>
 
 #include "psy-image.h"
+#include "psy-time-point.h"
 
 G_BEGIN_DECLS
 
@@ -26,6 +27,17 @@ typedef struct _PsyTextureClass {
     gboolean (*is_uploaded)(PsyTexture *self);
     void (*upload_image)(PsyTexture *self, PsyImage *image, GError **error);
     void (*bind)(PsyTexture *self, GError **error);
+    void (*upload_sub_image)(PsyTexture *self,
+                             PsyImage   *image,
+                             guint       x,
+                             guint       y,
+                             guint       width,
+                             guint       height,
+                             GError    **error);
+    void (*upload_async)(PsyTexture *self, GError **error);
+    gboolean (*is_upload_pending)(PsyTexture *self);
+    gboolean (*wait_uploaded)(PsyTexture *self, gint64 timeout_us);
+    void (*unload)(PsyTexture *self);
 } PsyTextureClass;
 
 G_MODULE_EXPORT void
@@ -34,6 +46,9 @@ psy_texture_set_path(PsyTexture *self, const char *path);
 G_MODULE_EXPORT void
 psy_texture_set_file(PsyTexture *self, GFile *file);
 
+G_MODULE_EXPORT gboolean
+psy_texture_decode_path(PsyTexture *self, const gchar *path, GError **error);
+
 //
 // G_MODULE_EXPORT void
 // psy_texture_set_file_async(PsyTexture         *self,
@@ -68,6 +83,26 @@ psy_texture_upload(PsyTexture *self, GError **error);
 G_MODULE_EXPORT gboolean
 psy_texture_is_uploaded(PsyTexture *self);
 
+G_MODULE_EXPORT void
+psy_texture_upload_async(PsyTexture *self, GError **error);
+
+G_MODULE_EXPORT gboolean
+psy_texture_is_upload_pending(PsyTexture *self);
+
+G_MODULE_EXPORT gboolean
+psy_texture_ensure_resident(PsyTexture   *self,
+                            PsyTimePoint *deadline,
+                            GError      **error);
+
+G_MODULE_EXPORT void
+psy_texture_unload(PsyTexture *self);
+
+G_MODULE_EXPORT void
+psy_texture_release_data(PsyTexture *self);
+
+G_MODULE_EXPORT gsize
+psy_texture_get_num_bytes(PsyTexture *self);
+
 G_MODULE_EXPORT void
 psy_texture_bind(PsyTexture *self, GError **error);
 
@@ -80,6 +115,15 @@ psy_texture_get_filename(PsyTexture *self);
 G_MODULE_EXPORT void
 psy_texture_upload_image(PsyTexture *self, PsyImage *image, GError **error);
 
+G_MODULE_EXPORT void
+psy_texture_upload_sub_image(PsyTexture *self,
+                             PsyImage   *image,
+                             guint       x,
+                             guint       y,
+                             guint       width,
+                             guint       height,
+                             GError    **error);
+
 G_END_DECLS
 
 #endif
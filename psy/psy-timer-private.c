@@ -83,7 +83,7 @@ typedef struct _PsyTimerThread {
     GPtrArray   *timers;
     GThread     *thread;
     PsyClock    *clock;
-    PsyDuration *busy_loop_dur;
+    gint64       busy_loop_us;
 } PsyTimerThread;
 
 G_DEFINE_TYPE(PsyTimerThread, psy_timer_thread, G_TYPE_OBJECT)
@@ -97,7 +97,7 @@ psy_timer_thread_init(PsyTimerThread *self)
     self->queue         = g_async_queue_new();
     self->timers        = g_ptr_array_new_full(64, NULL);
     self->clock         = psy_clock_new();
-    self->busy_loop_dur = psy_duration_new_ms(2);
+    self->busy_loop_us  = 2000;
     self->running       = TRUE;
     self->thread        = g_thread_new("TimerThread", timer_thread, self);
 
@@ -136,7 +136,6 @@ psy_timer_thread_finalize(GObject *self)
     PsyTimerThread *tt_self = PSY_TIMER_THREAD(self);
     g_ptr_array_free(tt_self->timers, TRUE);
 
-    psy_duration_free(tt_self->busy_loop_dur);
 #ifdef _WIN32
     timeEndPeriod(1);
 #endif
@@ -175,6 +174,18 @@ psy_timer_thread_del_timer(PsyTimerThread *self, PsyTimer *timer)
     return TRUE;
 }
 
+/*
+ * The monotonic time in µs at which timer should fire.
+ */
+static gint64
+timer_get_fire_time_us(PsyTimer *timer)
+{
+    PsyTimePoint *tp = psy_timer_get_fire_time(timer);
+    g_assert(tp != NULL);
+
+    return psy_clock_get_zero_time() + tp->ticks_since_start;
+}
+
 void
 psy_timer_thread_class_init(PsyTimerThreadClass *klass)
 {
@@ -191,8 +202,8 @@ psy_timer_thread_class_init(PsyTimerThreadClass *klass)
  * A loop function that checks whether one or multiple timers
  * are ready to fire. If so, the timers are fired.
  *
- * If there are no timers with a fire time  before now + self->busy_loop_dur
- * the loop is terminated.
+ * The loop spins until the first timer fires, the time is compared as
+ * integers, so spinning doesn't allocate.
  *
  * stability:private
  */
@@ -200,20 +211,12 @@ static void
 psy_timer_thread_fire_timers(PsyTimerThread *self)
 {
     while (self->timers->len > 0 && self->running) {
-        PsyTimePoint *now = psy_clock_now(self->clock);
-        PsyTimePoint *now_plus_busy_dur
-            = psy_time_point_add(now, self->busy_loop_dur);
-
         PsyTimer *first = self->timers->pdata[0];
         g_assert(PSY_IS_TIMER(first));
-        PsyTimePoint *tp = psy_timer_get_fire_time(first);
 
-        if (psy_time_point_greater_equal(now, tp)) {
+        if (psy_clock_get_monotonic_time() >= timer_get_fire_time_us(first)) {
             psy_timer_fire(first, psy_timer_get_fire_time(first));
             g_ptr_array_remove_index(self->timers, 0);
-
-            psy_time_point_free(now);
-            psy_time_point_free(now_plus_busy_dur);
             break;
         }
 
@@ -221,9 +224,6 @@ psy_timer_thread_fire_timers(PsyTimerThread *self)
         if (msg) {
             timer_thread_handle_message(self, msg);
         }
-
-        psy_time_point_free(now);
-        psy_time_point_free(now_plus_busy_dur);
     }
 }
 
@@ -232,7 +232,7 @@ psy_timer_thread_fire_timers(PsyTimerThread *self)
  *
  * This function checks whether there are timers about to be ready to fire
  *
- * Returns: TRUE if a timer is ready within now and now + self->busy_dur
+ * Returns: TRUE if a timer is ready within now and now + self->busy_loop_us
  *
  * stability:private
  */
@@ -242,18 +242,11 @@ psy_timer_thread_check_timers(PsyTimerThread *self)
     gboolean ret = FALSE;
 
     if (self->timers->len > 0) {
-        PsyTimePoint *now = psy_clock_now(self->clock);
-
-        PsyTimer     *first = self->timers->pdata[0];
-        PsyTimePoint *tp    = psy_timer_get_fire_time(first);
-        g_assert(tp != NULL);
-        PsyDuration *dur = psy_time_point_subtract(tp, now);
+        PsyTimer *first = self->timers->pdata[0];
+        gint64    wait_us
+            = timer_get_fire_time_us(first) - psy_clock_get_monotonic_time();
 
-        if (psy_duration_less_equal(dur, self->busy_loop_dur)) {
-            ret = TRUE;
-        }
-        psy_duration_free(dur);
-        psy_time_point_free(now);
+        ret = wait_us <= self->busy_loop_us;
     }
 
     return ret;
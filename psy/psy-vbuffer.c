@@ -186,6 +186,36 @@ psy_vbuffer_draw_triangle_fan(PsyVBuffer *self, GError **error)
     klass->draw_triangle_fan(self, error);
 }
 
+/**
+ * psy_vbuffer_draw_triangle_fan_instanced:
+ * @self: an instance of [class@VBuffer]
+ * @instances:(array length=num_instances): the data of each instance
+ * @num_instances: the number of instances to draw
+ * @error: errors may be returned here
+ *
+ * Draws the vertices of @self as a triangle fan @num_instances times in one
+ * go. Each instance is transformed by its own model matrix and drawn in its
+ * own color. This requires a shader program that takes the model matrix and
+ * color as vertex attributes, see PSY_INSTANCED_COLOR_PROGRAM_NAME. The
+ * instances are drawn in the order of @instances.
+ */
+void
+psy_vbuffer_draw_triangle_fan_instanced(PsyVBuffer               *self,
+                                        const PsyVBufferInstance *instances,
+                                        guint                     num_instances,
+                                        GError                  **error)
+{
+    g_return_if_fail(PSY_IS_VBUFFER(self));
+    g_return_if_fail(instances != NULL || num_instances == 0);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    PsyVBufferClass *klass = PSY_VBUFFER_GET_CLASS(self);
+
+    g_return_if_fail(klass->draw_triangle_fan_instanced);
+
+    klass->draw_triangle_fan_instanced(self, instances, num_instances, error);
+}
+
 void
 psy_vbuffer_set_nvertices(PsyVBuffer *self, guint nverts)
 {
@@ -30,6 +30,22 @@ typedef struct PsyVertex {
     PsyVertexTexPos texture_pos;
 } PsyVertex;
 
+/**
+ * PsyVBufferInstance:
+ * @model: the model matrix of the instance in column major order
+ * @color: the rgba color of the instance
+ * @tex_rect: the part of a texture atlas that is shown by the instance, as
+ *            the texture coordinates of its left top and right bottom
+ *
+ * The per instance data used when a vertex buffer is drawn instanced, see
+ * [method@VBuffer.draw_triangle_fan_instanced].
+ */
+typedef struct PsyVBufferInstance {
+    gfloat model[16];
+    gfloat color[4];
+    gfloat tex_rect[4];
+} PsyVBufferInstance;
+
 typedef struct _PsyVBufferClass {
     GObjectClass parent_class;
     void (*upload)(PsyVBuffer *self, GError **error);
@@ -38,6 +54,10 @@ typedef struct _PsyVBufferClass {
     void (*draw_triangles)(PsyVBuffer *self, GError **error);
     void (*draw_triangle_strip)(PsyVBuffer *self, GError **error);
     void (*draw_triangle_fan)(PsyVBuffer *self, GError **error);
+    void (*draw_triangle_fan_instanced)(PsyVBuffer               *self,
+                                        const PsyVBufferInstance *instances,
+                                        guint                     num_instances,
+                                        GError                  **error);
 } PsyVBufferClass;
 
 G_MODULE_EXPORT void
@@ -125,6 +145,12 @@ psy_vbuffer_draw_triangle_strip(PsyVBuffer *self, GError **error);
 G_MODULE_EXPORT void
 psy_vbuffer_draw_triangle_fan(PsyVBuffer *self, GError **error);
 
+G_MODULE_EXPORT void
+psy_vbuffer_draw_triangle_fan_instanced(PsyVBuffer               *self,
+                                        const PsyVBufferInstance *instances,
+                                        guint                     num_instances,
+                                        GError                  **error);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,928 @@
+
+#include <gst/app/gstappsrc.h>
+#include <gst/gst.h>
+
+#include "psy-enums.h"
+#include "psy-video-exporter.h"
+
+/**
+ * PsyVideoExporter:
+ *
+ * A PsyVideoExporter encodes the frames of a canvas to a video file. It
+ * feeds the [class@Image]s of the frames into a GStreamer pipeline of the
+ * form `appsrc ! videoconvert ! queue ! encoder ! muxer ! filesink`. The
+ * images are handed to GStreamer without copying them, and converting and
+ * encoding happens on the streaming threads of the pipeline, so the thread
+ * that draws only waits when the pipeline falls behind by more than
+ * [property@VideoExporter:max-queued-frames].
+ *
+ * The timestamp of a frame is derived from its frame number and
+ * [property@VideoExporter:frame-dur], frames that were skipped leave a gap
+ * in the video. A [class@GlCanvas] with asynchronous readback enabled is a
+ * natural source for frames, pass the images of its image-ready signal to
+ * [method@VideoExporter.add_frame] and call [method@VideoExporter.close]
+ * when done.
+ */
+
+G_DEFINE_QUARK("psy-video-exporter-error", psy_video_exporter_error)
+
+// The time the thread that adds frames sleeps, while the pipeline is behind
+#define BACKPRESSURE_POLL_NS (GST_MSECOND)
+
+typedef struct _PsyVideoExporter {
+    GObject      parent;
+    gchar       *filename;
+    gint         width, height;
+    PsyDuration *frame_dur;
+    gchar       *encoder;
+    gchar       *muxer;
+    guint        max_queued_frames;
+
+    GstElement    *pipeline; // NULL when the exporter is closed
+    GstAppSrc     *app_src;
+    GstBus        *bus;
+    GstBufferPool *buffer_pool;  // recycles the buffers of encoded frames
+    gint           fps_n, fps_d; // the framerate of the video
+    gboolean       failed;       // the pipeline has reported an error
+    guint64        first_frame;
+    guint64        num_frames;
+} PsyVideoExporter;
+
+G_DEFINE_FINAL_TYPE(PsyVideoExporter, psy_video_exporter, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NULL,
+    PROP_FILENAME,
+    PROP_WIDTH,
+    PROP_HEIGHT,
+    PROP_FRAME_DUR,
+    PROP_ENCODER,
+    PROP_MUXER,
+    PROP_MAX_QUEUED_FRAMES,
+    PROP_NUM_FRAMES,
+    PROP_IS_OPEN,
+    NUM_PROPERTIES
+} PsyVideoExporterProperty;
+
+static GParamSpec *video_exporter_properties[NUM_PROPERTIES];
+
+static void
+psy_video_exporter_set_property(GObject      *object,
+                                guint         prop_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+    PsyVideoExporter *self = PSY_VIDEO_EXPORTER(object);
+
+    switch ((PsyVideoExporterProperty) prop_id) {
+    case PROP_FILENAME:
+        g_free(self->filename);
+        self->filename = g_value_dup_string(value);
+        break;
+    case PROP_WIDTH:
+        self->width = g_value_get_int(value);
+        break;
+    case PROP_HEIGHT:
+        self->height = g_value_get_int(value);
+        break;
+    case PROP_FRAME_DUR:
+        g_clear_pointer(&self->frame_dur, psy_duration_free);
+        self->frame_dur = g_value_dup_boxed(value);
+        break;
+    case PROP_ENCODER:
+        psy_video_exporter_set_encoder(self, g_value_get_string(value));
+        break;
+    case PROP_MUXER:
+        psy_video_exporter_set_muxer(self, g_value_get_string(value));
+        break;
+    case PROP_MAX_QUEUED_FRAMES:
+        psy_video_exporter_set_max_queued_frames(self,
+                                                 g_value_get_uint(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_video_exporter_get_property(GObject    *object,
+                                guint       prop_id,
+                                GValue     *value,
+                                GParamSpec *pspec)
+{
+    PsyVideoExporter *self = PSY_VIDEO_EXPORTER(object);
+
+    switch ((PsyVideoExporterProperty) prop_id) {
+    case PROP_FILENAME:
+        g_value_set_string(value, self->filename);
+        break;
+    case PROP_WIDTH:
+        g_value_set_int(value, self->width);
+        break;
+    case PROP_HEIGHT:
+        g_value_set_int(value, self->height);
+        break;
+    case PROP_FRAME_DUR:
+        g_value_set_boxed(value, self->frame_dur);
+        break;
+    case PROP_ENCODER:
+        g_value_set_string(value, self->encoder);
+        break;
+    case PROP_MUXER:
+        g_value_set_string(value, self->muxer);
+        break;
+    case PROP_MAX_QUEUED_FRAMES:
+        g_value_set_uint(value, self->max_queued_frames);
+        break;
+    case PROP_NUM_FRAMES:
+        g_value_set_uint64(value, self->num_frames);
+        break;
+    case PROP_IS_OPEN:
+        g_value_set_boolean(value, psy_video_exporter_get_is_open(self));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void
+psy_video_exporter_init(PsyVideoExporter *self)
+{
+    (void) self;
+}
+
+static void
+video_exporter_destroy_pipeline(PsyVideoExporter *self)
+{
+    if (!self->pipeline)
+        return;
+
+    gst_element_set_state(self->pipeline, GST_STATE_NULL);
+    if (self->buffer_pool)
+        gst_buffer_pool_set_active(self->buffer_pool, FALSE);
+    gst_clear_object(&self->buffer_pool);
+    gst_clear_object(&self->bus);
+    gst_clear_object(&self->app_src);
+    gst_clear_object(&self->pipeline);
+}
+
+static void
+psy_video_exporter_dispose(GObject *object)
+{
+    PsyVideoExporter *self = PSY_VIDEO_EXPORTER(object);
+
+    if (self->pipeline) {
+        g_warning("A PsyVideoExporter for '%s' is disposed without closing "
+                  "it, the video may be incomplete",
+                  self->filename);
+        video_exporter_destroy_pipeline(self);
+    }
+
+    G_OBJECT_CLASS(psy_video_exporter_parent_class)->dispose(object);
+}
+
+static void
+psy_video_exporter_finalize(GObject *object)
+{
+    PsyVideoExporter *self = PSY_VIDEO_EXPORTER(object);
+
+    g_free(self->filename);
+    g_clear_pointer(&self->frame_dur, psy_duration_free);
+    g_free(self->encoder);
+    g_free(self->muxer);
+
+    G_OBJECT_CLASS(psy_video_exporter_parent_class)->finalize(object);
+}
+
+static void
+psy_video_exporter_class_init(PsyVideoExporterClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = psy_video_exporter_set_property;
+    object_class->get_property = psy_video_exporter_get_property;
+    object_class->dispose      = psy_video_exporter_dispose;
+    object_class->finalize     = psy_video_exporter_finalize;
+
+    /**
+     * PsyVideoExporter:filename:
+     *
+     * The path of the video file that is written.
+     */
+    video_exporter_properties[PROP_FILENAME]
+        = g_param_spec_string("filename",
+                              "Filename",
+                              "The path of the video file",
+                              NULL,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyVideoExporter:width:
+     *
+     * The width of the video in pixels, the frames must have this width.
+     */
+    video_exporter_properties[PROP_WIDTH]
+        = g_param_spec_int("width",
+                           "Width",
+                           "The width of the video in pixels",
+                           1,
+                           G_MAXINT,
+                           640,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyVideoExporter:height:
+     *
+     * The height of the video in pixels, the frames must have this height.
+     */
+    video_exporter_properties[PROP_HEIGHT]
+        = g_param_spec_int("height",
+                           "Height",
+                           "The height of the video in pixels",
+                           1,
+                           G_MAXINT,
+                           480,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyVideoExporter:frame-dur:
+     *
+     * The duration of one frame, this determines the frame rate and the
+     * timestamps of the video.
+     */
+    video_exporter_properties[PROP_FRAME_DUR]
+        = g_param_spec_boxed("frame-dur",
+                             "FrameDur",
+                             "The duration of one frame",
+                             PSY_TYPE_DURATION,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+    /**
+     * PsyVideoExporter:encoder:
+     *
+     * A GStreamer description of the encoder, e.g.
+     * "x264enc speed-preset=ultrafast". It may consist of several
+     * elements linked with "!".
+     */
+    video_exporter_properties[PROP_ENCODER]
+        = g_param_spec_string("encoder",
+                              "Encoder",
+                              "A GStreamer description of the encoder",
+                              "x264enc speed-preset=ultrafast",
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+    /**
+     * PsyVideoExporter:muxer:
+     *
+     * A GStreamer description of the muxer that writes the container
+     * format, e.g. "mp4mux" or "matroskamux".
+     */
+    video_exporter_properties[PROP_MUXER]
+        = g_param_spec_string("muxer",
+                              "Muxer",
+                              "A GStreamer description of the muxer",
+                              "mp4mux",
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+    /**
+     * PsyVideoExporter:max-queued-frames:
+     *
+     * The number of frames that may wait in the pipeline before
+     * [method@VideoExporter.add_frame] blocks until the pipeline has caught
+     * up.
+     */
+    video_exporter_properties[PROP_MAX_QUEUED_FRAMES]
+        = g_param_spec_uint("max-queued-frames",
+                            "MaxQueuedFrames",
+                            "The number of frames that may be queued",
+                            1,
+                            G_MAXUINT,
+                            8,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+    /**
+     * PsyVideoExporter:num-frames:
+     *
+     * The number of frames that have been added since the exporter was
+     * opened.
+     */
+    video_exporter_properties[PROP_NUM_FRAMES]
+        = g_param_spec_uint64("num-frames",
+                              "NumFrames",
+                              "The number of frames added",
+                              0,
+                              G_MAXUINT64,
+                              0,
+                              G_PARAM_READABLE);
+
+    /**
+     * PsyVideoExporter:is-open:
+     *
+     * Whether the exporter has been opened and accepts frames.
+     */
+    video_exporter_properties[PROP_IS_OPEN]
+        = g_param_spec_boolean("is-open",
+                               "IsOpen",
+                               "Whether the exporter accepts frames",
+                               FALSE,
+                               G_PARAM_READABLE);
+
+    g_object_class_install_properties(
+        object_class, NUM_PROPERTIES, video_exporter_properties);
+}
+
+/*
+ * Takes an error message from the bus, waiting at most timeout for it.
+ */
+static gboolean
+video_exporter_check_bus(PsyVideoExporter *self,
+                         GstClockTime      timeout,
+                         GError          **error)
+{
+    GstMessage *msg
+        = gst_bus_timed_pop_filtered(self->bus, timeout, GST_MESSAGE_ERROR);
+    if (!msg)
+        return TRUE;
+
+    // The error is taken from the bus, so remember that the pipeline failed.
+    self->failed = TRUE;
+
+    GError *gst_error = NULL;
+    gchar  *debug     = NULL;
+    gst_message_parse_error(msg, &gst_error, &debug);
+    g_set_error(error,
+                PSY_VIDEO_EXPORTER_ERROR,
+                PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                "Unable to encode '%s': %s",
+                self->filename,
+                gst_error->message);
+    g_debug("%s", debug ? debug : "");
+
+    g_free(debug);
+    g_error_free(gst_error);
+    gst_message_unref(msg);
+    return FALSE;
+}
+
+/* ************ public functions ******************** */
+
+/**
+ * psy_video_exporter_new:(constructor)
+ * @filename: the path of the video file to write
+ * @width: the width of the video in pixels
+ * @height: the height of the video in pixels
+ * @frame_dur: the duration of one frame
+ *
+ * Returns: a new [class@VideoExporter], call [method@VideoExporter.open]
+ *          before adding frames.
+ */
+PsyVideoExporter *
+psy_video_exporter_new(const gchar *filename,
+                       gint         width,
+                       gint         height,
+                       PsyDuration *frame_dur)
+{
+    g_return_val_if_fail(filename != NULL, NULL);
+    g_return_val_if_fail(frame_dur != NULL, NULL);
+
+    // clang-format off
+    return g_object_new(PSY_TYPE_VIDEO_EXPORTER,
+                        "filename", filename,
+                        "width", width,
+                        "height", height,
+                        "frame-dur", frame_dur,
+                        NULL);
+    // clang-format on
+}
+
+/**
+ * psy_video_exporter_new_for_canvas:(constructor)
+ * @canvas: the canvas whose frames are exported
+ * @filename: the path of the video file to write
+ *
+ * Creates an exporter with the size and frame duration of @canvas.
+ *
+ * Returns: a new [class@VideoExporter], call [method@VideoExporter.open]
+ *          before adding frames.
+ */
+PsyVideoExporter *
+psy_video_exporter_new_for_canvas(PsyCanvas *canvas, const gchar *filename)
+{
+    g_return_val_if_fail(PSY_IS_CANVAS(canvas), NULL);
+
+    return psy_video_exporter_new(filename,
+                                  psy_canvas_get_width(canvas),
+                                  psy_canvas_get_height(canvas),
+                                  psy_canvas_get_frame_dur(canvas));
+}
+
+/**
+ * psy_video_exporter_free:(skip)
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Frees instances of [class@VideoExporter]
+ */
+void
+psy_video_exporter_free(PsyVideoExporter *self)
+{
+    g_return_if_fail(PSY_IS_VIDEO_EXPORTER(self));
+    g_object_unref(self);
+}
+
+/**
+ * psy_video_exporter_get_filename:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the path of the video file
+ */
+const gchar *
+psy_video_exporter_get_filename(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), NULL);
+    return self->filename;
+}
+
+/**
+ * psy_video_exporter_get_width:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the width of the video in pixels
+ */
+gint
+psy_video_exporter_get_width(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), 0);
+    return self->width;
+}
+
+/**
+ * psy_video_exporter_get_height:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the height of the video in pixels
+ */
+gint
+psy_video_exporter_get_height(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), 0);
+    return self->height;
+}
+
+/**
+ * psy_video_exporter_get_frame_dur:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns:(transfer none): the duration of one frame of the video
+ */
+PsyDuration *
+psy_video_exporter_get_frame_dur(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), NULL);
+    return self->frame_dur;
+}
+
+/**
+ * psy_video_exporter_set_encoder:
+ * @self: an instance of [class@VideoExporter]
+ * @encoder: a GStreamer description of the encoder
+ *
+ * See [property@VideoExporter:encoder], this has effect the next time the
+ * exporter is opened.
+ */
+void
+psy_video_exporter_set_encoder(PsyVideoExporter *self, const gchar *encoder)
+{
+    g_return_if_fail(PSY_IS_VIDEO_EXPORTER(self));
+    g_return_if_fail(encoder != NULL);
+
+    g_free(self->encoder);
+    self->encoder = g_strdup(encoder);
+}
+
+/**
+ * psy_video_exporter_get_encoder:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the GStreamer description of the encoder
+ */
+const gchar *
+psy_video_exporter_get_encoder(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), NULL);
+    return self->encoder;
+}
+
+/**
+ * psy_video_exporter_set_muxer:
+ * @self: an instance of [class@VideoExporter]
+ * @muxer: a GStreamer description of the muxer
+ *
+ * See [property@VideoExporter:muxer], this has effect the next time the
+ * exporter is opened.
+ */
+void
+psy_video_exporter_set_muxer(PsyVideoExporter *self, const gchar *muxer)
+{
+    g_return_if_fail(PSY_IS_VIDEO_EXPORTER(self));
+    g_return_if_fail(muxer != NULL);
+
+    g_free(self->muxer);
+    self->muxer = g_strdup(muxer);
+}
+
+/**
+ * psy_video_exporter_get_muxer:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the GStreamer description of the muxer
+ */
+const gchar *
+psy_video_exporter_get_muxer(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), NULL);
+    return self->muxer;
+}
+
+/**
+ * psy_video_exporter_set_max_queued_frames:
+ * @self: an instance of [class@VideoExporter]
+ * @max_queued_frames: the number of frames that may be queued
+ *
+ * See [property@VideoExporter:max-queued-frames]
+ */
+void
+psy_video_exporter_set_max_queued_frames(PsyVideoExporter *self,
+                                         guint             max_queued_frames)
+{
+    g_return_if_fail(PSY_IS_VIDEO_EXPORTER(self));
+    g_return_if_fail(max_queued_frames > 0);
+
+    self->max_queued_frames = max_queued_frames;
+}
+
+/**
+ * psy_video_exporter_get_max_queued_frames:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the number of frames that may be queued
+ */
+guint
+psy_video_exporter_get_max_queued_frames(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), 0);
+    return self->max_queued_frames;
+}
+
+/**
+ * psy_video_exporter_get_num_frames:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: the number of frames added since @self was opened
+ */
+guint64
+psy_video_exporter_get_num_frames(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), 0);
+    return self->num_frames;
+}
+
+/**
+ * psy_video_exporter_get_is_open:
+ * @self: an instance of [class@VideoExporter]
+ *
+ * Returns: TRUE when @self accepts frames
+ */
+gboolean
+psy_video_exporter_get_is_open(PsyVideoExporter *self)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), FALSE);
+    return self->pipeline != NULL;
+}
+
+/**
+ * psy_video_exporter_open:
+ * @self: an instance of [class@VideoExporter]
+ * @error: an error is returned here when the pipeline can't be created
+ *
+ * Creates and starts the pipeline that encodes the video.
+ *
+ * Returns: TRUE when @self accepts frames
+ */
+gboolean
+psy_video_exporter_open(PsyVideoExporter *self, GError **error)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (self->pipeline) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_STATE,
+                    "The exporter for '%s' is open already",
+                    self->filename);
+        return FALSE;
+    }
+
+    if (!self->filename || !self->frame_dur) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_STATE,
+                    "The exporter needs a filename and a frame duration");
+        return FALSE;
+    }
+
+    if (!gst_init_check(NULL, NULL, error))
+        return FALSE;
+
+    // The queue lets converting and encoding run on separate threads.
+    gchar *description = g_strdup_printf(
+        "appsrc name=src format=time ! videoconvert n-threads=0 ! queue ! "
+        "%s ! %s ! filesink name=sink",
+        self->encoder,
+        self->muxer);
+    GError     *parse_error = NULL;
+    GstElement *pipeline    = gst_parse_launch(description, &parse_error);
+    g_free(description);
+
+    if (parse_error) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "Unable to create a pipeline for '%s': %s",
+                    self->filename,
+                    parse_error->message);
+        g_error_free(parse_error);
+        gst_clear_object(&pipeline);
+        return FALSE;
+    }
+
+    GstElement *src  = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    g_object_set(sink, "location", self->filename, NULL);
+    gst_object_unref(sink);
+
+    gst_util_double_to_fraction(1.0 / psy_duration_get_seconds(self->frame_dur),
+                                &self->fps_n,
+                                &self->fps_d);
+
+    // PsyImages are stored from the top row down, without padding.
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+                                        "format",
+                                        G_TYPE_STRING,
+                                        "RGBA",
+                                        "width",
+                                        G_TYPE_INT,
+                                        self->width,
+                                        "height",
+                                        G_TYPE_INT,
+                                        self->height,
+                                        "framerate",
+                                        GST_TYPE_FRACTION,
+                                        self->fps_n,
+                                        self->fps_d,
+                                        NULL);
+
+    self->pipeline = pipeline;
+    self->app_src  = GST_APP_SRC(src);
+    self->bus      = gst_element_get_bus(pipeline);
+
+    gst_app_src_set_caps(self->app_src, caps);
+
+    // The frames are copied into buffers of this pool, so the images return
+    // to their owner, e.g. the image pool of a PsyGlCanvas, right away and
+    // the buffers are reused once they have been encoded.
+    self->buffer_pool    = gst_buffer_pool_new();
+    GstStructure *config = gst_buffer_pool_get_config(self->buffer_pool);
+    gst_buffer_pool_config_set_params(config,
+                                      caps,
+                                      (guint) self->width * self->height * 4,
+                                      self->max_queued_frames,
+                                      0);
+    gboolean pool_ok = gst_buffer_pool_set_config(self->buffer_pool, config)
+                       && gst_buffer_pool_set_active(self->buffer_pool, TRUE);
+    gst_caps_unref(caps);
+
+    if (!pool_ok) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "Unable to create the buffers for '%s'",
+                    self->filename);
+        video_exporter_destroy_pipeline(self);
+        return FALSE;
+    }
+
+    self->failed      = FALSE;
+    self->first_frame = 0;
+    self->num_frames  = 0;
+
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING)
+            == GST_STATE_CHANGE_FAILURE
+        || !video_exporter_check_bus(self, 0, error)) {
+        if (error && !*error)
+            g_set_error(error,
+                        PSY_VIDEO_EXPORTER_ERROR,
+                        PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                        "Unable to start the pipeline for '%s'",
+                        self->filename);
+        video_exporter_destroy_pipeline(self);
+        return FALSE;
+    }
+
+    g_object_notify_by_pspec(G_OBJECT(self),
+                             video_exporter_properties[PROP_IS_OPEN]);
+    return TRUE;
+}
+
+/**
+ * psy_video_exporter_add_frame:
+ * @self: an instance of [class@VideoExporter]
+ * @image: the content of the frame, an image in the format
+ *         PSY_IMAGE_FORMAT_RGBA with the size of the video
+ * @frame_num: the number of the frame, this determines its timestamp
+ * @error: an error is returned here when the frame can't be encoded
+ *
+ * Queues @image for encoding. The pixels of @image are copied into a buffer
+ * that is reused once the frame has been encoded, so @image may be reused
+ * as soon as this returns. When [property@VideoExporter:max-queued-frames]
+ * frames are queued, this waits until the pipeline has caught up.
+ *
+ * Returns: TRUE when @image has been queued
+ */
+gboolean
+psy_video_exporter_add_frame(PsyVideoExporter *self,
+                             PsyImage         *image,
+                             guint64           frame_num,
+                             GError          **error)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), FALSE);
+    g_return_val_if_fail(PSY_IS_IMAGE(image), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (!self->pipeline) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_STATE,
+                    "The exporter for '%s' isn't open",
+                    self->filename);
+        return FALSE;
+    }
+
+    if (self->failed) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "The pipeline for '%s' has failed before",
+                    self->filename);
+        return FALSE;
+    }
+
+    if (psy_image_get_format(image) != PSY_IMAGE_FORMAT_RGBA
+        || psy_image_get_width(image) != (guint) self->width
+        || psy_image_get_height(image) != (guint) self->height) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_FORMAT,
+                    "A frame of %u * %u doesn't fit a RGBA video of %d * %d",
+                    psy_image_get_width(image),
+                    psy_image_get_height(image),
+                    self->width,
+                    self->height);
+        return FALSE;
+    }
+
+    if (self->num_frames == 0)
+        self->first_frame = frame_num;
+
+    if (frame_num < self->first_frame) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_FORMAT,
+                    "Frame %" G_GUINT64_FORMAT " precedes the first frame %"
+                    G_GUINT64_FORMAT " of the video",
+                    frame_num,
+                    self->first_frame);
+        return FALSE;
+    }
+
+    // Backpressure: wait while the pipeline is behind, but stop as soon as
+    // it reports an error, as then it never catches up.
+    guint64 frame_bytes = psy_image_get_num_bytes(image);
+    guint64 max_bytes   = frame_bytes * self->max_queued_frames;
+    while (gst_app_src_get_current_level_bytes(self->app_src) >= max_bytes) {
+        if (!video_exporter_check_bus(self, BACKPRESSURE_POLL_NS, error))
+            return FALSE;
+    }
+
+    // Holding on to image would keep it out of the pool of its canvas until
+    // it has been encoded, so the pixels are copied into a recycled buffer.
+    GstBuffer    *buffer = NULL;
+    GstFlowReturn ret
+        = gst_buffer_pool_acquire_buffer(self->buffer_pool, &buffer, NULL);
+    if (ret != GST_FLOW_OK) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "Unable to obtain a buffer for '%s': %s",
+                    self->filename,
+                    gst_flow_get_name(ret));
+        return FALSE;
+    }
+    gst_buffer_fill(buffer, 0, psy_image_get_ptr(image), frame_bytes);
+
+    // Scaling the index avoids the drift of a rounded frame duration.
+    guint64      index = frame_num - self->first_frame;
+    GstClockTime pts   = gst_util_uint64_scale(
+        index, (guint64) self->fps_d * GST_SECOND, (guint64) self->fps_n);
+    GstClockTime next = gst_util_uint64_scale(
+        index + 1, (guint64) self->fps_d * GST_SECOND, (guint64) self->fps_n);
+    GST_BUFFER_PTS(buffer)      = pts;
+    GST_BUFFER_DURATION(buffer) = next - pts;
+
+    // This takes the reference to buffer.
+    ret = gst_app_src_push_buffer(self->app_src, buffer);
+    if (ret != GST_FLOW_OK) {
+        // The pipeline won't handle end of stream anymore either.
+        self->failed = TRUE;
+        if (video_exporter_check_bus(self, 0, error))
+            g_set_error(error,
+                        PSY_VIDEO_EXPORTER_ERROR,
+                        PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                        "Unable to queue a frame for '%s': %s",
+                        self->filename,
+                        gst_flow_get_name(ret));
+        return FALSE;
+    }
+
+    self->num_frames++;
+    return video_exporter_check_bus(self, 0, error);
+}
+
+/**
+ * psy_video_exporter_close:
+ * @self: an instance of [class@VideoExporter]
+ * @error: an error is returned here when the video couldn't be completed
+ *
+ * Waits until all queued frames have been encoded, finishes the video file
+ * and stops the pipeline. Afterwards, @self may be opened again. When the
+ * pipeline has failed before, it is stopped right away and an error is
+ * returned, as the video is incomplete.
+ *
+ * Returns: TRUE when the video has been written completely
+ */
+gboolean
+psy_video_exporter_close(PsyVideoExporter *self, GError **error)
+{
+    g_return_val_if_fail(PSY_IS_VIDEO_EXPORTER(self), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (!self->pipeline) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_STATE,
+                    "The exporter for '%s' isn't open",
+                    self->filename);
+        return FALSE;
+    }
+
+    gboolean    ret = TRUE;
+    GstMessage *msg = NULL;
+
+    // A failed pipeline never posts end of stream, don't wait for it.
+    if (self->failed) {
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "Unable to finish '%s', the pipeline has failed before",
+                    self->filename);
+        video_exporter_destroy_pipeline(self);
+        g_object_notify_by_pspec(G_OBJECT(self),
+                                 video_exporter_properties[PROP_IS_OPEN]);
+        return FALSE;
+    }
+
+    gst_app_src_end_of_stream(self->app_src);
+
+    // The muxer writes its trailer before end of stream reaches the sink.
+    msg = gst_bus_timed_pop_filtered(
+        self->bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError *gst_error = NULL;
+        gst_message_parse_error(msg, &gst_error, NULL);
+        g_set_error(error,
+                    PSY_VIDEO_EXPORTER_ERROR,
+                    PSY_VIDEO_EXPORTER_ERROR_PIPELINE,
+                    "Unable to finish '%s': %s",
+                    self->filename,
+                    gst_error->message);
+        g_error_free(gst_error);
+        ret = FALSE;
+    }
+    gst_message_unref(msg);
+
+    video_exporter_destroy_pipeline(self);
+    g_object_notify_by_pspec(G_OBJECT(self),
+                             video_exporter_properties[PROP_IS_OPEN]);
+
+    return ret;
+}
@@ -0,0 +1,84 @@
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "psy-canvas.h"
+#include "psy-duration.h"
+#include "psy-image.h"
+
+G_BEGIN_DECLS
+
+#define PSY_VIDEO_EXPORTER_ERROR psy_video_exporter_error_quark()
+
+G_MODULE_EXPORT GQuark
+psy_video_exporter_error_quark(void);
+
+#define PSY_TYPE_VIDEO_EXPORTER psy_video_exporter_get_type()
+
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(
+    PsyVideoExporter, psy_video_exporter, PSY, VIDEO_EXPORTER, GObject)
+
+G_MODULE_EXPORT PsyVideoExporter *
+psy_video_exporter_new(const gchar *filename,
+                       gint         width,
+                       gint         height,
+                       PsyDuration *frame_dur);
+
+G_MODULE_EXPORT PsyVideoExporter *
+psy_video_exporter_new_for_canvas(PsyCanvas *canvas, const gchar *filename);
+
+G_MODULE_EXPORT void
+psy_video_exporter_free(PsyVideoExporter *self);
+
+G_MODULE_EXPORT const gchar *
+psy_video_exporter_get_filename(PsyVideoExporter *self);
+
+G_MODULE_EXPORT gint
+psy_video_exporter_get_width(PsyVideoExporter *self);
+
+G_MODULE_EXPORT gint
+psy_video_exporter_get_height(PsyVideoExporter *self);
+
+G_MODULE_EXPORT PsyDuration *
+psy_video_exporter_get_frame_dur(PsyVideoExporter *self);
+
+G_MODULE_EXPORT void
+psy_video_exporter_set_encoder(PsyVideoExporter *self, const gchar *encoder);
+
+G_MODULE_EXPORT const gchar *
+psy_video_exporter_get_encoder(PsyVideoExporter *self);
+
+G_MODULE_EXPORT void
+psy_video_exporter_set_muxer(PsyVideoExporter *self, const gchar *muxer);
+
+G_MODULE_EXPORT const gchar *
+psy_video_exporter_get_muxer(PsyVideoExporter *self);
+
+G_MODULE_EXPORT void
+psy_video_exporter_set_max_queued_frames(PsyVideoExporter *self,
+                                         guint             max_queued_frames);
+
+G_MODULE_EXPORT guint
+psy_video_exporter_get_max_queued_frames(PsyVideoExporter *self);
+
+G_MODULE_EXPORT guint64
+psy_video_exporter_get_num_frames(PsyVideoExporter *self);
+
+G_MODULE_EXPORT gboolean
+psy_video_exporter_get_is_open(PsyVideoExporter *self);
+
+G_MODULE_EXPORT gboolean
+psy_video_exporter_open(PsyVideoExporter *self, GError **error);
+
+G_MODULE_EXPORT gboolean
+psy_video_exporter_add_frame(PsyVideoExporter *self,
+                             PsyImage         *image,
+                             guint64           frame_num,
+                             GError          **error);
+
+G_MODULE_EXPORT gboolean
+psy_video_exporter_close(PsyVideoExporter *self, GError **error);
+
+G_END_DECLS
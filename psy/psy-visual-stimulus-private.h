@@ -0,0 +1,14 @@
+#pragma once
+
+#include "psy-visual-stimulus.h"
+
+G_BEGIN_DECLS
+
+guint
+psy_visual_stimulus_get_transform_serial(PsyVisualStimulus *self);
+
+void
+psy_visual_stimulus_set_onset_time(PsyVisualStimulus *self,
+                                   PsyTimePoint      *onset_time);
+
+G_END_DECLS
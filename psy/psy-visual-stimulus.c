@@ -3,6 +3,7 @@
 
 #include "psy-color.h"
 #include "psy-stimulus.h"
+#include "psy-visual-stimulus-private.h"
 #include "psy-visual-stimulus.h"
 
 /**
@@ -40,7 +41,9 @@ typedef struct PsyVisualStimulusPrivate {
     gfloat scale_x, scale_y;
     gfloat rotation; // Positive rotation follows the angle on the unit
                      // circle, so rotation is applied counter clockwise.
+    guint transform_serial; // Incremented when x/y/z/scale/rotation change
     PsyColor *color; // The default fill color of the stimulus
+    PsyTimePoint *onset_time; // The reported presentation of the first frame
 } PsyVisualStimulusPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(PsyVisualStimulus,
@@ -63,6 +66,7 @@ typedef enum {
     PROP_ROTATION,     // Rotation around the z axis
     PROP_ROTATION_DEG, // Rotation around the z axis
     PROP_COLOR,        // the fill color of the stimulus.
+    PROP_ONSET_TIME,   // the actual presentation time of the first frame
     NUM_PROPERTIES
 } VisualStimulusProperty;
 
@@ -117,6 +121,7 @@ psy_visual_stimulus_set_property(GObject      *object,
     case PROP_NUM_FRAMES: // gettable only
     case PROP_NTH_FRAME:  // gettable only
     case PROP_START_FRAME:
+    case PROP_ONSET_TIME:
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -169,6 +174,9 @@ psy_visual_stimulus_get_property(GObject    *object,
     case PROP_COLOR:
         g_value_set_object(value, psy_visual_stimulus_get_color(self));
         break;
+    case PROP_ONSET_TIME:
+        g_value_set_boxed(value, priv->onset_time);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
     }
@@ -182,6 +190,7 @@ psy_visual_stimulus_dispose(GObject *object)
 
     g_clear_object(&priv->color);
     g_clear_object(&priv->canvas);
+    g_clear_pointer(&priv->onset_time, psy_time_point_free);
 
     G_OBJECT_CLASS(psy_visual_stimulus_parent_class)->dispose(object);
 }
@@ -196,6 +205,8 @@ psy_visual_stimulus_init(PsyVisualStimulus *self)
     priv->num_frames  = -1;
     priv->start_frame = -1;
     priv->color       = psy_color_new();
+
+    priv->transform_serial = 1;
 }
 
 static void
@@ -456,6 +467,11 @@ psy_visual_stimulus_class_init(PsyVisualStimulusClass *klass)
      * PsyVisualStimulus:color
      *
      * The color `PsyColor` used to fill this object with
+     *
+     * The alpha of the color is honored: the canvases draw with alpha
+     * blending enabled, so a stimulus whose alpha is below 1.0 is blended
+     * with what has been drawn behind it. Use an alpha of 1.0 for opaque
+     * stimuli.
      */
     visual_stimulus_properties[PROP_COLOR]
         = g_param_spec_object("color",
@@ -464,6 +480,24 @@ psy_visual_stimulus_class_init(PsyVisualStimulusClass *klass)
                               PSY_TYPE_COLOR,
                               G_PARAM_READWRITE);
 
+    /**
+     * PsyVisualStimulus:onset-time:
+     *
+     * The time at which the first frame of this stimulus has actually been
+     * presented, as reported by the display backend. This is NULL until the
+     * backend has reported it, which may happen a few frames after the
+     * stimulus has started, and it remains NULL when the backend is unable to
+     * report the presentation time. Connect to the notify signal of this
+     * property in order to log the real visual onset of a stimulus rather
+     * than the predicted one.
+     */
+    visual_stimulus_properties[PROP_ONSET_TIME] = g_param_spec_boxed(
+        "onset-time",
+        "OnsetTime",
+        "The time at which the first frame has actually been presented",
+        PSY_TYPE_TIME_POINT,
+        G_PARAM_READABLE);
+
     g_object_class_install_properties(
         object_class, NUM_PROPERTIES, visual_stimulus_properties);
 
@@ -656,6 +690,49 @@ psy_visual_stimulus_get_start_frame(PsyVisualStimulus *self)
     return priv->start_frame;
 }
 
+/**
+ * psy_visual_stimulus_get_onset_time:
+ * @self: an instance of `PsyVisualStimulus`
+ *
+ * See [property@VisualStimulus:onset-time].
+ *
+ * Returns:(transfer none)(nullable): The time at which the first frame of
+ *          @self has actually been presented, or NULL when it isn't known.
+ */
+PsyTimePoint *
+psy_visual_stimulus_get_onset_time(PsyVisualStimulus *self)
+{
+    g_return_val_if_fail(PSY_IS_VISUAL_STIMULUS(self), NULL);
+    PsyVisualStimulusPrivate *priv
+        = psy_visual_stimulus_get_instance_private(self);
+
+    return priv->onset_time;
+}
+
+/**
+ * psy_visual_stimulus_set_onset_time:(skip)
+ * @self: an instance of `PsyVisualStimulus`
+ * @onset_time:(transfer none): the presentation time of the first frame
+ *
+ * Used by the canvas to report the actual onset of @self.
+ *
+ * Stability: private
+ */
+void
+psy_visual_stimulus_set_onset_time(PsyVisualStimulus *self,
+                                   PsyTimePoint      *onset_time)
+{
+    g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
+    g_return_if_fail(onset_time != NULL);
+    PsyVisualStimulusPrivate *priv
+        = psy_visual_stimulus_get_instance_private(self);
+
+    g_clear_pointer(&priv->onset_time, psy_time_point_free);
+    priv->onset_time = psy_time_point_copy(onset_time);
+    g_object_notify_by_pspec(G_OBJECT(self),
+                             visual_stimulus_properties[PROP_ONSET_TIME]);
+}
+
 /**
  * psy_visual_stimulus_get_x:
  * @self: an instance of `PsyVisualStimulus`
@@ -689,6 +766,7 @@ psy_visual_stimulus_set_x(PsyVisualStimulus *self, gfloat x)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->x = x;
+    priv->transform_serial++;
 }
 
 /**
@@ -724,6 +802,7 @@ psy_visual_stimulus_set_y(PsyVisualStimulus *self, gfloat y)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->y = y;
+    priv->transform_serial++;
 }
 
 /**
@@ -759,6 +838,7 @@ psy_visual_stimulus_set_z(PsyVisualStimulus *self, gfloat z)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->z = z;
+    priv->transform_serial++;
 }
 
 /**
@@ -794,6 +874,7 @@ psy_visual_stimulus_set_scale_x(PsyVisualStimulus *self, gfloat x)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->scale_x = x;
+    priv->transform_serial++;
 }
 
 /**
@@ -829,6 +910,7 @@ psy_visual_stimulus_set_scale_y(PsyVisualStimulus *self, gfloat y)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->scale_y = y;
+    priv->transform_serial++;
 }
 
 /**
@@ -874,6 +956,7 @@ psy_visual_stimulus_set_rotation(PsyVisualStimulus *self, gfloat rotation)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->rotation = rotation;
+    priv->transform_serial++;
 }
 
 /**
@@ -911,6 +994,7 @@ psy_visual_stimulus_set_rotation_deg(PsyVisualStimulus *self, gfloat rotation)
     g_return_if_fail(PSY_IS_VISUAL_STIMULUS(self));
 
     priv->rotation = psy_degrees_to_radians(rotation);
+    priv->transform_serial++;
 }
 
 /**
@@ -973,6 +1057,26 @@ psy_visual_stimulus_create_artist(PsyVisualStimulus *self)
     return cls->create_artist(self);
 }
 
+/**
+ * psy_visual_stimulus_get_transform_serial:(skip)
+ * @self: an instance of `PsyVisualStimulus`
+ *
+ * The serial is incremented every time the position, scale or rotation of
+ * @self is set. An artist may compare it with the serial it has seen before,
+ * in order to find out whether its cached model matrix is still valid.
+ *
+ * Returns: the current serial of the transformation of @self
+ * Stability: private
+ */
+guint
+psy_visual_stimulus_get_transform_serial(PsyVisualStimulus *self)
+{
+    PsyVisualStimulusPrivate *priv
+        = psy_visual_stimulus_get_instance_private(self);
+
+    return priv->transform_serial;
+}
+
 /* ************ utility functions for unit conversions ************** */
 
 /**
@@ -69,6 +69,9 @@ psy_visual_stimulus_set_start_frame(PsyVisualStimulus *self, gint64 frame_num);
 G_MODULE_EXPORT gint64
 psy_visual_stimulus_get_start_frame(PsyVisualStimulus *self);
 
+G_MODULE_EXPORT PsyTimePoint *
+psy_visual_stimulus_get_onset_time(PsyVisualStimulus *self);
+
 G_MODULE_EXPORT gfloat
 psy_visual_stimulus_get_x(PsyVisualStimulus *self);
 G_MODULE_EXPORT void
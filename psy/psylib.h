@@ -18,6 +18,8 @@
 #include "psy-duration.h"
 #include "psy-enums.h"
 #include "psy-font-utils.h"
+#include "psy-frame-stats.h"
+#include "psy-gpu-timer.h"
 #include "psy-image-canvas.h"
 #include "psy-image.h"
 #include "psy-init.h"
@@ -25,6 +27,7 @@
 #include "psy-matrix4.h"
 #include "psy-picture-artist.h"
 #include "psy-picture.h"
+#include "psy-presentation-log.h"
 #include "psy-random.h"
 #include "psy-rectangle-artist.h"
 #include "psy-rectangle.h"
@@ -36,6 +39,7 @@
 #include "psy-stimulus.h"
 #include "psy-text-artist.h"
 #include "psy-text.h"
+#include "psy-texture-atlas.h"
 #include "psy-texture.h"
 #include "psy-time-point.h"
 #include "psy-timer.h"
@@ -44,6 +48,7 @@
 #include "psy-vbuffer.h"
 #include "psy-vector.h"
 #include "psy-vector4.h"
+#include "psy-video-exporter.h"
 #include "psy-visual-stimulus.h"
 #include "psy-wave.h"
 #include "psy-window.h"
@@ -62,14 +67,20 @@
 #include "gl/psy-gl-context.h"
 #include "gl/psy-gl-error.h"
 #include "gl/psy-gl-fragment-shader.h"
+#include "gl/psy-gl-gpu-timer.h"
 #include "gl/psy-gl-program.h"
+#include "gl/psy-gl-render-pool.h"
 #include "gl/psy-gl-shader.h"
 #include "gl/psy-gl-texture.h"
 #include "gl/psy-gl-vbuffer.h"
 #include "gl/psy-gl-vertex-shader.h"
 
+#include "hw/psy-fake-parallel-port.h"
 #include "hw/psy-parallel-port.h"
 #include "hw/psy-parallel-trigger.h"
 #include "hw/psy-parport.h"
+#include "hw/psy-response-box.h"
+#include "hw/psy-serial-port.h"
+#include "hw/psy-trigger-device.h"
 
 #endif
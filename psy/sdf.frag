@@ -0,0 +1,52 @@
+#version 330 core
+
+in vec2 localPos;
+
+out vec4 FragColor;
+
+uniform vec4 ourColor;
+uniform vec4 sdfParams; // half width, half height, shape parameter, shape
+
+const float SHAPE_ELLIPSE           = 0.0;
+const float SHAPE_ANNULUS           = 1.0;
+const float SHAPE_ROUNDED_RECTANGLE = 2.0;
+
+// An approximation of the distance to an ellipse, exact for a disc.
+float
+ellipse(vec2 p, vec2 radii)
+{
+    float k1 = length(p / radii);
+    float k2 = length(p / (radii * radii));
+    return k2 > 0.0 ? k1 * (k1 - 1.0) / k2 : -min(radii.x, radii.y);
+}
+
+float
+annulus(vec2 p, float outer, float inner)
+{
+    return abs(length(p) - (outer + inner) / 2.0) - (outer - inner) / 2.0;
+}
+
+float
+rounded_rectangle(vec2 p, vec2 half_size, float radius)
+{
+    vec2 q = abs(p) - half_size + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+void main()
+{
+    float d;
+    if (sdfParams.w == SHAPE_ANNULUS)
+        d = annulus(localPos, sdfParams.x, sdfParams.z);
+    else if (sdfParams.w == SHAPE_ROUNDED_RECTANGLE)
+        d = rounded_rectangle(localPos, sdfParams.xy, sdfParams.z);
+    else
+        d = ellipse(localPos, sdfParams.xy);
+
+    // Cover the pixels on the edge according to their distance to it.
+    float coverage = clamp(0.5 - d / fwidth(d), 0.0, 1.0);
+    if (coverage <= 0.0)
+        discard;
+
+    FragColor = vec4(ourColor.rgb, ourColor.a * coverage);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos; // a unit square around the origin
+
+uniform mat4 projection;
+uniform mat4 model;
+uniform vec4 sdfParams; // half width, half height, shape parameter, shape
+
+out vec2 localPos; // the position relative to the center of the shape
+
+// The quad is a little larger than the shape, so its edge can be smoothed.
+const float margin = 1.0;
+
+void main()
+{
+    localPos    = aPos.xy * 2.0 * (sdfParams.xy + margin);
+    gl_Position = projection * model * vec4(localPos, 0.0, 1.0);
+}
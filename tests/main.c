@@ -117,6 +117,10 @@ add_suites_to_registry(void)
     if (error)
         return error;
 
+    error = add_serial_suite();
+    if (error)
+        return error;
+
     error = add_stepping_suite();
     if (error)
         return error;
@@ -5,13 +5,17 @@
 const gchar *g_option_str = "This is a small program to test triggers with a "
                             "PsyParallelTriggerDevice";
 
-gint dur_ms       = 1;
-gint num_triggers = 1000;
+gint     dur_ms       = 1;
+gint     num_triggers = 1000;
+gint     interval_ms  = 5;
+gboolean sequence     = FALSE;
 
 // clang-format off
 static GOptionEntry entries[] = {
     {"duration", 'd', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &dur_ms,        "The duration of the trigger", NULL},
     {"num",      'n', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &num_triggers,  "The number of triggers",      NULL},
+    {"sequence", 's', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &sequence,     "Schedule all triggers at once", NULL},
+    {"interval", 'i', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &interval_ms,   "The ms between the onsets of a sequence", NULL},
     {0}
 };
 
@@ -47,6 +51,61 @@ finished(PsyParallelTrigger *trigger,
     g_object_unref(newtp);
 }
 
+void
+events_written(PsyParallelTrigger *trigger, GPtrArray *events, gpointer data)
+{
+    (void) trigger;
+    TriggerInfo *info = data;
+
+    for (guint i = 0; i < events->len; i++) {
+        PsyParallelTriggerEvent *event = g_ptr_array_index(events, i);
+
+        PsyTimePoint *tstart = psy_parallel_trigger_event_get_start(event);
+        PsyTimePoint *twritten
+            = psy_parallel_trigger_event_get_written_start(event);
+
+        if (twritten) {
+            PsyDuration *late = psy_time_point_subtract(twritten, tstart);
+            g_print("trigger written %" G_GINT64_FORMAT " us late\n",
+                    psy_duration_get_us(late));
+            psy_duration_free(late);
+            psy_time_point_free(twritten);
+        }
+        psy_time_point_free(tstart);
+    }
+
+    info->n -= MIN(info->n, events->len);
+    if (info->n == 0)
+        g_main_loop_quit(info->loop);
+}
+
+static void
+schedule_sequence(PsyParallelTrigger *trigger,
+                  PsyTimePoint       *tstart,
+                  PsyDuration        *dur,
+                  GError            **error)
+{
+    PsyDuration *interval = psy_duration_new_ms(interval_ms);
+    GPtrArray   *events   = g_ptr_array_new_full(
+        num_triggers, (GDestroyNotify) psy_parallel_trigger_event_free);
+
+    PsyTimePoint *tp = psy_time_point_copy(tstart);
+    for (gint i = 0; i < num_triggers; i++) {
+        PsyTimePoint *next = psy_time_point_add(tp, interval);
+        g_ptr_array_add(events,
+                        psy_parallel_trigger_event_new(
+                            (guint8) (i % 255 + 1), tp, dur));
+        psy_time_point_free(tp);
+        tp = next;
+    }
+
+    psy_parallel_trigger_schedule_events(trigger, events, error);
+
+    psy_time_point_free(tp);
+    g_ptr_array_unref(events);
+    psy_duration_free(interval);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -78,6 +137,8 @@ main(int argc, char **argv)
     PsyParallelTrigger *trigger = psy_parallel_trigger_new();
 
     g_signal_connect(trigger, "finished", G_CALLBACK(finished), &info);
+    g_signal_connect(
+        trigger, "events-written", G_CALLBACK(events_written), &info);
 
     psy_parallel_trigger_open(trigger, 0, &error);
     if (error) {
@@ -91,8 +152,11 @@ main(int argc, char **argv)
     onset_dur     = psy_duration_new_ms(5);
     trigger_start = psy_time_point_add(now, onset_dur);
 
-    psy_parallel_trigger_write(
-        trigger, 255, trigger_start, trigger_dur, &error);
+    if (sequence)
+        schedule_sequence(trigger, trigger_start, trigger_dur, &error);
+    else
+        psy_parallel_trigger_write(
+            trigger, 255, trigger_start, trigger_dur, &error);
 
     if (error) {
         g_printerr("Unable to write trigger: %s\n", error->message);
@@ -39,6 +39,9 @@ add_picture_suite(void);
 int
 add_queue_suite(void);
 
+int
+add_serial_suite(void);
+
 int
 add_ref_count_suite(void);
 
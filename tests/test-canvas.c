@@ -2,9 +2,12 @@
 
 #include <CUnit/CUnit.h>
 #include <CUnit/TestDB.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 #include "unit-test-utilities.h"
 #include <gl/psy-gl-canvas.h>
+#include <psy-clock.h>
 
 const gint WIDTH  = 640;
 const gint HEIGHT = 480;
@@ -128,6 +131,193 @@ canvas_size_vd(void)
     g_object_unref(canvas);
 }
 
+static void
+canvas_instrument(void)
+{
+    PsyGlCanvas   *glcanvas = psy_gl_canvas_new(WIDTH, HEIGHT);
+    PsyCanvas     *canvas   = PSY_CANVAS(glcanvas);
+    PsyFrameStats *stats    = psy_canvas_get_frame_stats(canvas);
+    PsyTimePoint  *tp_null  = psy_time_point_new();
+    GError        *error    = NULL;
+    const guint    nframes  = 5;
+    guint64        num, num_gpu;
+    gdouble        cpu_mean, cpu_max, gpu_mean, gpu_max;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(stats);
+    CU_ASSERT_FALSE(psy_canvas_get_instrument(canvas));
+
+    PsyCircle *circle = psy_circle_new_full(canvas, 0, 0, 50, 20);
+    psy_stimulus_play(PSY_STIMULUS(circle), tp_null);
+
+    // Without instrumentation nothing is measured.
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(glcanvas));
+    CU_ASSERT_EQUAL(psy_frame_stats_get_num_frames(stats), 0);
+
+    psy_canvas_set_instrument(canvas, TRUE);
+    psy_frame_stats_set_trace_enabled(stats, TRUE);
+    for (guint i = 0; i < nframes; i++)
+        psy_image_canvas_iterate(PSY_IMAGE_CANVAS(glcanvas));
+
+    CU_ASSERT_EQUAL(psy_frame_stats_get_num_frames(stats), nframes);
+
+    gchar **names = psy_frame_stats_get_section_names(stats);
+    CU_ASSERT_TRUE(g_strv_contains((const gchar *const *) names, "draw"));
+    CU_ASSERT_TRUE(g_strv_contains((const gchar *const *) names, "clear"));
+    CU_ASSERT_TRUE(g_strv_contains((const gchar *const *) names, "PsyCircle"));
+    g_strfreev(names);
+
+    CU_ASSERT_TRUE(psy_frame_stats_get_section(stats,
+                                               "draw",
+                                               &num,
+                                               &cpu_mean,
+                                               &cpu_max,
+                                               &num_gpu,
+                                               &gpu_mean,
+                                               &gpu_max));
+    CU_ASSERT_EQUAL(num, nframes);
+    CU_ASSERT_TRUE(cpu_mean > 0 && cpu_mean <= cpu_max);
+    // The GPU lags behind, at most the last frames are missing.
+    CU_ASSERT_TRUE(num_gpu <= nframes);
+    if (num_gpu > 0)
+        CU_ASSERT_TRUE(gpu_mean <= gpu_max);
+
+    CU_ASSERT_TRUE(psy_frame_stats_get_section(
+        stats, "PsyCircle", &num, NULL, NULL, NULL, NULL, NULL));
+    CU_ASSERT_EQUAL(num, nframes);
+    CU_ASSERT_FALSE(psy_frame_stats_get_section(
+        stats, "PsyNothing", NULL, NULL, NULL, NULL, NULL, NULL));
+
+    gchar *path = g_build_filename(g_get_tmp_dir(), "psy-trace.json", NULL);
+    gchar *contents = NULL;
+    CU_ASSERT_TRUE(psy_frame_stats_save_trace(stats, path, &error));
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_TRUE(g_file_get_contents(path, &contents, NULL, NULL));
+    CU_ASSERT_PTR_NOT_NULL(contents ? strstr(contents, "PsyCircle") : NULL);
+    g_remove(path);
+    g_free(contents);
+    g_free(path);
+
+    psy_frame_stats_reset(stats);
+    CU_ASSERT_EQUAL(psy_frame_stats_get_num_frames(stats), 0);
+
+    psy_time_point_free(tp_null);
+    g_object_unref(circle);
+    g_object_unref(glcanvas);
+}
+
+static void
+canvas_presentation_log(void)
+{
+    PsyPresentationLog   *log = psy_presentation_log_new(5);
+    PsyPresentationRecord records[16];
+    guint64               cursor = 0;
+
+    // The capacity is rounded up to a power of two
+    CU_ASSERT_EQUAL(psy_presentation_log_get_capacity(log), 8);
+    CU_ASSERT_EQUAL(psy_presentation_log_read(log, &cursor, records, 16), 0);
+
+    for (gint64 i = 0; i < 4; i++) {
+        PsyPresentationRecord record
+            = {.frame_counter = i, .presentation_time = 1000 * i};
+        psy_presentation_log_push(log, &record);
+    }
+    CU_ASSERT_EQUAL(psy_presentation_log_read(log, &cursor, records, 3), 3);
+    CU_ASSERT_EQUAL(records[2].frame_counter, 2);
+    CU_ASSERT_EQUAL(psy_presentation_log_read(log, &cursor, records, 16), 1);
+    CU_ASSERT_EQUAL(records[0].presentation_time, 3000);
+
+    // A reader that falls behind loses the oldest records.
+    for (gint64 i = 4; i < 20; i++) {
+        PsyPresentationRecord record = {.frame_counter = i};
+        psy_presentation_log_push(log, &record);
+    }
+    CU_ASSERT_EQUAL(psy_presentation_log_get_num_records(log), 20);
+    CU_ASSERT_EQUAL(psy_presentation_log_read(log, &cursor, records, 16), 8);
+    CU_ASSERT_EQUAL(records[0].frame_counter, 12);
+    CU_ASSERT_EQUAL(records[7].frame_counter, 19);
+    CU_ASSERT_EQUAL(cursor, 20);
+
+    psy_presentation_log_free(log);
+}
+
+static void
+canvas_offline(void)
+{
+    PsyGlCanvas    *glcanvas = psy_gl_canvas_new(WIDTH, HEIGHT);
+    PsyImageCanvas *canvas   = PSY_IMAGE_CANVAS(glcanvas);
+    const gint64    nframes  = 600;
+
+    PsyTimePoint *tp_start = psy_image_canvas_get_time(canvas);
+    PsyDuration  *frame_dur = psy_canvas_get_frame_dur(PSY_CANVAS(glcanvas));
+
+    CU_ASSERT_FALSE(psy_image_canvas_get_offline(canvas));
+    CU_ASSERT_EQUAL(psy_image_canvas_get_frames_per_second(canvas), 0);
+
+    psy_image_canvas_set_offline(canvas, TRUE);
+    psy_image_canvas_set_auto_iterate(canvas, TRUE);
+
+    // Ten seconds at 60 Hz, which should render in a fraction of that.
+    gint64 start_us = g_get_monotonic_time();
+    while (psy_canvas_get_num_frames_total(PSY_CANVAS(glcanvas)) < nframes)
+        g_main_context_iteration(NULL, FALSE);
+    gint64 elapsed_us = g_get_monotonic_time() - start_us;
+
+    psy_image_canvas_set_auto_iterate(canvas, FALSE);
+
+    PsyTimePoint *tp_end  = psy_image_canvas_get_time(canvas);
+    PsyDuration  *elapsed = psy_time_point_subtract(tp_end, tp_start);
+    PsyDuration  *expected = psy_duration_multiply_scalar(frame_dur, nframes);
+
+    // The virtual time advanced with exactly one frame per iteration.
+    CU_ASSERT_TRUE(psy_duration_equal(elapsed, expected));
+    CU_ASSERT_TRUE(elapsed_us < psy_duration_get_us(expected));
+    CU_ASSERT_TRUE(psy_image_canvas_get_frames_per_second(canvas) > 0);
+
+    psy_time_point_free(tp_start);
+    psy_time_point_free(tp_end);
+    psy_duration_free(elapsed);
+    psy_duration_free(expected);
+    g_object_unref(glcanvas);
+}
+
+static void
+canvas_throttled(void)
+{
+    PsyGlCanvas    *glcanvas = psy_gl_canvas_new(WIDTH, HEIGHT);
+    PsyImageCanvas *canvas   = PSY_IMAGE_CANVAS(glcanvas);
+    PsyClock       *clk      = psy_clock_new();
+    const gint64    run_us   = 250000;
+
+    PsyDuration *frame_dur = psy_canvas_get_frame_dur(PSY_CANVAS(glcanvas));
+    gint64       frame_us  = psy_duration_get_us(frame_dur);
+
+    // Start at the time of the clock, so the canvas has nothing to catch up.
+    psy_image_canvas_set_time(canvas, psy_clock_now(clk));
+    psy_image_canvas_set_auto_iterate(canvas, TRUE);
+
+    gint64 start_us = g_get_monotonic_time();
+    while (g_get_monotonic_time() - start_us < run_us)
+        g_main_context_iteration(NULL, FALSE);
+
+    psy_image_canvas_set_auto_iterate(canvas, FALSE);
+
+    // The canvas is at most one frame ahead of the clock.
+    PsyTimePoint *tp_now    = psy_clock_now(clk);
+    PsyTimePoint *tp_limit  = psy_time_point_add(tp_now, frame_dur);
+    PsyTimePoint *tp_canvas = psy_image_canvas_get_time(canvas);
+    CU_ASSERT_TRUE(psy_time_point_less_equal(tp_canvas, tp_limit));
+
+    gint64 num_frames = psy_canvas_get_num_frames_total(PSY_CANVAS(glcanvas));
+    CU_ASSERT_TRUE(num_frames > 0);
+    CU_ASSERT_TRUE(num_frames <= run_us / frame_us + 2);
+
+    psy_time_point_free(tp_now);
+    psy_time_point_free(tp_limit);
+    psy_time_point_free(tp_canvas);
+    g_object_unref(clk);
+    g_object_unref(glcanvas);
+}
+
 int
 add_canvas_suite(void)
 {
@@ -149,5 +339,21 @@ add_canvas_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, canvas_instrument);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, canvas_presentation_log);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, canvas_offline);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, canvas_throttled);
+    if (!test)
+        return 1;
+
     return 0;
 }
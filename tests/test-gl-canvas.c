@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include <CUnit/CUnit.h>
+#include <glib/gstdio.h>
 
 #include <psylib.h>
 
@@ -114,6 +115,210 @@ test_gl_canvas_iterate(void)
     g_object_unref(canvas);
 }
 
+typedef struct ReadbackData {
+    guint    num_images;
+    guint64  last_frame;
+    gboolean in_order;
+    gboolean correct;
+} ReadbackData;
+
+static void
+on_image_ready(PsyGlCanvas *self,
+               PsyImage    *image,
+               guint64      frame_num,
+               gpointer     user_data)
+{
+    (void) self;
+    ReadbackData *data = user_data;
+
+    if (data->num_images > 0 && frame_num != data->last_frame + 1)
+        data->in_order = FALSE;
+    data->last_frame = frame_num;
+    data->num_images++;
+
+    // The stimulus covers the top half of the canvas.
+    guint     row    = psy_image_get_height(image) / 4;
+    guint     bottom = psy_image_get_height(image) * 3 / 4;
+    PsyColor *top_px = psy_image_get_pixel(image, row, 0);
+    PsyColor *bot_px = psy_image_get_pixel(image, bottom, 0);
+    if (!psy_color_equal_eps(top_px, g_stim_color, 1.0 / 255)
+        || !psy_color_equal_eps(bot_px, g_background_color, 1.0 / 255))
+        data->correct = FALSE;
+
+    g_object_unref(top_px);
+    g_object_unref(bot_px);
+}
+
+static void
+test_gl_canvas_async_readback(void)
+{
+    const guint   WIDTH = 640, HEIGHT = 480, NFRAMES = 6;
+    ReadbackData  data    = {.in_order = TRUE, .correct = TRUE};
+    PsyGlCanvas  *canvas  = psy_gl_canvas_new(WIDTH, HEIGHT);
+    PsyTimePoint *tp_null = psy_time_point_new();
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(canvas);
+    CU_ASSERT_FALSE(psy_gl_canvas_get_async_readback(canvas));
+
+    psy_canvas_set_background_color(PSY_CANVAS(canvas), g_background_color);
+    PsyRectangle *rect = psy_rectangle_new_full(
+        PSY_CANVAS(canvas), 0, HEIGHT / 4.0, WIDTH, HEIGHT / 2.0);
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(rect), g_stim_color);
+    psy_stimulus_play(PSY_STIMULUS(rect), tp_null);
+
+    g_signal_connect(canvas, "image-ready", G_CALLBACK(on_image_ready), &data);
+    psy_gl_canvas_set_async_readback(canvas, TRUE);
+
+    for (guint i = 0; i < NFRAMES; i++)
+        psy_image_canvas_iterate(PSY_IMAGE_CANVAS(canvas));
+
+    // The images lag two frames behind
+    CU_ASSERT_EQUAL(data.num_images, NFRAMES - 2);
+
+    psy_gl_canvas_flush_readback(canvas);
+    CU_ASSERT_EQUAL(data.num_images, NFRAMES);
+    CU_ASSERT_TRUE(data.in_order);
+    CU_ASSERT_TRUE(data.correct);
+
+    // The synchronous readback has the same orientation
+    PsyImage *image = psy_canvas_get_image(PSY_CANVAS(canvas));
+    PsyColor *pixel = psy_image_get_pixel(image, HEIGHT / 4, 0);
+    CU_ASSERT_TRUE(psy_color_equal_eps(pixel, g_stim_color, 1.0 / 255));
+
+    g_object_unref(pixel);
+    g_object_unref(image);
+    psy_time_point_free(tp_null);
+    g_object_unref(rect);
+    g_object_unref(canvas);
+}
+
+static void
+on_image_ready_export(PsyGlCanvas *self,
+                      PsyImage    *image,
+                      guint64      frame_num,
+                      gpointer     user_data)
+{
+    (void) self;
+    PsyVideoExporter *exporter = user_data;
+    GError           *error    = NULL;
+
+    CU_ASSERT_TRUE(
+        psy_video_exporter_add_frame(exporter, image, frame_num, &error));
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+}
+
+static void
+test_gl_canvas_video_export(void)
+{
+    const guint WIDTH = 64, HEIGHT = 48, NFRAMES = 5;
+    GError     *error = NULL;
+    GStatBuf    stat_buf;
+
+    PsyGlCanvas *canvas = psy_gl_canvas_new(WIDTH, HEIGHT);
+    gchar       *path
+        = g_build_filename(g_get_tmp_dir(), "psy-export.rgba", NULL);
+    PsyVideoExporter *exporter
+        = psy_video_exporter_new_for_canvas(PSY_CANVAS(canvas), path);
+
+    // Store the raw frames, so the test doesn't depend on an encoder.
+    psy_video_exporter_set_encoder(exporter, "identity");
+    psy_video_exporter_set_muxer(exporter, "identity");
+
+    // Frames are refused before the exporter is opened
+    PsyImage *small = psy_image_new(WIDTH / 2, HEIGHT, PSY_IMAGE_FORMAT_RGBA);
+    CU_ASSERT_FALSE(psy_video_exporter_add_frame(exporter, small, 0, &error));
+    CU_ASSERT_TRUE(g_error_matches(
+        error, PSY_VIDEO_EXPORTER_ERROR, PSY_VIDEO_EXPORTER_ERROR_STATE));
+    g_clear_error(&error);
+
+    CU_ASSERT_TRUE_FATAL(psy_video_exporter_open(exporter, &error));
+    CU_ASSERT_TRUE(psy_video_exporter_get_is_open(exporter));
+
+    g_signal_connect(canvas,
+                     "image-ready",
+                     G_CALLBACK(on_image_ready_export),
+                     exporter);
+    psy_gl_canvas_set_async_readback(canvas, TRUE);
+
+    for (guint i = 0; i < NFRAMES; i++)
+        psy_image_canvas_iterate(PSY_IMAGE_CANVAS(canvas));
+    psy_gl_canvas_flush_readback(canvas);
+
+    // A frame of the wrong size is refused
+    CU_ASSERT_FALSE(
+        psy_video_exporter_add_frame(exporter, small, NFRAMES, &error));
+    CU_ASSERT_TRUE(g_error_matches(
+        error, PSY_VIDEO_EXPORTER_ERROR, PSY_VIDEO_EXPORTER_ERROR_FORMAT));
+    g_clear_error(&error);
+
+    CU_ASSERT_EQUAL(psy_video_exporter_get_num_frames(exporter), NFRAMES);
+    CU_ASSERT_TRUE(psy_video_exporter_close(exporter, &error));
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_FALSE(psy_video_exporter_get_is_open(exporter));
+
+    CU_ASSERT_EQUAL(g_stat(path, &stat_buf), 0);
+    CU_ASSERT_EQUAL(stat_buf.st_size, NFRAMES * WIDTH * HEIGHT * 4);
+
+    g_remove(path);
+    g_free(path);
+    g_object_unref(small);
+    g_object_unref(exporter);
+    g_object_unref(canvas);
+}
+
+static void
+render_background(PsyImageCanvas *canvas, gpointer job_data)
+{
+    psy_canvas_set_background_color(PSY_CANVAS(canvas), job_data);
+}
+
+static void
+test_gl_render_pool(void)
+{
+    const guint WIDTH = 64, HEIGHT = 48, NJOBS = 8;
+    PsyColor   *colors[8];
+    gboolean    seen[8] = {FALSE};
+
+    PsyGlRenderPool *pool = psy_gl_render_pool_new(WIDTH, HEIGHT, 2);
+    CU_ASSERT_EQUAL(psy_gl_render_pool_get_num_workers(pool), 2);
+    CU_ASSERT_PTR_NULL(psy_gl_render_pool_pop(pool, NULL));
+
+    for (guint i = 0; i < NJOBS; i++) {
+        colors[i] = psy_color_new_rgb(i / 8.0, 0, 1 - i / 8.0);
+        guint64 id
+            = psy_gl_render_pool_push(pool,
+                                      render_background,
+                                      g_object_ref(colors[i]),
+                                      g_object_unref,
+                                      1);
+        CU_ASSERT_EQUAL(id, i);
+    }
+    CU_ASSERT_EQUAL(psy_gl_render_pool_get_num_pending(pool), NJOBS);
+
+    // Every job renders its own color, in whichever order they complete.
+    for (guint i = 0; i < NJOBS; i++) {
+        guint64   id    = G_MAXUINT64;
+        PsyImage *image = psy_gl_render_pool_pop(pool, &id);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(image);
+        CU_ASSERT_TRUE_FATAL(id < NJOBS);
+        CU_ASSERT_FALSE(seen[id]);
+        seen[id] = TRUE;
+
+        CU_ASSERT_EQUAL(psy_image_get_width(image), WIDTH);
+        PsyColor *pixel = psy_image_get_pixel(image, HEIGHT / 2, WIDTH / 2);
+        CU_ASSERT_TRUE(psy_color_equal_eps(pixel, colors[id], 1.0 / 255));
+
+        g_object_unref(pixel);
+        g_object_unref(image);
+    }
+    CU_ASSERT_EQUAL(psy_gl_render_pool_get_num_pending(pool), 0);
+
+    for (guint i = 0; i < NJOBS; i++)
+        g_object_unref(colors[i]);
+    g_object_unref(pool);
+}
+
 int
 add_gl_canvas_suite(void)
 {
@@ -131,5 +336,17 @@ add_gl_canvas_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, test_gl_canvas_async_readback);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, test_gl_canvas_video_export);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, test_gl_render_pool);
+    if (!test)
+        return 1;
+
     return 0;
 }
@@ -2,7 +2,10 @@
 #include <CUnit/CUnit.h>
 #include <CUnit/TestDB.h>
 
+#include "hw/psy-fake-parallel-port.h"
 #include "hw/psy-parallel-port.h"
+#include "hw/psy-parallel-trigger.h"
+#include "hw/psy-response-box.h"
 #include "psy-config.h"
 
 gint g_port_num = -1;
@@ -117,16 +120,232 @@ parallel_port_open(void)
     g_object_unref(port);
 }
 
+static void
+parallel_trigger_event_create(void)
+{
+    PsyTimePoint *tstart = psy_time_point_new();
+    PsyDuration  *dur    = psy_duration_new_ms(10);
+
+    tstart->ticks_since_start = 1000;
+
+    PsyParallelTriggerEvent *event
+        = psy_parallel_trigger_event_new(0x55, tstart, dur);
+    PsyParallelTriggerEvent *copy = psy_parallel_trigger_event_copy(event);
+
+    PsyTimePoint *start    = psy_parallel_trigger_event_get_start(copy);
+    PsyDuration  *copy_dur = psy_parallel_trigger_event_get_duration(copy);
+
+    CU_ASSERT_EQUAL(psy_parallel_trigger_event_get_mask(copy), 0x55);
+    CU_ASSERT_TRUE(psy_time_point_equal(start, tstart));
+    CU_ASSERT_EQUAL(psy_duration_get_us(copy_dur), 10000);
+
+    CU_ASSERT_FALSE(psy_parallel_trigger_event_is_written(copy));
+    CU_ASSERT_PTR_NULL(psy_parallel_trigger_event_get_written_start(copy));
+    CU_ASSERT_PTR_NULL(psy_parallel_trigger_event_get_written_stop(copy));
+
+    psy_time_point_free(start);
+    psy_duration_free(copy_dur);
+    psy_parallel_trigger_event_free(copy);
+    psy_parallel_trigger_event_free(event);
+    psy_duration_free(dur);
+    psy_time_point_free(tstart);
+}
+
+static void
+parallel_trigger_schedule_closed(void)
+{
+    GError             *error   = NULL;
+    PsyParallelTrigger *trigger = psy_parallel_trigger_new();
+    PsyTimePoint       *tstart  = psy_time_point_new();
+    PsyDuration        *dur     = psy_duration_new_ms(1);
+
+    psy_parallel_trigger_schedule(trigger, 1, tstart, dur, &error);
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->domain, PSY_PARALLEL_PORT_ERROR);
+        CU_ASSERT_EQUAL(error->code, PSY_PARALLEL_PORT_ERROR_DEV_CLOSED);
+        g_error_free(error);
+    }
+
+    psy_duration_free(dur);
+    psy_time_point_free(tstart);
+    g_object_unref(trigger);
+}
+
+static void
+fake_parallel_port_read_write(void)
+{
+    GError          *error = NULL;
+    PsyParallelPort *port  = psy_fake_parallel_port_new();
+
+    psy_parallel_port_open(port, 0, &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+    CU_ASSERT_STRING_EQUAL(psy_parallel_port_get_port_name(port), "fake0");
+
+    psy_parallel_port_write(port, 0x55, &error);
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_EQUAL(
+        psy_fake_parallel_port_get_output(PSY_FAKE_PARALLEL_PORT(port)), 0x55);
+
+    psy_parallel_port_read(port, &error);
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->code, PSY_PARALLEL_PORT_ERROR_DIRECTION);
+        g_clear_error(&error);
+    }
+
+    psy_parallel_port_set_direction(port, PSY_IO_DIRECTION_IN);
+    psy_fake_parallel_port_set_input(PSY_FAKE_PARALLEL_PORT(port), 0xaa);
+    CU_ASSERT_EQUAL(psy_parallel_port_read(port, &error), 0xaa);
+    CU_ASSERT_PTR_NULL(error);
+
+    // no change, so this should time out.
+    CU_ASSERT_FALSE(psy_parallel_port_wait_for_input(port, 1000, &error));
+    CU_ASSERT_PTR_NULL(error);
+
+    g_object_unref(port);
+}
+
+static void
+response_box_start_output(void)
+{
+    GError          *error = NULL;
+    PsyParallelPort *port  = psy_fake_parallel_port_new();
+    PsyResponseBox  *box   = psy_response_box_new(port);
+
+    psy_response_box_start(box, &error);
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->domain, PSY_RESPONSE_BOX_ERROR);
+        CU_ASSERT_EQUAL(error->code, PSY_RESPONSE_BOX_ERROR_PORT);
+        g_clear_error(&error);
+    }
+    CU_ASSERT_FALSE(psy_response_box_is_running(box));
+
+    g_object_unref(box);
+    g_object_unref(port);
+}
+
+typedef struct ResponseData {
+    GMainLoop *loop;
+    GArray    *events; // the pins of the events
+    gint64     last_time;
+    gboolean   ordered;
+    guint      num_expected;
+} ResponseData;
+
+static void
+on_response(PsyResponseBox *box, PsyResponseEvent *event, gpointer data)
+{
+    (void) box;
+    ResponseData *rdata = data;
+    PsyTimePoint *tp    = psy_response_event_get_time(event);
+    guint8        pins  = psy_response_event_get_pins(event);
+
+    if (tp->ticks_since_start < rdata->last_time)
+        rdata->ordered = FALSE;
+    rdata->last_time = tp->ticks_since_start;
+
+    g_array_append_val(rdata->events, pins);
+
+    if (rdata->events->len == rdata->num_expected)
+        g_main_loop_quit(rdata->loop);
+
+    psy_time_point_free(tp);
+}
+
+static gpointer
+press_buttons(gpointer data)
+{
+    PsyFakeParallelPort *port = data;
+
+    for (guint8 i = 1; i <= 4; i++) {
+        g_usleep(2000);
+        psy_fake_parallel_port_set_input(port, i);
+    }
+
+    return NULL;
+}
+
+static gboolean
+response_timeout(gpointer data)
+{
+    g_main_loop_quit(data);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+response_box_sample(void)
+{
+    GError          *error = NULL;
+    PsyParallelPort *port  = psy_fake_parallel_port_new();
+    PsyResponseBox  *box   = psy_response_box_new(port);
+
+    ResponseData rdata = {.loop         = g_main_loop_new(NULL, FALSE),
+                          .events       = g_array_new(FALSE, FALSE, 1),
+                          .ordered      = TRUE,
+                          .num_expected = 4};
+
+    psy_parallel_port_set_direction(port, PSY_IO_DIRECTION_IN);
+    psy_parallel_port_open(port, 0, &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+
+    g_signal_connect(box, "response", G_CALLBACK(on_response), &rdata);
+
+    psy_response_box_start(box, &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+    CU_ASSERT_TRUE(psy_response_box_is_running(box));
+
+    GThread *thread = g_thread_new("press-buttons", press_buttons, port);
+    guint    id     = g_timeout_add_seconds(5, response_timeout, rdata.loop);
+
+    g_main_loop_run(rdata.loop);
+    g_source_remove(id);
+    g_thread_join(thread);
+
+    psy_response_box_stop(box);
+    CU_ASSERT_FALSE(psy_response_box_is_running(box));
+
+    CU_ASSERT_EQUAL_FATAL(rdata.events->len, 4);
+    for (guint i = 0; i < rdata.events->len; i++)
+        CU_ASSERT_EQUAL(g_array_index(rdata.events, guint8, i), i + 1);
+    CU_ASSERT_TRUE(rdata.ordered);
+    CU_ASSERT_EQUAL(psy_response_box_get_num_dropped(box), 0);
+
+    g_array_unref(rdata.events);
+    g_main_loop_unref(rdata.loop);
+    g_object_unref(box);
+    g_object_unref(port);
+}
+
 int
 add_parallel_suite(gint port_num)
 {
-#if defined(HAVE_LINUX_PARPORT_H) // Check for other port implementations here
     CU_Suite *suite = CU_add_suite("parallel port tests", NULL, NULL);
     CU_Test  *test  = NULL;
 
     if (!suite)
         return 1;
 
+    test = CU_add_test(suite,
+                       "FakeParallelPort reads and writes",
+                       fake_parallel_port_read_write);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(suite,
+                       "ResponseBox needs an input port",
+                       response_box_start_output);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(
+        suite, "ResponseBox samples a port", response_box_sample);
+    if (!test)
+        return 1;
+
+#if defined(HAVE_LINUX_PARPORT_H) // Check for other port implementations here
+
     test = CU_add_test(suite,
                        "ParallelPort gets sensible default values",
                        parallel_port_create);
@@ -138,6 +357,18 @@ add_parallel_suite(gint port_num)
     if (!test)
         return 1;
 
+    test = CU_add_test(suite,
+                       "ParallelTriggerEvent stores its values",
+                       parallel_trigger_event_create);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(suite,
+                       "ParallelTrigger can't schedule on a closed port",
+                       parallel_trigger_schedule_closed);
+    if (!test)
+        return 1;
+
     if (port_num >= 0) {
 
         // These test must be enabled via the command line the
@@ -151,6 +382,7 @@ add_parallel_suite(gint port_num)
     }
 
 #else
+    (void) port_num;
     #pragma message "Can't test with parallel device"
 #endif
 
@@ -1,8 +1,11 @@
 
 #include <CUnit/CUnit.h>
+#include <glib/gstdio.h>
 #include <psy-image-canvas.h>
 #include <psy-picture.h>
+#include <psy-texture-atlas.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include "unit-test-utilities.h"
 
@@ -386,6 +389,430 @@ picture_test_drawing(void)
     g_object_unref(image);
 }
 
+static void
+picture_ensure_resident(void)
+{
+    GError            *error   = NULL;
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(g_canvas));
+    PsyTexture *texture = psy_drawing_context_get_texture(context, g_path);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(texture);
+
+    // The upload was started asynchronously in picture_setup
+    CU_ASSERT_TRUE(psy_texture_is_uploaded(texture)
+                   || psy_texture_is_upload_pending(texture));
+
+    CU_ASSERT_TRUE(psy_drawing_context_ensure_texture_resident(
+        context, g_path, NULL, &error));
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_TRUE(psy_texture_is_uploaded(texture));
+    CU_ASSERT_FALSE(psy_texture_is_upload_pending(texture));
+    g_clear_error(&error);
+
+    // A deadline in the past only polls an already resident texture
+    PsyTimePoint *past = psy_time_point_new();
+    CU_ASSERT_TRUE(psy_texture_ensure_resident(texture, past, &error));
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+    psy_time_point_free(past);
+
+    CU_ASSERT_FALSE(psy_drawing_context_ensure_texture_resident(
+        context, "no-such-texture.png", NULL, &error));
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->domain, PSY_DRAWING_CONTEXT_ERROR);
+        CU_ASSERT_EQUAL(error->code, PSY_DRAWING_CONTEXT_ERROR_NAME_NOT_FOUND);
+        g_clear_error(&error);
+    }
+}
+
+typedef struct PreloadData {
+    GMainLoop *loop;
+    guint      num_progress;
+    guint      last_loaded;
+    gboolean   result;
+    GError    *error;
+} PreloadData;
+
+static void
+on_preload_progress(PsyDrawingContext *context,
+                    guint              num_loaded,
+                    guint              num_to_load,
+                    gpointer           data)
+{
+    (void) context;
+    (void) num_to_load;
+    PreloadData *pdata = data;
+    pdata->num_progress++;
+    pdata->last_loaded = num_loaded;
+}
+
+static void
+on_preload_finished(GObject *source, GAsyncResult *result, gpointer data)
+{
+    PreloadData *pdata = data;
+    pdata->result      = psy_drawing_context_preload_textures_finish(
+        PSY_DRAWING_CONTEXT(source), result, &pdata->error);
+    g_main_loop_quit(pdata->loop);
+}
+
+static void
+picture_preload_manifest(void)
+{
+    GError            *error   = NULL;
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(g_canvas));
+    const guint        num_files = 3;
+
+    gchar *dir = g_dir_make_tmp("psy-preload-XXXXXX", &error);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(dir);
+
+    GString   *manifest = g_string_new("# images to preload\n\n");
+    GPtrArray *paths    = g_ptr_array_new_with_free_func(g_free);
+
+    for (guint i = 0; i < num_files; i++) {
+        gchar *name = g_strdup_printf("image-%u.png", i);
+        gchar *path = g_build_filename(dir, name, NULL);
+        psy_image_save_path(g_image, path, "png", &error);
+        CU_ASSERT_PTR_NULL(error);
+        g_clear_error(&error);
+        g_string_append_printf(manifest, "%s\n", name);
+        g_ptr_array_add(paths, path);
+        g_free(name);
+    }
+
+    gchar *manifest_path = g_build_filename(dir, "manifest.txt", NULL);
+    g_file_set_contents(manifest_path, manifest->str, -1, &error);
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+
+    PreloadData pdata = {.loop = g_main_loop_new(NULL, FALSE)};
+    gulong      id    = g_signal_connect(context,
+                                 "preload-progress",
+                                 G_CALLBACK(on_preload_progress),
+                                 &pdata);
+
+    psy_drawing_context_preload_manifest_async(
+        context, manifest_path, NULL, on_preload_finished, &pdata);
+    g_main_loop_run(pdata.loop);
+
+    CU_ASSERT_TRUE(pdata.result);
+    CU_ASSERT_PTR_NULL(pdata.error);
+    CU_ASSERT_EQUAL(pdata.num_progress, num_files);
+    CU_ASSERT_EQUAL(pdata.last_loaded, num_files);
+
+    for (guint i = 0; i < paths->len; i++) {
+        const gchar *path    = g_ptr_array_index(paths, i);
+        PsyTexture  *texture = psy_drawing_context_get_texture(context, path);
+        CU_ASSERT_PTR_NOT_NULL(texture);
+        CU_ASSERT_TRUE(psy_drawing_context_ensure_texture_resident(
+            context, path, NULL, &error));
+        CU_ASSERT_PTR_NULL(error);
+        g_clear_error(&error);
+    }
+
+    // A missing file is reported, but doesn't stop the preload.
+    g_clear_error(&pdata.error);
+    pdata.num_progress = 0;
+    gchar *missing     = g_build_filename(dir, "missing.png", NULL);
+    gchar *files[]     = {missing};
+
+    psy_drawing_context_preload_textures_async(
+        context, files, G_N_ELEMENTS(files), NULL, on_preload_finished, &pdata);
+    g_main_loop_run(pdata.loop);
+
+    CU_ASSERT_FALSE(pdata.result);
+    CU_ASSERT_PTR_NOT_NULL(pdata.error);
+    CU_ASSERT_EQUAL(pdata.num_progress, 1);
+    CU_ASSERT_PTR_NULL(psy_drawing_context_get_texture(context, missing));
+    g_clear_error(&pdata.error);
+
+    g_signal_handler_disconnect(context, id);
+    g_main_loop_unref(pdata.loop);
+
+    for (guint i = 0; i < paths->len; i++)
+        g_remove(g_ptr_array_index(paths, i));
+    g_remove(manifest_path);
+    g_rmdir(dir);
+
+    g_free(missing);
+    g_free(manifest_path);
+    g_ptr_array_unref(paths);
+    g_string_free(manifest, TRUE);
+    g_free(dir);
+}
+
+/*
+ * The bytes of a texture and its mipmaps on the graphics hardware
+ */
+static gsize
+mipmapped_num_bytes(guint width, guint height, guint num_channels)
+{
+    gsize num_bytes = (gsize) width * height * num_channels;
+
+    while (width > 1 || height > 1) {
+        width  = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+        num_bytes += (gsize) width * height * num_channels;
+    }
+    return num_bytes;
+}
+
+static gsize
+atlas_num_bytes(PsyTextureAtlas *atlas, gboolean mipmapped)
+{
+    guint width  = psy_texture_atlas_get_width(atlas);
+    guint height = psy_texture_atlas_get_height(atlas);
+
+    return mipmapped ? mipmapped_num_bytes(width, height, 4)
+                     : (gsize) width * height * 4;
+}
+
+static void
+picture_texture_cache(void)
+{
+    GError            *error   = NULL;
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(g_canvas));
+    guint64            num_hits, num_misses, num_evictions;
+    guint64            texture_bytes, image_bytes;
+
+    gchar *other = g_build_filename(g_get_tmp_dir(), "cached.png", NULL);
+    psy_image_save_path(g_image, other, "png", &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+    psy_drawing_context_load_files_as_texture(context, &other, 1, &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+
+    PsyTexture *texture = psy_drawing_context_get_texture(context, g_path);
+    gsize       nbytes  = psy_texture_get_num_bytes(texture);
+    CU_ASSERT_EQUAL(nbytes, g_img_width * g_img_height * 4);
+
+    // The textures occupy a third more on the GPU because of their mipmaps
+    // and the atlases are always accounted.
+    gsize gpu_bytes = mipmapped_num_bytes(g_img_width, g_img_height, 4);
+    CU_ASSERT_TRUE(gpu_bytes > nbytes);
+
+    PsyTextureAtlas *atlas  = psy_drawing_context_get_atlas(context);
+    PsyTextureAtlas *glyphs = psy_drawing_context_get_glyph_atlas(context);
+
+    gsize atlas_bytes
+        = atlas_num_bytes(atlas, TRUE) + atlas_num_bytes(glyphs, TRUE);
+    gsize atlas_pixels
+        = atlas_num_bytes(atlas, FALSE) + atlas_num_bytes(glyphs, FALSE);
+
+    // Room for one texture only, g_path has just been used.
+    psy_drawing_context_reset_cache_stats(context);
+    g_object_set(
+        context, "texture-budget", (guint64) (atlas_bytes + gpu_bytes), NULL);
+    CU_ASSERT_EQUAL(psy_drawing_context_get_texture_budget(context),
+                    atlas_bytes + gpu_bytes);
+
+    psy_drawing_context_get_cache_stats(
+        context, NULL, NULL, &num_evictions, &texture_bytes, NULL);
+    CU_ASSERT_TRUE(num_evictions > 0);
+    CU_ASSERT_EQUAL(texture_bytes, atlas_bytes + gpu_bytes);
+    CU_ASSERT_TRUE(psy_texture_is_uploaded(texture)
+                   || psy_texture_is_upload_pending(texture));
+
+    // Using the other texture evicts g_path and using g_path restores it.
+    psy_drawing_context_reset_cache_stats(context);
+    PsyTexture *other_texture = psy_drawing_context_get_texture(context, other);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(other_texture);
+    CU_ASSERT_FALSE(psy_texture_is_uploaded(texture)
+                    || psy_texture_is_upload_pending(texture));
+    CU_ASSERT_PTR_EQUAL(psy_drawing_context_get_texture(context, g_path),
+                        texture);
+    CU_ASSERT_TRUE(psy_drawing_context_ensure_texture_resident(
+        context, g_path, NULL, &error));
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+
+    psy_drawing_context_get_cache_stats(
+        context, &num_hits, &num_misses, &num_evictions, &texture_bytes, NULL);
+    CU_ASSERT_EQUAL(num_misses, 2);
+    CU_ASSERT_EQUAL(num_evictions, 2);
+    CU_ASSERT_EQUAL(num_hits, 1);
+    CU_ASSERT_EQUAL(texture_bytes, atlas_bytes + gpu_bytes);
+
+    // A pinned texture isn't evicted, a reference alone doesn't keep it.
+    CU_ASSERT_TRUE(psy_drawing_context_pin_texture(context, g_path));
+    psy_drawing_context_get_texture(context, other);
+    CU_ASSERT_TRUE(psy_texture_is_uploaded(texture)
+                   || psy_texture_is_upload_pending(texture));
+    psy_drawing_context_unpin_texture(context, g_path);
+    CU_ASSERT_FALSE(psy_texture_is_uploaded(texture)
+                    || psy_texture_is_upload_pending(texture));
+    CU_ASSERT_FALSE(psy_drawing_context_pin_texture(context, "not-registered"));
+
+    // Decoded images are freed, but the textures remain on the GPU. Only
+    // the pixels of the atlases remain in main memory.
+    psy_drawing_context_set_texture_budget(context, 0);
+    psy_drawing_context_set_image_budget(context, 1);
+    psy_drawing_context_get_cache_stats(
+        context, NULL, NULL, NULL, NULL, &image_bytes);
+    CU_ASSERT_EQUAL(image_bytes, atlas_pixels);
+    CU_ASSERT_PTR_NULL(psy_texture_get_data(texture));
+    CU_ASSERT_TRUE(psy_drawing_context_ensure_texture_resident(
+        context, g_path, NULL, &error));
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+
+    psy_drawing_context_set_image_budget(context, 0);
+
+    g_remove(other);
+    g_free(other);
+}
+
+static PsyImage *
+new_atlas_image(guint width, guint height)
+{
+    PsyImage *image = psy_image_new(width, height, PSY_IMAGE_FORMAT_RGBA);
+    PsyColor *color = psy_color_new_rgbi(255, 0, 0);
+    psy_image_clear(image, color);
+    g_object_unref(color);
+    return image;
+}
+
+static void
+picture_atlas_packing(void)
+{
+    GError            *error   = NULL;
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(g_canvas));
+    PsyTexture        *texture = psy_drawing_context_create_texture(context);
+    PsyTextureAtlas   *atlas   = psy_texture_atlas_new(texture, 256, 256);
+    PsyImage          *image   = new_atlas_image(100, 100);
+    const gchar       *names[] = {"a", "b", "c", "d"};
+    gfloat             rects[4][4];
+
+    g_object_unref(texture);
+
+    // Four images of 100 * 100 fit in an atlas of 256 * 256
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++) {
+        CU_ASSERT_TRUE(
+            psy_texture_atlas_add_image(atlas, names[i], image, &error));
+        CU_ASSERT_PTR_NULL(error);
+        g_clear_error(&error);
+    }
+    CU_ASSERT_EQUAL(psy_texture_atlas_get_num_entries(atlas), 4);
+
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++) {
+        gfloat *rect = rects[i];
+        CU_ASSERT_TRUE(psy_texture_atlas_lookup(atlas, names[i], rect));
+        CU_ASSERT_TRUE(rect[0] >= 0 && rect[0] < rect[2] && rect[2] <= 1);
+        CU_ASSERT_TRUE(rect[1] >= 0 && rect[1] < rect[3] && rect[3] <= 1);
+        CU_ASSERT_DOUBLE_EQUAL(rect[2] - rect[0], 100.0 / 256, 1e-6);
+        CU_ASSERT_DOUBLE_EQUAL(rect[3] - rect[1], 100.0 / 256, 1e-6);
+
+        // The images may not overlap
+        for (guint j = 0; j < i; j++) {
+            gfloat *other   = rects[j];
+            bool    overlap = rect[0] < other[2] && other[0] < rect[2]
+                          && rect[1] < other[3] && other[1] < rect[3];
+            CU_ASSERT_FALSE(overlap);
+        }
+    }
+
+    // "a" is now the least recently used, so it is evicted for "e"
+    psy_texture_atlas_lookup(atlas, "b", NULL);
+    psy_texture_atlas_lookup(atlas, "c", NULL);
+    psy_texture_atlas_lookup(atlas, "d", NULL);
+    CU_ASSERT_TRUE(psy_texture_atlas_add_image(atlas, "e", image, &error));
+    CU_ASSERT_PTR_NULL(error);
+    g_clear_error(&error);
+
+    CU_ASSERT_FALSE(psy_texture_atlas_contains(atlas, "a"));
+    CU_ASSERT_TRUE(psy_texture_atlas_contains(atlas, "e"));
+    CU_ASSERT_EQUAL(psy_texture_atlas_get_num_entries(atlas), 4);
+
+    // An image that is larger than the atlas never fits
+    PsyImage *large = new_atlas_image(300, 100);
+    CU_ASSERT_FALSE(psy_texture_atlas_add_image(atlas, "large", large, &error));
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->domain, PSY_TEXTURE_ERROR);
+        CU_ASSERT_EQUAL(error->code, PSY_TEXTURE_ERROR_ATLAS_FULL);
+        g_clear_error(&error);
+    }
+
+    psy_image_free(large);
+    psy_image_free(image);
+    psy_texture_atlas_free(atlas);
+}
+
+/*
+ * Draws a few overlapping pictures, these share the atlas of the drawing
+ * context, so they are drawn in one batch when batch_stimuli is TRUE.
+ */
+static PsyImage *
+draw_pictures(gboolean batch_stimuli)
+{
+    GPtrArray *pictures = g_ptr_array_new_with_free_func(g_object_unref);
+
+    psy_canvas_reset(PSY_CANVAS(g_canvas));
+    psy_canvas_set_batch_stimuli(PSY_CANVAS(g_canvas), batch_stimuli);
+
+    for (gint i = 0; i < 5; i++) {
+        PsyPicture *pic = psy_picture_new_full(PSY_CANVAS(g_canvas),
+                                               -200.0f + i * 100.0f,
+                                               -100.0f + i * 50.0f,
+                                               g_img_width / 2,
+                                               g_img_height / 2,
+                                               g_path);
+        psy_stimulus_play(PSY_STIMULUS(pic), g_tstart);
+        g_ptr_array_add(pictures, pic);
+    }
+
+    psy_image_canvas_iterate(g_canvas);
+    PsyImage *image = psy_canvas_get_image(PSY_CANVAS(g_canvas));
+
+    psy_canvas_set_batch_stimuli(PSY_CANVAS(g_canvas), TRUE);
+    g_ptr_array_unref(pictures);
+
+    return image;
+}
+
+static void
+picture_atlas_batched_equal_unbatched(void)
+{
+    PsyDrawingContext *context = psy_canvas_get_context(PSY_CANVAS(g_canvas));
+    PsyTextureAtlas   *atlas   = psy_drawing_context_get_atlas(context);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(atlas);
+    CU_ASSERT_TRUE(psy_texture_atlas_contains(atlas, g_path));
+
+    PsyImage *batched   = draw_pictures(TRUE);
+    PsyImage *unbatched = draw_pictures(FALSE);
+
+    if (save_images()) {
+        save_image_tmp_png(batched, "%s-batched.png", __func__);
+        save_image_tmp_png(unbatched, "%s-unbatched.png", __func__);
+    }
+
+    GBytes *bbytes = psy_image_get_bytes(batched);
+    GBytes *ubytes = psy_image_get_bytes(unbatched);
+    gsize   size, usize;
+
+    const guint8 *bdata = g_bytes_get_data(bbytes, &size);
+    const guint8 *udata = g_bytes_get_data(ubytes, &usize);
+    CU_ASSERT_EQUAL_FATAL(size, usize);
+
+    // The atlas is sampled at other texture coordinates than the picture's
+    // own texture, allow the edges to be filtered slightly differently.
+    gsize num_different = 0;
+    for (gsize i = 0; i < size; i++)
+        if (abs(bdata[i] - udata[i]) > 2)
+            num_different++;
+
+    if (num_different > size / 100)
+        g_warning("%" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes differ",
+                  num_different,
+                  size);
+    CU_ASSERT_TRUE(num_different <= size / 100);
+
+    g_bytes_unref(bbytes);
+    g_bytes_unref(ubytes);
+    psy_image_free(batched);
+    psy_image_free(unbatched);
+}
+
 int
 add_picture_suite(void)
 {
@@ -412,5 +839,25 @@ add_picture_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, picture_ensure_resident);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, picture_preload_manifest);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, picture_texture_cache);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, picture_atlas_packing);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, picture_atlas_batched_equal_unbatched);
+    if (!test)
+        return 1;
+
     return 0;
 }
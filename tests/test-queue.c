@@ -164,6 +164,33 @@ queue_simultaneous_push_pull(void)
     free(context.data_out);
 }
 
+static void
+input_queue_push_pop(void)
+{
+    PsyInputQueue *queue = psy_input_queue_new(4);
+    PsyInputSample sample;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    CU_ASSERT_EQUAL(psy_input_queue_capacity(queue), 4);
+    CU_ASSERT_FALSE(psy_input_queue_pop(queue, &sample));
+
+    for (guint i = 0; i < 4; i++) {
+        sample = (PsyInputSample){.time = i, .pins = i, .changed = 1};
+        CU_ASSERT_TRUE(psy_input_queue_push(queue, &sample));
+    }
+    CU_ASSERT_FALSE(psy_input_queue_push(queue, &sample));
+    CU_ASSERT_EQUAL(psy_input_queue_size(queue), 4);
+
+    for (guint i = 0; i < 4; i++) {
+        CU_ASSERT_TRUE(psy_input_queue_pop(queue, &sample));
+        CU_ASSERT_EQUAL(sample.time, i);
+        CU_ASSERT_EQUAL(sample.pins, i);
+    }
+    CU_ASSERT_EQUAL(psy_input_queue_size(queue), 0);
+
+    psy_input_queue_free(queue);
+}
+
 int
 add_queue_suite(void)
 {
@@ -189,5 +216,9 @@ add_queue_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, input_queue_push_pop);
+    if (!test)
+        return 1;
+
     return 0;
 }
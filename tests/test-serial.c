@@ -0,0 +1,278 @@
+#include <CUnit/CUnit.h>
+#include <psylib.h>
+
+#include "psy-config.h"
+
+#if defined(HAVE_TERMIOS_H)
+
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <unistd.h>
+
+/*
+ * Opens the master side of a pseudo terminal and returns the name of the
+ * slave side in slave_name, the slave may be opened with a PsySerialPort.
+ */
+static int
+open_pty(gchar **slave_name)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0)
+        return -1;
+
+    if (grantpt(master) != 0 || unlockpt(master) != 0) {
+        close(master);
+        return -1;
+    }
+
+    *slave_name = g_strdup(ptsname(master));
+    return master;
+}
+
+/*
+ * Reads n bytes from fd, returns the number of bytes read before the
+ * timeout has expired.
+ */
+static gsize
+read_bytes(int fd, guint8 *buffer, gsize n, int timeout_ms)
+{
+    gsize nread = 0;
+
+    while (nread < n) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        if (poll(&pfd, 1, timeout_ms) <= 0)
+            break;
+        ssize_t ret = read(fd, buffer + nread, n - nread);
+        if (ret <= 0)
+            break;
+        nread += (gsize) ret;
+    }
+
+    return nread;
+}
+
+static void
+serial_port_create(void)
+{
+    guint    baud_rate;
+    gboolean is_open, low_latency, drain;
+    gchar   *name = NULL;
+
+    PsySerialPort *port = psy_serial_port_new();
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(port);
+    CU_ASSERT_TRUE(PSY_IS_TRIGGER_DEVICE(port));
+
+    // clang-format off
+    g_object_get(port,
+                 "baud-rate", &baud_rate,
+                 "is-open", &is_open,
+                 "low-latency", &low_latency,
+                 "drain", &drain,
+                 "port-name", &name,
+                 NULL);
+    // clang-format on
+
+    CU_ASSERT_EQUAL(baud_rate, 115200);
+    CU_ASSERT_FALSE(is_open);
+    CU_ASSERT_TRUE(low_latency);
+    CU_ASSERT_TRUE(drain);
+    CU_ASSERT_STRING_EQUAL(name, "");
+
+    g_free(name);
+    g_object_unref(port);
+}
+
+static void
+serial_port_open_invalid(void)
+{
+    GError        *error = NULL;
+    PsySerialPort *port  = psy_serial_port_new();
+
+    psy_serial_port_open(port, "/this/device/does/not/exist", &error);
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->domain, PSY_SERIAL_PORT_ERROR);
+        CU_ASSERT_EQUAL(error->code, PSY_SERIAL_PORT_ERROR_OPEN);
+        g_error_free(error);
+    }
+    CU_ASSERT_FALSE(psy_serial_port_is_open(port));
+
+    guint8 byte = 1;
+    error       = NULL;
+    psy_serial_port_write(port, byte, &error);
+    CU_ASSERT_PTR_NOT_NULL(error);
+    if (error) {
+        CU_ASSERT_EQUAL(error->code, PSY_SERIAL_PORT_ERROR_DEV_CLOSED);
+        g_error_free(error);
+    }
+
+    g_object_unref(port);
+}
+
+static void
+serial_port_write_pty(void)
+{
+    GError *error = NULL;
+    gchar  *slave = NULL;
+    guint8  buffer[8];
+    guint8  batch[] = {1, 2, 3};
+    guint64 num_writes;
+
+    int master = open_pty(&slave);
+    CU_ASSERT_TRUE_FATAL(master >= 0);
+
+    PsySerialPort *port = psy_serial_port_new();
+    psy_serial_port_open(port, slave, &error);
+    CU_ASSERT_PTR_NULL(error);
+    if (error) {
+        g_printerr("Unable to open %s: %s\n", slave, error->message);
+        g_error_free(error);
+        goto out;
+    }
+    CU_ASSERT_STRING_EQUAL(psy_serial_port_get_port_name(port), slave);
+
+    PsyTriggerDevice *device = PSY_TRIGGER_DEVICE(port);
+
+    psy_trigger_device_write(device, 42, &error);
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_EQUAL(read_bytes(master, buffer, 1, 1000), 1);
+    CU_ASSERT_EQUAL(buffer[0], 42);
+
+    psy_trigger_device_write_batch(device, batch, G_N_ELEMENTS(batch), &error);
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_EQUAL(read_bytes(master, buffer, 3, 1000), 3);
+    CU_ASSERT_EQUAL(memcmp(buffer, batch, 3), 0);
+
+    psy_trigger_device_get_write_latency(device, NULL, NULL, NULL, &num_writes);
+    CU_ASSERT_EQUAL(num_writes, 2);
+
+    PsyDuration *mean
+        = psy_trigger_device_measure_write_latency(device, 10, &error);
+    CU_ASSERT_PTR_NULL(error);
+    CU_ASSERT_PTR_NOT_NULL(mean);
+    CU_ASSERT_EQUAL(read_bytes(master, buffer, 8, 1000), 8);
+    if (mean)
+        psy_duration_free(mean);
+
+    psy_trigger_device_reset_write_latency(device);
+    psy_trigger_device_get_write_latency(device, NULL, NULL, NULL, &num_writes);
+    CU_ASSERT_EQUAL(num_writes, 0);
+
+    g_clear_error(&error);
+
+out:
+    g_object_unref(port);
+    g_free(slave);
+    close(master);
+}
+
+typedef struct SequenceData {
+    GMainLoop *loop;
+    guint      num_written;
+} SequenceData;
+
+static void
+on_events_written(PsyParallelTrigger *trigger, GPtrArray *events, gpointer data)
+{
+    (void) trigger;
+    SequenceData *sdata = data;
+
+    for (guint i = 0; i < events->len; i++) {
+        PsyParallelTriggerEvent *event = g_ptr_array_index(events, i);
+        if (psy_parallel_trigger_event_is_written(event))
+            sdata->num_written++;
+    }
+    g_main_loop_quit(sdata->loop);
+}
+
+static void
+serial_port_trigger_sequence(void)
+{
+    GError *error = NULL;
+    gchar  *slave = NULL;
+    guint8  buffer[2];
+
+    int master = open_pty(&slave);
+    CU_ASSERT_TRUE_FATAL(master >= 0);
+
+    PsySerialPort *port = psy_serial_port_new();
+    psy_serial_port_open(port, slave, &error);
+    CU_ASSERT_PTR_NULL_FATAL(error);
+
+    PsyParallelTrigger *trigger
+        = psy_parallel_trigger_new_for_device(PSY_TRIGGER_DEVICE(port));
+    CU_ASSERT_TRUE(psy_parallel_trigger_is_open(trigger));
+    CU_ASSERT_STRING_EQUAL(psy_parallel_trigger_get_port_name(trigger), slave);
+
+    SequenceData sdata = {.loop = g_main_loop_new(NULL, FALSE)};
+    g_signal_connect(
+        trigger, "events-written", G_CALLBACK(on_events_written), &sdata);
+
+    PsyClock     *clk    = psy_clock_new();
+    PsyTimePoint *now    = psy_clock_now(clk);
+    PsyDuration  *onset  = psy_duration_new_ms(5);
+    PsyDuration  *dur    = psy_duration_new_ms(2);
+    PsyTimePoint *tstart = psy_time_point_add(now, onset);
+
+    psy_parallel_trigger_schedule(trigger, 0x11, tstart, dur, &error);
+    CU_ASSERT_PTR_NULL(error);
+
+    g_main_loop_run(sdata.loop);
+
+    CU_ASSERT_EQUAL(sdata.num_written, 1);
+    CU_ASSERT_EQUAL(read_bytes(master, buffer, 2, 1000), 2);
+    CU_ASSERT_EQUAL(buffer[0], 0x11);
+    CU_ASSERT_EQUAL(buffer[1], 0);
+
+    psy_time_point_free(tstart);
+    psy_duration_free(dur);
+    psy_duration_free(onset);
+    psy_time_point_free(now);
+    psy_clock_free(clk);
+
+    g_main_loop_unref(sdata.loop);
+    g_object_unref(trigger);
+    g_object_unref(port);
+    g_free(slave);
+    close(master);
+}
+
+#endif
+
+int
+add_serial_suite(void)
+{
+#if defined(HAVE_TERMIOS_H)
+    CU_Suite *suite = CU_add_suite("serial port tests", NULL, NULL);
+    CU_Test  *test  = NULL;
+
+    if (!suite)
+        return 1;
+
+    test = CU_add_test(
+        suite, "SerialPort gets sensible default values", serial_port_create);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(
+        suite, "SerialPort fails on invalid devices", serial_port_open_invalid);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(
+        suite, "SerialPort writes to a pty", serial_port_write_pty);
+    if (!test)
+        return 1;
+
+    test = CU_add_test(suite,
+                       "ParallelTrigger writes sequences to a SerialPort",
+                       serial_port_trigger_sequence);
+    if (!test)
+        return 1;
+#endif
+
+    return 0;
+}
@@ -112,6 +112,127 @@ text_markup_text_properties(void)
     g_object_unref(text);
 }
 
+/*
+ * Counts the pixels of image within the box that have the given color.
+ */
+static guint
+count_pixels(PsyImage *image, PsyColor *color, guint x, guint y, guint size)
+{
+    guint num = 0;
+    for (guint r = y; r < y + size; r++) {
+        for (guint c = x; c < x + size; c++) {
+            PsyColor *probe = psy_image_get_pixel(image, r, c);
+            if (psy_color_equal_eps(probe, color, 1.0f / 255))
+                num++;
+            g_object_unref(probe);
+        }
+    }
+    return num;
+}
+
+static void
+text_draw_glyphs(void)
+{
+    const guint        box     = 100;
+    PsyCanvas         *canvas  = PSY_CANVAS(g_canvas);
+    PsyDrawingContext *context = psy_canvas_get_context(canvas);
+    PsyText           *text
+        = psy_text_new_full(canvas, 0, 0, box, box, "HH", FALSE);
+
+    psy_canvas_reset(canvas);
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(text), g_bg_color);
+    psy_text_set_font_color(text, g_stim_color);
+    psy_stimulus_play(PSY_STIMULUS(text), g_tp_start);
+
+    psy_image_canvas_iterate(g_canvas);
+    CU_ASSERT_FALSE(psy_text_get_is_dirty(text));
+
+    PsyTextureAtlas *atlas = psy_drawing_context_get_glyph_atlas(context);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(atlas);
+    // The background and one glyph for both H's
+    guint num_entries = psy_texture_atlas_get_num_entries(atlas);
+    CU_ASSERT_EQUAL(num_entries, 2);
+
+    PsyImage *image = psy_canvas_get_image(canvas);
+    if (save_images())
+        save_image_tmp_png(image, "%s.png", __func__);
+
+    guint x = (WIDTH - box) / 2, y = (HEIGHT - box) / 2;
+    CU_ASSERT_TRUE(count_pixels(image, g_bg_color, x, y, box) > 0);
+    CU_ASSERT_TRUE(count_pixels(image, g_stim_color, x, y, box) > 0);
+    g_object_unref(image);
+
+    // Known glyphs are reused, new glyphs are rasterized once.
+    psy_text_set_content(text, "HHH");
+    CU_ASSERT_TRUE(psy_text_get_is_dirty(text));
+    psy_image_canvas_iterate(g_canvas);
+    CU_ASSERT_EQUAL(psy_texture_atlas_get_num_entries(atlas), num_entries);
+
+    psy_text_set_content(text, "HI");
+    psy_image_canvas_iterate(g_canvas);
+    CU_ASSERT_EQUAL(psy_texture_atlas_get_num_entries(atlas), num_entries + 1);
+
+    g_object_unref(text);
+}
+
+typedef struct RenderWait {
+    GMainLoop *loop;
+    guint      timeout;
+} RenderWait;
+
+static void
+on_render_ready(PsyText *text, gpointer data)
+{
+    (void) text;
+    RenderWait *waiter = data;
+    g_main_loop_quit(waiter->loop);
+}
+
+static gboolean
+on_render_timeout(gpointer data)
+{
+    RenderWait *waiter = data;
+    waiter->timeout    = 0; // the source is removed by returning
+    g_main_loop_quit(waiter->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+text_render_ready(void)
+{
+    PsyCanvas *canvas = PSY_CANVAS(g_canvas);
+    PsyText   *text = psy_text_new_full(canvas, 0, 0, 200, 100, "Hi", FALSE);
+    RenderWait waiter = {.loop = g_main_loop_new(NULL, FALSE)};
+
+    // The glyphs are prepared by a worker, the signal is emitted in the main
+    // context.
+    gulong id = g_signal_connect(
+        text, "render-ready", G_CALLBACK(on_render_ready), &waiter);
+    waiter.timeout = g_timeout_add_seconds(5, on_render_timeout, &waiter);
+    g_main_loop_run(waiter.loop);
+    CU_ASSERT_TRUE(psy_text_is_render_ready(text));
+    g_clear_handle_id(&waiter.timeout, g_source_remove);
+    g_signal_handler_disconnect(text, id);
+
+    // A change makes the text not ready, until it has been prepared again.
+    psy_text_set_content(text, "Hello");
+    psy_text_set_font_color(text, g_stim_color);
+    CU_ASSERT_TRUE(psy_text_wait_render_ready(text));
+    CU_ASSERT_TRUE(psy_text_is_render_ready(text));
+
+    psy_canvas_reset(canvas);
+    psy_stimulus_play(PSY_STIMULUS(text), g_tp_start);
+    psy_image_canvas_iterate(g_canvas);
+    CU_ASSERT_FALSE(psy_text_get_is_dirty(text));
+
+    // Dispatch the completions of the workers that have finished.
+    while (g_main_context_iteration(NULL, FALSE))
+        ;
+
+    g_main_loop_unref(waiter.loop);
+    g_object_unref(text);
+}
+
 int
 add_text_suite(void)
 {
@@ -131,5 +252,13 @@ add_text_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, text_draw_glyphs);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, text_render_ready);
+    if (!test)
+        return 1;
+
     return 0;
 }
@@ -264,6 +264,39 @@ check_clock_zero_time(void)
     psy_clock_free(clock);
 }
 
+static void
+check_clock_source(PsyClockSource source)
+{
+    gint64 prev = psy_clock_get_monotonic_time_ns();
+
+    for (gint i = 0; i < 10000; i++) {
+        gint64 now = psy_clock_get_monotonic_time_ns();
+        CU_ASSERT_TRUE(now >= prev);
+        prev = now;
+    }
+
+    // The clock should remain on the timebase of the glib clock
+    gint64 glib_time = g_get_monotonic_time();
+    gint64 psy_time  = psy_clock_get_monotonic_time();
+    CU_ASSERT_TRUE(ABS(psy_time - glib_time) < 1000);
+
+    CU_ASSERT_EQUAL(psy_clock_get_source(), source);
+}
+
+static void
+check_clock_sources(void)
+{
+    check_clock_source(PSY_CLOCK_SOURCE_MONOTONIC);
+
+    if (psy_clock_set_source(PSY_CLOCK_SOURCE_TSC))
+        check_clock_source(PSY_CLOCK_SOURCE_TSC);
+    else
+        CU_ASSERT_EQUAL(psy_clock_get_source(), PSY_CLOCK_SOURCE_MONOTONIC);
+
+    CU_ASSERT_TRUE(psy_clock_set_source(PSY_CLOCK_SOURCE_MONOTONIC));
+    CU_ASSERT_EQUAL(psy_clock_get_source(), PSY_CLOCK_SOURCE_MONOTONIC);
+}
+
 int
 add_time_utilities_suite(void)
 {
@@ -312,5 +345,10 @@ add_time_utilities_suite(void)
     if (!test)
         return 1;
 
+    test = CU_add_test(
+        suite, "Test clock sources share a timebase", check_clock_sources);
+    if (!test)
+        return 1;
+
     return 0;
 }
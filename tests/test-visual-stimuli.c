@@ -218,6 +218,169 @@ cross_specific_values(void)
     psy_image_free(image);
 }
 
+/*
+ * Counts the pixels in the middle row of image that have the stimulus color.
+ */
+static gint
+count_stim_pixels_in_middle_row(PsyImage *image)
+{
+    const guint row   = psy_image_get_height(image) / 2;
+    gint        count = 0;
+
+    for (guint col = 0; col < psy_image_get_width(image); col++) {
+        PsyColor *color = psy_image_get_pixel(image, row, col);
+        if (psy_color_equal_eps(g_stim_color, color, 1.0f / 255))
+            count++;
+        psy_color_free(color);
+    }
+    return count;
+}
+
+static void
+circle_smooth_and_ring(void)
+{
+    const gfloat radius = 50, inner_radius = 30;
+
+    PsyCircle *circle = psy_circle_new_full(g_canvas, 0, 0, radius, 3);
+    psy_circle_set_smooth(circle, TRUE);
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(circle), g_stim_color);
+
+    psy_canvas_reset(g_canvas);
+    psy_canvas_set_background_color(g_canvas, g_bg_color);
+    psy_stimulus_play(PSY_STIMULUS(circle), g_tp_start);
+
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(g_canvas));
+    PsyImage *image = psy_canvas_get_image(g_canvas);
+    if (save_images())
+        save_image_tmp_png(image, "%s-smooth.png", __func__);
+
+    // A smooth circle is round, despite its 3 vertices, the pixels on the
+    // edge are a blend of the circle and background.
+    gint count = count_stim_pixels_in_middle_row(image);
+    CU_ASSERT_TRUE(abs(count - (gint) (2 * radius)) <= 2);
+    psy_image_free(image);
+
+    psy_circle_set_inner_radius(circle, inner_radius);
+    psy_canvas_reset(g_canvas);
+    psy_canvas_set_background_color(g_canvas, g_bg_color);
+    psy_stimulus_play(PSY_STIMULUS(circle), g_tp_start);
+
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(g_canvas));
+    image = psy_canvas_get_image(g_canvas);
+    if (save_images())
+        save_image_tmp_png(image, "%s-ring.png", __func__);
+
+    count = count_stim_pixels_in_middle_row(image);
+    CU_ASSERT_TRUE(abs(count - (gint) (2 * (radius - inner_radius))) <= 2);
+
+    PsyColor *center = psy_image_get_pixel(image,
+                                           psy_image_get_height(image) / 2,
+                                           psy_image_get_width(image) / 2);
+    CU_ASSERT_TRUE(psy_color_equal_eps(g_bg_color, center, 1.0f / 255));
+    psy_color_free(center);
+
+    psy_image_free(image);
+    psy_circle_free(circle);
+}
+
+/*
+ * Draws a number of overlapping rectangles, circles and crosses in random
+ * colors, the same seed results in the same stimuli.
+ */
+static PsyImage *
+draw_overlapping_stimuli(guint32 seed, gboolean batch_stimuli)
+{
+    GRand     *rand    = g_rand_new_with_seed(seed);
+    GPtrArray *stimuli = g_ptr_array_new_with_free_func(g_object_unref);
+
+    psy_canvas_reset(g_canvas);
+    psy_canvas_set_background_color(g_canvas, g_bg_color);
+    psy_canvas_set_batch_stimuli(g_canvas, batch_stimuli);
+
+    for (gint i = 0; i < 60; i++) {
+        gfloat x    = g_rand_int_range(rand, -100, 100);
+        gfloat y    = g_rand_int_range(rand, -100, 100);
+        gfloat size = g_rand_int_range(rand, 10, 100);
+
+        PsyVisualStimulus *stim;
+        // Runs of the same shape, so that they are batched.
+        switch ((i / 4) % 3) {
+        case 0:
+            stim = PSY_VISUAL_STIMULUS(
+                psy_rectangle_new_full(g_canvas, x, y, size, size / 2));
+            break;
+        case 1:
+            stim = PSY_VISUAL_STIMULUS(
+                psy_circle_new_full(g_canvas, x, y, size / 2, 30));
+            break;
+        default:
+            stim = PSY_VISUAL_STIMULUS(
+                psy_cross_new_full(g_canvas, x, y, size, size / 5));
+            break;
+        }
+
+        PsyColor *color = psy_color_new_rgbi(g_rand_int_range(rand, 0, 256),
+                                             g_rand_int_range(rand, 0, 256),
+                                             g_rand_int_range(rand, 0, 256));
+        psy_visual_stimulus_set_color(stim, color);
+        g_object_unref(color);
+
+        psy_stimulus_play(PSY_STIMULUS(stim), g_tp_start);
+        g_ptr_array_add(stimuli, stim);
+    }
+
+    psy_image_canvas_iterate(PSY_IMAGE_CANVAS(g_canvas));
+    PsyImage *image = psy_canvas_get_image(g_canvas);
+
+    psy_canvas_set_batch_stimuli(g_canvas, TRUE);
+    g_ptr_array_unref(stimuli);
+    g_rand_free(rand);
+
+    return image;
+}
+
+static void
+batched_stimuli_equal_unbatched(void)
+{
+    guint32 seed = (guint32) random_int_range(0, G_MAXINT16);
+
+    PsyImage *batched   = draw_overlapping_stimuli(seed, TRUE);
+    PsyImage *unbatched = draw_overlapping_stimuli(seed, FALSE);
+
+    if (save_images()) {
+        save_image_tmp_png(batched, "%s-batched.png", __func__);
+        save_image_tmp_png(unbatched, "%s-unbatched.png", __func__);
+    }
+
+    GBytes *bbytes = psy_image_get_bytes(batched);
+    GBytes *ubytes = psy_image_get_bytes(unbatched);
+    gsize   size, usize;
+
+    const guint8 *bdata = g_bytes_get_data(bbytes, &size);
+    const guint8 *udata = g_bytes_get_data(ubytes, &usize);
+    CU_ASSERT_EQUAL_FATAL(size, usize);
+
+    // The batched stimuli are transformed on the GPU, allow the edges of a
+    // few stimuli to be rounded differently.
+    gsize num_different = 0;
+    for (gsize i = 0; i < size; i++)
+        if (bdata[i] != udata[i])
+            num_different++;
+
+    if (num_different > size / 1000)
+        g_warning("%" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT
+                  " bytes differ, seed = %u",
+                  num_different,
+                  size,
+                  seed);
+    CU_ASSERT_TRUE(num_different <= size / 1000);
+
+    g_bytes_unref(bbytes);
+    g_bytes_unref(ubytes);
+    psy_image_free(batched);
+    psy_image_free(unbatched);
+}
+
 int
 add_visual_stimuli_suite(void)
 {
@@ -237,5 +400,13 @@ add_visual_stimuli_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, circle_smooth_and_ring);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, batched_stimuli_equal_unbatched);
+    if (!test)
+        return 1;
+
     return 0;
 }
@@ -718,6 +718,165 @@ vstim_draworder_different_z(void)
     psy_duration_free(dur);
 }
 
+static void
+vstim_sorted_draworder(void)
+{
+    PsyImage    *image = NULL;
+    PsyDuration *dur   = psy_duration_new_ms(50);
+    PsyColor    *front_color
+        = g_object_new(PSY_TYPE_COLOR, "r", 1.0f, "a", 0.5f, NULL);
+    PsyColor *back_color
+        = g_object_new(PSY_TYPE_COLOR, "r", 1.0f, "g", 1.0f, "b", 0.0f, NULL);
+    PsyColor *bg_color = psy_color_new_rgb(0, 0, 0);
+
+    psy_canvas_reset(PSY_CANVAS(g_canvas));
+    psy_canvas_set_background_color(PSY_CANVAS(g_canvas), bg_color);
+    psy_canvas_set_sort_stimuli(PSY_CANVAS(g_canvas), TRUE);
+
+    // clang-format off
+    PsyRectangle *back = g_object_new(PSY_TYPE_RECTANGLE,
+                                      "canvas", g_canvas,
+                                      "z", 0.0f,
+                                      "width", 150.0f,
+                                      "height", 150.0f,
+                                      "color", back_color,
+                                      NULL);
+    PsyCircle *circle = g_object_new(PSY_TYPE_CIRCLE,
+                                     "canvas", g_canvas,
+                                     "x", 200.0f,
+                                     "z", 0.0f,
+                                     "radius", 20.0f,
+                                     "color", back_color,
+                                     NULL);
+    PsyRectangle *front = g_object_new(PSY_TYPE_RECTANGLE,
+                                       "canvas", g_canvas,
+                                       "z", 1.0f,
+                                       "width", 100.0f,
+                                       "height", 100.0f,
+                                       "color", front_color,
+                                       NULL);
+    // clang-format on
+
+    // Unsorted, the translucent front is drawn first, as it is played last.
+    PsyTimePoint *start = psy_image_canvas_get_time(g_canvas);
+    psy_stimulus_play_for(PSY_STIMULUS(back), start, dur);
+    psy_stimulus_play_for(PSY_STIMULUS(circle), start, dur);
+    psy_stimulus_play_for(PSY_STIMULUS(front), start, dur);
+
+    psy_image_canvas_iterate(g_canvas);
+
+    image = psy_canvas_get_image(PSY_CANVAS(g_canvas));
+    if (save_images())
+        save_image_tmp_png(image, "%s.png", __func__);
+
+    // The front is blended with the back, drawn from back to front.
+    PsyColor *test_color = psy_image_get_pixel(image, HEIGHT / 2, WIDTH / 2);
+    CU_ASSERT_DOUBLE_EQUAL(psy_color_get_red(test_color), 1.0, 2.0 / 255);
+    CU_ASSERT_DOUBLE_EQUAL(psy_color_get_green(test_color), 0.5, 2.0 / 255);
+    CU_ASSERT_DOUBLE_EQUAL(psy_color_get_blue(test_color), 0.0, 2.0 / 255);
+
+    psy_canvas_set_sort_stimuli(PSY_CANVAS(g_canvas), FALSE);
+    psy_canvas_set_background_color(PSY_CANVAS(g_canvas), g_bg_color);
+
+    g_object_unref(test_color);
+    g_object_unref(image);
+    g_object_unref(front);
+    g_object_unref(circle);
+    g_object_unref(back);
+    psy_time_point_free(start);
+    g_object_unref(bg_color);
+    g_object_unref(back_color);
+    g_object_unref(front_color);
+    psy_duration_free(dur);
+}
+
+static void
+vstim_artist_translucent(void)
+{
+    PsyColor *opaque = psy_color_new_rgb(1.0f, 0.0f, 0.0f);
+    PsyColor *half   = g_object_new(PSY_TYPE_COLOR, "r", 1.0f, "a", 0.5f, NULL);
+
+    PsyRectangle *rect = psy_rectangle_new(PSY_CANVAS(g_canvas));
+    PsyText      *text = psy_text_new(PSY_CANVAS(g_canvas));
+
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(rect), opaque);
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(text), opaque);
+
+    PsyRectangleArtist *rect_artist = psy_rectangle_artist_new(
+        PSY_CANVAS(g_canvas), PSY_VISUAL_STIMULUS(rect));
+    PsyTextArtist *text_artist
+        = psy_text_artist_new(PSY_CANVAS(g_canvas), PSY_VISUAL_STIMULUS(text));
+
+    CU_ASSERT_FALSE(psy_artist_is_translucent(PSY_ARTIST(rect_artist)));
+    // Text is blended, regardless of its color.
+    CU_ASSERT_TRUE(psy_artist_is_translucent(PSY_ARTIST(text_artist)));
+
+    // The smooth edges of a rounded rectangle are blended.
+    psy_rectangle_set_corner_radius(rect, 10.0f);
+    CU_ASSERT_TRUE(psy_artist_is_translucent(PSY_ARTIST(rect_artist)));
+    psy_rectangle_set_corner_radius(rect, 0.0f);
+    CU_ASSERT_FALSE(psy_artist_is_translucent(PSY_ARTIST(rect_artist)));
+
+    psy_visual_stimulus_set_color(PSY_VISUAL_STIMULUS(rect), half);
+    CU_ASSERT_TRUE(psy_artist_is_translucent(PSY_ARTIST(rect_artist)));
+
+    g_object_unref(text_artist);
+    g_object_unref(rect_artist);
+    g_object_unref(text);
+    g_object_unref(rect);
+    g_object_unref(half);
+    g_object_unref(opaque);
+}
+
+static void
+vstim_start_frame_order(void)
+{
+    const guint   num_stimuli = 8;
+    PsyCircle    *circles[8];
+    PsyDuration  *frame_dur = psy_canvas_get_frame_dur(PSY_CANVAS(g_canvas));
+    PsyTimePoint *now       = psy_image_canvas_get_time(g_canvas);
+
+    psy_canvas_reset(PSY_CANVAS(g_canvas));
+
+    // Schedule the stimuli in the reverse order of their start.
+    for (guint i = 0; i < num_stimuli; i++) {
+        PsyDuration *wait
+            = psy_duration_multiply_scalar(frame_dur, num_stimuli - i);
+        PsyTimePoint *start = psy_time_point_add(now, wait);
+
+        circles[i] = psy_circle_new(PSY_CANVAS(g_canvas));
+        psy_stimulus_play_for(PSY_STIMULUS(circles[i]), start, frame_dur);
+
+        psy_time_point_free(start);
+        psy_duration_free(wait);
+    }
+    CU_ASSERT_EQUAL(psy_canvas_get_num_stimuli(PSY_CANVAS(g_canvas)),
+                    num_stimuli);
+
+    for (guint frame = 0; frame < num_stimuli + 2; frame++) {
+        psy_image_canvas_iterate(g_canvas);
+
+        // A stimulus has only started when the ones before it have.
+        for (guint i = 1; i < num_stimuli; i++) {
+            gint64 nth_later = psy_visual_stimulus_get_nth_frame(
+                PSY_VISUAL_STIMULUS(circles[i - 1]));
+            gint64 nth_earlier = psy_visual_stimulus_get_nth_frame(
+                PSY_VISUAL_STIMULUS(circles[i]));
+            CU_ASSERT_TRUE(nth_later == 0 || nth_earlier > 0);
+        }
+    }
+
+    CU_ASSERT_EQUAL(psy_canvas_get_num_stimuli(PSY_CANVAS(g_canvas)), 0);
+    for (guint i = 0; i < num_stimuli; i++) {
+        CU_ASSERT_EQUAL(psy_visual_stimulus_get_nth_frame(
+                            PSY_VISUAL_STIMULUS(circles[i])),
+                        1);
+        g_object_unref(circles[i]);
+    }
+
+    psy_time_point_free(now);
+}
+
 int
 add_visual_stimulus_suite(void)
 {
@@ -754,5 +913,17 @@ add_visual_stimulus_suite(void)
     if (!test)
         return 1;
 
+    test = CU_ADD_TEST(suite, vstim_sorted_draworder);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, vstim_artist_translucent);
+    if (!test)
+        return 1;
+
+    test = CU_ADD_TEST(suite, vstim_start_frame_order);
+    if (!test)
+        return 1;
+
     return 0;
 }
@@ -0,0 +1,74 @@
+#include "alloc-count.h"
+
+#include <stddef.h>
+
+/*
+ * On glibc we interpose malloc and friends in order to count the number
+ * of allocations. Every call that may return new memory counts as one
+ * allocation, so a realloc counts even when it is able to grow the block in
+ * place. Elsewhere the count is reported as -1.
+ */
+#if defined(__GLIBC__)
+extern void *
+__libc_malloc(size_t size);
+extern void *
+__libc_calloc(size_t nmemb, size_t size);
+extern void *
+__libc_realloc(void *ptr, size_t size);
+
+static gint g_num_allocs      = 0;
+static gint g_count_allocs_on = 0;
+
+static inline void
+alloc_count_inc(void)
+{
+    if (g_atomic_int_get(&g_count_allocs_on))
+        g_atomic_int_inc(&g_num_allocs);
+}
+
+void *
+malloc(size_t size)
+{
+    alloc_count_inc();
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+    alloc_count_inc();
+    return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+    alloc_count_inc();
+    return __libc_realloc(ptr, size);
+}
+
+void
+alloc_count_start(void)
+{
+    g_atomic_int_set(&g_num_allocs, 0);
+    g_atomic_int_set(&g_count_allocs_on, 1);
+}
+
+gint64
+alloc_count_stop(void)
+{
+    g_atomic_int_set(&g_count_allocs_on, 0);
+    return g_atomic_int_get(&g_num_allocs);
+}
+#else
+void
+alloc_count_start(void)
+{
+}
+
+gint64
+alloc_count_stop(void)
+{
+    return -1;
+}
+#endif
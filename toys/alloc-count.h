@@ -0,0 +1,13 @@
+// Counts the allocations made by the process (psylib, glib and the toy
+// itself) between alloc_count_start and alloc_count_stop. The toys use this
+// to spot code paths that allocate while they should not.
+
+#pragma once
+
+#include <glib.h>
+
+void
+alloc_count_start(void);
+
+gint64
+alloc_count_stop(void);
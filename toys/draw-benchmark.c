@@ -0,0 +1,303 @@
+// This toy measures how much CPU time the artists need to draw many stimuli.
+// It creates a (large) number of circles, rectangles and crosses on an
+// offscreen PsyImageCanvas and times how long it takes to render a frame.
+// Optionally all stimuli are moved every frame, so the artists have to
+// rebuild their model matrices, or resized every frame, so the artists that
+// don't draw in batches have to upload new vertices. The results are printed
+// as text, csv or json, so they can be stored and compared between runs in
+// order to spot regressions.
+
+#include <psylib.h>
+
+#include "alloc-count.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static gint         num_stimuli  = 1000;
+static gint         num_frames   = 300;
+static gint         num_warmup   = 10;
+static gint         width        = 640;
+static gint         height       = 480;
+static gboolean     animate      = FALSE;
+static gboolean     resize       = FALSE;
+static gboolean     batch        = TRUE;
+static gint64       seed         = 0;
+static const gchar *format       = "text";
+static const gchar *output_fn    = NULL;
+static gboolean     print_header = TRUE;
+
+// clang-format off
+GOptionEntry options[] = {
+    {"num-stimuli", 'n', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &num_stimuli, "The number of stimuli to draw", "N"},
+    {"num-frames", 'F', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &num_frames, "The number of frames to time", "N"},
+    {"warmup", 'w', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &num_warmup, "The number of frames drawn before timing", "N"},
+    {"width", 'W', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &width, "The width of the canvas", "px"},
+    {"height", 'H', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &height, "The height of the canvas", "px"},
+    {"animate", 'a', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &animate, "Move every stimulus every frame", NULL},
+    {"resize", 'r', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &resize, "Resize every stimulus every frame", NULL},
+    {"no-batch", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &batch, "Draw every stimulus by its own artist", NULL},
+    {"seed", 'S', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT64, &seed, "Seed for the random stimuli, 0 = random", "N"},
+    {"format", 'f', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &format, "The output format {text, csv, json}", "FMT"},
+    {"output", 'o', G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &output_fn, "Append the results to this file instead of stdout", "FILE"},
+    {"no-header", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &print_header, "Don't print the csv header", NULL},
+    {0}
+};
+// clang-format on
+
+/* ************ benchmark ***************** */
+
+typedef struct BenchResult {
+    gint64  p50;
+    gint64  p99;
+    gint64  max;
+    gint64  min;
+    gdouble mean;
+    gdouble ns_per_stimulus;
+    gdouble allocs_per_frame;
+} BenchResult;
+
+static PsyVisualStimulus *
+create_stimulus(PsyCanvas *canvas, GRand *rand, gint i)
+{
+    gfloat x    = g_rand_double_range(rand, -width / 2.0, width / 2.0);
+    gfloat y    = g_rand_double_range(rand, -height / 2.0, height / 2.0);
+    gfloat size = g_rand_double_range(rand, 5.0, 50.0);
+
+    PsyVisualStimulus *stim;
+    switch (i % 3) {
+    case 0:
+        stim = PSY_VISUAL_STIMULUS(
+            psy_circle_new_full(canvas, x, y, size / 2, 20));
+        break;
+    case 1:
+        stim = PSY_VISUAL_STIMULUS(
+            psy_rectangle_new_full(canvas, x, y, size, size));
+        break;
+    default:
+        stim = PSY_VISUAL_STIMULUS(
+            psy_cross_new_full(canvas, x, y, size, size / 5));
+        break;
+    }
+
+    PsyColor *color = psy_color_new_rgb(g_rand_double(rand),
+                                        g_rand_double(rand),
+                                        g_rand_double(rand));
+    psy_visual_stimulus_set_color(stim, color);
+    g_object_unref(color);
+
+    return stim;
+}
+
+static void
+resize_stimulus(PsyVisualStimulus *stim, gint frame)
+{
+    gfloat scale = 1.0f + 0.25f * sinf(frame * 0.1f);
+
+    if (PSY_IS_CIRCLE(stim)) {
+        psy_circle_set_radius(PSY_CIRCLE(stim), 10.0f * scale);
+    }
+    else if (PSY_IS_RECTANGLE(stim)) {
+        psy_rectangle_set_width(PSY_RECTANGLE(stim), 20.0f * scale);
+        psy_rectangle_set_height(PSY_RECTANGLE(stim), 20.0f * scale);
+    }
+    else if (PSY_IS_CROSS(stim)) {
+        psy_cross_set_line_length_x(PSY_CROSS(stim), 20.0f * scale);
+        psy_cross_set_line_length_y(PSY_CROSS(stim), 20.0f * scale);
+    }
+}
+
+static gint
+compare_gint64(gconstpointer a, gconstpointer b)
+{
+    gint64 lhs = *(const gint64 *) a, rhs = *(const gint64 *) b;
+    return lhs < rhs ? -1 : lhs > rhs;
+}
+
+/*
+ * The nearest rank method on a sorted array.
+ */
+static gint64
+percentile(const gint64 *sorted, guint n, gdouble p)
+{
+    if (n == 0)
+        return 0;
+    gdouble exact = p / 100.0 * n;
+    guint   rank  = (guint) exact;
+    if (rank < exact || rank < 1)
+        rank++;
+    return sorted[MIN(rank, n) - 1];
+}
+
+static void
+write_result(FILE *out, BenchResult *r)
+{
+    if (g_strcmp0(format, "csv") == 0) {
+        if (print_header)
+            fprintf(out,
+                    "num_stimuli,num_frames,animate,resize,batch,seed,"
+                    "p50_us,p99_us,max_us,min_us,mean_us,ns_per_stimulus,"
+                    "allocs_per_frame\n");
+        fprintf(out,
+                "%d,%d,%d,%d,%d,%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT
+                ",%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT
+                ",%.3f,%.1f,%.2f\n",
+                num_stimuli,
+                num_frames,
+                animate,
+                resize,
+                batch,
+                seed,
+                r->p50,
+                r->p99,
+                r->max,
+                r->min,
+                r->mean,
+                r->ns_per_stimulus,
+                r->allocs_per_frame);
+    }
+    else if (g_strcmp0(format, "json") == 0) {
+        fprintf(out,
+                "{\"num_stimuli\": %d, \"num_frames\": %d, \"animate\": %s, "
+                "\"resize\": %s, \"batch\": %s, \"seed\": %" G_GINT64_FORMAT
+                ", \"frame_us\": {\"p50\": %" G_GINT64_FORMAT
+                ", \"p99\": %" G_GINT64_FORMAT ", \"max\": %" G_GINT64_FORMAT
+                ", \"min\": %" G_GINT64_FORMAT
+                ", \"mean\": %.3f}, \"ns_per_stimulus\": %.1f, "
+                "\"allocs_per_frame\": %.2f}\n",
+                num_stimuli,
+                num_frames,
+                animate ? "true" : "false",
+                resize ? "true" : "false",
+                batch ? "true" : "false",
+                seed,
+                r->p50,
+                r->p99,
+                r->max,
+                r->min,
+                r->mean,
+                r->ns_per_stimulus,
+                r->allocs_per_frame);
+    }
+    else {
+        fprintf(out, "stimuli        : %d\n", num_stimuli);
+        fprintf(out, "frames         : %d\n", num_frames);
+        fprintf(out, "animated       : %s\n", animate ? "yes" : "no");
+        fprintf(out, "resized        : %s\n", resize ? "yes" : "no");
+        fprintf(out, "batched        : %s\n", batch ? "yes" : "no");
+        fprintf(out, "seed           : %" G_GINT64_FORMAT "\n", seed);
+        fprintf(out, "frame p50      : %" G_GINT64_FORMAT " us\n", r->p50);
+        fprintf(out, "frame p99      : %" G_GINT64_FORMAT " us\n", r->p99);
+        fprintf(out, "frame max      : %" G_GINT64_FORMAT " us\n", r->max);
+        fprintf(out, "frame min      : %" G_GINT64_FORMAT " us\n", r->min);
+        fprintf(out, "frame mean     : %.3f us\n", r->mean);
+        fprintf(out, "ns/stimulus    : %.1f\n", r->ns_per_stimulus);
+        fprintf(out, "allocs/frame   : %.2f\n", r->allocs_per_frame);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    GError         *error = NULL;
+    GOptionContext *opts  = g_option_context_new("draw benchmark options");
+    g_option_context_add_main_entries(opts, options, NULL);
+
+    if (!g_option_context_parse(opts, &argc, &argv, &error)) {
+        g_printerr("Oops unable to parse options: %s\n", error->message);
+        g_option_context_free(opts);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(opts);
+
+    if (num_stimuli <= 0 || num_frames <= 0 || num_warmup < 0 || width <= 0
+        || height <= 0) {
+        g_printerr("Invalid options, see --help\n");
+        return EXIT_FAILURE;
+    }
+
+    psy_init();
+
+    if (seed == 0)
+        seed = g_get_real_time();
+    GRand *rand = g_rand_new_with_seed((guint32) seed);
+
+    PsyImageCanvas *canvas  = psy_image_canvas_new(width, height);
+    GPtrArray      *stimuli = g_ptr_array_new_with_free_func(g_object_unref);
+
+    psy_canvas_set_batch_stimuli(PSY_CANVAS(canvas), batch);
+
+    PsyTimePoint *now   = psy_image_canvas_get_time(canvas);
+    PsyTimePoint *start = psy_time_point_add(
+        now, psy_canvas_get_frame_dur(PSY_CANVAS(canvas)));
+
+    for (gint i = 0; i < num_stimuli; i++) {
+        PsyVisualStimulus *stim = create_stimulus(PSY_CANVAS(canvas), rand, i);
+        psy_stimulus_play(PSY_STIMULUS(stim), start);
+        g_ptr_array_add(stimuli, stim);
+    }
+
+    for (gint i = 0; i < num_warmup; i++)
+        psy_image_canvas_iterate(canvas);
+
+    gint64 *frame_times = g_new(gint64, num_frames);
+    gdouble sum         = 0;
+
+    alloc_count_start();
+    for (gint frame = 0; frame < num_frames; frame++) {
+        if (animate) {
+            for (guint i = 0; i < stimuli->len; i++) {
+                PsyVisualStimulus *stim = g_ptr_array_index(stimuli, i);
+                psy_visual_stimulus_set_rotation(stim, frame * 0.01f);
+            }
+        }
+        if (resize) {
+            for (guint i = 0; i < stimuli->len; i++)
+                resize_stimulus(g_ptr_array_index(stimuli, i), frame);
+        }
+
+        gint64 t0 = psy_clock_get_monotonic_time_ns();
+        psy_image_canvas_iterate(canvas);
+        gint64 t1 = psy_clock_get_monotonic_time_ns();
+
+        frame_times[frame] = (t1 - t0) / 1000;
+        sum += (gdouble) (t1 - t0);
+    }
+    gint64 allocs = alloc_count_stop();
+
+    qsort(frame_times, num_frames, sizeof(gint64), compare_gint64);
+
+    BenchResult result      = {0};
+    result.p50              = percentile(frame_times, num_frames, 50.0);
+    result.p99              = percentile(frame_times, num_frames, 99.0);
+    result.max              = frame_times[num_frames - 1];
+    result.min              = frame_times[0];
+    result.mean             = sum / num_frames / 1000.0;
+    result.ns_per_stimulus  = sum / num_frames / num_stimuli;
+    result.allocs_per_frame = allocs < 0 ? -1.0 : (gdouble) allocs / num_frames;
+
+    FILE *out = stdout;
+    if (output_fn) {
+        out = fopen(output_fn, "a");
+        if (!out) {
+            g_printerr("Unable to open %s, using stdout\n", output_fn);
+            out = stdout;
+        }
+    }
+    write_result(out, &result);
+    if (out != stdout)
+        fclose(out);
+
+    g_free(frame_times);
+    psy_time_point_free(start);
+    psy_time_point_free(now);
+    g_ptr_array_unref(stimuli);
+    psy_image_canvas_free(canvas);
+    g_rand_free(rand);
+
+    psy_deinit();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,416 @@
+// This toy measures how accurately PsyTimers fire. It schedules a (large)
+// number of timers at random deadlines and records how late the "fired"
+// signal arrives in the main context. Optionally the main loop is kept busy
+// with synthetic work and/or the audio device is mixing sounds while the
+// timers run. The results are printed as text, csv or json, so they can be
+// stored and compared between runs in order to spot regressions.
+
+#include <psylib.h>
+
+#include "alloc-count.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined G_OS_UNIX
+    #include <sys/resource.h>
+#endif
+
+static gint         num_timers   = 2000;
+static gint         spread_ms    = 4000;
+static gint         lead_ms      = 20;
+static gint         load_us      = 0;
+static gboolean     mix_audio    = FALSE;
+static gint64       seed         = 0;
+static const gchar *format       = "text";
+static const gchar *output_fn    = NULL;
+static const gchar *samples_fn   = NULL;
+static gboolean     print_header = TRUE;
+
+// clang-format off
+GOptionEntry options[] = {
+    {"num-timers", 'n', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &num_timers, "The number of timers to schedule", "N"},
+    {"spread", 's', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &spread_ms, "The deadlines are uniformly spread over this many ms", "ms"},
+    {"lead", 'l', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &lead_ms, "The earliest deadline is this many ms in the future", "ms"},
+    {"load", 'L', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &load_us, "Keep the main loop busy for N us every ms", "us"},
+    {"audio", 'a', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &mix_audio, "Play sounds on the default audio device while running", NULL},
+    {"seed", 'S', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT64, &seed, "Seed for the random deadlines, 0 = random", "N"},
+    {"format", 'f', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &format, "The output format {text, csv, json}", "FMT"},
+    {"output", 'o', G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &output_fn, "Append the results to this file instead of stdout", "FILE"},
+    {"samples", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &samples_fn, "Write the lateness of every timer to this file", "FILE"},
+    {"no-header", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &print_header, "Don't print the csv header", NULL},
+    {0}
+};
+// clang-format on
+
+/* ************ cpu usage ***************** */
+
+static gint64
+cpu_time_us(void)
+{
+#if defined G_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return (gint64) usage.ru_utime.tv_sec * G_USEC_PER_SEC
+           + usage.ru_utime.tv_usec
+           + (gint64) usage.ru_stime.tv_sec * G_USEC_PER_SEC
+           + usage.ru_stime.tv_usec;
+#else
+    return -1;
+#endif
+}
+
+/* ************ the benchmark ***************** */
+
+typedef struct BenchData BenchData;
+
+typedef struct BenchTimer {
+    BenchData *bench;
+    PsyTimer  *timer;
+    guint      index;
+} BenchTimer;
+
+struct BenchData {
+    GMainLoop      *loop;
+    BenchTimer     *timers;
+    gint64         *lateness; // in us, indexed by BenchTimer.index
+    guint           num_fired;
+    gint64          zero_time;
+    PsyAudioDevice *device;
+};
+
+typedef struct BenchResult {
+    gint64  p50, p99, p999, max, min;
+    gdouble mean;
+    gdouble cpu_percent;
+    gdouble allocs_per_fire;
+    guint   num_fired;
+} BenchResult;
+
+static void
+on_fire(PsyTimer *timer, PsyTimePoint *fire_time, gpointer data)
+{
+    (void) timer;
+    BenchTimer *bt    = data;
+    BenchData  *bench = bt->bench;
+
+    // don't use psy_clock_now here as that would add allocations per fire
+    gint64 now = g_get_monotonic_time() - bench->zero_time;
+
+    bench->lateness[bt->index] = now - fire_time->ticks_since_start;
+
+    if (++bench->num_fired == (guint) num_timers)
+        g_main_loop_quit(bench->loop);
+}
+
+static gboolean
+on_load(gpointer data)
+{
+    (void) data;
+    gint64 stop = g_get_monotonic_time() + load_us;
+    while (g_get_monotonic_time() < stop)
+        ; // spin
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+on_play_sound(gpointer data)
+{
+    BenchData *bench = data;
+
+    PsyClock     *clk   = psy_clock_new();
+    PsyTimePoint *now   = psy_clock_now(clk);
+    PsyDuration  *dur   = psy_duration_new_ms(50);
+    PsyDuration  *delay = psy_duration_new_ms(10);
+    PsyTimePoint *start = psy_time_point_add(now, delay);
+
+    PsyWave *wave = psy_wave_new_volume(bench->device, 0.1);
+    psy_stimulus_play_for(PSY_STIMULUS(wave), start, dur);
+    g_object_unref(wave);
+
+    psy_time_point_free(start);
+    psy_duration_free(delay);
+    psy_duration_free(dur);
+    psy_time_point_free(now);
+    psy_clock_free(clk);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+on_safety_timeout(gpointer data)
+{
+    BenchData *bench = data;
+    g_printerr("Not all timers fired in time, only %u of %d\n",
+               bench->num_fired,
+               num_timers);
+    g_main_loop_quit(bench->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gint
+compare_gint64(gconstpointer a, gconstpointer b)
+{
+    gint64 lhs = *(const gint64 *) a, rhs = *(const gint64 *) b;
+    return lhs < rhs ? -1 : lhs > rhs;
+}
+
+/*
+ * The nearest rank method on a sorted array.
+ */
+static gint64
+percentile(const gint64 *sorted, guint n, gdouble p)
+{
+    if (n == 0)
+        return 0;
+    gdouble exact = p / 100.0 * n;
+    guint   rank  = (guint) exact;
+    if (rank < exact || rank < 1)
+        rank++;
+    return sorted[MIN(rank, n) - 1];
+}
+
+static void
+compute_result(BenchData *bench, BenchResult *result)
+{
+    guint   n     = bench->num_fired;
+    gint64 *lates = g_new(gint64, num_timers);
+    guint   j     = 0;
+    gdouble sum   = 0;
+
+    // Timers that did not fire are marked with G_MININT64
+    for (gint i = 0; i < num_timers; i++) {
+        if (bench->lateness[i] != G_MININT64) {
+            lates[j++] = bench->lateness[i];
+            sum += (gdouble) bench->lateness[i];
+        }
+    }
+    g_assert(j == n);
+
+    qsort(lates, n, sizeof(gint64), compare_gint64);
+
+    result->num_fired = n;
+    result->p50       = percentile(lates, n, 50.0);
+    result->p99       = percentile(lates, n, 99.0);
+    result->p999      = percentile(lates, n, 99.9);
+    result->max       = n ? lates[n - 1] : 0;
+    result->min       = n ? lates[0] : 0;
+    result->mean      = n ? sum / n : 0.0;
+
+    g_free(lates);
+}
+
+static void
+write_samples(BenchData *bench)
+{
+    FILE *out = fopen(samples_fn, "w");
+    if (!out) {
+        g_printerr("Unable to open %s\n", samples_fn);
+        return;
+    }
+    fprintf(out, "timer,lateness_us\n");
+    for (gint i = 0; i < num_timers; i++)
+        if (bench->lateness[i] != G_MININT64)
+            fprintf(out, "%d,%" G_GINT64_FORMAT "\n", i, bench->lateness[i]);
+    fclose(out);
+}
+
+static void
+write_result(FILE *out, BenchResult *r, gboolean audio)
+{
+    if (g_strcmp0(format, "csv") == 0) {
+        if (print_header)
+            fprintf(out,
+                    "num_timers,num_fired,spread_ms,load_us,audio,seed,"
+                    "p50_us,p99_us,p999_us,max_us,min_us,mean_us,"
+                    "cpu_percent,allocs_per_fire\n");
+        fprintf(out,
+                "%d,%u,%d,%d,%d,%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT
+                ",%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT
+                ",%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT ",%.3f,%.2f,%.3f\n",
+                num_timers,
+                r->num_fired,
+                spread_ms,
+                load_us,
+                audio,
+                seed,
+                r->p50,
+                r->p99,
+                r->p999,
+                r->max,
+                r->min,
+                r->mean,
+                r->cpu_percent,
+                r->allocs_per_fire);
+    }
+    else if (g_strcmp0(format, "json") == 0) {
+        fprintf(out,
+                "{\"num_timers\": %d, \"num_fired\": %u, \"spread_ms\": %d, "
+                "\"load_us\": %d, \"audio\": %s, \"seed\": %" G_GINT64_FORMAT
+                ", \"lateness_us\": {\"p50\": %" G_GINT64_FORMAT
+                ", \"p99\": %" G_GINT64_FORMAT ", \"p99.9\": %" G_GINT64_FORMAT
+                ", \"max\": %" G_GINT64_FORMAT ", \"min\": %" G_GINT64_FORMAT
+                ", \"mean\": %.3f}, \"cpu_percent\": %.2f, "
+                "\"allocs_per_fire\": %.3f}\n",
+                num_timers,
+                r->num_fired,
+                spread_ms,
+                load_us,
+                audio ? "true" : "false",
+                seed,
+                r->p50,
+                r->p99,
+                r->p999,
+                r->max,
+                r->min,
+                r->mean,
+                r->cpu_percent,
+                r->allocs_per_fire);
+    }
+    else {
+        fprintf(out, "timers fired  : %u/%d\n", r->num_fired, num_timers);
+        fprintf(out, "seed          : %" G_GINT64_FORMAT "\n", seed);
+        fprintf(out, "lateness p50  : %" G_GINT64_FORMAT " us\n", r->p50);
+        fprintf(out, "lateness p99  : %" G_GINT64_FORMAT " us\n", r->p99);
+        fprintf(out, "lateness p99.9: %" G_GINT64_FORMAT " us\n", r->p999);
+        fprintf(out, "lateness max  : %" G_GINT64_FORMAT " us\n", r->max);
+        fprintf(out, "lateness min  : %" G_GINT64_FORMAT " us\n", r->min);
+        fprintf(out, "lateness mean : %.3f us\n", r->mean);
+        fprintf(out, "cpu usage     : %.2f %%\n", r->cpu_percent);
+        fprintf(out, "allocs/fire   : %.3f\n", r->allocs_per_fire);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    GError         *error = NULL;
+    GOptionContext *opts  = g_option_context_new("timer benchmark options");
+    g_option_context_add_main_entries(opts, options, NULL);
+
+    if (!g_option_context_parse(opts, &argc, &argv, &error)) {
+        g_printerr("Oops unable to parse options: %s\n", error->message);
+        g_option_context_free(opts);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(opts);
+
+    if (num_timers <= 0 || spread_ms <= 0 || lead_ms < 0 || load_us < 0
+        || load_us >= 1000) {
+        g_printerr("Invalid options, see --help\n");
+        return EXIT_FAILURE;
+    }
+
+    psy_init();
+
+    if (seed == 0)
+        seed = g_get_real_time();
+    GRand *rand = g_rand_new_with_seed((guint32) seed);
+
+    BenchData bench = {0};
+    bench.loop      = g_main_loop_new(NULL, FALSE);
+    bench.timers    = g_new0(BenchTimer, num_timers);
+    bench.lateness  = g_new(gint64, num_timers);
+    bench.zero_time = psy_clock_get_zero_time();
+
+    if (mix_audio) {
+        bench.device = psy_audio_device_new();
+        if (bench.device)
+            psy_audio_device_open(bench.device, &error);
+        if (!bench.device || error) {
+            g_printerr("Unable to open an audio device: %s\n",
+                       error ? error->message : "no audio backend");
+            g_clear_error(&error);
+            g_clear_object(&bench.device);
+        }
+    }
+
+    if (load_us > 0)
+        g_timeout_add(1, on_load, NULL);
+
+    if (bench.device)
+        g_timeout_add(100, on_play_sound, &bench);
+
+    PsyClock     *clk   = psy_clock_new();
+    PsyTimePoint *start = psy_clock_now(clk);
+
+    for (gint i = 0; i < num_timers; i++) {
+        BenchTimer *bt = &bench.timers[i];
+        bt->bench      = &bench;
+        bt->index      = (guint) i;
+        bt->timer      = psy_timer_new();
+
+        bench.lateness[i] = G_MININT64;
+
+        gint64 offset_us = (gint64) lead_ms * 1000
+                           + g_rand_int_range(rand, 0, spread_ms * 1000);
+        PsyDuration  *offset = psy_duration_new_us(offset_us);
+        PsyTimePoint *tp     = psy_time_point_add(start, offset);
+
+        g_signal_connect(bt->timer, "fired", G_CALLBACK(on_fire), bt);
+        psy_timer_set_fire_time(bt->timer, tp);
+
+        psy_time_point_free(tp);
+        psy_duration_free(offset);
+    }
+
+    g_timeout_add(lead_ms + spread_ms + 5000, on_safety_timeout, &bench);
+
+    gint64 cpu_start  = cpu_time_us();
+    gint64 wall_start = g_get_monotonic_time();
+    alloc_count_start();
+
+    g_main_loop_run(bench.loop);
+
+    gint64 num_allocs = alloc_count_stop();
+    gint64 wall_stop  = g_get_monotonic_time();
+    gint64 cpu_stop   = cpu_time_us();
+
+    BenchResult result = {0};
+    compute_result(&bench, &result);
+
+    result.cpu_percent = cpu_start < 0 ? -1.0
+                                       : 100.0 * (gdouble) (cpu_stop - cpu_start)
+                                             / (gdouble) (wall_stop - wall_start);
+    result.allocs_per_fire = num_allocs < 0 || result.num_fired == 0
+                                 ? -1.0
+                                 : (gdouble) num_allocs / result.num_fired;
+
+    FILE *out = stdout;
+    if (output_fn) {
+        out = fopen(output_fn, "a");
+        if (!out) {
+            g_printerr("Unable to open %s, writing to stdout\n", output_fn);
+            out = stdout;
+        }
+    }
+    write_result(out, &result, bench.device != NULL);
+    if (out != stdout)
+        fclose(out);
+
+    if (samples_fn)
+        write_samples(&bench);
+
+    if (bench.device) {
+        psy_audio_device_close(bench.device);
+        g_object_unref(bench.device);
+    }
+
+    for (gint i = 0; i < num_timers; i++)
+        psy_timer_free(bench.timers[i].timer);
+
+    g_free(bench.timers);
+    g_free(bench.lateness);
+    g_main_loop_unref(bench.loop);
+    g_rand_free(rand);
+
+    psy_time_point_free(start);
+    psy_clock_free(clk);
+
+    psy_deinit();
+
+    return result.num_fired == (guint) num_timers ? EXIT_SUCCESS
+                                                  : EXIT_FAILURE;
+}